@@ -7,7 +7,7 @@ public class MAProject : ModuleRules
 	public MAProject(ReadOnlyTargetRules Target) : base(Target)
 	{
 		PrivateDependencyModuleNames.AddRange(new string[] {"Niagara", "NiagaraAnimNotifies", "Persona",
-			"GenericGraphRuntime"});
+			"GenericGraphRuntime", "Json"});
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new[]
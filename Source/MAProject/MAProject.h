@@ -3,3 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Utility/Benchmark/CombatBenchmarkRecorder.h"
+
+//Timings of the combat AI (use "stat MAProjectAI" or a stats capture, which also works in headless -nullrhi sessions,
+//or run the CombatBenchmark commandlet for a JSON report)
+DECLARE_STATS_GROUP(TEXT("MAProject AI"), STATGROUP_MAProjectAI, STATCAT_Advanced);
+//Timings of the status effects of all characters (use "stat MAProjectStatusEffects")
+DECLARE_STATS_GROUP(TEXT("MAProject Status Effects"), STATGROUP_MAProjectStatusEffects, STATCAT_Advanced);
+//Usage of the pooled visual effects (use "stat MAProjectEffects")
+DECLARE_STATS_GROUP(TEXT("MAProject Effects"), STATGROUP_MAProjectEffects, STATCAT_Advanced);
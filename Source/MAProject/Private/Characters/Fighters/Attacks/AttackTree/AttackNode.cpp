@@ -3,6 +3,7 @@
 
 #include "Characters/Fighters/Attacks/AttackTree/AttackNode.h"
 
+#include "Characters/GeneralCharacter.h"
 #include "Utility/Stats/StatusEffect.h"
 
 
@@ -50,7 +51,7 @@ bool FAttackPropertiesNodeAdditional::operator==(const FAttackPropertiesNode& At
 	return Super::operator==(AttackProperties);
 }
 
-UAttackNode::UAttackNode(): bIsOnCd(false)
+UAttackNode::UAttackNode()
 {
 #if WITH_EDITORONLY_DATA
 	ContextMenuName = LOCTEXT("ContextMenuName", "Attack Node");
@@ -60,19 +61,12 @@ UAttackNode::UAttackNode(): bIsOnCd(false)
 
 const FAttackProperties& UAttackNode::GetAttackProperties(const AActor* PlayingInstance) const
 {
-	if(IsValid(PlayingInstance) && !AdditionalAttacks.IsEmpty())
+	if(AdditionalAttacks.IsEmpty()) return AttackProperties;
+	if(const AGeneralCharacter* Character = Cast<AGeneralCharacter>(PlayingInstance); IsValid(Character))
 	{
-		TArray<UActorComponent*> ActiveStatusEffects;
-		PlayingInstance->GetComponents(UStatusEffect::StaticClass(), ActiveStatusEffects);
-
 		for(const FAttackPropertiesNodeAdditional& AttackPropertiesNodeAdditional : AdditionalAttacks)
 		{
-			if(ActiveStatusEffects.FindByPredicate(
-				[ExecutionCondition = AttackPropertiesNodeAdditional.ExecutionCondition]
-				(UActorComponent* StatusEffect)
-			{
-				return StatusEffect->IsA(ExecutionCondition);
-			}) != nullptr)
+			if(Character->HasStatusEffect(AttackPropertiesNodeAdditional.ExecutionCondition))
 			{
 				return AttackPropertiesNodeAdditional;
 			}
@@ -128,45 +122,4 @@ FLinearColor UAttackNode::GetBackgroundColor() const
 }
 #endif
 
-
-
-void UAttackNode::Execute()
-{
-	const float ActualCdTime = AttackProperties.GetTotalCdTime();
-	if(ActualCdTime <= 0.f) return;
-	bIsOnCd = true;
-	GetOuter()->GetWorld()->GetTimerManager().SetTimer(CdHandle,
-		[this](){ bIsOnCd = false; },ActualCdTime, false);
-}
-
-void UAttackNode::ForceSetCd(float DesiredCd)
-{
-	if(GetOuter()->GetWorld()->GetTimerManager().IsTimerActive(CdHandle))
-	{
-		GetOuter()->GetWorld()->GetTimerManager().ClearTimer(CdHandle);
-	}
-	
-	if(DesiredCd <= 0.f)
-	{
-		bIsOnCd = false;
-	}
-	else
-	{
-		bIsOnCd = true;
-		GetOuter()->GetWorld()->GetTimerManager().SetTimer(CdHandle,
-		[this](){ bIsOnCd = false; },DesiredCd, false);
-	}
-}
-
-float UAttackNode::CdTimeElapsed() const
-{
-	if(!bIsOnCd) return -1.f;
-	return GetOuter()->GetWorld()->GetTimerManager().GetTimerElapsed(CdHandle);
-}
-
-float UAttackNode::CdTimeRemaining() const
-{
-	if(!bIsOnCd) return -1.f;
-	return GetOuter()->GetWorld()->GetTimerManager().GetTimerRemaining(CdHandle);
-}
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
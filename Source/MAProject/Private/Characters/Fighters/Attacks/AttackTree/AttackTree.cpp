@@ -3,6 +3,7 @@
 
 #include "Characters/Fighters/Attacks/AttackTree/AttackTree.h"
 
+#include "Characters/Fighters/Attacks/AttackTreeTable.h"
 #include "Characters/Fighters/Attacks/AttackTree/AttackTreeBaseNode.h"
 #include "Characters/Fighters/Attacks/AttackTree/AttackTreeEdge.h"
 
@@ -13,3 +14,14 @@ UAttackTree::UAttackTree() : bShowAsPlayerTree(false)
 
 	Name = "Attack Tree";
 }
+
+TSharedRef<const FAttackTreeTable> UAttackTree::GetCompiledTable() const
+{
+#if WITH_EDITOR
+	//the tree can be edited between play sessions, so it is compiled again for every character
+	return MakeShared<const FAttackTreeTable>(this);
+#else
+	if(!CompiledTable.IsValid()) CompiledTable = MakeShared<const FAttackTreeTable>(this);
+	return CompiledTable.ToSharedRef();
+#endif
+}
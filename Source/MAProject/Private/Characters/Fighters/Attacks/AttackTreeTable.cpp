@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/Fighters/Attacks/AttackTreeTable.h"
+
+#include "Characters/Fighters/Attacks/AttackTree/AttackNode.h"
+#include "Characters/Fighters/Attacks/AttackTree/AttackTree.h"
+#include "Characters/Fighters/Attacks/AttackTree/AttackTreeRootNode.h"
+
+FAttackTreeTable::FAttackTreeTable(const UAttackTree* AttackTree) : MainRootIndex(INDEX_NONE)
+{
+	check(IsValid(AttackTree));
+	Nodes = AttackTree->AllNodes;
+	for(UGenericGraphNode* RootNode : AttackTree->RootNodes)
+	{
+		Nodes.AddUnique(RootNode);
+	}
+	for(int32 i = 0; i < Nodes.Num(); i++)
+	{
+		NodeIndices.Add(Nodes[i], i);
+		AttackNodes.Add(Cast<UAttackNode>(Nodes[i]));
+	}
+
+	ChildrenStart.Reserve(Nodes.Num() + 1);
+	for(int32 i = 0; i < Nodes.Num(); i++)
+	{
+		ChildrenStart.Add(Children.Num());
+		for(UGenericGraphNode* ChildNode : Nodes[i]->ChildrenNodes)
+		{
+			const int32 ChildIndex = NodeIndices.FindChecked(ChildNode);
+			const AttackIndex EdgeIndex = CastChecked<UAttackTreeEdge>(Nodes[i]->GetEdge(ChildNode))->IndexCondition;
+			Children.Add(ChildIndex);
+			ChildrenEdgeIndices.Add(EdgeIndex);
+			//if multiple children share the same index, the first one is used (as it was found first when searching)
+			if(!Transitions.Contains(GetTransitionKey(i, EdgeIndex)))
+			{
+				Transitions.Add(GetTransitionKey(i, EdgeIndex), ChildIndex);
+			}
+		}
+	}
+	ChildrenStart.Add(Children.Num());
+	BuildAliasTables();
+
+	for(UGenericGraphNode* GraphNode : AttackTree->RootNodes)
+	{
+		const UAttackTreeRootNode* RootNode = CastChecked<UAttackTreeRootNode>(GraphNode);
+		const int32 RootIndex = NodeIndices.FindChecked(RootNode);
+		if(MainRootIndex == INDEX_NONE && RootNode->GetIsMainRootNode()) MainRootIndex = RootIndex;
+		if(!ModeRootIndices.Contains(RootNode->GetJumpToIdentifier()))
+		{
+			ModeRootIndices.Add(RootNode->GetJumpToIdentifier(), RootIndex);
+		}
+	}
+}
+
+int32 FAttackTreeTable::GetNodeIndex(const UGenericGraphNode* Node) const
+{
+	const int32* NodeIndex = NodeIndices.Find(Node);
+	return NodeIndex == nullptr ? INDEX_NONE : *NodeIndex;
+}
+
+int32 FAttackTreeTable::GetTransition(int32 ParentIndex, AttackIndex Index) const
+{
+	const int32* ChildIndex = Transitions.Find(GetTransitionKey(ParentIndex, Index));
+	return ChildIndex == nullptr ? INDEX_NONE : *ChildIndex;
+}
+
+TConstArrayView<int32> FAttackTreeTable::GetChildren(int32 NodeIndex) const
+{
+	return TConstArrayView<int32>(Children.GetData() + ChildrenStart[NodeIndex],
+		ChildrenStart[NodeIndex + 1] - ChildrenStart[NodeIndex]);
+}
+
+AttackIndex FAttackTreeTable::GetEdgeIndex(int32 ParentIndex, int32 ChildIndex) const
+{
+	for(int32 i = ChildrenStart[ParentIndex]; i < ChildrenStart[ParentIndex + 1]; i++)
+	{
+		if(Children[i] == ChildIndex) return ChildrenEdgeIndices[i];
+	}
+	return INDEX_NONE;
+}
+
+int32 FAttackTreeTable::GetRootIndex(const FString& ModeIdentifier) const
+{
+	if(ModeIdentifier.IsEmpty()) return MainRootIndex;
+	const int32* RootIndex = ModeRootIndices.Find(ModeIdentifier);
+	return RootIndex == nullptr ? INDEX_NONE : *RootIndex;
+}
+
+int32 FAttackTreeTable::FindAttackNode(const FString& NodeName) const
+{
+	return AttackNodes.IndexOfByPredicate([&NodeName](const UAttackNode* AttackNode)
+	{
+		return AttackNode != nullptr && AttackNode->CanBeCalled(NodeName);
+	});
+}
+
+void FAttackTreeTable::BuildAliasTables()
+{
+	ChildPriorities.Reserve(Children.Num());
+	ChildMaximalMovementDistances.Reserve(Children.Num());
+	for(const int32 ChildIndex : Children)
+	{
+		const UAttackNode* AttackNode = AttackNodes[ChildIndex];
+		ChildPriorities.Add(AttackNode == nullptr ? 0.f : FMath::Max(AttackNode->GetAttackProperties().Priority, 0.f));
+		ChildMaximalMovementDistances.Add(AttackNode == nullptr ? 0.f :
+			AttackNode->GetAttackProperties().MaximalMovementDistance);
+	}
+
+	AliasProbabilities.SetNumZeroed(Children.Num());
+	AliasSlots.SetNumZeroed(Children.Num());
+	TotalChildPriorities.SetNumZeroed(Nodes.Num());
+	TArray<double> ScaledProbabilities;
+	TArray<int32> SmallSlots;
+	TArray<int32> LargeSlots;
+	for(int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+	{
+		const int32 FirstChild = ChildrenStart[NodeIndex];
+		const int32 NumOfChildren = FMath::Min(ChildrenStart[NodeIndex + 1] - FirstChild, MaxSampledChildren);
+		ensureMsgf(ChildrenStart[NodeIndex + 1] - FirstChild <= MaxSampledChildren,
+			TEXT("Only the first %d children of an attack node can be selected randomly"), MaxSampledChildren);
+		double TotalPriority = 0.0;
+		for(int32 Slot = 0; Slot < NumOfChildren; Slot++) TotalPriority += ChildPriorities[FirstChild + Slot];
+		TotalChildPriorities[NodeIndex] = static_cast<float>(TotalPriority);
+		if(TotalPriority <= 0.0) continue;
+
+		ScaledProbabilities.Reset();
+		SmallSlots.Reset();
+		LargeSlots.Reset();
+		for(int32 Slot = 0; Slot < NumOfChildren; Slot++)
+		{
+			ScaledProbabilities.Add(ChildPriorities[FirstChild + Slot] * NumOfChildren / TotalPriority);
+			(ScaledProbabilities[Slot] < 1.0 ? SmallSlots : LargeSlots).Add(Slot);
+		}
+		while(!SmallSlots.IsEmpty() && !LargeSlots.IsEmpty())
+		{
+			const int32 SmallSlot = SmallSlots.Pop(false);
+			const int32 LargeSlot = LargeSlots.Last();
+			AliasProbabilities[FirstChild + SmallSlot] = static_cast<float>(ScaledProbabilities[SmallSlot]);
+			AliasSlots[FirstChild + SmallSlot] = LargeSlot;
+			ScaledProbabilities[LargeSlot] -= 1.0 - ScaledProbabilities[SmallSlot];
+			if(ScaledProbabilities[LargeSlot] < 1.0)
+			{
+				LargeSlots.Pop(false);
+				SmallSlots.Add(LargeSlot);
+			}
+		}
+		//the remaining slots are (up to rounding errors) exactly filled
+		for(const int32 Slot : LargeSlots)
+		{
+			AliasProbabilities[FirstChild + Slot] = 1.f;
+			AliasSlots[FirstChild + Slot] = Slot;
+		}
+		for(const int32 Slot : SmallSlots)
+		{
+			AliasProbabilities[FirstChild + Slot] = 1.f;
+			AliasSlots[FirstChild + Slot] = Slot;
+		}
+	}
+}
+
+int32 FAttackTreeTable::SampleChildLinear(int32 NodeIndex, uint64 AllowedChildren, double Random) const
+{
+	const int32 FirstChild = ChildrenStart[NodeIndex];
+	const int32 NumOfChildren = FMath::Min(ChildrenStart[NodeIndex + 1] - FirstChild, MaxSampledChildren);
+	double TotalPriority = 0.0;
+	int32 FirstAllowedSlot = INDEX_NONE;
+	int32 LastAllowedSlot = INDEX_NONE;
+	for(int32 Slot = 0; Slot < NumOfChildren; Slot++)
+	{
+		if(!(AllowedChildren & uint64(1) << Slot)) continue;
+		if(FirstAllowedSlot == INDEX_NONE) FirstAllowedSlot = Slot;
+		LastAllowedSlot = Slot;
+		TotalPriority += ChildPriorities[FirstChild + Slot];
+	}
+	//without any priority the first allowed attack is chosen
+	if(TotalPriority <= 0.0) return FirstAllowedSlot;
+
+	double RemainingPriority = Random * TotalPriority;
+	for(int32 Slot = FirstAllowedSlot; Slot <= LastAllowedSlot; Slot++)
+	{
+		if(!(AllowedChildren & uint64(1) << Slot)) continue;
+		RemainingPriority -= ChildPriorities[FirstChild + Slot];
+		if(RemainingPriority <= 0.0) return Slot;
+	}
+	return LastAllowedSlot;
+}
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+#include <random>
+
+#include "CoreMinimal.h"
+#include "Characters/Fighters/Attacks/AttackTree/AttackTreeEdge.h"
+
+class UAttackTree;
+class UAttackNode;
+class UGenericGraphNode;
+
+/**
+ * Immutable, flattened version of an attack tree. It is compiled once per asset and shared by all characters using it,
+ * so only the per character state (current node, cooldowns) has to be stored per instance.
+ * The node indices are used to store that state.
+ */
+class FAttackTreeTable
+{
+public:
+	explicit FAttackTreeTable(const UAttackTree* AttackTree);
+
+	int32 Num() const { return Nodes.Num(); }
+	UGenericGraphNode* GetNode(int32 NodeIndex) const { return Nodes[NodeIndex]; }
+	//INDEX_NONE if the node is not part of the tree
+	int32 GetNodeIndex(const UGenericGraphNode* Node) const;
+	bool IsAttackNode(int32 NodeIndex) const { return AttackNodes[NodeIndex] != nullptr; }
+	UAttackNode* GetAttackNode(int32 NodeIndex) const { return AttackNodes[NodeIndex]; }
+
+	//the index of the node following the parent when the attack with the given index is input (INDEX_NONE if there is none)
+	int32 GetTransition(int32 ParentIndex, AttackIndex Index) const;
+	TConstArrayView<int32> GetChildren(int32 NodeIndex) const;
+	//the attack index required to get from the parent to the child (INDEX_NONE if they aren't connected)
+	AttackIndex GetEdgeIndex(int32 ParentIndex, int32 ChildIndex) const;
+	bool IsChild(int32 ParentIndex, int32 ChildIndex) const { return GetChildren(ParentIndex).Contains(ChildIndex); }
+	//the maximal movement distance of the i-th child of the node
+	float GetChildMaximalMovementDistance(int32 NodeIndex, int32 ChildSlot) const
+	{
+		return ChildMaximalMovementDistances[ChildrenStart[NodeIndex] + ChildSlot];
+	}
+
+	//only the first MaxSampledChildren children of a node can be selected by SampleChild
+	static constexpr int32 MaxSampledChildren = 64;
+	/**
+	 * @brief Selects a child of the node with a probability proportional to its priority (using the node's alias table)
+	 * @param AllowedChildren Only the children whose bit is set are considered (bit i is the i-th child)
+	 * @return the slot of the selected child in GetChildren (INDEX_NONE if no child is allowed)
+	 */
+	template<typename TRandomGenerator>
+	int32 SampleChild(int32 NodeIndex, uint64 AllowedChildren, TRandomGenerator& Generator) const;
+
+	//Resolves the root node of a mode identifier (an empty identifier is the main root node). INDEX_NONE if there is none
+	int32 GetRootIndex(const FString& ModeIdentifier) const;
+	//the first attack node that can be called by the given name (INDEX_NONE if there is none)
+	int32 FindAttackNode(const FString& NodeName) const;
+
+protected:
+	TArray<UGenericGraphNode*> Nodes;
+	//nullptr for all nodes that are not attack nodes
+	TArray<UAttackNode*> AttackNodes;
+	TMap<const UGenericGraphNode*, int32> NodeIndices;
+
+	//the children of node i are stored in Children[ChildrenStart[i]] to Children[ChildrenStart[i + 1] - 1]
+	TArray<int32> ChildrenStart;
+	TArray<int32> Children;
+	TArray<AttackIndex> ChildrenEdgeIndices;
+	//(parent index, attack index) packed into one key
+	TMap<uint64, int32> Transitions;
+
+	//stored like the children, with the alias table of each node covering its children
+	TArray<float> ChildPriorities;
+	TArray<float> ChildMaximalMovementDistances;
+	TArray<float> AliasProbabilities;
+	TArray<int32> AliasSlots;
+	//the sum of the priorities of all children of the node
+	TArray<float> TotalChildPriorities;
+	//after this many rejected samples, the child is selected by walking through the allowed children instead
+	static constexpr int32 MaxAliasAttempts = 4;
+
+	int32 MainRootIndex;
+	TMap<FString, int32> ModeRootIndices;
+
+	static uint64 GetTransitionKey(int32 ParentIndex, AttackIndex Index)
+	{
+		return static_cast<uint64>(static_cast<uint32>(ParentIndex)) << 32 | static_cast<uint32>(Index);
+	}
+
+	//Builds the alias tables of all nodes using Vose's method
+	void BuildAliasTables();
+	int32 SampleChildLinear(int32 NodeIndex, uint64 AllowedChildren, double Random) const;
+};
+
+template <typename TRandomGenerator>
+int32 FAttackTreeTable::SampleChild(int32 NodeIndex, uint64 AllowedChildren, TRandomGenerator& Generator) const
+{
+	const int32 NumOfChildren = FMath::Min(ChildrenStart[NodeIndex + 1] - ChildrenStart[NodeIndex], MaxSampledChildren);
+	if(NumOfChildren < MaxSampledChildren) AllowedChildren &= (uint64(1) << NumOfChildren) - 1;
+	if(AllowedChildren == 0) return INDEX_NONE;
+
+	std::uniform_real_distribution Distribution(0.0, 1.0);
+	if(TotalChildPriorities[NodeIndex] > 0.f)
+	{
+		//sampling from all children and rejecting the disallowed ones results in the same distribution as sampling from
+		//the allowed ones directly, and is only a single sample when all of them are allowed
+		const int32 FirstChild = ChildrenStart[NodeIndex];
+		for(int32 Attempt = 0; Attempt < MaxAliasAttempts; Attempt++)
+		{
+			const double Column = Distribution(Generator) * NumOfChildren;
+			const int32 Slot = FMath::Min(static_cast<int32>(Column), NumOfChildren - 1);
+			const int32 SampledSlot = Column - Slot < AliasProbabilities[FirstChild + Slot] ? Slot :
+				AliasSlots[FirstChild + Slot];
+			if(AllowedChildren & uint64(1) << SampledSlot) return SampledSlot;
+		}
+	}
+	return SampleChildLinear(NodeIndex, AllowedChildren, Distribution(Generator));
+}
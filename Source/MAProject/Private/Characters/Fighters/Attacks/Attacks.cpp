@@ -3,26 +3,18 @@
 
 #include "Attacks.h"
 
+#include "Characters/Fighters/Attacks/AttackTreeTable.h"
+#include "Characters/Fighters/Attacks/CooldownTimelineSubsystem.h"
 #include "Characters/Fighters/Attacks/AttackTree/AttackTree.h"
 #include "Characters/Fighters/Attacks/AttackTree/AttackNode.h"
-#include "Characters/Fighters/Attacks/AttackTree/AttackTreeRootNode.h"
 
-FAttacks::FAttacks(UAttackTree const* AttackTree, UObject* Outer) : ComboExpirationTime(-1.0), PendingAttackProperties(nullptr)
+FAttacks::FAttacks(UAttackTree const* AttackTree, UObject* Outer) : ComboExpirationTime(-1.0),
+	PendingAttackProperties(nullptr), Table(AttackTree->GetCompiledTable()), Outer(Outer)
 {
-	this->AttackTree = DuplicateObject(AttackTree, Outer);
-	for(UGenericGraphNode* GraphNode : this->AttackTree->RootNodes)
-	{
-		PreCastedRootNodes.Add(CastChecked<UAttackTreeRootNode>(GraphNode));
-	}
-	for(UGenericGraphNode* GraphNode : this->AttackTree->AllNodes)
-	{
-		UAttackNode* AttackNode = Cast<UAttackNode>(GraphNode);
-		if(IsValid(AttackNode))
-		{
-			PreCastedAttackNodes.Add(AttackNode);
-		}
-	}
-	CurrentNode = GetRootNodeInternal();
+	CdReadyTimes.SetNumZeroed(Table->Num());
+	RootNodeIndex = Table->GetRootIndex(FString());
+	check(RootNodeIndex != INDEX_NONE);
+	CurrentNodeIndex = RootNodeIndex;
 }
 
 const UGenericGraphNode* FAttacks::GetCurrentNode(UWorld* WorldContext) const
@@ -31,13 +23,62 @@ const UGenericGraphNode* FAttacks::GetCurrentNode(UWorld* WorldContext) const
 	{
 		return GetRootNode();
 	}
-	return CurrentNode;
+	return Table->GetNode(CurrentNodeIndex);
+}
+
+const UGenericGraphNode* FAttacks::GetRootNode() const
+{
+	return Table->GetNode(RootNodeIndex);
+}
+
+int32 FAttacks::GetCurrentNodeIndex(UWorld* WorldContext) const
+{
+	return HasExceededComboTime(WorldContext) ? RootNodeIndex : CurrentNodeIndex;
+}
+
+uint64 FAttacks::GetAvailableChildren(int32 NodeIndex, float RequiredRange) const
+{
+	const double CurrentTime = Outer->GetWorld()->GetTimeSeconds();
+	const TConstArrayView<int32> Children = Table->GetChildren(NodeIndex);
+	const int32 NumOfChildren = FMath::Min(Children.Num(), FAttackTreeTable::MaxSampledChildren);
+	uint64 AvailableChildren = 0;
+	for(int32 Slot = 0; Slot < NumOfChildren; Slot++)
+	{
+		if(IsOnCd(Children[Slot], CurrentTime) ||
+			(RequiredRange >= 0.f && Table->GetChildMaximalMovementDistance(NodeIndex, Slot) < RequiredRange)) continue;
+		AvailableChildren |= uint64(1) << Slot;
+	}
+	return AvailableChildren;
+}
+
+bool FAttacks::IsOnCd(const UAttackNode* Node) const
+{
+	const int32 NodeIndex = Table->GetNodeIndex(Node);
+	check(NodeIndex != INDEX_NONE);
+	return IsOnCd(NodeIndex, Outer->GetWorld()->GetTimeSeconds());
+}
+
+float FAttacks::GetCdTimeRemaining(const UAttackNode* Node) const
+{
+	const int32 NodeIndex = Table->GetNodeIndex(Node);
+	check(NodeIndex != INDEX_NONE);
+	const double CurrentTime = Outer->GetWorld()->GetTimeSeconds();
+	if(!IsOnCd(NodeIndex, CurrentTime)) return -1.f;
+	return static_cast<float>(CdReadyTimes[NodeIndex] - CurrentTime);
+}
+
+double FAttacks::GetCdReadyTime(const UAttackNode* Node) const
+{
+	const int32 NodeIndex = Table->GetNodeIndex(Node);
+	check(NodeIndex != INDEX_NONE);
+	return IsOnCd(NodeIndex, Outer->GetWorld()->GetTimeSeconds()) ? CdReadyTimes[NodeIndex] : -1.0;
 }
 
 void FAttacks::SetModeIdentifier(const FString& ModeIdentifier, FSetAttackTreeModeIdentifier)
 {
-	RootNodeIdentifier = ModeIdentifier;
-	CurrentNode = GetRootNodeInternal();
+	RootNodeIndex = Table->GetRootIndex(ModeIdentifier);
+	check(RootNodeIndex != INDEX_NONE);
+	CurrentNodeIndex = RootNodeIndex;
 	ComboExpirationTime = -1.0;
 	// ReSharper disable once CppExpressionWithoutSideEffects
 	OnModeChanged.ExecuteIfBound();
@@ -45,57 +86,36 @@ void FAttacks::SetModeIdentifier(const FString& ModeIdentifier, FSetAttackTreeMo
 
 UAttackNode* FAttacks::GetFirstNodeMatchingIndex(AttackIndex Index)
 {
-	UGenericGraphNode* CurrentRoot = GetRootNodeInternal();
-	for(UGenericGraphNode* ChildNode : CurrentRoot->ChildrenNodes){
-		if(CastChecked<UAttackTreeEdge>(CurrentRoot->GetEdge(ChildNode))->IndexCondition == Index)
-		{
-			return CastChecked<UAttackNode>(ChildNode);
-		}
-	}
-	return nullptr;
+	const int32 NodeIndex = Table->GetTransition(RootNodeIndex, Index);
+	if(NodeIndex == INDEX_NONE) return nullptr;
+	return CastChecked<UAttackNode>(Table->GetNode(NodeIndex));
 }
 
 bool FAttacks::ExecuteAttack(AttackIndex Index, const AActor* PlayingInstance, UWorld* WorldContext)
 {
-	UAttackNode* ResultingAttackNode = nullptr;
+	int32 ResultingNodeIndex = INDEX_NONE;
 	if(!HasExceededComboTime(WorldContext))
 	{
-		for(UGenericGraphNode* ChildNode : CurrentNode->ChildrenNodes)
-		{
-			const UAttackTreeEdge* AttackTreeEdge = CastChecked<UAttackTreeEdge>(CurrentNode->GetEdge(ChildNode));
-			if(AttackTreeEdge->IndexCondition == Index)
-			{
-				ResultingAttackNode = CastChecked<UAttackNode>(ChildNode);
-				break;
-			}
-		}
+		ResultingNodeIndex = Table->GetTransition(CurrentNodeIndex, Index);
 	}
 
 	//we allow "jumping back" to the root node for one of two reasons:
 	//    1. the combo time for the current attack string has been exceeded
 	//    2. the received input is not part of the current attack string
-	if(ResultingAttackNode == nullptr)
+	if(ResultingNodeIndex == INDEX_NONE)
 	{
-		const UGenericGraphNode* RootNode = GetRootNode();
-		for(UGenericGraphNode* ChildNode : RootNode->ChildrenNodes)
-		{
-			const UAttackTreeEdge* AttackTreeEdge = CastChecked<UAttackTreeEdge>(RootNode->GetEdge(ChildNode));
-			if(AttackTreeEdge->IndexCondition == Index)
-			{
-				ResultingAttackNode = CastChecked<UAttackNode>(ChildNode);
-				break;
-			}
-		}
-		if(ResultingAttackNode == nullptr) return false;
+		ResultingNodeIndex = Table->GetTransition(RootNodeIndex, Index);
+		if(ResultingNodeIndex == INDEX_NONE) return false;
 	}
-	
+
+	UAttackNode* ResultingAttackNode = CastChecked<UAttackNode>(Table->GetNode(ResultingNodeIndex));
 	const FAttackProperties& AttackProperties = ResultingAttackNode->GetAttackProperties(PlayingInstance);
 
-	if(ResultingAttackNode->GetIsOnCd()) return false;
+	if(IsOnCd(ResultingNodeIndex, Outer->GetWorld()->GetTimeSeconds())) return false;
 	if(OnCheckCanExecuteAttack.IsBound() && !OnCheckCanExecuteAttack.Execute(AttackProperties)) return false;
 
 	
-	ExecuteAttackInternal(ResultingAttackNode, AttackProperties, WorldContext);
+	ExecuteAttackInternal(ResultingNodeIndex, AttackProperties, WorldContext);
 	OnCdChanged.ExecuteIfBound(ResultingAttackNode, Index);
 	return true;
 }
@@ -104,74 +124,85 @@ bool FAttacks::ExecuteAttackFromNode(UAttackNode* NodeToExecute, const AActor* P
 {
 	
 	const FAttackProperties& AttackProperties = NodeToExecute->GetAttackProperties(PlayingInstance);
+	const int32 NodeIndex = Table->GetNodeIndex(NodeToExecute);
 
-	if(!GetRootNode()->ChildrenNodes.Contains(NodeToExecute) &&
-		(!HasExceededComboTime(WorldContext) && !CurrentNode->ChildrenNodes.Contains(NodeToExecute)))
+	if(NodeIndex == INDEX_NONE || (!Table->IsChild(RootNodeIndex, NodeIndex) &&
+		(!HasExceededComboTime(WorldContext) && !Table->IsChild(CurrentNodeIndex, NodeIndex))))
 	{
 		checkNoEntry();
 		return false;
 	}
-	if(NodeToExecute->GetIsOnCd() || (OnCheckCanExecuteAttack.IsBound() && !OnCheckCanExecuteAttack.Execute(AttackProperties)))
+	if(IsOnCd(NodeIndex, Outer->GetWorld()->GetTimeSeconds()) ||
+		(OnCheckCanExecuteAttack.IsBound() && !OnCheckCanExecuteAttack.Execute(AttackProperties)))
 	{
 		checkNoEntry();
 		return false;
 	}
 	
-	ExecuteAttackInternal(NodeToExecute, AttackProperties, WorldContext);
+	ExecuteAttackInternal(NodeIndex, AttackProperties, WorldContext);
 	return true;
 }
 
 void FAttacks::ForceSetCd(const FString& NodeIdentifier, float CdTime, bool ChangeBy)
 {
-	UAttackNode** FoundNode = PreCastedAttackNodes.FindByPredicate([NodeIdentifier](UAttackNode* AttackNode)
-	{
-		return AttackNode->CanBeCalled(NodeIdentifier);
-	});
-
-	if(FoundNode == nullptr) return;
-	UAttackNode* IdentifiedNode = *FoundNode;
-	IdentifiedNode->ForceSetCd(ChangeBy ? IdentifiedNode->CdTimeRemaining() + CdTime : CdTime);
+	const int32 NodeIndex = Table->FindAttackNode(NodeIdentifier);
+	if(NodeIndex == INDEX_NONE) return;
+	UAttackNode* IdentifiedNode = Table->GetAttackNode(NodeIndex);
+	SetCd(NodeIndex, ChangeBy ? GetCdTimeRemaining(IdentifiedNode) + CdTime : CdTime);
 	if(OnCdChanged.IsBound())
 	{
 		//talking about node indices only makes sense when the node is directly connected to the root
-		UGenericGraphNode* CurrentRoot = GetRootNodeInternal();
-		if(IdentifiedNode->ParentNodes.Contains(CurrentRoot))
+		const AttackIndex Index = Table->GetEdgeIndex(RootNodeIndex, NodeIndex);
+		if(Index != INDEX_NONE)
 		{
-			OnCdChanged.ExecuteIfBound(IdentifiedNode,
-				CastChecked<UAttackTreeEdge>(CurrentRoot->GetEdge(IdentifiedNode))->IndexCondition);
+			OnCdChanged.ExecuteIfBound(IdentifiedNode, Index);
 		}
 	}
 }
 
 bool FAttacks::operator==(const FAttacks& Attacks) const
 {
-	return ComboExpirationTime == Attacks.ComboExpirationTime && AttackTree == Attacks.AttackTree &&
-		CurrentNode == Attacks.CurrentNode;
+	return ComboExpirationTime == Attacks.ComboExpirationTime && Table == Attacks.Table &&
+		CurrentNodeIndex == Attacks.CurrentNodeIndex;
 }
 
-UGenericGraphNode* FAttacks::GetRootNodeInternal() const
+void FAttacks::SetCd(int32 NodeIndex, float CdTime)
 {
-	for(UAttackTreeRootNode* RootNode : PreCastedRootNodes)
+	if(CdTime <= 0.f)
 	{
-		if(RootNode->GetIsMainRootNode(RootNodeIdentifier))
-		{
-			return RootNode;
-		}
+		CdReadyTimes[NodeIndex] = 0.0;
+		return;
 	}
-	checkNoEntry();
-	return nullptr;
+	CdReadyTimes[NodeIndex] = Outer->GetWorld()->GetTimeSeconds() + CdTime;
+	if(OnCdChanged.IsBound()) ScheduleCdExpiredNotification(NodeIndex);
 }
 
-void FAttacks::ExecuteAttackInternal(UAttackNode* Node, const FAttackProperties& Properties, UWorld* WorldContext)
+void FAttacks::ScheduleCdExpiredNotification(int32 NodeIndex)
 {
-	CurrentNode = Node;
+	UCooldownTimelineSubsystem* CooldownTimeline = Outer->GetWorld()->GetSubsystem<UCooldownTimelineSubsystem>();
+	if(CooldownTimeline == nullptr) return;
+	const double ReadyTime = CdReadyTimes[NodeIndex];
+	//the attacks live as long as their outer, and the notification is dropped if the cooldown was changed in between
+	CooldownTimeline->Schedule(ReadyTime, FSimpleDelegate::CreateWeakLambda(Outer, [this, NodeIndex, ReadyTime]()
+	{
+		if(!CdReadyTimes.IsValidIndex(NodeIndex) || CdReadyTimes[NodeIndex] != ReadyTime) return;
+		//talking about node indices only makes sense when the node is directly connected to the root
+		const AttackIndex Index = Table->GetEdgeIndex(RootNodeIndex, NodeIndex);
+		if(Index != INDEX_NONE) OnCdChanged.ExecuteIfBound(Table->GetAttackNode(NodeIndex), Index);
+	}));
+}
+
+void FAttacks::ExecuteAttackInternal(int32 NodeIndex, const FAttackProperties& Properties, UWorld* WorldContext)
+{
+	CurrentNodeIndex = NodeIndex;
 	ComboExpirationTime = WorldContext->RealTimeSeconds + Properties.MaxComboTime;
 	PendingAttackProperties = &Properties;
 	OnExecuteAttack.Broadcast(Properties);
-	Node->Execute();
+	const float CdTime = Table->GetAttackNode(NodeIndex)->GetCdTime();
+	if(CdTime > 0.f) SetCd(NodeIndex, CdTime);
 }
 
 bool FAttacks::HasExceededComboTime(UWorld* WorldContext) const
 {
 	return WorldContext->RealTimeSeconds > ComboExpirationTime;
-}
+}
\ No newline at end of file
@@ -8,7 +8,7 @@
 #include "Attacks.generated.h"
 
 
-class UAttackTreeRootNode;
+class FAttackTreeTable;
 class UAttackNode;
 class UAttackTree;
 class UGenericGraphNode;
@@ -40,8 +40,10 @@ public:
 	FOnExecuteAttackDelegate OnExecuteAttack;
 	FOnCheckCanExecuteAttackDelegate OnCheckCanExecuteAttack;
 	
-	FAttacks() : ComboExpirationTime(0.0), PendingAttackProperties(nullptr), AttackTree(nullptr), CurrentNode(nullptr){}
+	FAttacks() : ComboExpirationTime(0.0), PendingAttackProperties(nullptr), Outer(nullptr), RootNodeIndex(INDEX_NONE),
+		CurrentNodeIndex(INDEX_NONE){}
 
+	//the tree itself is shared between all characters using it, only the combo state and the cooldowns are per instance
 	FAttacks(UAttackTree const* AttackTree, UObject* Outer);
 
 	bool HasPendingAttackProperties() const { return PendingAttackProperties != nullptr; }
@@ -50,7 +52,17 @@ public:
 	double GetComboExpirationTime() const { return ComboExpirationTime; }
 	
 	const UGenericGraphNode* GetCurrentNode(UWorld* WorldContext) const;
-	const UGenericGraphNode* GetRootNode() const{ return GetRootNodeInternal(); }
+	const UGenericGraphNode* GetRootNode() const;
+	const FAttackTreeTable& GetTable() const { return *Table; }
+	int32 GetCurrentNodeIndex(UWorld* WorldContext) const;
+	//Bit i is set if the i-th child of the node isn't on cooldown and can (if RequiredRange >= 0) move that far
+	uint64 GetAvailableChildren(int32 NodeIndex, float RequiredRange = -1.f) const;
+
+	bool IsOnCd(const UAttackNode* Node) const;
+	//-1 if the node isn't on cooldown
+	float GetCdTimeRemaining(const UAttackNode* Node) const;
+	//the world time at which the cooldown of the node is over (-1 if the node isn't on cooldown)
+	double GetCdReadyTime(const UAttackNode* Node) const;
 
 	void SetModeIdentifier(const FString& ModeIdentifier, FSetAttackTreeModeIdentifier);
 
@@ -68,15 +80,20 @@ protected:
 	double ComboExpirationTime;
 	FAttackProperties const* PendingAttackProperties;
 
-	FString RootNodeIdentifier;
-	TArray<UAttackTreeRootNode*> PreCastedRootNodes;
-	TArray<UAttackNode*> PreCastedAttackNodes;
-	UAttackTree* AttackTree;
-	UGenericGraphNode* CurrentNode;
+	TSharedPtr<const FAttackTreeTable> Table;
+	//used to access the world time
+	UObject* Outer;
+	int32 RootNodeIndex;
+	int32 CurrentNodeIndex;
+	//the world time at which the cooldown of each node is over, indexed like the nodes of the table
+	TArray<double> CdReadyTimes;
 
-	UGenericGraphNode* FAttacks::GetRootNodeInternal() const;
+	bool IsOnCd(int32 NodeIndex, double CurrentTime) const { return CdReadyTimes[NodeIndex] > CurrentTime; }
+	void SetCd(int32 NodeIndex, float CdTime);
+	//Notifies OnCdChanged once the cooldown of the node is over
+	void ScheduleCdExpiredNotification(int32 NodeIndex);
 
-	void ExecuteAttackInternal(UAttackNode* Node, const FAttackProperties& Properties, UWorld* WorldContext);
+	void ExecuteAttackInternal(int32 NodeIndex, const FAttackProperties& Properties, UWorld* WorldContext);
 
 	FORCEINLINE bool HasExceededComboTime(UWorld* WorldContext) const;
 };
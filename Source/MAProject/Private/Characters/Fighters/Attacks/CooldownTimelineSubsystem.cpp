@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/Fighters/Attacks/CooldownTimelineSubsystem.h"
+
+#include "Algo/BinarySearch.h"
+
+void UCooldownTimelineSubsystem::Schedule(double ReadyTime, FSimpleDelegate&& OnExpired)
+{
+	Expiries.Insert(FCooldownExpiry(ReadyTime, MoveTemp(OnExpired)),
+		Algo::UpperBoundBy(Expiries, ReadyTime, &FCooldownExpiry::ReadyTime));
+}
+
+void UCooldownTimelineSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	const int32 NumOfExpired = Algo::UpperBoundBy(Expiries, GetWorld()->GetTimeSeconds(), &FCooldownExpiry::ReadyTime);
+	if(NumOfExpired == 0) return;
+
+	//the delegates may schedule new expiries, so the expired ones are removed first
+	FiringExpiries.Reset();
+	FiringExpiries.Append(Expiries.GetData(), NumOfExpired);
+	Expiries.RemoveAt(0, NumOfExpired, false);
+	for(const FCooldownExpiry& Expiry : FiringExpiries)
+	{
+		// ReSharper disable once CppExpressionWithoutSideEffects
+		Expiry.OnExpired.ExecuteIfBound();
+	}
+	FiringExpiries.Reset();
+}
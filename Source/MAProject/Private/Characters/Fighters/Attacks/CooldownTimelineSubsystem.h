@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CooldownTimelineSubsystem.generated.h"
+
+struct FCooldownExpiry
+{
+	FCooldownExpiry() : ReadyTime(0.0){}
+	FCooldownExpiry(double NewReadyTime, FSimpleDelegate&& NewOnExpired) : ReadyTime(NewReadyTime),
+		OnExpired(MoveTemp(NewOnExpired)){}
+
+	double ReadyTime;
+	FSimpleDelegate OnExpired;
+};
+
+/**
+ * Cooldowns are stored as the world time at which they are over, so they don't need any timers. Only the cooldowns
+ * someone wants to be notified about (e.g. the HUD) are added to this timeline, which is sorted by the time they end.
+ */
+UCLASS()
+class UCooldownTimelineSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Executes the delegate once the world time has reached the ready time
+	void Schedule(double ReadyTime, FSimpleDelegate&& OnExpired);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UCooldownTimelineSubsystem, STATGROUP_Tickables);
+	}
+
+protected:
+	//sorted by ready time
+	TArray<FCooldownExpiry> Expiries;
+	//the expiries of the current tick
+	TArray<FCooldownExpiry> FiringExpiries;
+};
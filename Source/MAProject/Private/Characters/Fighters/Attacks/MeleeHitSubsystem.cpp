@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/Fighters/Attacks/MeleeHitSubsystem.h"
+
+#include "MAProject.h"
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+#include "Characters/Fighters/FighterCharacter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Melee Sweeps"), STAT_MeleeSweeps, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Melee Sweep Count"), STAT_MeleeSweepCount, STATGROUP_MAProjectAI);
+
+void UMeleeHitSubsystem::QueueSweep(AFighterCharacter* Attacker, const FVector& Start, const FVector& End, float Radius)
+{
+	QueuedSweeps.Emplace(Attacker, Start, End, Radius);
+}
+
+void UMeleeHitSubsystem::Flush(const AFighterCharacter* Attacker)
+{
+	//the remaining sweeps are run with the next pass
+	if(bIsRunningSweeps) return;
+	SweepsToRun.Reset();
+	for(int32 i = QueuedSweeps.Num() - 1; i >= 0; i--)
+	{
+		if(QueuedSweeps[i].Attacker != Attacker) continue;
+		SweepsToRun.Add(QueuedSweeps[i]);
+		QueuedSweeps.RemoveAt(i, 1, false);
+	}
+	if(SweepsToRun.IsEmpty()) return;
+	//the sweeps were collected in reverse
+	Algo::Reverse(SweepsToRun);
+	RunSweeps();
+}
+
+void UMeleeHitSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if(QueuedSweeps.IsEmpty() || bIsRunningSweeps) return;
+	SweepsToRun.Reset();
+	Swap(SweepsToRun, QueuedSweeps);
+	RunSweeps();
+}
+
+void UMeleeHitSubsystem::RunSweeps()
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_MeleeSweeps);
+	INC_DWORD_STAT_BY(STAT_MeleeSweepCount, SweepsToRun.Num());
+	TGuardValue<bool> RunningGuard(bIsRunningSweeps, true);
+	if(SweepResults.Num() < SweepsToRun.Num())
+	{
+		SweepResults.SetNum(SweepsToRun.Num(), false);
+		DestructibleResults.SetNum(SweepsToRun.Num(), false);
+	}
+
+	//scene queries are read only, so all sweeps of the frame can be run at the same time
+	const UWorld* World = GetWorld();
+	ParallelFor(SweepsToRun.Num(), [this, World](int32 Index)
+	{
+		const FMeleeSweep& Sweep = SweepsToRun[Index];
+		SweepResults[Index].Reset();
+		DestructibleResults[Index] = FHitResult();
+		if(!IsValid(Sweep.Attacker)) return;
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(MeleeSweep), true, Sweep.Attacker);
+		QueryParams.AddIgnoredActor(Sweep.Attacker->GetOwner());
+		//an object query doesn't stop at the first blocking hit, so neither the world geometry nor other blocking
+		//actors can absorb the hits of the fighters behind them
+		World->SweepMultiByObjectType(SweepResults[Index], Sweep.Start, Sweep.End, FQuat::Identity,
+			FCollisionObjectQueryParams(ECC_Pawn), FCollisionShape::MakeSphere(Sweep.Radius), QueryParams);
+		World->SweepSingleByChannel(DestructibleResults[Index], Sweep.Start, Sweep.End, FQuat::Identity,
+			ECC_Destructible, FCollisionShape::MakeSphere(Sweep.Radius), QueryParams);
+	});
+
+	//damage has to be applied on the game thread
+	for(int32 i = 0; i < SweepsToRun.Num(); i++)
+	{
+		//the attacker ignores the targets it has already hit
+		for(const FHitResult& Hit : SweepResults[i])
+		{
+			if(!IsValid(SweepsToRun[i].Attacker)) break;
+			if(!Hit.GetActor() || !Hit.GetActor()->IsA<AFighterCharacter>()) continue;
+			SweepsToRun[i].Attacker->OnMeleeHit(Hit, FMeleeHitKey());
+		}
+
+		const FHitResult& DestructibleHit = DestructibleResults[i];
+		AActor* HitActor = DestructibleHit.GetActor();
+		if(!IsValid(SweepsToRun[i].Attacker) || !DestructibleHit.bBlockingHit || !IsValid(HitActor) ||
+			HitActor->IsA<AFighterCharacter>()) continue;
+		//the world geometry blocks the channel as well, but doesn't overlap the mesh
+		if(SweepsToRun[i].Attacker->GetMesh()->IsOverlappingActor(HitActor))
+		{
+			SweepsToRun[i].Attacker->OnMeleeHit(DestructibleHit, FMeleeHitKey());
+		}
+	}
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MeleeHitSubsystem.generated.h"
+
+class AFighterCharacter;
+
+struct FMeleeHitKey final
+{
+	friend class UMeleeHitSubsystem;
+private:
+	FMeleeHitKey(){}
+};
+
+//The path of a melee bone during a single sub-step
+struct FMeleeSweep
+{
+	FMeleeSweep() : Attacker(nullptr), Start(NAN), End(NAN), Radius(0.f){}
+	FMeleeSweep(AFighterCharacter* NewAttacker, const FVector& NewStart, const FVector& NewEnd, float NewRadius) :
+		Attacker(NewAttacker), Start(NewStart), End(NewEnd), Radius(NewRadius){}
+
+	AFighterCharacter* Attacker;
+	FVector Start;
+	FVector End;
+	float Radius;
+};
+
+/**
+ * Collects the melee sweeps of all attackers during the frame and runs them together in a single parallel pass,
+ * after which the hits are handed back to the attackers in the order they were queued.
+ * Fighters are hit by every sweep passing through them. Other actors (e.g. destructibles) are hit like before the
+ * sweeps: by the first blocking hit on the Destructible channel, if they overlap the attacker's mesh.
+ */
+UCLASS()
+class UMeleeHitSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void QueueSweep(AFighterCharacter* Attacker, const FVector& Start, const FVector& End, float Radius);
+	//Immediately runs the queued sweeps of the attacker (e.g. before its attack ends and the hits can't be registered anymore)
+	void Flush(const AFighterCharacter* Attacker);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UMeleeHitSubsystem, STATGROUP_Tickables);
+	}
+
+protected:
+	TArray<FMeleeSweep> QueuedSweeps;
+	//the sweeps of the current pass (swapped with the queue)
+	TArray<FMeleeSweep> SweepsToRun;
+	//only ever grows, so the hit arrays of the sweeps keep their memory as well
+	TArray<TArray<FHitResult>> SweepResults;
+	TArray<FHitResult> DestructibleResults;
+	//hits can end attacks of other characters, which then try to flush their sweeps
+	bool bIsRunningSweeps = false;
+
+	//Runs the sweeps in parallel and notifies the attackers of all fighters that were hit (in the order of the hits)
+	void RunSweeps();
+};
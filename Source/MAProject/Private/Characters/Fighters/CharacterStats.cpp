@@ -31,23 +31,31 @@ FCharacterStatsBuffs FCharacterStatsBuffs::ReverseCharacterStatsBuffs() const
 		-FlatInterruptionRes, -FlatToughness);
 }
 
-FCharacterStats::FCharacterStats() :
-	WalkSpeed(0.f, 0.f, 0.f), RunSpeed(0.f, 0.f, 0.f),
-	RunSpeedupFactor(1.f), DashFactor(2.f), InterruptionResistance(0.f, 0.f, 0.f)
+void FCharacterStatsBuffs::AddTo(FStatBonuses& Bonuses) const
+{
+	FGeneralObjectStatsBuffs::AddTo(Bonuses);
+	Bonuses.Add(EScalableStat::WalkSpeed, FlatWalkSpeed, WalkSpeedBuff);
+	Bonuses.Add(EScalableStat::RunSpeed, FlatRunSpeed, RunSpeedBuff);
+	Bonuses.Add(EScalableStat::InterruptionResistance, FlatInterruptionRes, InterruptionResBuff);
+	Bonuses.Add(EScalableStat::Toughness, FlatToughness, ToughnessBuff);
+}
+
+FCharacterStats::FCharacterStats() : RunSpeedupFactor(1.f), DashFactor(2.f), CurrentToughness(0)
 {
 }
 
 void FCharacterStats::FromBase(const FCharacterBaseStats& Stats, const FSavableCharacterModifiers& Modifiers, UObject* Outer)
 {
 	Super::FromBase(Stats, Modifiers);
-	WalkSpeed.Base = Stats.BaseWalkSpeed;
+	ScalableStats.SetBase(EScalableStat::WalkSpeed, Stats.BaseWalkSpeed);
 	RunSpeedupFactor = Stats.RunSpeedup/100.f;
 	RecalculateBaseRunSpeed();
 	DashFactor = Stats.DashFactor;
-	Toughness.SetBaseMax(Stats.BaseToughness);
+	ScalableStats.SetBase(EScalableStat::Toughness, Stats.BaseToughness);
+	CurrentToughness = GetMaxToughness();
 
 	
-	InterruptionResistance.Base = Stats.BaseInterruptionResistance;
+	ScalableStats.SetBase(EScalableStat::InterruptionResistance, Stats.BaseInterruptionResistance);
 	Attacks = FAttacks(Stats.AttackTree, Outer);
 }
 
@@ -62,80 +70,59 @@ void FCharacterStats::Reset()
 
 void FCharacterStats::ResetToughness()
 {
-	Toughness.Reset();
-	OnMaxToughnessChanged.Broadcast(Health.Current, Health.Maximum.GetResulting());
+	ScalableStats.ResetBonuses(EScalableStat::Toughness);
+	CurrentToughness = GetMaxToughness();
+	OnMaxToughnessChanged.Broadcast(CurrentToughness, GetMaxToughness());
 }
 
 void FCharacterStats::ResetRunSpeed()
 {
-	RunSpeed.FlatBonus = 0.f;
-	RunSpeed.PercentageBonus = 0.f;
+	ScalableStats.ResetBonuses(EScalableStat::RunSpeed);
 }
 
 void FCharacterStats::ResetWalkSpeed()
 {
-	WalkSpeed.FlatBonus = 0.f;
-	WalkSpeed.PercentageBonus = 0.f;
+	ScalableStats.ResetBonuses(EScalableStat::WalkSpeed);
 	RecalculateBaseRunSpeed();
 }
 
 void FCharacterStats::ResetInterruptionResistance()
 {
-	InterruptionResistance.Base = 0.f;
-	InterruptionResistance.PercentageBonus = 0.f;
+	ScalableStats.ResetBonuses(EScalableStat::InterruptionResistance);
 }
 
 void FCharacterStats::RecalculateBaseRunSpeed()
 {
-	RunSpeed.Base = (1.f + RunSpeedupFactor) * WalkSpeed.GetResulting();
-}
-
-void FCharacterStats::Buff(const FCharacterStatsBuffs& Buffs)
-{
-	Super::Buff(Buffs);
-	WalkSpeed.FlatBonus += Buffs.FlatWalkSpeed;
-	WalkSpeed.PercentageBonus += Buffs.WalkSpeedBuff;
-	RecalculateBaseRunSpeed();
-	RunSpeed.FlatBonus += Buffs.FlatRunSpeed;
-	RunSpeed.PercentageBonus += Buffs.RunSpeedBuff;
-	InterruptionResistance.FlatBonus += Buffs.FlatInterruptionRes;
-	InterruptionResistance.PercentageBonus += Buffs.InterruptionResBuff;
-	Toughness.AddBonuses(Buffs.FlatToughness, Buffs.ToughnessBuff);
-	OnMaxToughnessChanged.Broadcast(Toughness.Current, Toughness.Maximum.GetResulting());
+	ScalableStats.SetBase(EScalableStat::RunSpeed, (1.f + RunSpeedupFactor) * GetWalkSpeed());
 }
 
-void FCharacterStats::Debuff(const FCharacterStatsBuffs& Buffs)
+void FCharacterStats::ApplyBonuses(const FStatBonuses& Bonuses)
 {
-	Super::Debuff(Buffs);
-	WalkSpeed.FlatBonus -= Buffs.FlatWalkSpeed;
-	WalkSpeed.PercentageBonus -= Buffs.WalkSpeedBuff;
+	const int32 OldMaxToughness = GetMaxToughness();
+	Super::ApplyBonuses(Bonuses);
 	RecalculateBaseRunSpeed();
-	RunSpeed.FlatBonus -= Buffs.FlatRunSpeed;
-	RunSpeed.PercentageBonus -= Buffs.RunSpeedBuff;
-	InterruptionResistance.FlatBonus -= Buffs.FlatInterruptionRes;
-	InterruptionResistance.PercentageBonus -= Buffs.InterruptionResBuff;
-	Toughness.AddBonuses(-Buffs.FlatToughness, -Buffs.ToughnessBuff);
-	OnMaxToughnessChanged.Broadcast(Toughness.Current, Toughness.Maximum.GetResulting());
+	CurrentToughness = RescaleCurrent(CurrentToughness, OldMaxToughness, GetMaxToughness());
+	OnMaxToughnessChanged.Broadcast(CurrentToughness, GetMaxToughness());
 }
 
 void FCharacterStats::ReduceToughness(int32 ToughnessBreak)
 {
-	OnToughnessChanged.Broadcast(Toughness.Current <=  ToughnessBreak ? 0 :
-		Toughness.Current - ToughnessBreak, Toughness.Current);
+	OnToughnessChanged.Broadcast(CurrentToughness <=  ToughnessBreak ? 0 :
+		CurrentToughness - ToughnessBreak, CurrentToughness);
 	
-	if(Toughness.Current <= ToughnessBreak)
+	if(CurrentToughness <= ToughnessBreak)
 	{
-		Toughness.Current = 0;
+		CurrentToughness = 0;
 		if(OnNoToughnessReached.IsBound()) OnNoToughnessReached.Broadcast();
 	}
 	
-	Toughness.Current -= ToughnessBreak;
+	CurrentToughness -= ToughnessBreak;
 }
 
 void FCharacterStats::RefillToughness()
 {
-	OnToughnessChanged.Broadcast(Toughness.Maximum.GetResulting(), Toughness.Current);
-	Toughness.Current = Toughness.Maximum.GetResulting();
+	OnToughnessChanged.Broadcast(GetMaxToughness(), CurrentToughness);
+	CurrentToughness = GetMaxToughness();
 }
 
 float FCharacterStats::GetDamageOutput() const
@@ -170,8 +157,7 @@ uint32 FCharacterStats::ReceiveDamage(float Damage, const FAttackDamageEvent* Da
 
 bool FCharacterStats::operator==(const FCharacterStats& CharacterStats) const
 {
-	return Super::operator==(CharacterStats) && WalkSpeed == CharacterStats.WalkSpeed &&
-		RunSpeed == CharacterStats.RunSpeed && RunSpeedupFactor == CharacterStats.RunSpeedupFactor &&
-		DashFactor == CharacterStats.DashFactor && InterruptionResistance == CharacterStats.InterruptionResistance &&
-		Toughness == CharacterStats.Toughness && Attacks == CharacterStats.Attacks;
+	return Super::operator==(CharacterStats) && RunSpeedupFactor == CharacterStats.RunSpeedupFactor &&
+		DashFactor == CharacterStats.DashFactor && CurrentToughness == CharacterStats.CurrentToughness &&
+		Attacks == CharacterStats.Attacks;
 }
\ No newline at end of file
@@ -89,6 +89,7 @@ public:
 	float FlatToughness;
 
 	FCharacterStatsBuffs ReverseCharacterStatsBuffs() const;
+	virtual void AddTo(FStatBonuses& Bonuses) const override;
 };
 
 
@@ -105,12 +106,9 @@ struct FCharacterStats : public FGeneralObjectStats
 	FOnMaxToughnessChangedDelegate OnMaxToughnessChanged;
 	FOnMinToughnessReachedDelegate OnNoToughnessReached;
 	
-	TScalable<float, float> WalkSpeed;
-	TScalable<float, float> RunSpeed;
 	float RunSpeedupFactor;
 	float DashFactor;
-	TScalable<int32, float> InterruptionResistance;
-	TMaxedValue<int32, float> Toughness;
+	int32 CurrentToughness;
 
 	FAttacks Attacks;
 
@@ -121,9 +119,14 @@ struct FCharacterStats : public FGeneralObjectStats
 	void ResetWalkSpeed();
 	void ResetInterruptionResistance();
 	void RecalculateBaseRunSpeed();
-	float GetDashSpeed() const { return RunSpeed.GetResulting() * DashFactor; }
-	void Buff(const FCharacterStatsBuffs& Buffs);
-	void Debuff(const FCharacterStatsBuffs& Buffs);
+	int32 GetMaxToughness() const { return ScalableStats.GetResultingInt(EScalableStat::Toughness); }
+	float GetWalkSpeed() const { return ScalableStats.GetResulting(EScalableStat::WalkSpeed); }
+	float GetRunSpeed() const { return ScalableStats.GetResulting(EScalableStat::RunSpeed); }
+	float GetDashSpeed() const { return GetRunSpeed() * DashFactor; }
+	int32 GetInterruptionResistance() const
+	{
+		return ScalableStats.GetResultingInt(EScalableStat::InterruptionResistance);
+	}
 	void ReduceToughness(int32 ToughnessBreak);
 	void RefillToughness();
 
@@ -133,5 +136,8 @@ struct FCharacterStats : public FGeneralObjectStats
 
 	
 	bool operator==(const FCharacterStats& CharacterStats) const;
+
+protected:
+	virtual void ApplyBonuses(const FStatBonuses& Bonuses) override;
 };
 
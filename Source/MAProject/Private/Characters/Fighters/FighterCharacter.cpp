@@ -3,19 +3,24 @@
 
 #include "Characters/Fighters/FighterCharacter.h"
 
+#include "MAProject.h"
 #include "NiagaraComponent.h"
 #include "NiagaraFunctionLibrary.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Perception/AISense_Damage.h"
+#include "Characters/Fighters/Attacks/MeleeHitSubsystem.h"
 #include "UserInterface/StatsMonitorBaseWidget.h"
 #include "Utility/NonPlayerFunctionality/TargetInformationComponent.h"
 #include "Utility/Sound/SoundResponseConfigs.h"
 
+DECLARE_CYCLE_STAT(TEXT("Check Mesh Overlaps"), STAT_CheckMeshOverlaps, STATGROUP_MAProjectAI);
+
 
 AFighterCharacter::AFighterCharacter(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer),
 	bIsInvincible(false),  TargetTimeDilation(-1.f), TimeDilationBlendTime(-1.f), TimeDilationTotalTime(-1.f),
-	TimeDilationEffectTimeRemaining(-1.f), CharacterStats(nullptr), ToughnessBrokenTime(1.f), HitFXRadius(50.f)
+	TimeDilationEffectTimeRemaining(-1.f), CharacterStats(nullptr), ToughnessBrokenTime(1.f), MeleeHitSubsystem(nullptr),
+	EffectPoolSubsystem(nullptr), HitFXRadius(50.f), MeleeSweepRadius(10.f), MeleeSubStepLength(20.f), MaxMeleeSubSteps(8)
 {
 	PrimaryActorTick.bCanEverTick = true;
 	PrimaryActorTick.bStartWithTickEnabled = true;
@@ -37,7 +42,7 @@ void AFighterCharacter::Tick(float DeltaSeconds)
 float AFighterCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator,
                                     AActor* DamageCauser)
 {
-	int32 RemainingHealth = CharacterStats->Health.Current;
+	int32 RemainingHealth = CharacterStats->CurrentHealth;
 	if(
 		FGenericTeamId::GetAttitude(this, DamageCauser) != ETeamAttitude::Friendly && !bIsInvincible &&
 		DamageEvent.IsOfType(FCustomDamageEvent::ClassID))
@@ -62,8 +67,10 @@ void AFighterCharacter::StopAnimMontage(UAnimMontage* AnimMontage)
 	if(IsValid(GetCurrentMontage()))
 	{
 		//Prevent melee enabled bones from not being disabled when the animation ends
+		if(IsValid(MeleeHitSubsystem)) MeleeHitSubsystem->Flush(this);
 		RecentlyDamagedActors.Empty();
 		MeleeEnabledBones.Empty();
+		MeleeBoneLastLocations.Empty();
 	}
 	Super::StopAnimMontage(AnimMontage);
 }
@@ -77,13 +84,13 @@ bool AFighterCharacter::IsMovingOnFloor() const
 bool AFighterCharacter::IsWalking() const
 {
 	return IsMovingOnFloor() &&
-		GetCharacterMovement()->GetMaxSpeed() == CharacterStats->WalkSpeed.GetResulting();
+		GetCharacterMovement()->GetMaxSpeed() == CharacterStats->GetWalkSpeed();
 }
 
 bool AFighterCharacter::IsRunning() const
 {
 	return IsMovingOnFloor() &&
-		GetCharacterMovement()->GetMaxSpeed() == CharacterStats->RunSpeed.GetResulting();
+		GetCharacterMovement()->GetMaxSpeed() == CharacterStats->GetRunSpeed();
 
 }
 
@@ -101,20 +108,41 @@ void AFighterCharacter::ActivateMeleeBones(const TArray<FName>& BonesToEnable, b
                                            bool AllowHitRecentVictims, FMeleeControlsKey Key)
 {
 	if(!CharacterStats->Attacks.HasPendingAttackProperties()) return;
-	if(StartEmpty) MeleeEnabledBones.Empty();
+	if(StartEmpty)
+	{
+		MeleeEnabledBones.Empty();
+		MeleeBoneLastLocations.Empty();
+	}
 	if(AllowHitRecentVictims) RecentlyDamagedActors.Empty();
-	MeleeEnabledBones.Append(BonesToEnable);
+	//the first sweep of the bones starts where they are now
+	if(MeleeEnabledBones.IsEmpty()) LastMeleeMeshTransform = GetMesh()->GetComponentTransform();
+	for(const FName BoneToEnable : BonesToEnable)
+	{
+		MeleeEnabledBones.Add(BoneToEnable);
+		//relative to the mesh transform of the last sweep, so bones added during an attack start where they are now
+		MeleeBoneLastLocations.Add(LastMeleeMeshTransform.InverseTransformPosition(
+			GetMesh()->GetBoneLocation(BoneToEnable, EBoneSpaces::WorldSpace)));
+	}
 }
 
 void AFighterCharacter::DeactivateMeleeBones(const TArray<FName>& BonesToDisable, bool IsLastAttackOfAnimation,
 	FMeleeControlsKey Key)
 {
+	//the hits of the bones have to be registered while the attack properties are still available
+	CheckMeshOverlaps();
+	if(IsValid(MeleeHitSubsystem)) MeleeHitSubsystem->Flush(this);
 	if(IsLastAttackOfAnimation)
 	{
 		RecentlyDamagedActors.Empty();
 		CharacterStats->Attacks.ClearPendingAttackPropertiesInternal();
 	}
-	for(FName BoneToDisable : BonesToDisable) MeleeEnabledBones.RemoveSwap(BoneToDisable);
+	for(FName BoneToDisable : BonesToDisable)
+	{
+		const int32 Index = MeleeEnabledBones.Find(BoneToDisable);
+		if(Index == INDEX_NONE) continue;
+		MeleeEnabledBones.RemoveAtSwap(Index);
+		MeleeBoneLastLocations.RemoveAtSwap(Index);
+	}
 }
 
 void AFighterCharacter::AddOnInputLimitsResetDelegate(const TDelegate<void(bool)>& FunctionToAdd, FModifyInputLimitsKey)
@@ -146,37 +174,56 @@ void AFighterCharacter::EndInvincibility()
 }
 
 
+void AFighterCharacter::OnMeleeHit(const FHitResult& HitResult, FMeleeHitKey)
+{
+	AActor* Target = HitResult.GetActor();
+	if(Target == this || !IsValid(Target) || !CharacterStats->Attacks.HasPendingAttackProperties()) return;
+	bool WasRecentlyDamaged;
+	RecentlyDamagedActors.Add(Target, &WasRecentlyDamaged);
+	if(WasRecentlyDamaged) return;
+	
+	FAttackDamageEvent AttackDamageEvent;
+	GenerateDamageEvent(AttackDamageEvent, HitResult);
+	Target->TakeDamage(CharacterStats->GetDamageOutput(), AttackDamageEvent, GetInstigatorController(), this);
+}
+
 void AFighterCharacter::CheckMeshOverlaps()
 {
-	TArray<AActor*> OverlappingActors;
-	GetMesh()->GetOverlappingActors(OverlappingActors);
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_CheckMeshOverlaps);
+	if(!IsValid(MeleeHitSubsystem)) return;
+	const FTransform MeshTransform = GetMesh()->GetComponentTransform();
 	
-	//loop through all bones that can damage targets, to find some that actually hit a target
-	FHitResult HitTraceResult;
-	for(const FName BodyName : MeleeEnabledBones)
+	//sweep along the path of all bones that can damage targets, so no target is missed independent of the frame rate
+	for(int32 i = 0; i < MeleeEnabledBones.Num(); i++)
 	{
-		FVector VelocityDirection = GetMesh()->GetBoneLinearVelocity(BodyName).GetSafeNormal();
-
-		//we need hit results for attack management
-		UKismetSystemLibrary::LineTraceSingle(GetWorld(), GetMesh()->GetBoneLocation(BodyName),
-		GetMesh()->GetBoneLocation(BodyName) + VelocityDirection * 100.f, UEngineTypes::ConvertToTraceType(ECC_Destructible),
-		true, {this, Owner}, EDrawDebugTrace::None, HitTraceResult, true);
-
-		if(HitTraceResult.bBlockingHit)
+		const FVector BoneLocation = GetMesh()->GetBoneLocation(MeleeEnabledBones[i], EBoneSpaces::ComponentSpace);
+		const FVector& LastBoneLocation = MeleeBoneLastLocations[i];
+		const double Distance = FVector::Distance(LastMeleeMeshTransform.TransformPosition(LastBoneLocation),
+			MeshTransform.TransformPosition(BoneLocation));
+		const int32 SubSteps = FMath::Clamp(FMath::CeilToInt32(Distance / MeleeSubStepLength), 1, MaxMeleeSubSteps);
+
+		FVector SubStepStart = LastMeleeMeshTransform.TransformPosition(LastBoneLocation);
+		for(int32 SubStep = 1; SubStep <= SubSteps; SubStep++)
 		{
-			for(AActor* Target : OverlappingActors)
-			{
-				if(Target == this || !IsValid(Target)  || RecentlyDamagedActors.Contains(Target) ||
-					HitTraceResult.GetActor() != Target) continue;
-				RecentlyDamagedActors.Add(Target);
-				FAttackDamageEvent AttackDamageEvent;
-				GenerateDamageEvent(AttackDamageEvent, HitTraceResult);
-				Target->TakeDamage(CharacterStats->GetDamageOutput(),
-					AttackDamageEvent, GetInstigatorController(), this);
-				break;
-			}
+			const float Alpha = static_cast<float>(SubStep) / SubSteps;
+			FTransform SubStepTransform;
+			SubStepTransform.Blend(LastMeleeMeshTransform, MeshTransform, Alpha);
+			const FVector SubStepEnd = SubStepTransform.TransformPosition(
+				InterpolateMeleeBoneLocation(LastBoneLocation, BoneLocation, Alpha));
+			MeleeHitSubsystem->QueueSweep(this, SubStepStart, SubStepEnd, MeleeSweepRadius);
+			SubStepStart = SubStepEnd;
 		}
+		MeleeBoneLastLocations[i] = BoneLocation;
 	}
+	LastMeleeMeshTransform = MeshTransform;
+}
+
+FVector AFighterCharacter::InterpolateMeleeBoneLocation(const FVector& From, const FVector& To, float Alpha)
+{
+	const double FromYaw = FMath::Atan2(From.Y, From.X);
+	const double Yaw = FromYaw + FMath::FindDeltaAngleRadians(FromYaw, FMath::Atan2(To.Y, To.X)) * Alpha;
+	const double Radius = FMath::Lerp(From.Size2D(), To.Size2D(), static_cast<double>(Alpha));
+	return FVector(Radius * FMath::Cos(Yaw), Radius * FMath::Sin(Yaw), FMath::Lerp(From.Z, To.Z, static_cast<double>(Alpha)));
 }
 
 void AFighterCharacter::ProcessTimeDilation(float DeltaSeconds)
@@ -260,17 +307,15 @@ void AFighterCharacter::SpawnHitFX(const FVector& Location, float ScaleFactor)
 {
 	//Spawn get hit FX
 	constexpr float RealRadius = 75.f;
-	FFXSystemSpawnParameters SpawnParameters;
-	SpawnParameters.SystemTemplate = GetHitFX;
-	SpawnParameters.Location = Location;
-	SpawnParameters.Scale = FVector(HitFXRadius/RealRadius * ScaleFactor);
-	SpawnParameters.AttachToComponent = GetRootComponent();
-	SpawnParameters.bAutoActivate = true;
-	SpawnParameters.bAutoDestroy = true;
-	SpawnParameters.WorldContextObject = GetWorld();
-	UNiagaraComponent* NiagaraComponent =
-		UNiagaraFunctionLibrary::SpawnSystemAttachedWithParams(SpawnParameters);
-	NiagaraComponent->SetVariableLinearColor("BaseColor", FLinearColor(0.5f, 0.5f, 0.5f));
+	const FVector Scale(HitFXRadius/RealRadius * ScaleFactor);
+	//the pool doesn't exist in every world (e.g. editor previews)
+	UNiagaraComponent* NiagaraComponent = IsValid(EffectPoolSubsystem) ?
+		EffectPoolSubsystem->SpawnAttached(GetHitFX, GetRootComponent(), NAME_None, Location, FRotator::ZeroRotator,
+			Scale, EAttachLocation::KeepRelativeOffset) :
+		UNiagaraFunctionLibrary::SpawnSystemAttached(GetHitFX, GetRootComponent(), NAME_None, Location,
+			FRotator::ZeroRotator, Scale, EAttachLocation::KeepRelativeOffset, true, ENCPoolMethod::None);
+	if(NiagaraComponent == nullptr) return;
+	HitFXBaseColor.Set(NiagaraComponent, FLinearColor(0.5f, 0.5f, 0.5f));
 }
 
 void AFighterCharacter::GetStaggered(bool HeavyStagger)
@@ -362,7 +407,8 @@ void AFighterCharacter::RegisterHealthInfoWidget(UStatsMonitorBaseWidget* Widget
 	check(IsValid(Widget));
 	StatsMonitorWidget = Widget;
 
-	StatsMonitorWidget->SetupInformation(CharacterStats->Health, CharacterStats->Toughness, FSetupInformationKey());
+	StatsMonitorWidget->SetupInformation(CharacterStats->CurrentHealth, CharacterStats->GetMaxHealth(),
+		CharacterStats->CurrentToughness, CharacterStats->GetMaxToughness(), FSetupInformationKey());
 	
 	CharacterStats->OnHealthChanged.AddDynamic(StatsMonitorWidget, &UStatsMonitorBaseWidget::UpdateHealth);
 	CharacterStats->OnMaxHealthChanged.AddDynamic(StatsMonitorWidget, &UStatsMonitorBaseWidget::UpdateMaxHealth);
@@ -378,12 +424,12 @@ void AFighterCharacter::SetAttackTreeMode(FString ModeIdentifier)
 
 void AFighterCharacter::SwitchMovementToWalk(FSetWalkOrRunKey) const
 {
-	GetCharacterMovement()->MaxWalkSpeed = CharacterStats->WalkSpeed.GetResulting();
+	GetCharacterMovement()->MaxWalkSpeed = CharacterStats->GetWalkSpeed();
 }
 
 void AFighterCharacter::SwitchMovementToRun(FSetWalkOrRunKey) const
 {
-	GetCharacterMovement()->MaxWalkSpeed = CharacterStats->RunSpeed.GetResulting();
+	GetCharacterMovement()->MaxWalkSpeed = CharacterStats->GetRunSpeed();
 }
 
 void AFighterCharacter::BeginPlay()
@@ -391,6 +437,14 @@ void AFighterCharacter::BeginPlay()
 	Super::BeginPlay();
 	check(GetMesh()->GetRelativeTransform().GetMaximumAxisScale() == GetMesh()->GetRelativeTransform().GetMinimumAxisScale());
 	SetAnimRootMotionTranslationScale(GetMesh()->GetRelativeTransform().GetMaximumAxisScale()/100.f);
+	MeleeHitSubsystem = GetWorld()->GetSubsystem<UMeleeHitSubsystem>();
+	EffectPoolSubsystem = GetWorld()->GetSubsystem<UNiagaraEffectPoolSubsystem>();
+	if(IsValid(GetHitFX))
+	{
+		//the first hit shouldn't have to create the components
+		if(IsValid(EffectPoolSubsystem)) EffectPoolSubsystem->Prewarm(GetHitFX);
+		HitFXBaseColor = FNiagaraEffectParameter(GetHitFX, FNiagaraTypeDefinition::GetColorDef(), "BaseColor");
+	}
 	CharacterStats->OnHealthChanged.AddDynamic(this, &AFighterCharacter::OnHealthChanged);
 	CharacterStats->OnNoHealthReached.AddDynamic(this, &AFighterCharacter::OnDeath);
 	CharacterStats->OnNoToughnessReached.AddDynamic(this, &AFighterCharacter::OnToughnessBroken);
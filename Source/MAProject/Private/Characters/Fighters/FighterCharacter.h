@@ -7,6 +7,7 @@
 #include "CharacterStats.h"
 #include "GenericTeamAgentInterface.h"
 #include "Characters/GeneralCharacter.h"
+#include "Utility/Animation/NiagaraEffectPoolSubsystem.h"
 #include "FighterCharacter.generated.h"
 
 class UAttackTree;
@@ -14,6 +15,8 @@ class UStatsMonitorBaseWidget;
 class UBoneSoundResponseConfig;
 class UTargetInformationComponent;
 class UNiagaraSystem;
+class UMeleeHitSubsystem;
+struct FMeleeHitKey;
 
 struct FSetWalkOrRunKey final
 {
@@ -73,6 +76,9 @@ public:
 	
 	void SwitchMovementToWalk(FSetWalkOrRunKey) const;
 	void SwitchMovementToRun(FSetWalkOrRunKey) const;
+
+	//one of the melee enabled bones has hit something during its last sweep
+	void OnMeleeHit(const FHitResult& HitResult, FMeleeHitKey);
 	
 protected:
 	uint8 bIsInvincible:1;
@@ -84,12 +90,21 @@ protected:
 
 	
 	TArray<FName> MeleeEnabledBones;
+	//the locations of the melee enabled bones when they were last swept (relative to LastMeleeMeshTransform)
+	TArray<FVector> MeleeBoneLastLocations;
+	FTransform LastMeleeMeshTransform;
 	FCharacterStats* CharacterStats;
 	FTimerHandle InvincibilityHandle;
 	float ToughnessBrokenTime;
 
 	UPROPERTY()
-	TArray<AActor*> RecentlyDamagedActors;
+	TSet<AActor*> RecentlyDamagedActors;
+
+	UPROPERTY()
+	UMeleeHitSubsystem* MeleeHitSubsystem;
+	UPROPERTY()
+	UNiagaraEffectPoolSubsystem* EffectPoolSubsystem;
+	FNiagaraEffectParameter HitFXBaseColor;
 
 	UPROPERTY()
 	UStatsMonitorBaseWidget* StatsMonitorWidget;
@@ -112,12 +127,23 @@ protected:
 	UPROPERTY(EditAnywhere, Category = Combat, meta=(Units="cm"))
 	float HitFXRadius;
 
+	UPROPERTY(EditAnywhere, Category = Combat, AdvancedDisplay, meta=(Units="cm"))
+	float MeleeSweepRadius;
+	//the maximal distance a melee bone moves per sub-step (the path in between sub-steps is approximated linearly)
+	UPROPERTY(EditAnywhere, Category = Combat, AdvancedDisplay, meta=(Units="cm", ClampMin=1))
+	float MeleeSubStepLength;
+	UPROPERTY(EditAnywhere, Category = Combat, AdvancedDisplay, meta=(ClampMin=1))
+	int32 MaxMeleeSubSteps;
+
 	virtual void BeginPlay() override;
 
 	virtual void MakeInvincible(float InvincibilityTime);
 	void EndInvincibility();
 	
+	//queues sweeps along the paths the melee enabled bones have taken since the last check
 	void CheckMeshOverlaps();
+	//Swinging bones move along arcs around the character, so the bones are interpolated in cylindrical coordinates
+	static FVector InterpolateMeleeBoneLocation(const FVector& From, const FVector& To, float Alpha);
 	void ProcessTimeDilation(float DeltaSeconds);
 
 	virtual void GenerateDamageEvent(FAttackDamageEvent& AttackDamageEvent, const FHitResult& CausingHit);
@@ -142,7 +168,7 @@ protected:
 	void SetAttackTreeMode(FString ModeIdentifier);
 	
 	UFUNCTION(BlueprintPure)
-	float GetMaxHealthBlueprint() const { return CharacterStats->Health.Maximum.GetResulting(); }
+	float GetMaxHealthBlueprint() const { return CharacterStats->GetMaxHealth(); }
 
 	UFUNCTION(BlueprintCallable)
 	void ApplyBuffTimed(const FCharacterStatsBuffs& Buffs, float Duration = 1.f);
@@ -3,6 +3,7 @@
 
 #include "Characters/Fighters/Opponents/AI/OpponentController.h"
 
+#include "MAProject.h"
 #include "NavigationSystem.h"
 #include "BehaviorTree/BehaviorTree.h"
 #include "BehaviorTree/BlackboardComponent.h"
@@ -20,9 +21,13 @@
 #include "Perception/AISense_Sight.h"
 #include "Perception/AISense_Touch.h"
 #include "Utility/Animation/SuckToTargetComponent.h"
+#include "Utility/NonPlayerFunctionality/BudgetedBehaviorTreeComponent.h"
 #include "Utility/NonPlayerFunctionality/CharacterRotationManagerComponent.h"
 #include "Utility/NonPlayerFunctionality/MovementTarget.h"
 
+DECLARE_CYCLE_STAT(TEXT("Update Combat Location"), STAT_UpdateCombatLocation, STATGROUP_MAProjectAI);
+DECLARE_CYCLE_STAT(TEXT("Target Perception Updated"), STAT_TargetPerceptionUpdated, STATGROUP_MAProjectAI);
+
 void FAIMoveRequestExpanded::ForceSetGoalActor(const AActor* InGoalActor)
 {
 	GoalActor = const_cast<AActor*>(InGoalActor);
@@ -69,6 +74,8 @@ AOpponentController::AOpponentController(const FObjectInitializer& ObjectInitial
 {
 	PrimaryActorTick.bCanEverTick = true; //necessary for pawn orientation
 	PerceptionComponent = CreateDefaultSubobject<UAIPerceptionComponent>(TEXT("PerceptionComp"));
+	//RunBehaviorTree uses the brain component if it is a behavior tree component
+	BrainComponent = CreateDefaultSubobject<UBudgetedBehaviorTreeComponent>(TEXT("BehaviorTreeComp"));
 
 	CrowdFollowingComponent =
 		Cast<UCrowdFollowingComponent>(GetComponentByClass(UCrowdFollowingComponent::StaticClass()));
@@ -89,62 +96,91 @@ void AOpponentController::EndPlay(const EEndPlayReason::Type EndPlayReason)
 			CombatManager->UnregisterCombatParticipant(ControlledOpponent, false, FManageCombatParticipantsKey());
 		if(IsValid(MoveTarget)) MoveTarget->Destroy();
 	}
+	if(IsValid(SightTracking)) SightTracking->StopWatchingAll(this);
+	if(IsValid(AISignificance)) AISignificance->Unregister(this);
 }
 
-void AOpponentController::Tick(float DeltaSeconds)
+bool AOpponentController::UpdateCombatLocation(FVector& ResultingLocation, ECombatParticipantStatus ParticipantStatus,
+                                               bool ForceRecalculation) const
 {
-	Super::Tick(DeltaSeconds);
-	
-	if(!LastSightStimuli.IsEmpty())
-	{
-		TArray<FTimestampedStimulus> PendingForgottenStimuli;
-	
-		//Senses don't get updated except when registered/unregistered so we have to notify on position changes ourselves
-		//Currently Sight is the only sense whose location can be changed
-		for(const FTimestampedStimulus& LastSightStimulus : LastSightStimuli)
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_UpdateCombatLocation);
+	TArray<FCombatLocationQuery> Queries;
+	if(!SetupCombatLocationQueryInternal(Queries.AddDefaulted_GetRef(), ParticipantStatus, ForceRecalculation, {}))
+		return false;
+	ACombatManager::SolveCombatLocations(Queries, GetWorld());
+	FinishCombatLocationQuery(Queries[0]);
+	ResultingLocation = Queries[0].ResultingLocation;
+	return Queries[0].bFoundLocation;
+}
+
+void AOpponentController::OnCombatLocationSolved(const FCombatLocationQuery& Query, FCombatLocationQueryKey) const
+{
+	FinishCombatLocationQuery(Query);
+	//the old location isn't valid anymore (e.g. the combat target is unreachable), so it shouldn't be walked to
+	if(!Query.bFoundLocation) Blackboard->ClearValue(TargetLocationKeyName);
+	else Blackboard->SetValueAsVector(TargetLocationKeyName, Query.ResultingLocation);
+}
+
+void AOpponentController::OnWatchedActorMoved(AActor* SightedActor, const FVector& NewLocation, FSightTrackingKey)
+{
+	const FTimestampedStimulus* LastSightStimulus = LastSightStimuli.FindByPredicate(
+		[SightedActor](const FTimestampedStimulus& TimestampedStimulus)
 		{
-			AActor* PerceivedActor = LastSightStimulus.TargetActor;
-			if(!IsValid(PerceivedActor)) PendingForgottenStimuli.Add(LastSightStimulus);
-			else
-			{
-				//We shouldn't update if we have lost sight but the stimulus has jet to fade
-				if(!LastSightStimulus.WasSuccessfullySensed())
-				{
-					//the automatic expiration system is buggy so this is a custom implementation for just that
-					if(GetWorld()->TimeSeconds - LastSightStimulus.Timestamp > 1.f)
-					{
-						//try to forget the sight stimulus, if not possible, than we still update the stimulus (even if it has expired)
-						if(OnSightForgotten(PerceivedActor))
-						{
-							PendingForgottenStimuli.Add(LastSightStimulus);
-							continue;
-						}
-					}
-					else continue;
-				}
-		
-				//don't update every frame but just when relevant changes occur
-				if(FVector::Distance(LastSightStimulus.StimulusLocation, PerceivedActor->GetActorLocation()) >=
-					RelevantSightPerceptionChangeRadius)
-				{
-					FAIStimulus CurrentSightStimulus = LastSightStimulus;
-					CurrentSightStimulus.ReceiverLocation = GetPawn()->GetActorLocation();
-					CurrentSightStimulus.StimulusLocation = PerceivedActor->GetActorLocation();
-					OnTargetPerceptionUpdated(PerceivedActor, CurrentSightStimulus);
-				}
-			}
-		}
+			return TimestampedStimulus.TargetActor == SightedActor;
+		});
+	if(LastSightStimulus == nullptr)
+	{
+		SightTracking->StopWatching(this, SightedActor);
+		return;
+	}
+	FAIStimulus CurrentSightStimulus = *LastSightStimulus;
+	CurrentSightStimulus.ReceiverLocation = GetPawn()->GetActorLocation();
+	CurrentSightStimulus.StimulusLocation = NewLocation;
+	OnTargetPerceptionUpdated(SightedActor, CurrentSightStimulus);
+}
 
-		//Remove all stimuli pending to be forgotten
-		for(const FTimestampedStimulus& StimulusPendingRemoval : PendingForgottenStimuli)
+void AOpponentController::OnSightExpired(AActor* SightedActor, FSightTrackingKey)
+{
+	if(!IsValid(SightedActor))
+	{
+		LastSightStimuli.RemoveAllSwap([](const FTimestampedStimulus& TimestampedStimulus)
 		{
-			LastSightStimuli.RemoveSwap(StimulusPendingRemoval);
-		}
+			return !IsValid(TimestampedStimulus.TargetActor);
+		});
+		return;
 	}
+	const int32 StimulusIndex = LastSightStimuli.IndexOfByPredicate(
+		[SightedActor](const FTimestampedStimulus& TimestampedStimulus)
+		{
+			return TimestampedStimulus.TargetActor == SightedActor;
+		});
+	//the sight might have been regained (and maybe lost again) since the expiry was scheduled
+	if(StimulusIndex == INDEX_NONE || LastSightStimuli[StimulusIndex].WasSuccessfullySensed() ||
+		GetWorld()->TimeSeconds - LastSightStimuli[StimulusIndex].Timestamp < SightExpirationTime) return;
+
+	//try to forget the sight stimulus, if not possible, than we still update the stimulus (even if it has expired)
+	if(OnSightForgotten(SightedActor))
+	{
+		LastSightStimuli.RemoveAtSwap(StimulusIndex);
+		SightTracking->StopWatching(this, SightedActor);
+		return;
+	}
+	SightTracking->Watch(this, SightedActor, LastSightStimuli[StimulusIndex].StimulusLocation,
+		RelevantSightPerceptionChangeRadius);
+	SightTracking->ScheduleExpiry(this, SightedActor, 0.0);
 }
 
-bool AOpponentController::UpdateCombatLocation(FVector& ResultingLocation, ECombatParticipantStatus ParticipantStatus,
-                                               bool ForceRecalculation) const
+void AOpponentController::ApplySignificanceTier(const FAISignificanceTierSettings& Settings, FAISignificanceKey Key)
+{
+	SetActorTickInterval(Settings.TickInterval);
+	if(IsValid(BrainComponent)) BrainComponent->SetComponentTickInterval(Settings.BehaviorTreeTickInterval);
+	CrowdFollowingComponent->SetCrowdAvoidanceQuality(Settings.CrowdAvoidanceQuality);
+	if(IsValid(ControlledOpponent)) ControlledOpponent->ApplySignificanceTier(Settings, Key);
+}
+
+bool AOpponentController::SetupCombatLocationQueryInternal(FCombatLocationQuery& Query,
+	ECombatParticipantStatus ParticipantStatus, bool ForceRecalculation,
+	const TArray<AOpponentCharacter*>& JointlySolvedParticipants) const
 {
 	//if the controlled character has no combat target anymore or is not in combat, this calculation is not needed
 	if(!IsValid(ControlledOpponent->GetCombatTarget()))
@@ -152,17 +188,21 @@ bool AOpponentController::UpdateCombatLocation(FVector& ResultingLocation, EComb
 		EndCombat(true);
 		return false;
 	}
-	const FVector CurrentLocation = ControlledOpponent->GetActorLocation();
+	//use the same state of the combat as all other participants solved this frame, if possible
+	const FCombatParticipantsSnapshot& Snapshot = CombatManager->GetParticipantsSnapshot();
+	const int32 SnapshotIndex = Snapshot.Find(ControlledOpponent);
+	const bool UseSnapshot = SnapshotIndex != INDEX_NONE &&
+		Snapshot.HasFlags(SnapshotIndex, ECombatParticipantFlags::HasCombatTarget);
+	const FVector CurrentLocation = UseSnapshot ? Snapshot.Locations[SnapshotIndex] : ControlledOpponent->GetActorLocation();
 
-	TArray<FReservedSpaceConstraint> ReservedSpaceConstraints;
-	FCircularDistanceConstraint PlayerDistanceConstraint;
 	switch(ParticipantStatus)
 	{
 	case ECombatParticipantStatus::Active:
 		{
-			PlayerDistanceConstraint = ControlledOpponent->GetActivePlayerDistanceConstraint();
+			Query.PlayerDistanceConstraint = ControlledOpponent->GetActivePlayerDistanceConstraint();
 			bool IsPossible = true;
-			if(PlayerDistanceConstraint.bUseNavPath)
+			//with asynchronous navigation, the combat manager checks this together with the path lengths
+			if(Query.PlayerDistanceConstraint.bUseNavPath && !Query.bUseAsyncNavigation)
 			{
 				//if the distance constraint requires a connecting navigation path, a path from the NPC to the target has to exist
 				const UNavigationSystemV1* NavigationSystem = UNavigationSystemV1::GetNavigationSystem(GetWorld());
@@ -174,7 +214,7 @@ bool AOpponentController::UpdateCombatLocation(FVector& ResultingLocation, EComb
 				{
 					IsPossible = NavigationSystem->TestPathSync(
 						FPathFindingQuery(this, *NavData,ControlledOpponent->GetNavAgentLocation(),
-						PlayerDistanceConstraint.AnchorController->GetCharacter()->GetNavAgentLocation()));
+						Query.PlayerDistanceConstraint.AnchorController->GetCharacter()->GetNavAgentLocation()));
 				}
 				else IsPossible = false;
 			}
@@ -183,7 +223,7 @@ bool AOpponentController::UpdateCombatLocation(FVector& ResultingLocation, EComb
 		}
 	case ECombatParticipantStatus::Passive:
 		{
-			PlayerDistanceConstraint = ControlledOpponent->GetPassivePlayerDistanceConstraint();
+			Query.PlayerDistanceConstraint = ControlledOpponent->GetPassivePlayerDistanceConstraint();
 			break;
 		}
 	default:
@@ -192,87 +232,68 @@ bool AOpponentController::UpdateCombatLocation(FVector& ResultingLocation, EComb
 			return false;
 		}
 	}
-
-	const float MinRequestedRadius = ControlledOpponent->GetRequiredSpace().GetMinimalRadius();
-	TArray<AOpponentCharacter*> CombatParticipants = CombatManager->GetAllActiveParticipants();
-	CombatParticipants.Append(CombatManager->GetAllPassiveParticipants());
-	CombatParticipants.RemoveSwap(ControlledOpponent);
-	for(const AOpponentCharacter* CombatParticipant : CombatParticipants)
+	Query.Participant = ControlledOpponent;
+	Query.ParticipantStatus = ParticipantStatus;
+	if(UseSnapshot)
 	{
-		FVector ParticipantTargetLocation = GetCharacterTargetLocation(CombatParticipant, TargetLocationKeyName);
-		if(ParticipantTargetLocation.ContainsNaN()) continue;
-		const ACharacter* CombatTarget = CombatParticipant->GetCombatTarget();
-		if(!IsValid(CombatTarget)) continue;
-				
-		ReservedSpaceConstraints.Add(FReservedSpaceConstraint(CombatParticipant->GetRequiredSpace(),
-			ParticipantTargetLocation,CombatTarget->GetActorLocation(),
-			MinRequestedRadius));
+		Query.CombatTargetLocation = Snapshot.FacingPoints[SnapshotIndex];
+		Query.MinRequestedRadius = Snapshot.MinRequiredRadii[SnapshotIndex];
 	}
-
-
-	//add all the calculated constraints to the array of all relevant constraints
-	TArray<const FPositionalConstraint*> RelevantConstraints = {&PlayerDistanceConstraint};
-	for(const FReservedSpaceConstraint& ReservedSpace : ReservedSpaceConstraints)
+	else
 	{
-		RelevantConstraints.Add(&ReservedSpace);
+		Query.CombatTargetLocation = ControlledOpponent->GetCombatTarget()->GetActorLocation();
+		Query.MinRequestedRadius = ControlledOpponent->GetRequiredSpace().GetMinimalRadius();
 	}
-	
-	const FVector CurrentToCombatTarget = ControlledOpponent->GetCombatTarget()->GetActorLocation() - CurrentLocation;
+#if WITH_EDITORONLY_DATA
+	Query.bIsDebugging = bIsDebugging;
+#endif
+
+	//the space reserved by all other participants is kept up to date by the combat manager
+	TArray<const AActor*> IgnoredReservers = {ControlledOpponent};
+	IgnoredReservers.Append(JointlySolvedParticipants);
+	Query.ReservedSpaceConstraint = FReservedSpaceGridConstraint(&CombatManager->GetReservedSpaceGrid(),
+		IgnoredReservers, Query.MinRequestedRadius);
+
+	const FVector CurrentToCombatTarget = Query.CombatTargetLocation - CurrentLocation;
 	if(!ForceRecalculation)
 	{
-		//Check if it is necessary to change the target location, before calculating it, reducing movement noise
-		FVector CurrentTargetLocation;
 		if(Blackboard->GetValueAsBool(HasJustExecutedAttackKeyName))
 		{
 			//if the character has executed an attack, after reaching the target location,
 			//the character is not walking anymore is most likely not in the same position as the
 			//last walk to target anymore (due to the SuckToTargetComponent). The current position is then more relevant
 			//and there is no target point interpolation needed as the character is not moving currently anyways
-			CurrentTargetLocation = CurrentLocation;
+			Query.CurrentTargetLocation = CurrentLocation;
 			MoveTarget->ForceNoInterpolationOnce();
 		}
-		else CurrentTargetLocation = Blackboard->GetValueAsVector(TargetLocationKeyName);
-		
-		if(UConstraintsFunctionLibrary::GetMatchLevel(CurrentTargetLocation, RelevantConstraints, GetWorld(),
-			FVector(0, 0, abs(CurrentToCombatTarget.Z) + 100.f),
-			UConstraintsFunctionLibrary::RequireAllValid))
+		else if(Blackboard->IsVectorValueSet(TargetLocationKeyName))
 		{
-			ResultingLocation = CurrentTargetLocation;
-			return true;
+			Query.CurrentTargetLocation = Blackboard->GetValueAsVector(TargetLocationKeyName);
 		}
 	}
+	Query.ValidationExtent = FVector(0, 0, abs(CurrentToCombatTarget.Z) + 100.f);
+	Query.ProjectionExtent = FVector(0.0, 0.0, abs(CurrentToCombatTarget.Z) + 500.f);
+
+	Query.PlayerZoneConstraint = FPlayerRelativeWorldZoneConstraint(ControlledOpponent->GetCombatTargetController(),
+	                                                                CurrentLocation);
+	Query.PointGenerator = FCircularPointsGenerator(Query.PlayerDistanceConstraint, -CurrentToCombatTarget,
+	                                               ECombatParticipantStatus::Active == ParticipantStatus ? 0.05 : 0.001);
+	return true;
+}
 
+void AOpponentController::FinishCombatLocationQuery(const FCombatLocationQuery& Query) const
+{
+	if(!Query.bWasRecalculated) return;
 #if WITH_EDITORONLY_DATA
 	if(bIsDebugging){
-		GLog->Log(GetActorNameOrLabel() + " is recalculating desired location");
+		GLog->Log(GetActorNameOrLabel() + " has recalculated desired location");
 	}
-#endif
-
-
-	const FPlayerRelativeWorldZoneConstraint PlayerZoneConstraint(ControlledOpponent->GetCombatTargetController(),
-	                                                              CurrentLocation);
-	
-	RelevantConstraints.Add(&PlayerZoneConstraint);
-
-	const FCircularPointsGenerator PointGenerator(PlayerDistanceConstraint, -CurrentToCombatTarget,
-	                                             ECombatParticipantStatus::Active == ParticipantStatus ? 0.05 : 0.001);
-	const bool FoundLocation = UConstraintsFunctionLibrary::GetBestPositionSampled(ResultingLocation, PointGenerator,
-		RelevantConstraints, GetWorld(),FVector(0.0, 0.0, abs(CurrentToCombatTarget.Z) + 500.f),
-		UConstraintsFunctionLibrary::RequireAllOptimal,
-		UConstraintsFunctionLibrary::RequireAllValid, false
-#if WITH_EDITORONLY_DATA
-		, bIsDebugging
-#endif
-	);
-#if WITH_EDITORONLY_DATA
-	if(!FoundLocation)
+	if(!Query.bFoundLocation)
 	{
 		GLog->Log("Repositioning failed");
 	}
 #endif
-	
 	Blackboard->SetValueAsBool(HasJustExecutedAttackKeyName, false);
-	return FoundLocation;
 }
 
 FPathFollowingRequestResult AOpponentController::MoveTo(const FAIMoveRequest& MoveRequest, FNavPathSharedPtr* OutPath)
@@ -327,6 +348,9 @@ void AOpponentController::BeginPlay()
 	TArray<AActor*> Actors;
 	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ACombatManager::StaticClass(), Actors);
 	CombatManager = CastChecked<ACombatManager>(Actors[0]);
+	SightTracking = GetWorld()->GetSubsystem<USightTrackingSubsystem>();
+	AISignificance = GetWorld()->GetSubsystem<UAISignificanceSubsystem>();
+	if(IsValid(ControlledOpponent)) AISignificance->Register(this);
 
 	ReceiveMoveCompleted.AddDynamic(this, &AOpponentController::OnFlickBackTriggered);
 }
@@ -370,6 +394,9 @@ void AOpponentController::OnPossess(APawn* InPawn)
 	
 	MoveTarget->SetActorLabel(ControlledOpponent->GetActorNameOrLabel() + " MovementTarget");
 	MoveTarget->SetActorLocation(GetPawn()->GetActorLocation());
+
+	//possessing might happen before or after BeginPlay
+	if(IsValid(AISignificance)) AISignificance->Register(this);
 }
 
 void AOpponentController::TriggerInvestigationProcess(const FAIStimulus& KnownInformation) const
@@ -400,12 +427,11 @@ void AOpponentController::ActiveUpdateCombat(const AActor* CombatTarget, const F
 
 		Blackboard->SetValueAsBool(IsInCombatKeyName, true);
 		Blackboard->SetValueAsBool(IsInvestigatingKeyName, false); //cannot do both at the same time
+		AISignificance->Refresh(this);
 	}
 
-	//Update the target location
-	FVector TargetLocation;
-	UpdateCombatLocation(TargetLocation, CombatManager->GetParticipationStatus(ControlledOpponent), false);
-	Blackboard->SetValueAsVector(TargetLocationKeyName, TargetLocation);
+	//Update the target location (solved together with the other participants by the combat manager)
+	CombatManager->RequestCombatLocation(this, false, FRequestCombatLocationKey());
 }
 
 void AOpponentController::EndCombat(bool FullyUnregister) const
@@ -419,6 +445,7 @@ void AOpponentController::EndCombat(bool FullyUnregister) const
 
 	ControlledOpponent->RegisterCombatTarget(nullptr, FSetCombatTargetKey());
 	CombatManager->UnregisterCombatParticipant(ControlledOpponent, !FullyUnregister, FManageCombatParticipantsKey());
+	if(IsValid(AISignificance)) AISignificance->Refresh(this);
 #if WITH_EDITORONLY_DATA
 	if(bIsDebugging) GLog->Log(ControlledOpponent->GetActorNameOrLabel() + " has ended combat.");
 #endif
@@ -459,7 +486,9 @@ FVector AOpponentController::GetCharacterTargetLocation(const AOpponentCharacter
 	{
 		//See if the character is moving.
 		//As the squared length is slightly faster, we use that. We actually mean velocity > 10cm/s
-		if(RelevantCharacter->GetVelocity().SquaredLength() > 100.0)
+		//The target location is cleared if no valid one could be found
+		if(RelevantCharacter->GetVelocity().SquaredLength() > 100.0 &&
+			RelevantCharacter->GetUsedBlackboardComponent()->IsVectorValueSet(BlackboardTargetLocationName))
 		{
 			ParticipantTargetLocation =
 				RelevantCharacter->GetUsedBlackboardComponent()->GetValueAsVector(BlackboardTargetLocationName);
@@ -475,6 +504,7 @@ FVector AOpponentController::GetCharacterTargetLocation(const AOpponentCharacter
 // ReSharper disable once CppPassValueParameterByConstReference
 void AOpponentController::OnTargetPerceptionUpdated(AActor* UpdatedActor, FAIStimulus Stimulus)
 {	
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_TargetPerceptionUpdated);
 	
 	const ETeamAttitude::Type AttitudeTowardsUpdatedActor =
 		FGenericTeamId::GetAttitude(this, UpdatedActor->GetInstigatorController());
@@ -495,6 +525,20 @@ void AOpponentController::OnTargetPerceptionUpdated(AActor* UpdatedActor, FAISti
 				});
 		}
 		else *MatchingStimulus = FTimestampedStimulus(Stimulus, GetWorld()->TimeSeconds, UpdatedActor);
+
+		//Senses don't get updated except when registered/unregistered so we have to notify on position changes ourselves
+		//Currently Sight is the only sense whose location can be changed
+		if(Stimulus.WasSuccessfullySensed())
+		{
+			SightTracking->Watch(this, UpdatedActor, Stimulus.StimulusLocation, RelevantSightPerceptionChangeRadius);
+		}
+		else
+		{
+			//We shouldn't update if we have lost sight but the stimulus has jet to fade
+			SightTracking->StopWatching(this, UpdatedActor);
+			//the automatic expiration system is buggy so this is a custom implementation for just that
+			SightTracking->ScheduleExpiry(this, UpdatedActor, SightExpirationTime);
+		}
 		
 		//Start combat
 		if(AttitudeTowardsUpdatedActor != ETeamAttitude::Hostile) return;
@@ -5,6 +5,7 @@
 
 #include <Characters/AdvancedCharacterMovementComponent.h>
 
+#include "Characters/Fighters/Attacks/AttackTreeTable.h"
 #include "Characters/Fighters/Attacks/AttackTree/AttackNode.h"
 #include "Characters/Fighters/Player/PlayerCharacter.h"
 #include "Components/BoxComponent.h"
@@ -59,6 +60,14 @@ void AOpponentCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	}
 }
 
+void AOpponentCharacter::ApplySignificanceTier(const FAISignificanceTierSettings& Settings, FAISignificanceKey)
+{
+	SetActorTickInterval(Settings.TickInterval);
+	GetMesh()->VisibilityBasedAnimTickOption = Settings.AnimTickOption;
+	GetMesh()->SetComponentTickInterval(Settings.AnimTickInterval);
+	RotationManagerComponent->SetAllowSynchronousPathQueries(Settings.bAllowSynchronousPathQueries);
+}
+
 void AOpponentCharacter::BindOnAggressionTokensGranted(const TDelegate<void()>& FunctionToBind, FEditOnAggressionTokensGrantedOrReleasedKey)
 {
 	OnAggressionTokensGranted = FunctionToBind;
@@ -69,6 +78,17 @@ void AOpponentCharacter::BindOnAggressionTokensReleased(const TDelegate<void()>&
 	OnAggressionTokensRemoved = FunctionToBind;
 }
 
+void AOpponentCharacter::BindOnAggressionScoreInvalidated(const TDelegate<void(AOpponentCharacter*)>& FunctionToBind,
+	FEditOnAggressionScoreInvalidatedKey)
+{
+	OnAggressionScoreInvalidated.Add(FunctionToBind);
+}
+
+void AOpponentCharacter::UnbindOnAggressionScoreInvalidated(const void* BoundObject, FEditOnAggressionScoreInvalidatedKey)
+{
+	OnAggressionScoreInvalidated.RemoveAll(BoundObject);
+}
+
 void AOpponentCharacter::ExecuteOnAggressionTokensGranted(FExecuteOnAggressionTokensGrantedKey) const
 {
 	SetUseActiveCombatSpace();
@@ -126,7 +146,7 @@ FCircularDistanceConstraint AOpponentCharacter::GetActivePlayerDistanceConstrain
 		if(!FoundExecutableAttack)
 		{
 			//the first actually executable attack resets the values because it is stronger than all non-executable ones
-			if(!AttackNode->GetIsOnCd())
+			if(!CharacterStats->Attacks.IsOnCd(AttackNode))
 			{
 				FoundExecutableAttack = true;
 				TotalDistance = 0.f;
@@ -137,7 +157,7 @@ FCircularDistanceConstraint AOpponentCharacter::GetActivePlayerDistanceConstrain
 				NumValidAttacks = 0.f;
 			}
 		}
-		else if(AttackNode->GetIsOnCd()) continue;
+		else if(CharacterStats->Attacks.IsOnCd(AttackNode)) continue;
 		
 		NumValidAttacks += 1.f;
 		if(MaxDistance < AttackProperties.MaximalMovementDistance)
@@ -184,6 +204,7 @@ void AOpponentCharacter::ClearCombatTarget(FClearCombatTargetKey)
 {
 	TargetPlayer = DistanceFromTargetPassive.AnchorController = nullptr;
 	RotationManagerComponent->SetRotationMode(ECharacterRotationMode::OrientToMovement, true);
+	OnAggressionScoreInvalidated.Broadcast(this);
 }
 
 void AOpponentCharacter::RegisterCombatTarget(AController* NewOpponent, FSetCombatTargetKey Key)
@@ -199,6 +220,7 @@ void AOpponentCharacter::RegisterCombatTarget(AController* NewOpponent, FSetComb
 		RotationManagerComponent->SetRotationMode(ECharacterRotationMode::OrientToTarget, true,
 			TargetPlayer->GetPawn());
 	}
+	OnAggressionScoreInvalidated.Broadcast(this);
 }
 
 void AOpponentCharacter::SetUsedBlackboardComponent(UBlackboardComponent* NewBlackboard, FSetUsedBlackboardKey)
@@ -225,36 +247,7 @@ UAttackNode* AOpponentCharacter::GetRandomValidAttack() const
 		return nullptr;
 	}
 
-	const UGenericGraphNode* SourceNode = GetCharacterStats()->Attacks.GetCurrentNode(GetWorld());
-	
-	//Sort through all available attacks and remove those that cannot be executed
-	TArray<TTuple<UGenericGraphNode*, float>> ValidAttacks;
-	double TotalScore = 0.f;
-	for (UGenericGraphNode* ChildNode : SourceNode->ChildrenNodes)
-	{
-		const UAttackNode* AttackNode = CastChecked<UAttackNode>(ChildNode);
-		if (AttackNode->GetIsOnCd()) continue;
-		const float Priority = AttackNode->GetAttackProperties().Priority;
-		ValidAttacks.Add({ChildNode, Priority});
-		TotalScore += Priority;
-	}
-
-	if(ValidAttacks.IsEmpty()) return nullptr;
-
-	//Randomly chose a valid attack
-	UAttackNode* ChosenNode = nullptr;
-	std::uniform_real_distribution Distribution(0.0, TotalScore);
-	double RandomNumber = Distribution(RandomGenerator);
-	for (const TTuple<UGenericGraphNode*, float>& Attack : ValidAttacks)
-	{
-		RandomNumber -= Attack.Value;
-		if (RandomNumber <= 0.f)
-		{
-			ChosenNode = CastChecked<UAttackNode>(Attack.Key);
-			break;
-		}
-	}
-	return ChosenNode;
+	return SampleAvailableAttack(-1.f);
 }
 
 UAttackNode* AOpponentCharacter::GetRandomValidAttackInRange() const
@@ -268,54 +261,56 @@ UAttackNode* AOpponentCharacter::GetRandomValidAttackInRange() const
 	}
 
 	const float RequiredRange = FVector::Distance(TargetCharacter->GetActorLocation(), GetActorLocation());
-	const UGenericGraphNode* SourceNode = GetCharacterStats()->Attacks.GetCurrentNode(GetWorld());
-	
-	//Sort through all available attacks and remove those that cannot be executed
-	TArray<TTuple<UGenericGraphNode*, float>> ValidAttacks;
-	double TotalScore = 0.0;
-	for (UGenericGraphNode* ChildNode : SourceNode->ChildrenNodes)
-	{
-		const UAttackNode* AttackNode = CastChecked<UAttackNode>(ChildNode);
-		const FAttackProperties& AttackProperties = AttackNode->GetAttackProperties();
-		if (AttackNode->GetIsOnCd() ||
-			AttackProperties.MaximalMovementDistance < RequiredRange) continue;
-		const float Priority = AttackProperties.Priority;
-		ValidAttacks.Add({ChildNode, Priority});
-		TotalScore += Priority;
-	}
-
-	if(ValidAttacks.IsEmpty()) return nullptr;
+	return SampleAvailableAttack(RequiredRange);
+}
 
-	//Randomly chose a valid attack
-	UAttackNode* ChosenNode = nullptr;
-	std::uniform_real_distribution Distribution(0.0, TotalScore);
-	double RandomNumber = Distribution(RandomGenerator);
-	//float RandomNumber = FMath::FRandRange(0.0, TotalScore);
-	for (const TTuple<UGenericGraphNode*, float>& Attack : ValidAttacks)
-	{
-		RandomNumber -= Attack.Value;
-		if (RandomNumber <= 0.f)
-		{
-			ChosenNode = CastChecked<UAttackNode>(Attack.Key);
-			break;
-		}
-	}
-	return ChosenNode;
+UAttackNode* AOpponentCharacter::SampleAvailableAttack(float RequiredRange) const
+{
+	//the priorities of the attacks are precomputed in the alias tables of the attack tree, only the currently
+	//unavailable attacks have to be filtered
+	const FAttacks& Attacks = GetCharacterStats()->Attacks;
+	const int32 SourceIndex = Attacks.GetCurrentNodeIndex(GetWorld());
+	const uint64 AvailableChildren = Attacks.GetAvailableChildren(SourceIndex, RequiredRange);
+	const int32 ChosenSlot = Attacks.GetTable().SampleChild(SourceIndex, AvailableChildren, RandomGenerator);
+	if(ChosenSlot == INDEX_NONE) return nullptr;
+	return Attacks.GetTable().GetAttackNode(Attacks.GetTable().GetChildren(SourceIndex)[ChosenSlot]);
 }
 
 float AOpponentCharacter::GenerateAggressionScore(APlayerCharacter* PlayerCharacter) const
+{
+	return GenerateAggressionScore(PlayerCharacter, GetActorLocation(), PlayerCharacter->GetActorLocation());
+}
+
+float AOpponentCharacter::GenerateAggressionScore(APlayerCharacter* PlayerCharacter, const FVector& OwnLocation,
+	const FVector& PlayerLocation) const
+{
+	return ScaleAggressionScore(GenerateBaseAggressionScore(PlayerCharacter, OwnLocation, PlayerLocation),
+		CanAttackInSeconds());
+}
+
+float AOpponentCharacter::GenerateBaseAggressionScore(APlayerCharacter* PlayerCharacter, const FVector& OwnLocation,
+	const FVector& PlayerLocation) const
 {
 	if(!bCanBecomeAggressive) return -1.f;
 	float Score = 0.f;
 	//Aggression priority
-	if(AggressionRange > 0.f) Score += AggressionPriority * (1.f - std::min(FVector::Distance(PlayerCharacter->GetActorLocation(),
-			GetActorLocation())/AggressionRange, 1.0));
+	if(AggressionRange > 0.f) Score += AggressionPriority * (1.f - std::min(FVector::Distance(PlayerLocation,
+			OwnLocation)/AggressionRange, 1.0));
 	//Action rank
 	Score += PlayerCharacter->RequestActionRank(this);
+	return Score;
+}
 
+float AOpponentCharacter::ScaleAggressionScore(float BaseScore, float CanAttackInSeconds)
+{
+	if(BaseScore < 0.f) return BaseScore;
 	//Opponents that can't attack right now can become aggressive, but are less likely to
-	Score = Score * (1.f - (CanAttackInSeconds() / 5.f));
-	return Score;
+	return BaseScore * (1.f - (CanAttackInSeconds / 5.f));
+}
+
+double AOpponentCharacter::GetAttackReadyTime() const
+{
+	return GetWorld()->GetTimeSeconds() + CanAttackInSeconds();
 }
 
 void AOpponentCharacter::BeginPlay()
@@ -326,7 +321,7 @@ void AOpponentCharacter::BeginPlay()
 	CharacterStats->Attacks.OnModeChanged.BindUObject(this, &AOpponentCharacter::OnAttackTreeRootChanged);
 	if(IsValid(ToughnessBrokenAnimation)) ToughnessBrokenTime = ToughnessBrokenAnimation->GetPlayLength();
 
-	HealthWidgetComponent->OnHealthMonitorWidgetInitialized.AddDynamic(this, &AOpponentCharacter::RegisterHealthInfoWidget);
+	HealthWidgetComponent->RegisterStats(CharacterStats, FSetupInformationKey());
 	Super::BeginPlay();
 }
 
@@ -334,6 +329,7 @@ bool AOpponentCharacter::TriggerDeath()
 {
 	if(!Super::TriggerDeath()) return false;
 	bCanBecomeAggressive = false;
+	OnAggressionScoreInvalidated.Broadcast(this);
 	return true;
 }
 
@@ -368,7 +364,7 @@ void AOpponentCharacter::OnGetAttacked(const FAttackDamageEvent* DamageEvent)
 	if(AttackStaggers)
 	{
 		CasePerThousand = Distribution(RandomGenerator); //generate another random number to see if the stagger can be prevented
-		const bool IsStaggerPrevented = CasePerThousand <= CharacterStats->InterruptionResistance.GetResulting();
+		const bool IsStaggerPrevented = CasePerThousand <= CharacterStats->GetInterruptionResistance();
 		if(!IsStaggerPrevented) GetStaggered(false);
 	}
 		
@@ -390,12 +386,12 @@ float AOpponentCharacter::CanAttackInSeconds() const
 	return FMath::Max(RemainingComboTime, EarliestAttackSeconds(CharacterStats->Attacks.GetRootNode()));
 }
 
-float AOpponentCharacter::EarliestAttackSeconds(const UGenericGraphNode* SourceNode)
+float AOpponentCharacter::EarliestAttackSeconds(const UGenericGraphNode* SourceNode) const
 {
 	float ShortestCd = std::numeric_limits<float>::max();
 	for(const UGenericGraphNode* ChildNode : SourceNode->ChildrenNodes)
 	{
-		const float RemainingCdTime = CastChecked<UAttackNode>(ChildNode)->CdTimeRemaining();
+		const float RemainingCdTime = CharacterStats->Attacks.GetCdTimeRemaining(CastChecked<UAttackNode>(ChildNode));
 		if(RemainingCdTime <= 0.f) return 0.f;
 		if(RemainingCdTime < ShortestCd)
 		{
@@ -421,6 +417,8 @@ void AOpponentCharacter::SetUsePassiveSpace() const
 
 void AOpponentCharacter::OnSelectMotionWarpingTarget(const FAttackProperties& Properties)
 {
+	//the cooldowns and the combo have changed
+	OnAggressionScoreInvalidated.Broadcast(this);
 	if(IsValid(TargetPlayer)){
 		UActorComponent* Component = TargetPlayer->GetPawn()->GetComponentByClass(UTargetInformationComponent::StaticClass());
 		if(IsValid(Component))
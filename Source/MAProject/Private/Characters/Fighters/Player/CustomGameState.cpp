@@ -3,30 +3,38 @@
 
 #include "Characters/Fighters/Player/CustomGameState.h"
 
-#include "EngineUtils.h"
 #include "Characters/Fighters/Player/CustomGameMode.h"
 #include "Kismet/GameplayStatics.h"
 #include "UObject/SavePackage.h"
 #include "Utility/Savegame/ReadWriteHelpers.h"
-#include "Utility/Savegame/SavableObjectMarkerComponent.h"
+#include "Utility/Savegame/SaveRegistrySubsystem.h"
+#include "Utility/Savegame/WorldSaveGameFile.h"
 #include "Utility/Savegame/WorldStateSaveGame.h"
 
 DEFINE_LOG_CATEGORY(LogSaveGame);
 
 const FString ACustomGameState::WorldSaveGameName = "WorldSaveGame";
 
-ACustomGameState::ACustomGameState() : WorldSaveGame(nullptr)
+ACustomGameState::ACustomGameState() : WorldSaveGame(nullptr), bCompressSaveGame(true)
 {
 }
 
 void ACustomGameState::ReceivedGameModeClass()
 {
 	Super::ReceivedGameModeClass();
+	SaveFile = MakeShared<FWorldSaveGameFile>(WorldSaveGameName);
 	if(UGameplayStatics::DoesSaveGameExist(WorldSaveGameName, 0))
 	{
-		WorldSaveGame = Cast<UWorldStateSaveGame>(UGameplayStatics::LoadGameFromSlot(WorldSaveGameName, 0));
+		//only the player and the index of the chunks are read here, the chunks are read once their level is loaded
+		WorldSaveGame = SaveFile->Open();
 		LoadSaveGame();
 	}
+	if(!IsValid(WorldSaveGame))
+	{
+		WorldSaveGame = Cast<UWorldStateSaveGame>(UGameplayStatics::CreateSaveGameObject(UWorldStateSaveGame::StaticClass()));
+		UE_LOG(LogSaveGame, Log, TEXT("Created New SaveGame Data."));
+		GetWorld()->GetSubsystem<USaveRegistrySubsystem>()->LoadSaveGame(WorldSaveGame, SaveFile);
+	}
 }
 
 void ACustomGameState::LoadSaveGame()
@@ -41,38 +49,13 @@ void ACustomGameState::LoadSaveGame()
 	//special loading procedures
 	CastChecked<ACustomGameMode>(AuthorityGameMode)->SetPlayerSetupData(&WorldSaveGame->PlayerData, FSetPlayerSetupDataKey());
 
-	//Iterate the entire world of actors
-	TArray<AActor*> WorldActors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AActor::StaticClass(), WorldActors);
-	for(AActor* Actor : WorldActors)
-	{
-		//Only interested in Savable actors
-		if(!IsValid(Actor)) continue;
-		UActorComponent* ObjectComponent = Actor->GetComponentByClass(USavableObjectMarkerComponent::StaticClass());
-		if(!IsValid(ObjectComponent)) continue;
-		const USavableObjectMarkerComponent* CallRef = CastChecked<USavableObjectMarkerComponent>(ObjectComponent);
-
-		for(FNonPlayerSaveData ActorSaveData : WorldSaveGame->SavedActors)
-		{
-			if(ActorSaveData.ActorUniqueWorldID == CallRef->GetUniqueWorldID())
-			{
-				Actor->SetActorTransform(ActorSaveData.Transform);
-				UReadWriteHelpers::WriteToTarget(Actor, ActorSaveData.SerializedData);				
-				CallRef->OnActorLoaded.Broadcast();
-
-				break;
-			}
-		}
-	}
+	//the savable actors usually haven't begun play yet, so their records are applied once they register
+	GetWorld()->GetSubsystem<USaveRegistrySubsystem>()->LoadSaveGame(WorldSaveGame, SaveFile);
 }
 
 void ACustomGameState::WriteSaveGame()
 {
-	if(!UGameplayStatics::DoesSaveGameExist(WorldSaveGameName, 0))
-	{
-		WorldSaveGame = Cast<UWorldStateSaveGame>(UGameplayStatics::CreateSaveGameObject(UWorldStateSaveGame::StaticClass()));
-		UE_LOG(LogSaveGame, Log, TEXT("Created New SaveGame Data."));
-	}
+	check(IsValid(WorldSaveGame));
 
 	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
 	check(IsValid(PlayerController));
@@ -82,25 +65,13 @@ void ACustomGameState::WriteSaveGame()
 	WorldSaveGame->PlayerData.Transform = PlayerController->GetPawn()->GetActorTransform();
 	UReadWriteHelpers::ReadFromTarget(PlayerController, WorldSaveGame->PlayerData.SerializedData);
 	
-	WorldSaveGame->SavedActors.Empty();
-	//Iterate the entire world of actors
-	TArray<AActor*> WorldActors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AActor::StaticClass(), WorldActors);
-	for(AActor* Actor : WorldActors)
-	{
-		if(!IsValid(Actor)) continue;
-		UActorComponent* SavableObjectComponent = Actor->GetComponentByClass(USavableObjectMarkerComponent::StaticClass());
-		if(!IsValid(SavableObjectComponent)) continue;
-
-
-		FNonPlayerSaveData ActorSaveData;
-		ActorSaveData.ActorUniqueWorldID = CastChecked<USavableObjectMarkerComponent>(SavableObjectComponent)->GetUniqueWorldID();
-		ActorSaveData.Transform = Actor->GetTransform();
-		UReadWriteHelpers::ReadFromTarget(Actor, ActorSaveData.SerializedData);
-
-		WorldSaveGame->SavedActors.Add(ActorSaveData);
-	}
+	//only the actors that changed since the last save are serialized again
+	GetWorld()->GetSubsystem<USaveRegistrySubsystem>()->WriteSaveGame();
 	
-	UGameplayStatics::AsyncSaveGameToSlot(WorldSaveGame, WorldSaveGameName, 0);
+	SaveFile->WriteAsync(WorldSaveGame, bCompressSaveGame,
+		FOnWorldSaveGameWrittenDelegate::CreateWeakLambda(this, [this](bool bSuccess)
+		{
+			OnSaveGameWritten.Broadcast(bSuccess);
+		}));
 }
 
@@ -63,7 +63,7 @@ bool FStoredInput::operator==(const FStoredInput& SavedInput) const
 
 APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer),
 	bIsRunning(false), bHasJumped(false), bIsRestoringHealth(false), RestoreHealthTimestamp(0.0),
-	CurrentTarget(nullptr), PlayerStatsMonitor(nullptr), AutotargetingRange(1000.f), DashOrBlinkCooldown(1.f),
+	ConfirmedTargetSelectionFrame(0), CurrentTarget(nullptr), PlayerStatsMonitor(nullptr), AutotargetingRange(1000.f), DashOrBlinkCooldown(1.f),
 	RememberInputDirectionTime(0.5), MaximalInputWindowTime(0.5)
 {
 	// Create a camera boom (pulls in towards the player if there is a collision)
@@ -186,6 +186,7 @@ void APlayerCharacter::BeginPlay()
 	RegisterHealthInfoWidget(PlayerStatsMonitor);
 	
 	Super::BeginPlay();
+	TargetSelectionQueries.Initialize(this);
 	OnAttackInterrupted.BindUObject(this, &APlayerCharacter::AttackInterrupted);
 	CharacterStats->Attacks.OnExecuteAttack.AddDynamic(this, &APlayerCharacter::OnSelectMotionWarpingTarget);
 	CharacterStats->Attacks.OnCdChanged.BindUObject(this, &APlayerCharacter::OnCdSet);
@@ -306,11 +307,11 @@ void APlayerCharacter::OnAttackTreeModeChanged(FString NewRoot)
 {
 	Super::OnAttackTreeModeChanged(NewRoot);
 	const UAttackNode* SkillNode = CharacterStats->Attacks.GetFirstNodeMatchingIndex(EAttackType::AttackType_Skill);
-	PlayerStatsMonitor->SetSkillTimer(SkillNode->GetTimerHandle());
+	PlayerStatsMonitor->SetSkillCdReadyTime(CharacterStats->Attacks.GetCdReadyTime(SkillNode));
 	PlayerStatsMonitor->SetTotalSkillCdTime(SkillNode->GetAttackProperties().GetTotalCdTime());
 
 	const UAttackNode* UltimateNode = CharacterStats->Attacks.GetFirstNodeMatchingIndex(EAttackType::AttackType_Ultimate);
-	PlayerStatsMonitor->SetUltimateTimer(UltimateNode->GetTimerHandle());
+	PlayerStatsMonitor->SetUltimateCdReadyTime(CharacterStats->Attacks.GetCdReadyTime(UltimateNode));
 	PlayerStatsMonitor->SetTotalUltimateCdTime(UltimateNode->GetAttackProperties().GetTotalCdTime());
 }
 
@@ -323,13 +324,7 @@ void APlayerCharacter::OnNewStatusEffectReceived(UStatusEffect* StatusEffect)
 void APlayerCharacter::OnStatusEffectRemoved()
 {
 	Super::OnStatusEffectRemoved();
-	TArray<UActorComponent*> StatusEffectACs;
-	GetComponents(UStatusEffect::StaticClass(), StatusEffectACs);
-	TArray<UStatusEffect*> StatusEffects;
-	for(UActorComponent* ActorComponent : StatusEffectACs)
-	{
-		StatusEffects.Add(CastChecked<UStatusEffect>(ActorComponent));
-	}
+	const TArray<UStatusEffect*>& StatusEffects = GetActiveStatusEffects();
 
 	//Reorder the images so they don't have gap in between them
 	while(true)
@@ -477,6 +472,7 @@ void APlayerCharacter::DashStartRunning()
 	AcceptedInputs.ResetLimits(GetWorld()); //force interrupt
 
 	//try to blink to the other side of the current enemy
+	ConfirmTargetSelection();
 	if(IsValid(GetCurrentTarget()) && !bIsRunning && Blink()) return;
 		
 	//the first seconds of run are a dash
@@ -637,53 +633,82 @@ void APlayerCharacter::UpdateTargetSelection()
 	GetActorEyesViewPoint(EyesLocation, EyesRotation);
 	const FVector& PlayerLocation = GetActorLocation();
 
-	//get the target (if any exists) that is right at the center of the player's vision
-	FHitResult CenteredHitResult;
-	UKismetSystemLibrary::LineTraceSingle(GetWorld(), EyesLocation,
-										  EyesLocation + EyesRotation.Vector() * AutotargetingRange,
-										  UEngineTypes::ConvertToTraceType(ECC_Destructible), true,
-										  {this, Owner}, EDrawDebugTrace::None,
-										  CenteredHitResult, true);
-	
-	TArray<FHitResult> TraceResults;
-	UKismetSystemLibrary::SphereTraceMulti(GetWorld(), GetActorLocation(), GetActorLocation(),
-		AutotargetingRange, UEngineTypes::ConvertToTraceType(ECC_Destructible),true,
-		{this, Owner}, EDrawDebugTrace::None, TraceResults, true);
+	//a target confirmed this frame has been selected with the current state of the world already
+	if(ConfirmedTargetSelectionFrame != GFrameCounter)
+		SelectTarget(EyesLocation, EyesRotation.Vector(), PlayerLocation, false);
+
+	//the results are used during the next updates
+	TargetSelectionQueries.IssueVisibilityTraces(EyesLocation, PlayerLocation);
+	TargetSelectionQueries.QueryCandidates(EyesLocation, EyesRotation.Vector(), PlayerLocation, AutotargetingRange);
+
+#if WITH_EDITORONLY_DATA
+	//Draw debugging information
+	if (bIsDebugging)
+	{
+		DrawDebugSphere(GetWorld(), GetActorLocation(), AutotargetingRange, 100, FColor(0, 255, 0));
+		if (GetWorld()->RealTimeSeconds - InputDirection.Key <= RememberInputDirectionTime)
+			DrawDebugDirectionalArrow(GetWorld(),
+			                          GetActorLocation(), GetActorLocation() + InputDirection.Value * 100.f,
+			                          50.f, FColor(0, 0, 255), false, -1.f, 0, 5.f);
+		if (IsValid(CurrentTarget))
+			DrawDebugSphere(GetWorld(), CurrentTarget->GetComponentLocation(), 50.f,
+			                20, FColor(100, 255, 100));
+	}
+#endif
+}
+
+void APlayerCharacter::ConfirmTargetSelection()
+{
+	if(ConfirmedTargetSelectionFrame == GFrameCounter) return;
+	ConfirmedTargetSelectionFrame = GFrameCounter;
+
+	FVector EyesLocation;
+	FRotator EyesRotation;
+	GetActorEyesViewPoint(EyesLocation, EyesRotation);
+	TargetSelectionQueries.QueryCandidatesSynchronously(EyesLocation, EyesRotation.Vector(), GetActorLocation(),
+		AutotargetingRange);
+	SelectTarget(EyesLocation, EyesRotation.Vector(), GetActorLocation(), true);
+}
+
+void APlayerCharacter::SelectTarget(const FVector& EyesLocation, const FVector& ViewDirection,
+	const FVector& PlayerLocation, bool bIsSelectionRequested)
+{
+	//the candidates in range and the target (if any exists) that is right at the center of the player's vision
+	const AActor* CenteredActor = TargetSelectionQueries.GetCenteredActor();
 
 	TTuple<float, UTargetInformationComponent*> BestResult;
 	BestResult.Key = std::numeric_limits<float>::lowest();
 	BestResult.Value = nullptr;
-	for (FHitResult TraceResult : TraceResults)
+	for (const TWeakObjectPtr<AActor>& Candidate : TargetSelectionQueries.GetCandidates())
 	{
-		if (!TraceResult.bBlockingHit) continue; //all relevant meshes are set to block destructible objects...
-		UActorComponent* Component = TraceResult.GetActor()->GetComponentByClass(UTargetInformationComponent::StaticClass());
-		if (!IsValid(Component)) continue; //... and have a target information component
+		AActor* CandidateActor = Candidate.Get();
+		if (!IsValid(CandidateActor)) continue;
+		UActorComponent* Component = CandidateActor->GetComponentByClass(UTargetInformationComponent::StaticClass());
+		if (!IsValid(Component)) continue; //all relevant actors have a target information component
 		UTargetInformationComponent* TargetInfoComp = CastChecked<UTargetInformationComponent>(Component);
 		if(!TargetInfoComp->GetCanBeTargeted()) continue;
 		
 		//Get the actors center
 		FVector ActorCenter;
 		FVector Extent;
-		TraceResult.GetActor()->GetActorBounds(true, ActorCenter, Extent);
+		CandidateActor->GetActorBounds(true, ActorCenter, Extent);
 
 		//whether the target is on screen
-		float OffsetFromForward = FVector::DotProduct(EyesRotation.Vector(),
+		float OffsetFromForward = FVector::DotProduct(ViewDirection,
 		        UKismetMathLibrary::GetDirectionUnitVector(EyesLocation, ActorCenter));
 		if (UKismetMathLibrary::DegAcos(OffsetFromForward) > GetFieldOfView() / 2.f) continue;
 
-		//the TargetInfoComp has to be visible to the camera...
-		if(IsOccluded(UEngineTypes::ConvertToTraceType(ECC_Visibility),
-			EyesLocation, ActorCenter, Extent, TraceResult.GetActor())) continue;
-		//and to the actual character
-		if(IsOccluded(UEngineTypes::ConvertToTraceType(ECC_Visibility),
-			PlayerLocation, ActorCenter, Extent, TraceResult.GetActor())) continue;
+		//the TargetInfoComp has to be visible to the camera and to the actual character (cached for a few frames)
+		const bool IsVisible = bIsSelectionRequested ?
+			TargetSelectionQueries.EvaluateVisibility(CandidateActor, ActorCenter, Extent, EyesLocation, PlayerLocation) :
+			TargetSelectionQueries.RequestVisibility(CandidateActor, ActorCenter, Extent);
+		if(!IsVisible) continue;
 
 
 		//Generate a score for the target priority
 		float TotalScore = 0.f;
 		TotalScore += 0.75f * OffsetFromForward; //together with centered actor we can still reach 1.f
-		if (CenteredHitResult.bBlockingHit && CenteredHitResult.GetActor() == TraceResult.GetActor())
-			TotalScore += 0.25f;
+		if (CenteredActor == CandidateActor) TotalScore += 0.25f;
 		if (GetWorld()->RealTimeSeconds - InputDirection.Key <= RememberInputDirectionTime)
 			TotalScore += 3.f * FVector::DotProduct(InputDirection.Value,
 			    UKismetMathLibrary::GetDirectionUnitVector(PlayerLocation, ActorCenter));
@@ -710,47 +735,6 @@ void APlayerCharacter::UpdateTargetSelection()
 		}
 		else CurrentTarget = nullptr;
 	}
-
-#if WITH_EDITORONLY_DATA
-	//Draw debugging information
-	if (bIsDebugging)
-	{
-		DrawDebugSphere(GetWorld(), GetActorLocation(), AutotargetingRange, 100, FColor(0, 255, 0));
-		if (GetWorld()->RealTimeSeconds - InputDirection.Key <= RememberInputDirectionTime)
-			DrawDebugDirectionalArrow(GetWorld(),
-			                          GetActorLocation(), GetActorLocation() + InputDirection.Value * 100.f,
-			                          50.f, FColor(0, 0, 255), false, -1.f, 0, 5.f);
-		if (IsValid(CurrentTarget))
-			DrawDebugSphere(GetWorld(), CurrentTarget->GetComponentLocation(), 50.f,
-			                20, FColor(100, 255, 100));
-	}
-#endif
-}
-
-bool APlayerCharacter::IsOccluded(ETraceTypeQuery TraceType, const FVector& ObserverLocation,
-	const FVector& TargetCenter, const FVector& TargetExtent, AActor* TargetActor) const
-{
-	FHitResult VisibilityTrace;
-	UKismetSystemLibrary::LineTraceSingle(GetWorld(), ObserverLocation, TargetCenter,
-		TraceType, true,{const_cast<APlayerCharacter*>(this),
-			Owner}, EDrawDebugTrace::None,VisibilityTrace, true);
-	
-	if (VisibilityTrace.bBlockingHit && VisibilityTrace.GetActor() != TargetActor)
-	{
-		//If the first probe didn't return visible, it doesn't mean the actor is really occluded
-		TArray Locations({
-			TargetCenter + TargetExtent,
-			TargetCenter - TargetExtent,
-			TargetCenter + FVector(TargetExtent.X, TargetExtent.Y, -TargetExtent.Z),
-			TargetCenter + FVector(TargetExtent.X, -TargetExtent.Y, TargetExtent.Z),
-			TargetCenter + FVector(-TargetExtent.X, TargetExtent.Y, TargetExtent.Z),
-			TargetCenter - FVector(TargetExtent.X, TargetExtent.Y, -TargetExtent.Z),
-			TargetCenter - FVector(TargetExtent.X, -TargetExtent.Y, TargetExtent.Z),
-			TargetCenter - FVector(-TargetExtent.X, TargetExtent.Y, TargetExtent.Z)
-		});
-		return !AreMultipleVisible(TargetActor, TraceType, ObserverLocation, Locations, 3);
-	}
-	return false;
 }
 
 void APlayerCharacter::ShowDeathMenu(bool IsLimitDurationOver)
@@ -772,11 +756,11 @@ void APlayerCharacter::OnCdSet(UAttackNode* IdentifiedNode, int32 Index)
 {
 	if(Index == EAttackType::AttackType_Skill)
 	{
-		PlayerStatsMonitor->SetSkillTimer(IdentifiedNode->GetTimerHandle());
+		PlayerStatsMonitor->SetSkillCdReadyTime(CharacterStats->Attacks.GetCdReadyTime(IdentifiedNode));
 	}
 	else if(Index == EAttackType::AttackType_Ultimate)
 	{
-		PlayerStatsMonitor->SetUltimateTimer(IdentifiedNode->GetTimerHandle());		
+		PlayerStatsMonitor->SetUltimateCdReadyTime(CharacterStats->Attacks.GetCdReadyTime(IdentifiedNode));		
 	}
 }
 
@@ -789,6 +773,7 @@ void APlayerCharacter::AttackInterrupted(bool IsLimitDurationOver)
 
 void APlayerCharacter::OnSelectMotionWarpingTarget(const FAttackProperties& Properties)
 {
+	ConfirmTargetSelection();
 	if (IsValid(CurrentTarget))
 	{
 		const FVector DeltaLocation = CurrentTarget->GetComponentLocation() - GetActorLocation();
@@ -0,0 +1,291 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/Fighters/Player/TargetSelectionQueries.h"
+
+#include "MAProject.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Target Selection Queries"), STAT_TargetSelectionQueries, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Target Visibility Traces"), STAT_TargetVisibilityTraces, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Synchronous Target Visibility Evaluations"), STAT_SynchronousTargetVisibility,
+	STATGROUP_MAProjectAI);
+
+void FTargetVisibility::GetCorners(const FVector& Center, const FVector& Extent, FVector (&Corners)[NumOfCorners])
+{
+	Corners[0] = Center + Extent;
+	Corners[1] = Center - Extent;
+	Corners[2] = Center + FVector(Extent.X, Extent.Y, -Extent.Z);
+	Corners[3] = Center + FVector(Extent.X, -Extent.Y, Extent.Z);
+	Corners[4] = Center + FVector(-Extent.X, Extent.Y, Extent.Z);
+	Corners[5] = Center - FVector(Extent.X, Extent.Y, -Extent.Z);
+	Corners[6] = Center - FVector(Extent.X, -Extent.Y, Extent.Z);
+	Corners[7] = Center - FVector(-Extent.X, Extent.Y, Extent.Z);
+}
+
+void FTargetSelectionQueries::Initialize(AActor* NewOwner)
+{
+	check(IsValid(NewOwner));
+	Owner = NewOwner;
+	Candidates.Reset();
+	UniqueCandidates.Reset();
+	CenteredActor.Reset();
+	Visibilities.Reset();
+	RequestedCandidates.Reset();
+	Cursor = 0;
+}
+
+FCollisionQueryParams FTargetSelectionQueries::GetQueryParams() const
+{
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TargetSelection), true, Owner);
+	QueryParams.AddIgnoredActor(Owner->GetOwner());
+	return QueryParams;
+}
+
+void FTargetSelectionQueries::SetCandidates(const TArray<FHitResult>& Hits)
+{
+	Candidates.Reset();
+	UniqueCandidates.Reset();
+	for(const FHitResult& Hit : Hits)
+	{
+		//all relevant meshes are set to block destructible objects
+		if(!Hit.bBlockingHit || Hit.GetActor() == nullptr) continue;
+		bool bIsAlreadyCandidate;
+		UniqueCandidates.Add(Hit.GetActor(), &bIsAlreadyCandidate);
+		if(!bIsAlreadyCandidate) Candidates.Add(Hit.GetActor());
+	}
+}
+
+void FTargetSelectionQueries::QueryCandidates(const FVector& EyesLocation, const FVector& ViewDirection,
+	const FVector& CharacterLocation, float Range)
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_TargetSelectionQueries);
+	const FCollisionQueryParams QueryParams = GetQueryParams();
+	//get the target (if any exists) that is right at the center of the player's vision
+	const FTraceDelegate CenteredDelegate = FTraceDelegate::CreateWeakLambda(Owner,
+		[this](const FTraceHandle&, FTraceDatum& TraceDatum)
+	{
+		const FHitResult* Hit = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits);
+		CenteredActor = Hit == nullptr ? nullptr : Hit->GetActor();
+	});
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, EyesLocation, EyesLocation + ViewDirection * Range,
+		ECC_Destructible, QueryParams, FCollisionResponseParams::DefaultResponseParam, &CenteredDelegate);
+
+	const FTraceDelegate CandidatesDelegate = FTraceDelegate::CreateWeakLambda(Owner,
+		[this](const FTraceHandle&, FTraceDatum& TraceDatum)
+	{
+		SetCandidates(TraceDatum.OutHits);
+	});
+	GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Multi, CharacterLocation, CharacterLocation, FQuat::Identity,
+		ECC_Destructible, FCollisionShape::MakeSphere(Range), QueryParams,
+		FCollisionResponseParams::DefaultResponseParam, &CandidatesDelegate);
+}
+
+void FTargetSelectionQueries::QueryCandidatesSynchronously(const FVector& EyesLocation, const FVector& ViewDirection,
+	const FVector& CharacterLocation, float Range)
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_TargetSelectionQueries);
+	const FCollisionQueryParams QueryParams = GetQueryParams();
+	FHitResult CenteredHit;
+	GetWorld()->LineTraceSingleByChannel(CenteredHit, EyesLocation, EyesLocation + ViewDirection * Range,
+		ECC_Destructible, QueryParams);
+	CenteredActor = CenteredHit.bBlockingHit ? CenteredHit.GetActor() : nullptr;
+
+	TArray<FHitResult> Hits;
+	GetWorld()->SweepMultiByChannel(Hits, CharacterLocation, CharacterLocation, FQuat::Identity, ECC_Destructible,
+		FCollisionShape::MakeSphere(Range), QueryParams);
+	SetCandidates(Hits);
+}
+
+bool FTargetSelectionQueries::RequestVisibility(const AActor* Candidate, const FVector& Center, const FVector& Extent)
+{
+	return AddRequest(Candidate, Center, Extent).bIsVisible;
+}
+
+bool FTargetSelectionQueries::EvaluateVisibility(const AActor* Candidate, const FVector& Center, const FVector& Extent,
+	const FVector& EyesLocation, const FVector& CharacterLocation)
+{
+	FTargetVisibility& Visibility = AddRequest(Candidate, Center, Extent);
+	if(Visibility.Stage == FTargetVisibility::EStage::Idle && Visibility.SynchronousFrame == GFrameCounter)
+		return Visibility.bIsVisible;
+
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_TargetSelectionQueries);
+	INC_DWORD_STAT(STAT_SynchronousTargetVisibility);
+	//the results of the traces that are still pending are outdated
+	Visibility.RequestId = NextRequestId++;
+	Visibility.Stage = FTargetVisibility::EStage::Idle;
+	Visibility.SynchronousFrame = GFrameCounter;
+	Visibility.TracedCenter = Center;
+	Visibility.TracedExtent = Extent;
+	Visibility.Observers[0] = EyesLocation;
+	Visibility.Observers[1] = CharacterLocation;
+	Visibility.bIsVisible = true;
+	//like with the asynchronous evaluation, the candidate has to be visible to all observers
+	for(int32 Observer = 0; Observer < FTargetVisibility::NumOfObservers && Visibility.bIsVisible; Observer++)
+	{
+		Visibility.bIsVisible = IsVisibleSynchronously(Candidate, Visibility.Observers[Observer], Center, Extent);
+	}
+	Visibility.EvaluatedTime = GetWorld()->GetTimeSeconds();
+	return Visibility.bIsVisible;
+}
+
+FTargetVisibility& FTargetSelectionQueries::AddRequest(const AActor* Candidate, const FVector& Center,
+	const FVector& Extent)
+{
+	const TObjectKey<AActor> CandidateKey(Candidate);
+	FTargetVisibility& Visibility = Visibilities.FindOrAdd(CandidateKey);
+	Visibility.LastRequestedTime = GetWorld()->GetTimeSeconds();
+	Visibility.Center = Center;
+	Visibility.Extent = Extent;
+	RequestedCandidates.Add(CandidateKey);
+	return Visibility;
+}
+
+void FTargetSelectionQueries::IssueVisibilityTraces(const FVector& EyesLocation, const FVector& CharacterLocation)
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_TargetSelectionQueries);
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	//candidates that weren't requested for a while have left the range (or the screen)
+	for(auto Iterator = Visibilities.CreateIterator(); Iterator; ++Iterator)
+	{
+		if(CurrentTime - Iterator.Value().LastRequestedTime > MaxVisibilityAge) Iterator.RemoveCurrent();
+	}
+
+	int32 RemainingBudget = TraceBudget;
+	const int32 NumOfRequested = RequestedCandidates.Num();
+	int32 Offset = 0;
+	for(; Offset < NumOfRequested; Offset++)
+	{
+		const TObjectKey<AActor>& Candidate = RequestedCandidates[(Cursor + Offset) % NumOfRequested];
+		FTargetVisibility& Visibility = Visibilities.FindChecked(Candidate);
+		if(Visibility.Stage == FTargetVisibility::EStage::Idle)
+		{
+			if(Visibility.EvaluatedTime >= 0.0 && CurrentTime - Visibility.EvaluatedTime < MaxVisibilityAge) continue;
+			if(RemainingBudget < FTargetVisibility::NumOfObservers) break;
+			Visibility.Observers[0] = EyesLocation;
+			Visibility.Observers[1] = CharacterLocation;
+			IssueCenterTraces(Candidate, Visibility);
+			RemainingBudget -= FTargetVisibility::NumOfObservers;
+		}
+		else if(Visibility.Stage == FTargetVisibility::EStage::CornersNeeded)
+		{
+			const int32 Cost = FMath::CountBits(Visibility.HiddenObservers) * FTargetVisibility::NumOfCorners;
+			if(RemainingBudget < Cost) break;
+			IssueCornerTraces(Candidate, Visibility);
+			RemainingBudget -= Cost;
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_TargetVisibilityTraces, TraceBudget - RemainingBudget);
+	//the candidates that didn't fit into the budget are the first to be evaluated next frame
+	Cursor = NumOfRequested == 0 ? 0 : (Cursor + Offset) % NumOfRequested;
+	RequestedCandidates.Reset();
+}
+
+void FTargetSelectionQueries::IssueCenterTraces(const TObjectKey<AActor>& Candidate, FTargetVisibility& Visibility)
+{
+	Visibility.Stage = FTargetVisibility::EStage::WaitingForCenters;
+	Visibility.RequestId = NextRequestId++;
+	Visibility.PendingTraces = FTargetVisibility::NumOfObservers;
+	Visibility.HiddenObservers = 0;
+	Visibility.TracedCenter = Visibility.Center;
+	Visibility.TracedExtent = Visibility.Extent;
+	FMemory::Memzero(Visibility.VisibleCorners);
+
+	const FCollisionQueryParams QueryParams = GetQueryParams();
+	for(int32 Observer = 0; Observer < FTargetVisibility::NumOfObservers; Observer++)
+	{
+		const FTraceDelegate Delegate = FTraceDelegate::CreateWeakLambda(Owner,
+			[this, Candidate, RequestId = Visibility.RequestId, Observer](const FTraceHandle&, FTraceDatum& TraceDatum)
+		{
+			OnVisibilityTraceCompleted(Candidate, RequestId, Observer, false, TraceDatum);
+		});
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Visibility.Observers[Observer], Visibility.TracedCenter,
+			ECC_Visibility, QueryParams, FCollisionResponseParams::DefaultResponseParam, &Delegate);
+	}
+}
+
+void FTargetSelectionQueries::IssueCornerTraces(const TObjectKey<AActor>& Candidate, FTargetVisibility& Visibility)
+{
+	Visibility.Stage = FTargetVisibility::EStage::WaitingForCorners;
+	Visibility.PendingTraces = FMath::CountBits(Visibility.HiddenObservers) * FTargetVisibility::NumOfCorners;
+
+	//the corners belong to the same bounds as the centers
+	FVector Corners[FTargetVisibility::NumOfCorners];
+	FTargetVisibility::GetCorners(Visibility.TracedCenter, Visibility.TracedExtent, Corners);
+	const FCollisionQueryParams QueryParams = GetQueryParams();
+	for(int32 Observer = 0; Observer < FTargetVisibility::NumOfObservers; Observer++)
+	{
+		//if the center is visible, it doesn't matter whether the corners are
+		if(!(Visibility.HiddenObservers & 1 << Observer)) continue;
+		const FTraceDelegate Delegate = FTraceDelegate::CreateWeakLambda(Owner,
+			[this, Candidate, RequestId = Visibility.RequestId, Observer](const FTraceHandle&, FTraceDatum& TraceDatum)
+		{
+			OnVisibilityTraceCompleted(Candidate, RequestId, Observer, true, TraceDatum);
+		});
+		for(const FVector& Corner : Corners)
+		{
+			GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Visibility.Observers[Observer], Corner,
+				ECC_Visibility, QueryParams, FCollisionResponseParams::DefaultResponseParam, &Delegate);
+		}
+	}
+}
+
+void FTargetSelectionQueries::OnVisibilityTraceCompleted(const TObjectKey<AActor>& Candidate, uint32 RequestId,
+	int32 Observer, bool bIsCorner, const FTraceDatum& TraceDatum)
+{
+	FTargetVisibility* Visibility = Visibilities.Find(Candidate);
+	//the candidate was removed or re-evaluated in the meantime
+	if(Visibility == nullptr || Visibility->RequestId != RequestId) return;
+
+	const bool bIsTraceVisible = IsVisible(Candidate.ResolveObjectPtr(), TraceDatum);
+	if(!bIsCorner && !bIsTraceVisible) Visibility->HiddenObservers |= 1 << Observer;
+	else if(bIsCorner && bIsTraceVisible) Visibility->VisibleCorners[Observer]++;
+	if(--Visibility->PendingTraces > 0) return;
+
+	//the corners are only traced if a center is hidden
+	if(Visibility->Stage == FTargetVisibility::EStage::WaitingForCenters && Visibility->HiddenObservers != 0)
+	{
+		Visibility->Stage = FTargetVisibility::EStage::CornersNeeded;
+		return;
+	}
+	FinishEvaluation(*Visibility);
+}
+
+void FTargetSelectionQueries::FinishEvaluation(FTargetVisibility& Visibility) const
+{
+	Visibility.bIsVisible = true;
+	for(int32 Observer = 0; Observer < FTargetVisibility::NumOfObservers; Observer++)
+	{
+		if(!(Visibility.HiddenObservers & 1 << Observer)) continue;
+		Visibility.bIsVisible &= Visibility.VisibleCorners[Observer] >= FTargetVisibility::RequiredVisibleCorners;
+	}
+	Visibility.Stage = FTargetVisibility::EStage::Idle;
+	Visibility.EvaluatedTime = GetWorld()->GetTimeSeconds();
+}
+
+bool FTargetSelectionQueries::IsVisibleSynchronously(const AActor* Candidate, const FVector& Observer,
+	const FVector& Center, const FVector& Extent) const
+{
+	const FCollisionQueryParams QueryParams = GetQueryParams();
+	FHitResult Hit;
+	if(!GetWorld()->LineTraceSingleByChannel(Hit, Observer, Center, ECC_Visibility, QueryParams) ||
+		Hit.GetActor() == Candidate) return true;
+
+	//if the center is hidden, the candidate is still visible if enough corners are visible
+	FVector Corners[FTargetVisibility::NumOfCorners];
+	FTargetVisibility::GetCorners(Center, Extent, Corners);
+	int32 VisibleCorners = 0;
+	for(const FVector& Corner : Corners)
+	{
+		if(!GetWorld()->LineTraceSingleByChannel(Hit, Observer, Corner, ECC_Visibility, QueryParams) ||
+			Hit.GetActor() == Candidate) VisibleCorners++;
+		if(VisibleCorners >= FTargetVisibility::RequiredVisibleCorners) return true;
+	}
+	return false;
+}
+
+bool FTargetSelectionQueries::IsVisible(const AActor* Candidate, const FTraceDatum& TraceDatum)
+{
+	const FHitResult* Hit = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits);
+	return Hit == nullptr || Hit->GetActor() == Candidate;
+}
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+struct FTraceDatum;
+
+//The visibility of a target candidate from the camera and the character
+struct FTargetVisibility
+{
+	static constexpr int32 NumOfObservers = 2;
+	static constexpr int32 NumOfCorners = 8;
+	//like with the synchronous checks, an actor whose center is hidden counts as visible if enough corners are visible
+	static constexpr int32 RequiredVisibleCorners = 3;
+
+	enum class EStage : uint8
+	{
+		Idle,
+		WaitingForCenters,
+		CornersNeeded,
+		WaitingForCorners
+	};
+
+	FTargetVisibility() : bIsVisible(false), Stage(EStage::Idle), EvaluatedTime(-1.0), LastRequestedTime(0.0),
+		RequestId(0), SynchronousFrame(0), PendingTraces(0), HiddenObservers(0), Center(NAN), Extent(NAN),
+		TracedCenter(NAN), TracedExtent(NAN)
+	{
+		FMemory::Memzero(VisibleCorners);
+	}
+
+	bool bIsVisible;
+	EStage Stage;
+	double EvaluatedTime;
+	double LastRequestedTime;
+	//results of older requests are ignored
+	uint32 RequestId;
+	//the frame in which the visibility was last evaluated synchronously
+	uint64 SynchronousFrame;
+	int32 PendingTraces;
+	//bit i is set if the center isn't visible from observer i
+	uint8 HiddenObservers;
+	int32 VisibleCorners[NumOfObservers];
+	//the bounds of the candidate when it was last requested
+	FVector Center;
+	FVector Extent;
+	//the locations the (current or last) evaluation traces between
+	FVector Observers[NumOfObservers];
+	FVector TracedCenter;
+	FVector TracedExtent;
+
+	static void GetCorners(const FVector& Center, const FVector& Extent, FVector (&Corners)[NumOfCorners]);
+};
+
+/**
+ * Issues the traces needed by the player's target selection as asynchronous queries. The results are available the
+ * frame after they were issued. The visibility of the candidates is cached for a few frames and re-evaluated within a
+ * fixed number of traces per frame. When a selection is requested (e.g. by an attack), the candidates are traced
+ * synchronously instead, as the asynchronous results were traced against the world of an earlier frame (in which
+ * the candidates or the occluders might have been elsewhere). That way, the chosen target is the same as if all traces
+ * had been synchronous.
+ */
+class FTargetSelectionQueries
+{
+public:
+	//the maximal number of visibility traces issued per frame
+	static constexpr int32 TraceBudget = 48;
+	//the time after which the visibility of a candidate is re-evaluated
+	static constexpr double MaxVisibilityAge = 0.1;
+
+	FTargetSelectionQueries() : Owner(nullptr){}
+
+	//The owner (and its owner) are ignored by all traces
+	void Initialize(AActor* NewOwner);
+
+	//Starts searching the candidates within the range and the actor at the center of the view (available next frame)
+	void QueryCandidates(const FVector& EyesLocation, const FVector& ViewDirection, const FVector& CharacterLocation,
+		float Range);
+	//Like QueryCandidates, but the results are available immediately
+	void QueryCandidatesSynchronously(const FVector& EyesLocation, const FVector& ViewDirection,
+		const FVector& CharacterLocation, float Range);
+	const TArray<TWeakObjectPtr<AActor>>& GetCandidates() const { return Candidates; }
+	const AActor* GetCenteredActor() const { return CenteredActor.Get(); }
+
+	//Whether the candidate was visible from both observers (false until it has been evaluated once). Calling this
+	//marks the candidate for re-evaluation
+	bool RequestVisibility(const AActor* Candidate, const FVector& Center, const FVector& Extent);
+	//Like RequestVisibility, but the candidate is traced synchronously unless that already happened this frame (the
+	//result is cached)
+	bool EvaluateVisibility(const AActor* Candidate, const FVector& Center, const FVector& Extent,
+		const FVector& EyesLocation, const FVector& CharacterLocation);
+	//Issues the traces for the requested candidates that need to be re-evaluated, within the trace budget
+	void IssueVisibilityTraces(const FVector& EyesLocation, const FVector& CharacterLocation);
+
+protected:
+	AActor* Owner;
+
+	TArray<TWeakObjectPtr<AActor>> Candidates;
+	//the actors already added to the candidates by the current query
+	TSet<const AActor*> UniqueCandidates;
+	TWeakObjectPtr<AActor> CenteredActor;
+	TMap<TObjectKey<AActor>, FTargetVisibility> Visibilities;
+	//the candidates requested this frame, in request order
+	TArray<TObjectKey<AActor>> RequestedCandidates;
+	//the index into the requested candidates at which the next evaluation starts
+	int32 Cursor = 0;
+	uint32 NextRequestId = 1;
+
+	UWorld* GetWorld() const { return Owner->GetWorld(); }
+	FCollisionQueryParams GetQueryParams() const;
+	//Keeps the first hit of every actor (in the order of the hits, like the synchronous selection)
+	void SetCandidates(const TArray<FHitResult>& Hits);
+	FTargetVisibility& AddRequest(const AActor* Candidate, const FVector& Center, const FVector& Extent);
+	void IssueCenterTraces(const TObjectKey<AActor>& Candidate, FTargetVisibility& Visibility);
+	void IssueCornerTraces(const TObjectKey<AActor>& Candidate, FTargetVisibility& Visibility);
+	void OnVisibilityTraceCompleted(const TObjectKey<AActor>& Candidate, uint32 RequestId, int32 Observer,
+		bool bIsCorner, const FTraceDatum& TraceDatum);
+	void FinishEvaluation(FTargetVisibility& Visibility) const;
+	bool IsVisibleSynchronously(const AActor* Candidate, const FVector& Observer, const FVector& Center,
+		const FVector& Extent) const;
+	static bool IsVisible(const AActor* Candidate, const FTraceDatum& TraceDatum);
+};
@@ -9,10 +9,12 @@
 #include "Utility/Animation/CustomAnimInstance.h"
 #include "Utility/Animation/SuckToTargetComponent.h"
 #include "Utility/Stats/StatusEffect.h"
+#include "Utility/Stats/StatusEffectSubsystem.h"
 
 
 AGeneralCharacter::AGeneralCharacter(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer),
-	bAllowAutomaticOpacityChanges(true), MinimumFadeDistance(100.f), MaximumFadeDistance(150.f), InputFadeStrength(2.f)
+	bAllowAutomaticOpacityChanges(true), MinimumFadeDistance(100.f), MaximumFadeDistance(150.f), InputFadeStrength(2.f),
+	StatusEffectsVersion(0)
 {
 	SuckToTargetComponent = CreateDefaultSubobject<USuckToTargetComponent>(TEXT("SuckToTargetComp"));
 	PrimaryActorTick.bCanEverTick = true;
@@ -169,9 +171,43 @@ void AGeneralCharacter::RemoveStatusEffectInternal(UStatusEffect* StatusEffect)
 {
 	StatusEffect->OnEffectRemoved_Implementation(this);
 	StatusEffect->DestroyComponent();
+	ActiveStatusEffects.RemoveSingle(StatusEffect);
+	UpdateActiveStatusEffectClasses();
 	OnStatusEffectRemoved();
 }
 
+void AGeneralCharacter::UpdateActiveStatusEffectClasses()
+{
+	UStatusEffectSubsystem* StatusEffectSubsystem = GetWorld()->GetSubsystem<UStatusEffectSubsystem>();
+	//effects can share parent classes, so the entries are set again for all remaining effects
+	FMemory::Memzero(ActiveStatusEffectsByClass.GetData(), ActiveStatusEffectsByClass.Num() * sizeof(UStatusEffect*));
+	for(UStatusEffect* StatusEffect : ActiveStatusEffects)
+	{
+		for(const UClass* EffectClass = StatusEffect->GetClass(); EffectClass != nullptr &&
+			EffectClass->IsChildOf(UStatusEffect::StaticClass()); EffectClass = EffectClass->GetSuperClass())
+		{
+			const int32 ClassIndex = StatusEffectSubsystem->GetEffectClassIndex(EffectClass);
+			if(ClassIndex >= ActiveStatusEffectsByClass.Num()) ActiveStatusEffectsByClass.SetNumZeroed(ClassIndex + 1);
+			//the first matching effect is the one that is refreshed or removed
+			if(ActiveStatusEffectsByClass[ClassIndex] == nullptr) ActiveStatusEffectsByClass[ClassIndex] = StatusEffect;
+		}
+	}
+	StatusEffectsVersion++;
+}
+
+UStatusEffect* AGeneralCharacter::FindStatusEffect(const UClass* EffectType) const
+{
+	if(EffectType == nullptr || ActiveStatusEffects.IsEmpty()) return nullptr;
+	const UStatusEffectSubsystem* StatusEffectSubsystem = GetWorld()->GetSubsystem<UStatusEffectSubsystem>();
+	const int32 ClassIndex = StatusEffectSubsystem->FindEffectClassIndex(EffectType);
+	return ActiveStatusEffectsByClass.IsValidIndex(ClassIndex) ? ActiveStatusEffectsByClass[ClassIndex] : nullptr;
+}
+
+bool AGeneralCharacter::HasStatusEffect(TSubclassOf<UStatusEffect> EffectType) const
+{
+	return FindStatusEffect(EffectType) != nullptr;
+}
+
 bool AGeneralCharacter::AreMultipleVisible(AActor* Target, ETraceTypeQuery TraceType, const FVector& TraceStart,
                                            TArray<FVector>& RemainingEnds, int32 RequiredPositiveTests) const
 {
@@ -188,28 +224,28 @@ bool AGeneralCharacter::AreMultipleVisible(AActor* Target, ETraceTypeQuery Trace
 
 void AGeneralCharacter::ReceiveStatusEffect(TSubclassOf<UStatusEffect> NewEffectType)
 {
-	TArray<UActorComponent*> MatchingStatusEffects;
-	GetComponents(NewEffectType, MatchingStatusEffects);
+	UStatusEffect* MatchingStatusEffect = FindStatusEffect(NewEffectType);
 
 	//Re-adding a status effect refreshes only it's duration (but doesn't add the effect twice)
-	if(MatchingStatusEffects.IsEmpty())
+	if(MatchingStatusEffect == nullptr)
 	{
 		UStatusEffect* TargetEffect = NewObject<UStatusEffect>(this, NewEffectType);
 		TargetEffect->RegisterComponent();
+		ActiveStatusEffects.Add(TargetEffect);
+		UpdateActiveStatusEffectClasses();
 		TargetEffect->OnEffectApplied_Implementation(this);
 		OnNewStatusEffectReceived(TargetEffect);
 		return;
 	}
 	
-	CastChecked<UStatusEffect>(MatchingStatusEffects[0])->ForceRestartTimer(FForceStatusEffectTimerRestartKey());
+	MatchingStatusEffect->ForceRestartTimer(FForceStatusEffectTimerRestartKey());
 }
 
 void AGeneralCharacter::RemoveStatusEffect(TSubclassOf<UStatusEffect> EffectType)
 {
-	TArray<UActorComponent*> MatchingStatusEffects;
-	GetComponents(EffectType, MatchingStatusEffects);
-	if(MatchingStatusEffects.IsEmpty()) return;
-	RemoveStatusEffectInternal(CastChecked<UStatusEffect>(MatchingStatusEffects[0]));
+	UStatusEffect* MatchingStatusEffect = FindStatusEffect(EffectType);
+	if(MatchingStatusEffect == nullptr) return;
+	RemoveStatusEffectInternal(MatchingStatusEffect);
 }
 
 
@@ -64,6 +64,12 @@ public:
 	void ReceiveStatusEffectExternal(TSubclassOf<UStatusEffect> NewEffectType, FModifyCharacterStatusEffectKey){ ReceiveStatusEffect(NewEffectType); }
 	void RemoveStatusEffectExternal(UStatusEffect* StatusEffect, FModifyCharacterStatusEffectKey){ RemoveStatusEffectInternal(StatusEffect); }
 
+	//Whether an effect of the given type (or a subclass of it) is active
+	bool HasStatusEffect(TSubclassOf<UStatusEffect> EffectType) const;
+	const TArray<UStatusEffect*>& GetActiveStatusEffects() const { return ActiveStatusEffects; }
+	//Changes whenever an effect is added or removed, so caches depending on the active effects know when to update
+	uint32 GetStatusEffectsVersion() const { return StatusEffectsVersion; }
+
 #if WITH_EDITORONLY_DATA
 	void SetIsDebugging(bool IsDebugging);
 	bool GetIsDebugging() const { return bIsDebugging; }
@@ -93,6 +99,13 @@ protected:
 	UPROPERTY(EditAnywhere, Category = Animation)
 	USuckToTargetComponent* SuckToTargetComponent;
 
+	UPROPERTY()
+	TArray<UStatusEffect*> ActiveStatusEffects;
+	//indexed by the effect class index (see UStatusEffectSubsystem::GetEffectClassIndex), the first active effect
+	//of the class or one of its child classes (nullptr if there is none)
+	TArray<UStatusEffect*> ActiveStatusEffectsByClass;
+	uint32 StatusEffectsVersion;
+
 
 	virtual void BeginPlay() override;
 
@@ -106,6 +119,9 @@ protected:
 	virtual void OnNewStatusEffectReceived(UStatusEffect* StatusEffect){}
 	virtual void OnStatusEffectRemoved(){}
 	void RemoveStatusEffectInternal(UStatusEffect* StatusEffect);
+	void UpdateActiveStatusEffectClasses();
+	//the first active effect of the given class or one of its child classes
+	UStatusEffect* FindStatusEffect(const UClass* EffectType) const;
 	
 	bool AreMultipleVisible(AActor* Target, ETraceTypeQuery TraceType, const FVector& TraceStart,
 							TArray<FVector>& RemainingEnds, int32 RequiredPositiveTests) const;
@@ -0,0 +1,55 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Tests/AutomationTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Components/BoxComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+FAutomationTestWorld::FAutomationTestWorld() : PreviousWorld(GWorld)
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("AutomationTestWorld"), nullptr, true,
+		ERHIFeatureLevel::Num, &UWorld::InitializationValues().AllowAudioPlayback(false).CreatePhysicsScene(true)
+		.CreateNavigation(false).CreateAISystem(false).ShouldSimulatePhysics(false).EnableTraceCollision(true));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	GWorld = World;
+
+	const FURL URL;
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+	//without a game mode, nothing else starts the play of the actors
+	World->GetWorldSettings()->NotifyBeginPlay();
+}
+
+FAutomationTestWorld::~FAutomationTestWorld()
+{
+	World->EndPlay(EEndPlayReason::Quit);
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	GWorld = PreviousWorld;
+}
+
+void FAutomationTestWorld::Tick(float DeltaTime)
+{
+	World->Tick(LEVELTICK_All, DeltaTime);
+	GFrameCounter++;
+}
+
+AActor* FAutomationTestWorld::SpawnBlockingBox(const FVector& Location, const FVector& Extent) const
+{
+	AActor* Actor = World->SpawnActor<AActor>(Location, FRotator::ZeroRotator);
+	UBoxComponent* Box = NewObject<UBoxComponent>(Actor);
+	Box->SetBoxExtent(Extent, false);
+	Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Actor->SetRootComponent(Box);
+	Box->RegisterComponent();
+	Actor->SetActorLocation(Location);
+	return Actor;
+}
+
+#endif
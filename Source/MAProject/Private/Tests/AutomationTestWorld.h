@@ -0,0 +1,34 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * A game world without a map or game mode for headless automation tests (also runs with -nullrhi). The world has
+ * begun play, so spawned actors and the world subsystems behave like during a game. Destroyed with the object.
+ */
+class FAutomationTestWorld
+{
+public:
+	FAutomationTestWorld();
+	~FAutomationTestWorld();
+
+	FAutomationTestWorld(const FAutomationTestWorld&) = delete;
+	FAutomationTestWorld& operator=(const FAutomationTestWorld&) = delete;
+
+	UWorld* Get() const { return World; }
+	//Ticks the world as a frame of the game would (including the asynchronous traces)
+	void Tick(float DeltaTime = 1.f/60.f);
+
+	//Spawns an actor whose root is a box blocking all channels
+	AActor* SpawnBlockingBox(const FVector& Location, const FVector& Extent) const;
+
+protected:
+	UWorld* World;
+	UWorld* PreviousWorld;
+};
+
+#endif
@@ -0,0 +1,140 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Tests/AutomationTestWorld.h"
+#include "Utility/Animation/FootstepSurfaceSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FootstepSurfaceTests
+{
+	//the sockets and scan lengths of the footstep notifies (sound and AI noise) of both feet
+	const FName FootSockets[] = {TEXT("foot_l"), TEXT("foot_r")};
+	constexpr float ScanLengths[] = {150.f, 200.f};
+
+	void SetSurfaceType(UPrimitiveComponent* Floor, EPhysicalSurface SurfaceType)
+	{
+		UPhysicalMaterial* PhysicalMaterial = NewObject<UPhysicalMaterial>(Floor);
+		PhysicalMaterial->SurfaceType = SurfaceType;
+		Floor->SetPhysMaterialOverride(PhysicalMaterial);
+	}
+
+	//Spawns a floor whose physical material has the surface type
+	UPrimitiveComponent* SpawnFloor(const FAutomationTestWorld& TestWorld, const FVector& Location,
+		const FVector& Extent, EPhysicalSurface SurfaceType)
+	{
+		UPrimitiveComponent* Floor = CastChecked<UPrimitiveComponent>(
+			TestWorld.SpawnBlockingBox(Location, Extent)->GetRootComponent());
+		SetSurfaceType(Floor, SurfaceType);
+		return Floor;
+	}
+
+	//Walks the character along the X axis and returns the surface below it afterwards
+	EPhysicalSurface Walk(FAutomationTestWorld& TestWorld, ACharacter* Character, int32 Frames)
+	{
+		for(int32 Frame = 0; Frame < Frames; Frame++)
+		{
+			Character->AddMovementInput(FVector::ForwardVector, 1.f, true);
+			TestWorld.Tick();
+			//the notifies keep using the surface in between
+			UFootstepSurfaceSubsystem::FindFloor(Character->GetMesh(), FootSockets[Frame % 2], ScanLengths[0]);
+		}
+		return UFootstepSurfaceSubsystem::FindFloor(Character->GetMesh(), FootSockets[0], ScanLengths[0]).SurfaceType;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFootstepSurfaceCrowdTest, "MAProject.Animation.FootstepSurface.Crowd",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FFootstepSurfaceCrowdTest::RunTest(const FString& Parameters)
+{
+	using namespace FootstepSurfaceTests;
+	FAutomationTestWorld TestWorld;
+	SpawnFloor(TestWorld, FVector(0.0, 0.0, -10.0), FVector(5000.0, 5000.0, 10.0), SurfaceType1);
+
+	//a crowd of 100 characters walking in circles
+	constexpr uint32 NumOfCharacters = 100;
+	constexpr int32 WarmupFrames = 30;
+	constexpr int32 Frames = 150;
+	TArray<ACharacter*> Characters;
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	for(uint32 i = 0; i < NumOfCharacters; i++)
+	{
+		const FVector Location(i % 10 * 300.0 - 1500.0, i / 10 * 300.0 - 1500.0, 100.0);
+		ACharacter* Character = TestWorld.Get()->SpawnActor<ACharacter>(Location, FRotator::ZeroRotator,
+			SpawnParameters);
+		if(!TestNotNull(TEXT("Character"), Character)) return false;
+		//the floor scans shouldn't hit the character itself
+		Character->GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
+		Character->GetCharacterMovement()->bRunPhysicsWithNoController = true;
+		Character->GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+		Characters.Add(Character);
+	}
+
+	//the shared scans and surfaces answer every notify like a scan of its own would
+	for(int32 Frame = 0; Frame < Frames; Frame++)
+	{
+		TestWorld.Tick();
+		for(ACharacter* Character : Characters)
+		{
+			Character->AddMovementInput(FRotator(0.0, Frame * 6.0, 0.0).Vector(), 1.f, true);
+			for(const FName Socket : FootSockets)
+			{
+				for(const float ScanLength : ScanLengths)
+				{
+					const FFootstepFloor Floor = UFootstepSurfaceSubsystem::FindFloor(Character->GetMesh(), Socket,
+						ScanLength);
+					if(Frame < WarmupFrames) continue;
+					const FVector Foot = Character->GetMesh()->GetComponentLocation();
+					if(!Floor.bHasFloor || Floor.SurfaceType != SurfaceType1 ||
+						!Floor.Location.Equals(FVector(Foot.X, Foot.Y, 0.0), 0.1) ||
+						!FMath::IsNearlyEqual(Floor.Distance, Foot.Z, 0.1))
+					{
+						AddError(FString::Printf(TEXT("A character at %s found %s in frame %d"), *Foot.ToString(),
+							Floor.bHasFloor ? *Floor.Location.ToString() : TEXT("no floor"), Frame));
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFootstepSurfaceMaterialsTest, "MAProject.Animation.FootstepSurface.Materials",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FFootstepSurfaceMaterialsTest::RunTest(const FString& Parameters)
+{
+	using namespace FootstepSurfaceTests;
+	FAutomationTestWorld TestWorld;
+	//stone below x < 0 and grass above
+	SpawnFloor(TestWorld, FVector(-2000.0, 0.0, -10.0), FVector(2000.0, 500.0, 10.0), SurfaceType1);
+	UPrimitiveComponent* Grass = SpawnFloor(TestWorld, FVector(2000.0, 0.0, -10.0), FVector(2000.0, 500.0, 10.0),
+		SurfaceType2);
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	ACharacter* Character = TestWorld.Get()->SpawnActor<ACharacter>(FVector(-400.0, 0.0, 100.0),
+		FRotator::ZeroRotator, SpawnParameters);
+	if(!TestNotNull(TEXT("Character"), Character)) return false;
+	Character->GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
+	Character->GetCharacterMovement()->bRunPhysicsWithNoController = true;
+	Character->GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+
+	TestEqual(TEXT("Surface on the first floor"), Walk(TestWorld, Character, 30), SurfaceType1);
+	TestEqual(TEXT("Surface after stepping onto the second floor"), Walk(TestWorld, Character, 60), SurfaceType2);
+	TestTrue(TEXT("The character is on the second floor"), Character->GetActorLocation().X > 100.0);
+	//like another layer of a landscape, the same component has another material further ahead
+	SetSurfaceType(Grass, SurfaceType1);
+	TestEqual(TEXT("Surface after walking on within the same floor"), Walk(TestWorld, Character, 60),
+		SurfaceType1);
+	return true;
+}
+
+#endif
@@ -0,0 +1,156 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Math/InverseRotationMatrix.h"
+#include "Math/PerspectiveMatrix.h"
+#include "Math/TranslationMatrix.h"
+#include "Tests/AutomationTestWorld.h"
+#include "UserInterface/StatsMonitorBaseWidget.h"
+#include "UserInterface/HUD/Worldspace/HealthBarSubsystem.h"
+#include "UserInterface/HUD/Worldspace/PlayerFacingWidgetComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HealthBarTests
+{
+	//a camera with a horizontal field of view of 90 degrees
+	FHealthBarView MakeView(const FVector& Location, const FRotator& Rotation, const FIntRect& ViewRect)
+	{
+		const FMatrix ViewRotationMatrix = FInverseRotationMatrix(Rotation) * FMatrix(FPlane(0, 0, 1, 0),
+			FPlane(1, 0, 0, 0), FPlane(0, 1, 0, 0), FPlane(0, 0, 0, 1));
+		const FMatrix ProjectionMatrix = FReversedZPerspectiveMatrix(UE_HALF_PI / 2.0, ViewRect.Width(),
+			ViewRect.Height(), 10.0);
+		return FHealthBarView(Location, FTranslationMatrix(-Location) * ViewRotationMatrix * ProjectionMatrix,
+			ViewRect);
+	}
+
+	//Spawns an opponent stand-in with a health bar, which registers itself with the subsystem
+	UPlayerFacingWidgetComponent* SpawnBar(const FAutomationTestWorld& TestWorld, const FVector& Location,
+		bool bIsRendered = true)
+	{
+		AActor* Owner = TestWorld.SpawnBlockingBox(Location, FVector(35.0, 35.0, 90.0));
+		UPlayerFacingWidgetComponent* Component = NewObject<UPlayerFacingWidgetComponent>(Owner);
+		Component->SetWidgetClass(UStatsMonitorBaseWidget::StaticClass());
+		Component->SetupAttachment(Owner->GetRootComponent());
+		Component->RegisterComponent();
+		if(bIsRendered) Component->SetLastRenderTime(static_cast<float>(TestWorld.Get()->GetTimeSeconds()));
+		return Component;
+	}
+
+	const FHealthBarState* FindBar(const UHealthBarSubsystem* Subsystem, float HealthRatio)
+	{
+		return Subsystem->GetDisplayedBars().FindByPredicate(
+			[HealthRatio](const FHealthBarState& Bar){ return Bar.HealthRatio == HealthRatio; });
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHealthBarDisplayTest, "MAProject.UserInterface.HealthBars.Display",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHealthBarDisplayTest::RunTest(const FString& Parameters)
+{
+	using namespace HealthBarTests;
+	FAutomationTestWorld TestWorld;
+	UHealthBarSubsystem* Subsystem = TestWorld.Get()->GetSubsystem<UHealthBarSubsystem>();
+	if(!TestNotNull(TEXT("Health bar subsystem"), Subsystem)) return false;
+
+	//every bar has its own health ratio, so it can be found among the displayed bars
+	const UPlayerFacingWidgetComponent* Ahead = SpawnBar(TestWorld, FVector(500.0, 0.0, 0.0));
+	const UPlayerFacingWidgetComponent* Offset = SpawnBar(TestWorld, FVector(500.0, 250.0, 100.0));
+	const UPlayerFacingWidgetComponent* Behind = SpawnBar(TestWorld, FVector(-500.0, 0.0, 0.0));
+	const UPlayerFacingWidgetComponent* TooFar = SpawnBar(TestWorld, FVector(100000.0, 0.0, 0.0));
+	const UPlayerFacingWidgetComponent* Hidden = SpawnBar(TestWorld, FVector(800.0, -200.0, 0.0), false);
+	const UPlayerFacingWidgetComponent* Defeated = SpawnBar(TestWorld, FVector(600.0, 100.0, 0.0));
+	Subsystem->SetRatios(Ahead, 0.9f, 0.5f);
+	Subsystem->SetRatios(Offset, 0.8f, 0.25f);
+	Subsystem->SetRatios(Behind, 0.7f, 1.f);
+	Subsystem->SetRatios(TooFar, 0.6f, 1.f);
+	Subsystem->SetRatios(Hidden, 0.5f, 1.f);
+	Subsystem->SetRatios(Defeated, 0.f, 1.f);
+
+	//the positions are relative to the view rectangle, wherever it is on the screen
+	for(const FIntRect& ViewRect : {FIntRect(0, 0, 1920, 1080), FIntRect(100, 50, 2020, 1130)})
+	{
+		Subsystem->CollectDisplayedBars(MakeView(FVector::ZeroVector, FRotator::ZeroRotator, ViewRect));
+		TestEqual(TEXT("Displayed bars"), Subsystem->GetDisplayedBars().Num(), 2);
+		const FHealthBarState* AheadBar = FindBar(Subsystem, 0.9f);
+		const FHealthBarState* OffsetBar = FindBar(Subsystem, 0.8f);
+		if(!TestNotNull(TEXT("Bar ahead"), AheadBar) || !TestNotNull(TEXT("Offset bar"), OffsetBar)) return false;
+		TestEqual(TEXT("Bar ahead position"), AheadBar->ScreenPosition, FVector2D(960.0, 540.0), 0.01f);
+		TestEqual(TEXT("Bar ahead toughness"), AheadBar->ToughnessRatio, 0.5f);
+		TestEqual(TEXT("Offset bar position"), OffsetBar->ScreenPosition, FVector2D(1440.0, 348.0), 0.01f);
+		TestEqual(TEXT("Offset bar toughness"), OffsetBar->ToughnessRatio, 0.25f);
+	}
+
+	//the remaining bars still receive their values once another bar is unregistered
+	Subsystem->Unregister(Ahead);
+	Subsystem->SetRatios(Offset, 0.75f, 0.125f);
+	Subsystem->SetRatios(Defeated, 0.4f, 0.5f);
+	Subsystem->CollectDisplayedBars(MakeView(FVector::ZeroVector, FRotator::ZeroRotator, FIntRect(0, 0, 1920, 1080)));
+	TestEqual(TEXT("Displayed bars after unregistering"), Subsystem->GetDisplayedBars().Num(), 2);
+	TestNull(TEXT("Unregistered bar"), FindBar(Subsystem, 0.9f));
+	const FHealthBarState* OffsetBar = FindBar(Subsystem, 0.75f);
+	const FHealthBarState* RevivedBar = FindBar(Subsystem, 0.4f);
+	if(!TestNotNull(TEXT("Updated offset bar"), OffsetBar) || !TestNotNull(TEXT("Revived bar"), RevivedBar))
+		return false;
+	TestEqual(TEXT("Updated offset bar toughness"), OffsetBar->ToughnessRatio, 0.125f);
+	TestEqual(TEXT("Revived bar position"), RevivedBar->ScreenPosition, FVector2D(1120.0, 540.0), 0.01f);
+
+	//turning the camera around shows the bar that was behind it
+	Subsystem->CollectDisplayedBars(MakeView(FVector::ZeroVector, FRotator(0.0, 180.0, 0.0),
+		FIntRect(0, 0, 1920, 1080)));
+	const FHealthBarState* BehindBar = FindBar(Subsystem, 0.7f);
+	if(!TestNotNull(TEXT("Bar behind"), BehindBar)) return false;
+	TestEqual(TEXT("Bar behind position"), BehindBar->ScreenPosition, FVector2D(960.0, 540.0), 0.01f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHealthBarBenchmark, "MAProject.UserInterface.HealthBars.Benchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FHealthBarBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace HealthBarTests;
+	constexpr int32 Counts[] = {25, 50, 100, 200, 400, 800};
+	constexpr int32 Frames = 200;
+	for(const int32 Count : Counts)
+	{
+		FAutomationTestWorld TestWorld;
+		UHealthBarSubsystem* Subsystem = TestWorld.Get()->GetSubsystem<UHealthBarSubsystem>();
+		TArray<UPlayerFacingWidgetComponent*> Components;
+		for(int32 i = 0; i < Count; i++)
+		{
+			//a crowd in front of the camera, partly beyond the distance at which the bars are culled
+			const double Angle = FMath::DegreesToRadians(-60.0 + 120.0 * i / Count);
+			const double Distance = 300.0 + 4000.0 * (i % 17) / 16.0;
+			Components.Add(SpawnBar(TestWorld, FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * Distance));
+		}
+
+		uint64 CollectCycles = 0;
+		uint64 SetRatiosCycles = 0;
+		for(int32 Frame = 0; Frame < Frames; Frame++)
+		{
+			//about a tenth of the opponents take damage each frame
+			const uint64 SetRatiosStart = FPlatformTime::Cycles64();
+			for(int32 i = Frame % 10; i < Count; i += 10)
+			{
+				Subsystem->SetRatios(Components[i], 1.f - static_cast<float>(Frame) / Frames, 1.f);
+			}
+			SetRatiosCycles += FPlatformTime::Cycles64() - SetRatiosStart;
+
+			const FHealthBarView View = MakeView(FVector(0.0, 0.0, 150.0), FRotator(-5.0, Frame * 0.1, 0.0),
+				FIntRect(0, 0, 1920, 1080));
+			const uint64 CollectStart = FPlatformTime::Cycles64();
+			Subsystem->CollectDisplayedBars(View);
+			CollectCycles += FPlatformTime::Cycles64() - CollectStart;
+		}
+		const double CollectMicroseconds = FPlatformTime::ToMilliseconds64(CollectCycles) * 1000.0 / Frames;
+		AddInfo(FString::Printf(TEXT("%d opponents: %.2f us per frame for culling and projection (%.3f us per "
+			"opponent), %.2f us for setting the ratios, %d bars displayed"), Count, CollectMicroseconds,
+			CollectMicroseconds / Count, FPlatformTime::ToMilliseconds64(SetRatiosCycles) * 1000.0 / Frames,
+			Subsystem->GetDisplayedBars().Num()));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,147 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "Tests/AutomationTestWorld.h"
+#include "Utility/Animation/NiagaraEffectPoolSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NiagaraEffectPoolTests
+{
+	//the effect of the fighters getting hit, which has a base color parameter
+	const TCHAR* HitEffectPath = TEXT("/Game/Characters/Fighters/Attacks/FX/Templates/Hit_NS.Hit_NS");
+
+	struct FLiveEffect
+	{
+		UNiagaraComponent* Component;
+		int32 FinishFrame;
+	};
+
+	//Finishes the effect like the system instances of the engine do once they are complete
+	void Finish(UNiagaraComponent* Component)
+	{
+		Component->DeactivateImmediate();
+		Component->OnSystemFinished.Broadcast(Component);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraEffectPoolReuseTest, "MAProject.Effects.NiagaraEffectPool.Reuse",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FNiagaraEffectPoolReuseTest::RunTest(const FString& Parameters)
+{
+	using namespace NiagaraEffectPoolTests;
+	UNiagaraSystem* HitEffect = LoadObject<UNiagaraSystem>(nullptr, HitEffectPath);
+	if(!TestNotNull(TEXT("Hit effect"), HitEffect)) return false;
+	const FNiagaraEffectParameter BaseColor(HitEffect, FNiagaraTypeDefinition::GetColorDef(), "BaseColor");
+	if(!TestTrue(TEXT("Hit effect has a base color"), BaseColor.bExists)) return false;
+	const FLinearColor DefaultColor = HitEffect->GetExposedParameters().GetParameterValue<FLinearColor>(
+		BaseColor.Variable);
+
+	FAutomationTestWorld TestWorld;
+	UNiagaraEffectPoolSubsystem* EffectPool = TestWorld.Get()->GetSubsystem<UNiagaraEffectPoolSubsystem>();
+	if(!TestNotNull(TEXT("Effect pool"), EffectPool)) return false;
+	const AActor* Target = TestWorld.SpawnBlockingBox(FVector(100.0, 0.0, 0.0), FVector(35.0, 35.0, 90.0));
+
+	UNiagaraComponent* Attached = EffectPool->SpawnAttached(HitEffect, Target->GetRootComponent(), NAME_None,
+		FVector(0.0, 0.0, 50.0), FRotator::ZeroRotator, FVector(2.0), EAttachLocation::KeepRelativeOffset);
+	if(!TestNotNull(TEXT("Attached effect"), Attached)) return false;
+	BaseColor.Set(Attached, FLinearColor::Red);
+	TestEqual(TEXT("Attached effect parent"), Attached->GetAttachParent(), Target->GetRootComponent());
+	TestEqual(TEXT("Attached effect location"), Attached->GetComponentLocation(), FVector(100.0, 0.0, 50.0));
+	TestEqual(TEXT("Attached effect scale"), Attached->GetComponentScale(), FVector(2.0));
+	TestEqual(TEXT("Attached effect color"), Attached->GetOverrideParameters().GetParameterValue<FLinearColor>(
+		BaseColor.Variable), FLinearColor::Red);
+	TestTrue(TEXT("Attached effect is active"), Attached->IsActive());
+
+	//the finished component is spawned again, but without anything left over from its previous use
+	Finish(Attached);
+	TestNull(TEXT("Finished effect parent"), Attached->GetAttachParent());
+	UNiagaraComponent* Placed = EffectPool->SpawnAtLocation(HitEffect, FVector(-300.0, 200.0, 0.0),
+		FRotator(0.0, 90.0, 0.0), FVector::OneVector);
+	TestEqual(TEXT("Reused component"), Placed, Attached);
+	if(!TestNotNull(TEXT("Placed effect"), Placed)) return false;
+	TestNull(TEXT("Placed effect parent"), Placed->GetAttachParent());
+	TestEqual(TEXT("Placed effect location"), Placed->GetComponentLocation(), FVector(-300.0, 200.0, 0.0));
+	TestEqual(TEXT("Placed effect rotation"), Placed->GetComponentRotation(), FRotator(0.0, 90.0, 0.0));
+	TestEqual(TEXT("Placed effect scale"), Placed->GetComponentScale(), FVector::OneVector);
+	TestEqual(TEXT("Placed effect color"), Placed->GetOverrideParameters().GetParameterValue<FLinearColor>(
+		BaseColor.Variable), DefaultColor);
+	TestTrue(TEXT("Placed effect is active"), Placed->IsActive());
+
+	//moving the target mustn't move an effect that was attached to it before
+	TestWorld.Tick();
+	Target->GetRootComponent()->SetWorldLocation(FVector(500.0, 0.0, 0.0));
+	TestEqual(TEXT("Placed effect location after moving the previous parent"), Placed->GetComponentLocation(),
+		FVector(-300.0, 200.0, 0.0));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraEffectPoolHitStormTest, "MAProject.Effects.NiagaraEffectPool.HitStorm",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FNiagaraEffectPoolHitStormTest::RunTest(const FString& Parameters)
+{
+	using namespace NiagaraEffectPoolTests;
+	UNiagaraSystem* HitEffect = LoadObject<UNiagaraSystem>(nullptr, HitEffectPath);
+	if(!TestNotNull(TEXT("Hit effect"), HitEffect)) return false;
+
+	FAutomationTestWorld TestWorld;
+	UNiagaraEffectPoolSubsystem* EffectPool = TestWorld.Get()->GetSubsystem<UNiagaraEffectPoolSubsystem>();
+	if(!TestNotNull(TEXT("Effect pool"), EffectPool)) return false;
+	const AActor* Target = TestWorld.SpawnBlockingBox(FVector::ZeroVector, FVector(35.0, 35.0, 90.0));
+
+	//six hits per frame (half of them attached to the target), each effect lasting 20 frames
+	constexpr int32 WarmupFrames = 40;
+	constexpr int32 Frames = 400;
+	constexpr int32 HitsPerFrame = 6;
+	constexpr int32 EffectFrames = 20;
+	TArray<FLiveEffect> LiveEffects;
+	//once the warm-up is over, every hit reuses one of the components spawned during it
+	TSet<const UNiagaraComponent*> WarmupComponents;
+	int32 NumOfNewComponents = 0;
+	FRandomStream RandomStream(42);
+	for(int32 Frame = 0; Frame < Frames; Frame++)
+	{
+		for(int32 i = LiveEffects.Num() - 1; i >= 0; i--)
+		{
+			if(LiveEffects[i].FinishFrame > Frame) continue;
+			UNiagaraComponent* Component = LiveEffects[i].Component;
+			LiveEffects.RemoveAtSwap(i, 1, false);
+			Finish(Component);
+			if(Component->GetAttachParent() != nullptr) AddError(TEXT("A finished effect is still attached"));
+		}
+
+		for(int32 Hit = 0; Hit < HitsPerFrame; Hit++)
+		{
+			const FVector Location = RandomStream.VRand() * 100.0;
+			const bool bIsAttached = Hit % 2 == 1;
+			UNiagaraComponent* Component = bIsAttached ?
+				EffectPool->SpawnAttached(HitEffect, Target->GetRootComponent(), NAME_None, Location,
+					FRotator::ZeroRotator, FVector::OneVector, EAttachLocation::KeepRelativeOffset) :
+				EffectPool->SpawnAtLocation(HitEffect, Location, FRotator::ZeroRotator, FVector::OneVector);
+			if(!TestNotNull(TEXT("Spawned effect"), Component)) return false;
+			if(!Component->IsActive()) AddError(TEXT("A spawned effect isn't active"));
+			if(!Component->GetComponentLocation().Equals(Location))
+			{
+				AddError(FString::Printf(TEXT("An effect spawned at %s is at %s"), *Location.ToString(),
+					*Component->GetComponentLocation().ToString()));
+			}
+			if((Component->GetAttachParent() == Target->GetRootComponent()) != bIsAttached)
+			{
+				AddError(TEXT("A spawned effect has the wrong parent"));
+			}
+			if(Frame < WarmupFrames) WarmupComponents.Add(Component);
+			else if(!WarmupComponents.Contains(Component)) NumOfNewComponents++;
+			LiveEffects.Add({Component, Frame + EffectFrames});
+		}
+		TestWorld.Tick();
+	}
+
+	TestEqual(TEXT("Components first spawned after the warm-up"), NumOfNewComponents, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,87 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Components/Image.h"
+#include "Components/TextBlock.h"
+#include "Materials/Material.h"
+#include "Tests/AutomationTestWorld.h"
+#include "UserInterface/HUD/Playerscreen/PlayerStatsMonitorBaseWidget.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PlayerStatsMonitorTests
+{
+	UImage* CreateCdImage(UUserWidget* Widget)
+	{
+		UImage* Image = NewObject<UImage>(Widget);
+		Image->SetBrushFromMaterial(UMaterial::GetDefaultMaterial(MD_Surface));
+		return Image;
+	}
+
+	bool IsShown(const UTextBlock* Text)
+	{
+		return Text->GetVisibility() != ESlateVisibility::Hidden;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlayerStatsMonitorCooldownTest, "MAProject.UserInterface.PlayerStatsMonitor.Cooldown",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPlayerStatsMonitorCooldownTest::RunTest(const FString& Parameters)
+{
+	using namespace PlayerStatsMonitorTests;
+	FAutomationTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+	UPlayerStatsMonitorBaseWidget* Widget = CreateWidget<UPlayerStatsMonitorBaseWidget>(World);
+	if(!TestNotNull(TEXT("Widget"), Widget)) return false;
+	Widget->HealthText = NewObject<UTextBlock>(Widget);
+	Widget->SkillCdTime = NewObject<UTextBlock>(Widget);
+	Widget->UltimateCdTime = NewObject<UTextBlock>(Widget);
+	Widget->SkillCdPercentage = CreateCdImage(Widget);
+	Widget->UltimateCdPercentage = CreateCdImage(Widget);
+
+	const double SkillReadyTime = World->GetTimeSeconds() + 2.0;
+	Widget->SetTotalSkillCdTime(2.f);
+	Widget->SetTotalUltimateCdTime(10.f);
+	Widget->SetSkillCdReadyTime(SkillReadyTime);
+	TestTrue(TEXT("Skill cooldown shown"), IsShown(Widget->SkillCdTime));
+	TestEqual(TEXT("Skill cooldown text"), Widget->SkillCdTime->GetText().ToString(), FString(TEXT("2.0")));
+	TestFalse(TEXT("Ultimate cooldown shown without a ready time"), IsShown(Widget->UltimateCdTime));
+	//changing the total cooldown only changes the percentage
+	Widget->SetTotalSkillCdTime(3.f);
+	TestEqual(TEXT("Skill cooldown text after changing the total cooldown"),
+		Widget->SkillCdTime->GetText().ToString(), FString(TEXT("2.0")));
+
+	//the text shows the remaining time rounded down to tenths in every frame, without the widget ticking
+	for(int32 Frame = 0; Frame < 150; Frame++)
+	{
+		TestWorld.Tick();
+		const double Remaining = SkillReadyTime - World->GetTimeSeconds();
+		if(Remaining <= 0.0)
+		{
+			if(IsShown(Widget->SkillCdTime)) AddError(FString::Printf(TEXT("Skill cooldown shown in frame %d"),
+				Frame));
+			continue;
+		}
+		const FString Text = Widget->SkillCdTime->GetText().ToString();
+		const double Displayed = FCString::Atod(*Text);
+		if(!IsShown(Widget->SkillCdTime) || Displayed > Remaining + 0.001 || Displayed + 0.1 < Remaining - 0.001)
+		{
+			AddError(FString::Printf(TEXT("Skill cooldown shows \"%s\" with %.3f seconds remaining in frame %d"),
+				*Text, Remaining, Frame));
+		}
+	}
+	TestFalse(TEXT("Skill cooldown shown once it is over"), IsShown(Widget->SkillCdTime));
+
+	//a new ready time replaces the displayed cooldown right away
+	Widget->SetUltimateCdReadyTime(World->GetTimeSeconds() + 10.0);
+	TestTrue(TEXT("Ultimate cooldown shown"), IsShown(Widget->UltimateCdTime));
+	TestEqual(TEXT("Ultimate cooldown text"), Widget->UltimateCdTime->GetText().ToString(), FString(TEXT("10.0")));
+	Widget->SetUltimateCdReadyTime(-1.0);
+	TestFalse(TEXT("Ultimate cooldown shown after resetting it"), IsShown(Widget->UltimateCdTime));
+	TestWorld.Tick(1.f);
+	TestFalse(TEXT("Ultimate cooldown shown after the steps of the reset cooldown"), IsShown(Widget->UltimateCdTime));
+	return !HasAnyErrors();
+}
+
+#endif
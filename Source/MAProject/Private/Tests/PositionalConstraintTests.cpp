@@ -0,0 +1,162 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Utility/NonPlayerFunctionality/PositionalConstraint.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PositionalConstraintTests
+{
+	//The sample point lookup from before the circle offsets were introduced (searching the circle of every point).
+	//The current lookup has to give bit for bit identical results, so the tuning of the constraints carries over
+	FVector GetSearchedSamplePoint(const FCircularPointsGenerator& Generator, uint64 Index)
+	{
+		uint64 CurrentCircleIndex = 0;
+		uint64 IndicesRemaining = Index;
+		uint64 PointsOnCurrentCircle = 0;
+		for(uint64 i = 0; i < Index; i++)
+		{
+			PointsOnCurrentCircle = ceil(Generator.Density * (DOUBLE_TWO_PI * (Generator.MinimalLength +
+				static_cast<double>(i) / Generator.Density)));
+			if(IndicesRemaining >= PointsOnCurrentCircle)
+			{
+				IndicesRemaining -= PointsOnCurrentCircle;
+				continue;
+			}
+			CurrentCircleIndex = i;
+			break;
+		}
+
+		const double Radius = Generator.MinimalLength + static_cast<double>(CurrentCircleIndex) / Generator.Density;
+		const double RadiansPerStep = PointsOnCurrentCircle == 0 ? 0.0 :
+			DOUBLE_TWO_PI/static_cast<double>(PointsOnCurrentCircle);
+		const double RotationAmount = RadiansPerStep * ceil(static_cast<double>(IndicesRemaining)/2.0) *
+			(IndicesRemaining & 0b1 ? -1.0 : 1.0);
+		return Generator.SourcePoint + (Generator.StartDirection * Radius).RotateAngleAxisRad(RotationAmount,
+			FVector(0.f, 0.f, 1.f));
+	}
+
+	struct FGeneratorSetup
+	{
+		float MinRadius;
+		float MaxRadius;
+		float Density;
+	};
+
+	//the densities of active (0.05) and passive (0.001) opponents over typical radii, as well as some extreme cases
+	constexpr FGeneratorSetup GeneratorSetups[] = {
+		{200.f, 300.f, 0.05f},
+		{150.f, 700.f, 0.05f},
+		{400.f, 1500.f, 0.001f},
+		{0.f, 2000.f, 0.001f},
+		{0.f, 400.f, 0.05f},
+		{1000.f, 5000.f, 0.01f}
+	};
+
+	FCircularPointsGenerator CreateGenerator(const FGeneratorSetup& Setup)
+	{
+		FCircularPointsGenerator Generator;
+		Generator.SetProperties(FVector(120.0, -40.0, 90.0), FVector(1.0, 0.5, 0.0), Setup.MinRadius,
+			Setup.MaxRadius, Setup.Density);
+		return Generator;
+	}
+
+	FString DescribeSetup(const FGeneratorSetup& Setup)
+	{
+		return FString::Printf(TEXT("radius %.0f - %.0f, density %.3f"), Setup.MinRadius, Setup.MaxRadius, Setup.Density);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCircularPointsGeneratorSamplingOrderTest,
+	"MAProject.AI.CircularPointsGenerator.SamplingOrder",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCircularPointsGeneratorSamplingOrderTest::RunTest(const FString& Parameters)
+{
+	using namespace PositionalConstraintTests;
+	for(const FGeneratorSetup& Setup : GeneratorSetups)
+	{
+		const FCircularPointsGenerator Generator = CreateGenerator(Setup);
+		//GetIndexRange overestimates the number of points, so also check the points beyond the stored circles
+		const uint64 IndexRange = Generator.GetIndexRange() + 64;
+		FCircularPointsIterator It = Generator.CreateIterator();
+		for(uint64 Index = 0; Index < IndexRange; Index++, ++It)
+		{
+			//no tolerance, the points have to be bit for bit identical
+			const FVector Expected = GetSearchedSamplePoint(Generator, Index);
+			if(Generator.GetSamplePoint(Index) != Expected)
+			{
+				AddError(FString::Printf(TEXT("GetSamplePoint(%llu) differs (%s)"), Index, *DescribeSetup(Setup)));
+				return false;
+			}
+			if(It.GetIndex() != Index || *It != Expected)
+			{
+				AddError(FString::Printf(TEXT("The iterator differs at %llu (%s)"), Index, *DescribeSetup(Setup)));
+				return false;
+			}
+		}
+
+		//iterators may also start in the middle of the range
+		const uint64 StartIndex = Generator.GetIndexRange() / 2;
+		FCircularPointsIterator MidwayIt = Generator.CreateIterator(StartIndex);
+		for(uint64 Index = StartIndex; Index < IndexRange; Index++, ++MidwayIt)
+		{
+			if(*MidwayIt != GetSearchedSamplePoint(Generator, Index))
+			{
+				AddError(FString::Printf(TEXT("An iterator starting at %llu differs at %llu (%s)"), StartIndex, Index,
+					*DescribeSetup(Setup)));
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCircularPointsGeneratorBenchmark, "MAProject.AI.CircularPointsGenerator.Benchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FCircularPointsGeneratorBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace PositionalConstraintTests;
+	constexpr int32 Sweeps = 20;
+	for(const FGeneratorSetup& Setup : GeneratorSetups)
+	{
+		const FCircularPointsGenerator Generator = CreateGenerator(Setup);
+		const uint64 IndexRange = Generator.GetIndexRange();
+		//summing up the points keeps the compiler from optimizing the lookups away
+		FVector Checksum = FVector::ZeroVector;
+
+		double StartTime = FPlatformTime::Seconds();
+		for(int32 Sweep = 0; Sweep < Sweeps; Sweep++)
+		{
+			for(uint64 Index = 0; Index < IndexRange; Index++) Checksum += GetSearchedSamplePoint(Generator, Index);
+		}
+		const double SearchedTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for(int32 Sweep = 0; Sweep < Sweeps; Sweep++)
+		{
+			for(uint64 Index = 0; Index < IndexRange; Index++) Checksum -= Generator.GetSamplePoint(Index);
+		}
+		const double LookupTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for(int32 Sweep = 0; Sweep < Sweeps; Sweep++)
+		{
+			for(FCircularPointsIterator It = Generator.CreateIterator(); It.GetIndex() < IndexRange; ++It)
+			{
+				Checksum += *It;
+			}
+		}
+		const double IteratorTime = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%s, %llu points: searched %.3f ms, lookup %.3f ms (x%.1f), iterator %.3f ms (x%.1f)"),
+			*DescribeSetup(Setup), IndexRange, SearchedTime * 1000.0 / Sweeps, LookupTime * 1000.0 / Sweeps,
+			SearchedTime / FMath::Max(LookupTime, UE_DOUBLE_SMALL_NUMBER), IteratorTime * 1000.0 / Sweeps,
+			SearchedTime / FMath::Max(IteratorTime, UE_DOUBLE_SMALL_NUMBER)));
+		TestFalse(TEXT("Checksum is valid"), Checksum.ContainsNaN());
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,90 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Utility/Stats/GeneralStats.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace StatBlockTests
+{
+	//The resulting value as computed by the scalable stats before the stat blocks were introduced
+	double GetScalableResulting(float Base, float FlatBonus, float PercentageBonus)
+	{
+		return (PercentageBonus < 0 ? 1 : Base * (1.0 + PercentageBonus/100.0)) + FlatBonus;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStatBlockResolveTest, "MAProject.Stats.StatBlock.Resolve",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FStatBlockResolveTest::RunTest(const FString& Parameters)
+{
+	using namespace StatBlockTests;
+	{
+		FStatBlock StatBlock;
+		StatBlock.SetBase(EScalableStat::Health, 225.f);
+		FStatBonuses Bonuses;
+		Bonuses.Add(EScalableStat::Health, 0.f, 4.f);
+		StatBlock.AddBonuses(Bonuses);
+		TestEqual(TEXT("225 with +4%"), StatBlock.GetResultingInt(EScalableStat::Health), 234);
+	}
+
+	//the stat blocks have to give the same (truncated) values, so the balancing of the characters carries over
+	constexpr float Percentages[] = {-10.f, 0.f, 1.f, 3.f, 4.f, 7.5f, 12.f, 33.f, 100.f};
+	constexpr float FlatBonuses[] = {-5.f, 0.f, 3.f, 17.f};
+	for(int32 Base = 0; Base <= 2000; Base += 7)
+	{
+		for(const float Percentage : Percentages)
+		{
+			for(const float FlatBonus : FlatBonuses)
+			{
+				FStatBlock StatBlock;
+				FStatBonuses Bonuses;
+				for(int32 Lane = 0; Lane < static_cast<int32>(EScalableStat::Num); Lane++)
+				{
+					StatBlock.SetBase(static_cast<EScalableStat>(Lane), Base);
+					Bonuses.Add(static_cast<EScalableStat>(Lane), FlatBonus, Percentage);
+				}
+				StatBlock.AddBonuses(Bonuses);
+
+				const double Expected = GetScalableResulting(Base, FlatBonus, Percentage);
+				for(int32 Lane = 0; Lane < static_cast<int32>(EScalableStat::Num); Lane++)
+				{
+					if(StatBlock.GetResultingInt(static_cast<EScalableStat>(Lane)) == static_cast<int32>(Expected) &&
+						StatBlock.GetResulting(static_cast<EScalableStat>(Lane)) == static_cast<float>(Expected)) continue;
+					AddError(FString::Printf(TEXT("Base %d, flat %.1f, %.1f%% results in %f instead of %f"), Base,
+						FlatBonus, Percentage, StatBlock.GetResulting(static_cast<EScalableStat>(Lane)), Expected));
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStatBlockFlatHealthTest, "MAProject.Stats.StatBlock.FlatHealth",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FStatBlockFlatHealthTest::RunTest(const FString& Parameters)
+{
+	//fractional flat health bonuses are truncated before they are added up, like the integer health always did
+	FStatBlock StatBlock;
+	StatBlock.SetBase(EScalableStat::Health, 100.f);
+	FStatBonuses Bonuses;
+	FGeneralObjectStatsBuffs(0.f, 0.f, 0.f, 2.7f, 0.f, 0.f).AddTo(Bonuses);
+	StatBlock.AddBonuses(Bonuses);
+	StatBlock.AddBonuses(Bonuses);
+	TestEqual(TEXT("100 with 2 * 2.7"), StatBlock.GetResultingInt(EScalableStat::Health), 104);
+	TestEqual(TEXT("100 with 2 * 2.7 (not truncated)"), StatBlock.GetResulting(EScalableStat::Health), 104.f);
+	StatBlock.AddBonuses(-Bonuses);
+	StatBlock.AddBonuses(-Bonuses);
+	TestEqual(TEXT("100 after removing the bonuses"), StatBlock.GetResultingInt(EScalableStat::Health), 100);
+
+	FStatBonuses Maluses;
+	FGeneralObjectStatsBuffs(0.f, 0.f, 0.f, -2.7f, 0.f, 0.f).AddTo(Maluses);
+	StatBlock.AddBonuses(Maluses);
+	TestEqual(TEXT("100 with -2.7"), StatBlock.GetResultingInt(EScalableStat::Health), 98);
+	return true;
+}
+
+#endif
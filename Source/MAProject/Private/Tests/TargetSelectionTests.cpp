@@ -0,0 +1,166 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Characters/Fighters/Player/TargetSelectionQueries.h"
+#include "Tests/AutomationTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TargetSelectionTests
+{
+	constexpr float Range = 1000.f;
+	constexpr float HalfFieldOfView = 45.f;
+
+	//The visibility check of the player before the traces were run asynchronously
+	bool IsOccluded(const UWorld* World, const FCollisionQueryParams& QueryParams, const FVector& Observer,
+		const FVector& Center, const FVector& Extent, const AActor* Target)
+	{
+		FHitResult Hit;
+		World->LineTraceSingleByChannel(Hit, Observer, Center, ECC_Visibility, QueryParams);
+		if(!Hit.bBlockingHit || Hit.GetActor() == Target) return false;
+		FVector Corners[FTargetVisibility::NumOfCorners];
+		FTargetVisibility::GetCorners(Center, Extent, Corners);
+		int32 VisibleCorners = 0;
+		for(const FVector& Corner : Corners)
+		{
+			World->LineTraceSingleByChannel(Hit, Observer, Corner, ECC_Visibility, QueryParams);
+			if(!Hit.bBlockingHit || Hit.GetActor() == Target) VisibleCorners++;
+		}
+		return VisibleCorners < FTargetVisibility::RequiredVisibleCorners;
+	}
+
+	//The scoring of the player without the input direction, the current target and the priorities
+	template<typename IsVisibleType>
+	const AActor* ChooseTarget(const TArray<const AActor*>& Candidates, const AActor* CenteredActor,
+		const FVector& EyesLocation, const FVector& ViewDirection, const FVector& PlayerLocation,
+		IsVisibleType&& IsVisible)
+	{
+		float BestScore = std::numeric_limits<float>::lowest();
+		const AActor* BestCandidate = nullptr;
+		for(const AActor* Candidate : Candidates)
+		{
+			FVector Center;
+			FVector Extent;
+			Candidate->GetActorBounds(true, Center, Extent);
+			const float OffsetFromForward = FVector::DotProduct(ViewDirection, (Center - EyesLocation).GetSafeNormal());
+			if(FMath::RadiansToDegrees(FMath::Acos(OffsetFromForward)) > HalfFieldOfView) continue;
+			if(!IsVisible(Candidate, Center, Extent)) continue;
+			float Score = 0.75f * OffsetFromForward;
+			if(CenteredActor == Candidate) Score += 0.25f;
+			Score += 1.f - FVector::Distance(PlayerLocation, Center) / Range;
+			if(Score > BestScore)
+			{
+				BestScore = Score;
+				BestCandidate = Candidate;
+			}
+		}
+		return BestCandidate;
+	}
+
+	TArray<const AActor*> GetCandidates(const FTargetSelectionQueries& Queries)
+	{
+		TArray<const AActor*> Candidates;
+		for(const TWeakObjectPtr<AActor>& Candidate : Queries.GetCandidates())
+		{
+			if(Candidate.IsValid()) Candidates.Add(Candidate.Get());
+		}
+		return Candidates;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTargetSelectionEquivalenceTest, "MAProject.Player.TargetSelection.Equivalence",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTargetSelectionEquivalenceTest::RunTest(const FString& Parameters)
+{
+	using namespace TargetSelectionTests;
+	FAutomationTestWorld TestWorld;
+	UWorld* World = TestWorld.Get();
+
+	AActor* Player = World->SpawnActor<AActor>(FVector::ZeroVector, FRotator::ZeroRotator);
+	const FVector PlayerLocation = FVector::ZeroVector;
+	const FVector EyesLocation(0.0, 0.0, 150.0);
+
+	//a crowd around the player, half of it walking back and forth, behind a few pillars
+	TArray<AActor*> Crowd;
+	for(int32 i = 0; i < 40; i++)
+	{
+		const double Angle = DOUBLE_TWO_PI * i / 40.0;
+		const double Distance = 300.0 + 600.0 * (i % 5) / 4.0;
+		Crowd.Add(TestWorld.SpawnBlockingBox(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * Distance +
+			FVector(0.0, 0.0, 90.0), FVector(35.0, 35.0, 90.0)));
+	}
+	for(int32 i = 0; i < 12; i++)
+	{
+		const double Angle = DOUBLE_TWO_PI * (i + 0.5) / 12.0;
+		TestWorld.SpawnBlockingBox(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * 450.0 +
+			FVector(0.0, 0.0, 100.0), FVector(40.0, 40.0, 100.0));
+	}
+
+	FTargetSelectionQueries Queries;
+	Queries.Initialize(Player);
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(TargetSelection), true, Player);
+
+	//the camera sweeps around the player twice, a selection is requested every few frames
+	constexpr int32 Frames = 240;
+	int32 NumOfSelections = 0;
+	for(int32 Frame = 0; Frame < Frames; Frame++)
+	{
+		const FVector ViewDirection = FRotator(-10.0, 720.0 * Frame / Frames, 0.0).Vector();
+		for(int32 i = 1; i < Crowd.Num(); i += 2)
+		{
+			Crowd[i]->AddActorWorldOffset(FRotator(0.0, 360.0 * i / Crowd.Num() + 90.0, 0.0).Vector() * 8.0 * FMath::Sin(Frame * 0.2));
+		}
+
+		if(Frame % 7 == 3)
+		{
+			Queries.QueryCandidatesSynchronously(EyesLocation, ViewDirection, PlayerLocation, Range);
+			const AActor* Chosen = ChooseTarget(GetCandidates(Queries), Queries.GetCenteredActor(), EyesLocation,
+				ViewDirection, PlayerLocation, [&](const AActor* Candidate, const FVector& Center, const FVector& Extent)
+			{
+				return Queries.EvaluateVisibility(Candidate, Center, Extent, EyesLocation, PlayerLocation);
+			});
+
+			FHitResult CenteredHit;
+			World->LineTraceSingleByChannel(CenteredHit, EyesLocation, EyesLocation + ViewDirection * Range,
+				ECC_Destructible, QueryParams);
+			TArray<FHitResult> Hits;
+			World->SweepMultiByChannel(Hits, PlayerLocation, PlayerLocation, FQuat::Identity, ECC_Destructible,
+				FCollisionShape::MakeSphere(Range), QueryParams);
+			TArray<const AActor*> ExpectedCandidates;
+			for(const FHitResult& Hit : Hits)
+			{
+				if(Hit.bBlockingHit && Hit.GetActor() != nullptr) ExpectedCandidates.Add(Hit.GetActor());
+			}
+			const AActor* Expected = ChooseTarget(ExpectedCandidates,
+				CenteredHit.bBlockingHit ? CenteredHit.GetActor() : nullptr, EyesLocation, ViewDirection,
+				PlayerLocation, [&](const AActor* Candidate, const FVector& Center, const FVector& Extent)
+			{
+				return !IsOccluded(World, QueryParams, EyesLocation, Center, Extent, Candidate) &&
+					!IsOccluded(World, QueryParams, PlayerLocation, Center, Extent, Candidate);
+			});
+			if(Chosen != Expected)
+			{
+				AddError(FString::Printf(TEXT("Frame %d: chose %s instead of %s"), Frame, *GetNameSafe(Chosen),
+					*GetNameSafe(Expected)));
+			}
+			NumOfSelections++;
+		}
+		else
+		{
+			//the selection of the frames in between only uses the cached results
+			ChooseTarget(GetCandidates(Queries), Queries.GetCenteredActor(), EyesLocation, ViewDirection,
+				PlayerLocation, [&](const AActor* Candidate, const FVector& Center, const FVector& Extent)
+			{
+				return Queries.RequestVisibility(Candidate, Center, Extent);
+			});
+		}
+		Queries.IssueVisibilityTraces(EyesLocation, PlayerLocation);
+		Queries.QueryCandidates(EyesLocation, ViewDirection, PlayerLocation, Range);
+		TestWorld.Tick();
+	}
+	AddInfo(FString::Printf(TEXT("Compared %d selections"), NumOfSelections));
+	return !HasAnyErrors();
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "UserInterface/HUD/Playerscreen/PlayerStatsMonitorBaseWidget.h"
 
+#include "Characters/Fighters/Attacks/CooldownTimelineSubsystem.h"
 #include "Components/Image.h"
 #include "Components/TextBlock.h"
 
@@ -10,31 +11,38 @@
 
 
 UPlayerStatsMonitorBaseWidget::UPlayerStatsMonitorBaseWidget(): SkillTotalCd(0), UltimateTotalCd(0),
-	HealthText(nullptr), SkillCdTime(nullptr), UltimateCdTime(nullptr), SkillCdPercentage(nullptr),
-	UltimateCdPercentage(nullptr)
+	SkillCdReadyTime(-1.0), UltimateCdReadyTime(-1.0), DisplayedSkillCdTenths(INDEX_NONE),
+	DisplayedUltimateCdTenths(INDEX_NONE), SkillCdGeneration(0), UltimateCdGeneration(0), HealthText(nullptr),
+	SkillCdTime(nullptr), UltimateCdTime(nullptr), SkillCdPercentage(nullptr), UltimateCdPercentage(nullptr)
 {
 }
 
 void UPlayerStatsMonitorBaseWidget::SetTotalSkillCdTime(float CdTime)
 {
 	SkillTotalCd = CdTime;
-	if(!SkillCdHandle.IsValid()) SetSkillCdTime(-1.f);
+	//only the displayed percentage changes, the next step is already scheduled
+	SetSkillCdTime(SkillCdReadyTime < 0.0 ? -1.f :
+		static_cast<float>(SkillCdReadyTime - GetWorld()->GetTimeSeconds()));
 }
 
 void UPlayerStatsMonitorBaseWidget::SetTotalUltimateCdTime(float CdTime)
 {
 	UltimateTotalCd = CdTime;
-	if(!UltimateCdHandle.IsValid()) SetUltimateCdTime(-1.f);
+	//only the displayed percentage changes, the next step is already scheduled
+	SetUltimateCdTime(UltimateCdReadyTime < 0.0 ? -1.f :
+		static_cast<float>(UltimateCdReadyTime - GetWorld()->GetTimeSeconds()));
 }
 
-void UPlayerStatsMonitorBaseWidget::SetSkillTimer(FTimerHandle SkillTimerHandle)
+void UPlayerStatsMonitorBaseWidget::SetSkillCdReadyTime(double ReadyTime)
 {
-	SkillCdHandle = SkillTimerHandle;
+	SkillCdReadyTime = ReadyTime;
+	OnSkillCdStep(++SkillCdGeneration);
 }
 
-void UPlayerStatsMonitorBaseWidget::SetUltimateTimer(FTimerHandle UltimateTimerHandle)
+void UPlayerStatsMonitorBaseWidget::SetUltimateCdReadyTime(double ReadyTime)
 {
-	UltimateCdHandle = UltimateTimerHandle;
+	UltimateCdReadyTime = ReadyTime;
+	OnUltimateCdStep(++UltimateCdGeneration);
 }
 
 UImage* UPlayerStatsMonitorBaseWidget::GetFirstAvailableImage()
@@ -64,18 +72,39 @@ UImage* UPlayerStatsMonitorBaseWidget::GetFirstUnconnectedImage()
 	return nullptr;
 }
 
-void UPlayerStatsMonitorBaseWidget::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+void UPlayerStatsMonitorBaseWidget::OnSkillCdStep(uint32 Generation)
 {
-	Super::NativeTick(MyGeometry, InDeltaTime);
-	
-	if(SkillCdHandle.IsValid())
+	if(Generation != SkillCdGeneration) return;
+	if(SkillCdReadyTime < 0.0)
 	{
-		SetSkillCdTime(GetWorld()->GetTimerManager().GetTimerRemaining(SkillCdHandle));
+		SetSkillCdTime(-1.f);
+		return;
 	}
-	if(UltimateCdHandle.IsValid())
+	SetSkillCdTime(static_cast<float>(SkillCdReadyTime - GetWorld()->GetTimeSeconds()));
+	if(SkillCdReadyTime < 0.0) return;
+	GetWorld()->GetSubsystem<UCooldownTimelineSubsystem>()->Schedule(GetNextCdStepTime(SkillCdReadyTime),
+		FSimpleDelegate::CreateUObject(this, &UPlayerStatsMonitorBaseWidget::OnSkillCdStep, Generation));
+}
+
+void UPlayerStatsMonitorBaseWidget::OnUltimateCdStep(uint32 Generation)
+{
+	if(Generation != UltimateCdGeneration) return;
+	if(UltimateCdReadyTime < 0.0)
 	{
-		SetUltimateCdTime(GetWorld()->GetTimerManager().GetTimerRemaining(UltimateCdHandle));
+		SetUltimateCdTime(-1.f);
+		return;
 	}
+	SetUltimateCdTime(static_cast<float>(UltimateCdReadyTime - GetWorld()->GetTimeSeconds()));
+	if(UltimateCdReadyTime < 0.0) return;
+	GetWorld()->GetSubsystem<UCooldownTimelineSubsystem>()->Schedule(GetNextCdStepTime(UltimateCdReadyTime),
+		FSimpleDelegate::CreateUObject(this, &UPlayerStatsMonitorBaseWidget::OnUltimateCdStep, Generation));
+}
+
+double UPlayerStatsMonitorBaseWidget::GetNextCdStepTime(double ReadyTime) const
+{
+	//the displayed value is rounded down to tenths, so it changes whenever the remaining time drops below a tenth
+	const double RemainingTenths = FMath::CeilToDouble((ReadyTime - GetWorld()->GetTimeSeconds()) * 10.0);
+	return ReadyTime - FMath::Max(RemainingTenths - 1.0, 0.0) * 0.1;
 }
 
 void UPlayerStatsMonitorBaseWidget::UpdateHealthInternal(int32 NewHealth, int32 OldHealth)
@@ -94,7 +123,9 @@ void UPlayerStatsMonitorBaseWidget::SetSkillCdTime(float CdTime)
 {
 	if(CdTime <= 0)
 	{
-		SkillCdHandle.Invalidate();
+		SkillCdReadyTime = -1.0;
+		if(DisplayedSkillCdTenths == INDEX_NONE && SkillCdTime->GetVisibility() == ESlateVisibility::Hidden) return;
+		DisplayedSkillCdTenths = INDEX_NONE;
 		SkillCdTime->SetVisibility(ESlateVisibility::Hidden);
 		SkillCdPercentage->GetDynamicMaterial()->SetScalarParameterValue("Alpha", 1.f);
 		return;
@@ -103,7 +134,13 @@ void UPlayerStatsMonitorBaseWidget::SetSkillCdTime(float CdTime)
 	{
 		SkillCdTime->SetVisibility(ESlateVisibility::Visible);
 	}
-	SkillCdTime->SetText(FText::FromString(FString::SanitizeFloat(floor(CdTime * 10) * 0.1, 1)));
+	//the text is only formatted when the displayed value changes
+	const int32 CdTenths = FMath::FloorToInt32(CdTime * 10.f);
+	if(CdTenths != DisplayedSkillCdTenths)
+	{
+		DisplayedSkillCdTenths = CdTenths;
+		SkillCdTime->SetText(FText::FromString(FString::SanitizeFloat(CdTenths * 0.1, 1)));
+	}
 	SkillCdPercentage->GetDynamicMaterial()->SetScalarParameterValue("Alpha", 1.f - CdTime/SkillTotalCd);
 }
 
@@ -111,7 +148,10 @@ void UPlayerStatsMonitorBaseWidget::SetUltimateCdTime(float CdTime)
 {
 	if(CdTime <= 0)
 	{
-		UltimateCdHandle.Invalidate();
+		UltimateCdReadyTime = -1.0;
+		if(DisplayedUltimateCdTenths == INDEX_NONE && UltimateCdTime->GetVisibility() == ESlateVisibility::Hidden)
+			return;
+		DisplayedUltimateCdTenths = INDEX_NONE;
 		UltimateCdTime->SetVisibility(ESlateVisibility::Hidden);
 		UltimateCdPercentage->GetDynamicMaterial()->SetScalarParameterValue("Alpha", 1.f);
 		return;
@@ -120,7 +160,13 @@ void UPlayerStatsMonitorBaseWidget::SetUltimateCdTime(float CdTime)
 	{
 		UltimateCdTime->SetVisibility(ESlateVisibility::Visible);
 	}
-	UltimateCdTime->SetText(FText::FromString(FString::SanitizeFloat(floor(CdTime * 10) * 0.1, 1)));
+	//the text is only formatted when the displayed value changes
+	const int32 CdTenths = FMath::FloorToInt32(CdTime * 10.f);
+	if(CdTenths != DisplayedUltimateCdTenths)
+	{
+		DisplayedUltimateCdTenths = CdTenths;
+		UltimateCdTime->SetText(FText::FromString(FString::SanitizeFloat(CdTenths * 0.1, 1)));
+	}
 	UltimateCdPercentage->GetDynamicMaterial()->SetScalarParameterValue("Alpha", 1.f - CdTime/UltimateTotalCd);
 }
 
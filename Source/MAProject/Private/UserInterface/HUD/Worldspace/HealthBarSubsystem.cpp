@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UserInterface/HUD/Worldspace/HealthBarSubsystem.h"
+
+#include "MAProject.h"
+#include "SceneView.h"
+#include "Algo/Sort.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "UserInterface/StatsMonitorBaseWidget.h"
+#include "UserInterface/HUD/Worldspace/PlayerFacingWidgetComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Health Bars"), STAT_HealthBars, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Registered Health Bars"), STAT_RegisteredHealthBars, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Displayed Health Bars"), STAT_DisplayedHealthBars, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Updated Health Bar Widgets"), STAT_UpdatedHealthBarWidgets, STATGROUP_MAProjectAI);
+
+UHealthBarSubsystem::UHealthBarSubsystem() : MaxDistance(3000.f), MaxBars(16), VisibilityTimeout(0.2f)
+{
+}
+
+void UHealthBarSubsystem::Register(UPlayerFacingWidgetComponent* Component)
+{
+	if(EntryIndices.Contains(Component)) return;
+	EntryIndices.Add(Component, Entries.Emplace(Component));
+}
+
+void UHealthBarSubsystem::Unregister(const UPlayerFacingWidgetComponent* Component)
+{
+	if(const int32* EntryIndex = EntryIndices.Find(Component)) RemoveEntry(*EntryIndex);
+}
+
+void UHealthBarSubsystem::SetRatios(const UPlayerFacingWidgetComponent* Component, float HealthRatio,
+	float ToughnessRatio)
+{
+	const int32* EntryIndex = EntryIndices.Find(Component);
+	if(EntryIndex == nullptr) return;
+	Entries[*EntryIndex].HealthRatio = HealthRatio;
+	Entries[*EntryIndex].ToughnessRatio = ToughnessRatio;
+}
+
+void UHealthBarSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_HealthBars);
+	FHealthBarView View;
+	if(GetPlayerView(View)) CollectDisplayedBars(View);
+	else DisplayedBars.Reset();
+	UpdateWidgets();
+	SET_DWORD_STAT(STAT_RegisteredHealthBars, Entries.Num());
+	SET_DWORD_STAT(STAT_DisplayedHealthBars, DisplayedBars.Num());
+}
+
+bool UHealthBarSubsystem::GetPlayerView(FHealthBarView& View) const
+{
+	//the same projection the player controller uses for its screen positions
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const ULocalPlayer* LocalPlayer = IsValid(PlayerController) ? PlayerController->GetLocalPlayer() : nullptr;
+	if(LocalPlayer == nullptr || LocalPlayer->ViewportClient == nullptr) return false;
+	FSceneViewProjectionData ProjectionData;
+	if(!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData)) return false;
+	View = FHealthBarView(ProjectionData.ViewOrigin, ProjectionData.ComputeViewProjectionMatrix(),
+		ProjectionData.GetConstrainedViewRect());
+	return true;
+}
+
+void UHealthBarSubsystem::RemoveEntry(int32 EntryIndex)
+{
+	EntryIndices.Remove(Entries[EntryIndex].ComponentKey);
+	Entries.RemoveAtSwap(EntryIndex, 1, false);
+	if(Entries.IsValidIndex(EntryIndex)) EntryIndices.FindChecked(Entries[EntryIndex].ComponentKey) = EntryIndex;
+}
+
+void UHealthBarSubsystem::CollectDisplayedBars(const FHealthBarView& View)
+{
+	DisplayedBars.Reset();
+	for(int32 i = Entries.Num() - 1; i >= 0; i--)
+	{
+		if(!Entries[i].Component.IsValid()) RemoveEntry(i);
+	}
+
+	const double MaxDistanceSquared = FMath::Square(static_cast<double>(MaxDistance));
+	for(int32 i = 0; i < Entries.Num(); i++)
+	{
+		const FHealthBarEntry& Entry = Entries[i];
+		//like with the widgets, the bars of defeated opponents are hidden
+		if(Entry.HealthRatio <= 0.f) continue;
+		const UPlayerFacingWidgetComponent* Component = Entry.Component.Get();
+		if(!Component->IsVisible() || Component->GetWidgetClass() == nullptr) continue;
+
+		const FVector Location = Component->GetComponentLocation();
+		const double DistanceSquared = FVector::DistSquared(Location, View.ViewLocation);
+		if(DistanceSquared > MaxDistanceSquared) continue;
+		//the world space widgets used to be hidden by the geometry in front of them
+		if(!Component->GetOwner()->WasRecentlyRendered(VisibilityTimeout)) continue;
+		FVector2D ScreenPosition;
+		if(!FSceneView::ProjectWorldToScreen(Location, View.ViewRect, View.ViewProjectionMatrix, ScreenPosition))
+			continue;
+		DisplayedBars.Emplace(i, ScreenPosition - FVector2D(View.ViewRect.Min), DistanceSquared, Entry.HealthRatio,
+			Entry.ToughnessRatio);
+	}
+
+	if(DisplayedBars.Num() > MaxBars)
+	{
+		Algo::SortBy(DisplayedBars, &FHealthBarState::DistanceSquared);
+		DisplayedBars.SetNum(FMath::Max(MaxBars, 0), false);
+	}
+}
+
+void UHealthBarSubsystem::UpdateWidgets()
+{
+	UsedBarWidgets.Init(false, BarWidgets.Num());
+	//first, the bars keep the widgets they were displayed with, so their values rarely have to be set again
+	for(const FHealthBarState& Bar : DisplayedBars)
+	{
+		FHealthBarEntry& Entry = Entries[Bar.EntryIndex];
+		if(BarWidgets.IsValidIndex(Entry.WidgetIndex) && !UsedBarWidgets[Entry.WidgetIndex] &&
+			BarWidgets[Entry.WidgetIndex]->GetClass() == Entry.Component->GetWidgetClass())
+		{
+			UsedBarWidgets[Entry.WidgetIndex] = true;
+		}
+		else Entry.WidgetIndex = INDEX_NONE;
+	}
+
+	int32 NumOfUpdatedWidgets = 0;
+	for(const FHealthBarState& Bar : DisplayedBars)
+	{
+		FHealthBarEntry& Entry = Entries[Bar.EntryIndex];
+		if(Entry.WidgetIndex == INDEX_NONE) Entry.WidgetIndex = AcquireWidget(Entry.Component.Get());
+		if(Entry.WidgetIndex == INDEX_NONE) continue;
+
+		UStatsMonitorBaseWidget* Widget = BarWidgets[Entry.WidgetIndex];
+		FHealthBarWidgetState& WidgetState = BarWidgetStates[Entry.WidgetIndex];
+		bool IsUpdated = false;
+		if(WidgetState.ScreenPosition != Bar.ScreenPosition)
+		{
+			Widget->SetPositionInViewport(Bar.ScreenPosition);
+			WidgetState.ScreenPosition = Bar.ScreenPosition;
+			IsUpdated = true;
+		}
+		if(WidgetState.HealthRatio != Bar.HealthRatio || WidgetState.ToughnessRatio != Bar.ToughnessRatio)
+		{
+			Widget->SetBarRatios(Bar.HealthRatio, Bar.ToughnessRatio, FSetupInformationKey());
+			WidgetState.HealthRatio = Bar.HealthRatio;
+			WidgetState.ToughnessRatio = Bar.ToughnessRatio;
+			IsUpdated = true;
+		}
+		if(Widget->GetVisibility() != ESlateVisibility::HitTestInvisible)
+		{
+			Widget->SetVisibility(ESlateVisibility::HitTestInvisible);
+			IsUpdated = true;
+		}
+		if(IsUpdated) NumOfUpdatedWidgets++;
+	}
+	INC_DWORD_STAT_BY(STAT_UpdatedHealthBarWidgets, NumOfUpdatedWidgets);
+
+	for(int32 i = 0; i < BarWidgets.Num(); i++)
+	{
+		if(UsedBarWidgets[i] || BarWidgets[i]->GetVisibility() == ESlateVisibility::Collapsed) continue;
+		BarWidgets[i]->SetVisibility(ESlateVisibility::Collapsed);
+	}
+}
+
+int32 UHealthBarSubsystem::AcquireWidget(const UPlayerFacingWidgetComponent* Component)
+{
+	const UClass* WidgetClass = Component->GetWidgetClass();
+	int32 ReplacedIndex = INDEX_NONE;
+	for(int32 i = 0; i < BarWidgets.Num(); i++)
+	{
+		if(UsedBarWidgets[i]) continue;
+		if(BarWidgets[i]->GetClass() == WidgetClass)
+		{
+			UsedBarWidgets[i] = true;
+			return i;
+		}
+		if(ReplacedIndex == INDEX_NONE) ReplacedIndex = i;
+	}
+	//only when the pool is full, widgets of other classes are replaced
+	if(BarWidgets.Num() < MaxBars) ReplacedIndex = INDEX_NONE;
+	else if(ReplacedIndex == INDEX_NONE) return INDEX_NONE;
+
+	UStatsMonitorBaseWidget* Widget = CreateWidget<UStatsMonitorBaseWidget>(GetWorld()->GetFirstPlayerController(),
+		Component->GetWidgetClass());
+	if(!ensureMsgf(IsValid(Widget), TEXT("Health bars have to use a stats monitor widget"))) return INDEX_NONE;
+	//behind the rest of the HUD
+	Widget->AddToViewport(-1);
+	Widget->SetDesiredSizeInViewport(Component->GetDrawSize());
+	Widget->SetAlignmentInViewport(Component->GetPivot());
+	if(ReplacedIndex == INDEX_NONE)
+	{
+		BarWidgets.Add(Widget);
+		BarWidgetStates.AddDefaulted();
+		UsedBarWidgets.Add(true);
+		return BarWidgets.Num() - 1;
+	}
+	BarWidgets[ReplacedIndex]->RemoveFromParent();
+	BarWidgets[ReplacedIndex] = Widget;
+	BarWidgetStates[ReplacedIndex] = FHealthBarWidgetState();
+	UsedBarWidgets[ReplacedIndex] = true;
+	return ReplacedIndex;
+}
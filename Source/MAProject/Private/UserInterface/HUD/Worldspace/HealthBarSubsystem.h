@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "HealthBarSubsystem.generated.h"
+
+class UPlayerFacingWidgetComponent;
+class UStatsMonitorBaseWidget;
+
+//A health bar in the world, whose values are pushed by its component
+struct FHealthBarEntry
+{
+	FHealthBarEntry() : HealthRatio(1.f), ToughnessRatio(1.f), WidgetIndex(INDEX_NONE){}
+	explicit FHealthBarEntry(UPlayerFacingWidgetComponent* NewComponent) : Component(NewComponent),
+		ComponentKey(NewComponent), HealthRatio(1.f), ToughnessRatio(1.f), WidgetIndex(INDEX_NONE){}
+
+	TWeakObjectPtr<UPlayerFacingWidgetComponent> Component;
+	//still identifies the entry once the component has been destroyed
+	TObjectKey<UPlayerFacingWidgetComponent> ComponentKey;
+	float HealthRatio;
+	float ToughnessRatio;
+	//the widget that displayed the bar last (the bar keeps it as long as possible, so the widget rarely changes)
+	int32 WidgetIndex;
+};
+
+//What a pooled widget currently displays, so unchanged values aren't set again
+struct FHealthBarWidgetState
+{
+	FHealthBarWidgetState() : ScreenPosition(NAN), HealthRatio(NAN), ToughnessRatio(NAN){}
+
+	FVector2D ScreenPosition;
+	float HealthRatio;
+	float ToughnessRatio;
+};
+
+//The view the bars are projected with
+struct FHealthBarView
+{
+	FHealthBarView() : ViewLocation(NAN), ViewProjectionMatrix(FMatrix::Identity){}
+	FHealthBarView(const FVector& NewViewLocation, const FMatrix& NewViewProjectionMatrix, const FIntRect& NewViewRect) :
+		ViewLocation(NewViewLocation), ViewProjectionMatrix(NewViewProjectionMatrix), ViewRect(NewViewRect){}
+
+	FVector ViewLocation;
+	FMatrix ViewProjectionMatrix;
+	//the screen positions are relative to this rectangle's origin
+	FIntRect ViewRect;
+};
+
+//A health bar that is displayed this frame
+struct FHealthBarState
+{
+	FHealthBarState() : EntryIndex(INDEX_NONE), ScreenPosition(NAN), DistanceSquared(0.0), HealthRatio(0.f),
+		ToughnessRatio(0.f){}
+	FHealthBarState(int32 NewEntryIndex, const FVector2D& NewScreenPosition, double NewDistanceSquared,
+		float NewHealthRatio, float NewToughnessRatio) : EntryIndex(NewEntryIndex), ScreenPosition(NewScreenPosition),
+		DistanceSquared(NewDistanceSquared), HealthRatio(NewHealthRatio), ToughnessRatio(NewToughnessRatio){}
+
+	int32 EntryIndex;
+	//in viewport pixels
+	FVector2D ScreenPosition;
+	//to the camera
+	double DistanceSquared;
+	float HealthRatio;
+	float ToughnessRatio;
+};
+
+/**
+ * Draws the health bars of all opponents with a small pool of screen space widgets. Each frame the bars are culled by
+ * distance and visibility, projected to the screen and handed to the widgets, so the components themselves never tick.
+ */
+UCLASS(Config=Game)
+class UHealthBarSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UHealthBarSubsystem();
+
+	void Register(UPlayerFacingWidgetComponent* Component);
+	void Unregister(const UPlayerFacingWidgetComponent* Component);
+	void SetRatios(const UPlayerFacingWidgetComponent* Component, float HealthRatio, float ToughnessRatio);
+
+	//Culls and projects the bars (done every tick with the view of the first player)
+	void CollectDisplayedBars(const FHealthBarView& View);
+
+	//the bars displayed during the last tick (nearest first if some had to be dropped)
+	const TArray<FHealthBarState>& GetDisplayedBars() const { return DisplayedBars; }
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UHealthBarSubsystem, STATGROUP_Tickables);
+	}
+
+protected:
+	TArray<FHealthBarEntry> Entries;
+	//the index of the entry of every registered component
+	TMap<TObjectKey<UPlayerFacingWidgetComponent>, int32> EntryIndices;
+	//the bars that passed the culling of the last view
+	TArray<FHealthBarState> DisplayedBars;
+
+	UPROPERTY()
+	TArray<UStatsMonitorBaseWidget*> BarWidgets;
+	//what the widget with the same index displays
+	TArray<FHealthBarWidgetState> BarWidgetStates;
+	//whether the widget with the same index displays a bar this frame
+	TBitArray<> UsedBarWidgets;
+
+	//bars further away from the camera aren't displayed
+	UPROPERTY(Config, meta=(Units="cm"))
+	float MaxDistance;
+	//the maximal number of bars displayed at once (the size of the widget pool)
+	UPROPERTY(Config)
+	int32 MaxBars;
+	//how long a bar is displayed after its owner has last been rendered
+	UPROPERTY(Config, meta=(Units="s"))
+	float VisibilityTimeout;
+
+	bool GetPlayerView(FHealthBarView& View) const;
+	void RemoveEntry(int32 EntryIndex);
+	void UpdateWidgets();
+	//Returns the index of a pooled widget of the class that isn't used this frame (INDEX_NONE if the pool is exhausted)
+	int32 AcquireWidget(const UPlayerFacingWidgetComponent* Component);
+};
@@ -3,14 +3,22 @@
 
 #include "UserInterface/HUD/Worldspace/PlayerFacingWidgetComponent.h"
 
-#include "Kismet/KismetMathLibrary.h"
-#include "UserInterface/StatsMonitorBaseWidget.h"
+#include "UserInterface/HUD/Worldspace/HealthBarSubsystem.h"
+#include "Utility/Stats/GeneralStats.h"
 
 
 // Sets default values for this component's properties
-UPlayerFacingWidgetComponent::UPlayerFacingWidgetComponent()
+UPlayerFacingWidgetComponent::UPlayerFacingWidgetComponent() : CurrentHealth(1), MaxHealth(1), CurrentToughness(1),
+	MaxToughness(1)
 {
-	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UPlayerFacingWidgetComponent::InitWidget()
+{
+	//the widget is only needed for the preview in the editor
+	if(GetWorld() != nullptr && GetWorld()->IsGameWorld()) return;
+	Super::InitWidget();
 }
 
 
@@ -18,21 +26,64 @@ UPlayerFacingWidgetComponent::UPlayerFacingWidgetComponent()
 void UPlayerFacingWidgetComponent::BeginPlay()
 {
 	Super::BeginPlay();
-	UStatsMonitorBaseWidget* HealthMonitorWidget = CastChecked<UStatsMonitorBaseWidget>(GetWidget());
-	OnHealthMonitorWidgetInitialized.Broadcast(HealthMonitorWidget);
+	GetWorld()->GetSubsystem<UHealthBarSubsystem>()->Register(this);
+	PushRatios();
 }
 
-
-// Called every frame
-void UPlayerFacingWidgetComponent::TickComponent(float DeltaTime, ELevelTick TickType,
-                                                 FActorComponentTickFunction* ThisTickFunction)
+void UPlayerFacingWidgetComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	
-	if(HasBegunPlay() && GetWidget()->IsVisible())
+	if(UHealthBarSubsystem* HealthBarSubsystem = GetWorld()->GetSubsystem<UHealthBarSubsystem>())
 	{
-		SetWorldRotation(UKismetMathLibrary::FindLookAtRotation(GetComponentLocation(),
-			GetWorld()->GetFirstPlayerController()->PlayerCameraManager->GetCameraLocation()));
+		HealthBarSubsystem->Unregister(this);
 	}
+	Super::EndPlay(EndPlayReason);
 }
 
+void UPlayerFacingWidgetComponent::RegisterStats(FCharacterStats* Stats, FSetupInformationKey)
+{
+	check(Stats != nullptr);
+	CurrentHealth = Stats->CurrentHealth;
+	MaxHealth = Stats->GetMaxHealth();
+	CurrentToughness = Stats->CurrentToughness;
+	MaxToughness = Stats->GetMaxToughness();
+	Stats->OnHealthChanged.AddDynamic(this, &UPlayerFacingWidgetComponent::UpdateHealth);
+	Stats->OnMaxHealthChanged.AddDynamic(this, &UPlayerFacingWidgetComponent::UpdateMaxHealth);
+	Stats->OnToughnessChanged.AddDynamic(this, &UPlayerFacingWidgetComponent::UpdateToughness);
+	Stats->OnMaxToughnessChanged.AddDynamic(this, &UPlayerFacingWidgetComponent::UpdateMaxToughness);
+	PushRatios();
+}
+
+void UPlayerFacingWidgetComponent::UpdateHealth(int32 NewHealth, int32 OldHealth)
+{
+	CurrentHealth = NewHealth;
+	PushRatios();
+}
+
+void UPlayerFacingWidgetComponent::UpdateMaxHealth(int32 NewCurrentHealth, int32 NewMaxHealth)
+{
+	CurrentHealth = NewCurrentHealth;
+	MaxHealth = NewMaxHealth;
+	PushRatios();
+}
+
+void UPlayerFacingWidgetComponent::UpdateToughness(int32 NewToughness, int32 OldToughness)
+{
+	CurrentToughness = NewToughness;
+	PushRatios();
+}
+
+void UPlayerFacingWidgetComponent::UpdateMaxToughness(int32 NewCurrentToughness, int32 NewMaxToughness)
+{
+	CurrentToughness = NewCurrentToughness;
+	MaxToughness = NewMaxToughness;
+	PushRatios();
+}
+
+void UPlayerFacingWidgetComponent::PushRatios() const
+{
+	//the stats may be registered before the game starts
+	if(!HasBegunPlay()) return;
+	GetWorld()->GetSubsystem<UHealthBarSubsystem>()->SetRatios(this,
+		MaxHealth > 0 ? static_cast<float>(CurrentHealth) / static_cast<float>(MaxHealth) : 0.f,
+		MaxToughness > 0 ? static_cast<float>(CurrentToughness) / static_cast<float>(MaxToughness) : 0.f);
+}
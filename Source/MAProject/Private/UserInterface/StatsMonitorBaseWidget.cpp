@@ -5,13 +5,20 @@
 
 #include "Components/ProgressBar.h"
 
-void UStatsMonitorBaseWidget::SetupInformation(const TMaxedValue<int32, float>& Health,
-	const TMaxedValue<int32, float>& Toughness, FSetupInformationKey)
+void UStatsMonitorBaseWidget::SetupInformation(int32 CurrentHealth, int32 NewMaxHealth, int32 CurrentToughness,
+	int32 NewMaxToughness, FSetupInformationKey)
 {
-	MaxHealth = Health.Maximum.GetResulting();
-	UpdateHealth(Health.Current, Health.Current);
-	MaxToughness = Toughness.Maximum.GetResulting();
-	UpdateToughness(Toughness.Current, Toughness.Current);
+	MaxHealth = NewMaxHealth;
+	UpdateHealth(CurrentHealth, CurrentHealth);
+	MaxToughness = NewMaxToughness;
+	UpdateToughness(CurrentToughness, CurrentToughness);
+}
+
+void UStatsMonitorBaseWidget::SetBarRatios(float HealthRatio, float ToughnessRatio, FSetupInformationKey)
+{
+	check(IsValid(HealthBar) && IsValid(ToughnessBar));
+	HealthBar->SetPercent(HealthRatio);
+	ToughnessBar->SetPercent(ToughnessRatio);
 }
 
 void UStatsMonitorBaseWidget::UpdateToughness(int32 NewToughness, int32 OldToughness)
@@ -15,6 +15,7 @@ struct FSetupInformationKey final
 	friend class AOpponentCharacter;
 	friend class APlayerCharacter;
 	friend class AFighterCharacter;
+	friend class UHealthBarSubsystem;
 private:
 	FSetupInformationKey(){}
 };
@@ -29,7 +30,10 @@ class UStatsMonitorBaseWidget : public UUserWidget
 	GENERATED_BODY()
 public:
 	
-	virtual void SetupInformation(const TMaxedValue<int32, float>& Health, const TMaxedValue<int32, float>& Toughness, FSetupInformationKey);
+	virtual void SetupInformation(int32 CurrentHealth, int32 NewMaxHealth, int32 CurrentToughness, int32 NewMaxToughness,
+		FSetupInformationKey);
+	//Displays the ratios directly (used by pooled widgets, which don't belong to a single character)
+	void SetBarRatios(float HealthRatio, float ToughnessRatio, FSetupInformationKey);
 	
 	/// @brief Update health bar
 	UFUNCTION()
@@ -7,7 +7,7 @@
 
 
 UAnimNotifyState_TimedNiagaraEffectParameters::UAnimNotifyState_TimedNiagaraEffectParameters() : NotifyTime(0.f),
-	NonAttachedScale(1.f)
+	NonAttachedScale(1.f), bHasResolvedParameters(false)
 {
 }
 
@@ -18,61 +18,107 @@ void UAnimNotifyState_TimedNiagaraEffectParameters::NotifyBegin(USkeletalMeshCom
 	NotifyTime = TotalDuration;
 }
 
+void UAnimNotifyState_TimedNiagaraEffectParameters::NotifyEnd(USkeletalMeshComponent* MeshComp,
+	UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference)
+{
+	if(!bDestroyAtEnd)
+	{
+		Super::NotifyEnd(MeshComp, Animation, EventReference);
+		return;
+	}
+	//pooled components are reused, so they are stopped immediately instead of being destroyed
+	//(components that aren't pooled were spawned with auto destroy and destroy themselves once stopped)
+	if(UNiagaraComponent* NiagaraComponent = Cast<UNiagaraComponent>(GetSpawnedEffect(MeshComp)))
+	{
+		NiagaraComponent->ComponentTags.Remove(GetSpawnedComponentTag());
+		NiagaraComponent->DeactivateImmediate();
+	}
+	UAnimNotifyState::NotifyEnd(MeshComp, Animation, EventReference);
+}
+
+#if WITH_EDITOR
+void UAnimNotifyState_TimedNiagaraEffectParameters::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	bHasResolvedParameters = false;
+}
+#endif
+
+void UAnimNotifyState_TimedNiagaraEffectParameters::ResolveParameters() const
+{
+	bHasResolvedParameters = true;
+	ResolvedPlayLength = PlayLengthName.IsNone() ? FNiagaraEffectParameter() :
+		FNiagaraEffectParameter(Template, FNiagaraTypeDefinition::GetFloatDef(), PlayLengthName);
+	ResolvedFloatParameters.Reset(FloatParameters.Num());
+	for(const FFloatParameter& Parameter : FloatParameters)
+	{
+		ResolvedFloatParameters.Emplace(Template, FNiagaraTypeDefinition::GetFloatDef(), Parameter.VariableName);
+	}
+	ResolvedLinearColorParameters.Reset(LinearColorParameters.Num());
+	for(const FLinearColorParameter& Parameter : LinearColorParameters)
+	{
+		ResolvedLinearColorParameters.Emplace(Template, FNiagaraTypeDefinition::GetColorDef(), Parameter.VariableName);
+	}
+	ResolvedVectorParameters.Reset(VectorParameters.Num());
+	for(const FVectorParameter& Parameter : VectorParameters)
+	{
+		ResolvedVectorParameters.Emplace(Template, FNiagaraTypeDefinition::GetVec3Def(), Parameter.VariableName);
+	}
+}
+
 UFXSystemComponent* UAnimNotifyState_TimedNiagaraEffectParameters::SpawnEffect(USkeletalMeshComponent* MeshComp,
                                                                                UAnimSequenceBase* Animation) const
 {
 	// Only spawn if we've got valid params
 	if (!SocketName.IsNone() && !ValidateParameters(MeshComp)) return nullptr;
 
+	//the pool doesn't exist in every world (e.g. animation previews)
+	UNiagaraEffectPoolSubsystem* EffectPool = MeshComp->GetWorld()->GetSubsystem<UNiagaraEffectPoolSubsystem>();
 	UNiagaraComponent* NiagaraSystem;
 	if(!SocketName.IsNone())
 	{
-		 NiagaraSystem =  UNiagaraFunctionLibrary::SpawnSystemAttached(Template, MeshComp,
-			SocketName, LocationOffset, RotationOffset, EAttachLocation::KeepRelativeOffset, bDestroyAtEnd);
+		NiagaraSystem = IsValid(EffectPool) ?
+			EffectPool->SpawnAttached(Template, MeshComp, SocketName, LocationOffset, RotationOffset, FVector(1.f),
+				EAttachLocation::KeepRelativeOffset) :
+			UNiagaraFunctionLibrary::SpawnSystemAttached(Template, MeshComp, SocketName, LocationOffset,
+				RotationOffset, EAttachLocation::KeepRelativeOffset, bDestroyAtEnd);
 	}
 	else
 	{
 		const FVector Offset =
 			MeshComp->GetComponentRotation().RotateVector(LocationOffset)*MeshComp->GetComponentScale().X;
-		NiagaraSystem = UNiagaraFunctionLibrary::SpawnSystemAtLocation(MeshComp->GetWorld(), Template,
-			 Offset + MeshComp->GetComponentLocation(), MeshComp->GetComponentRotation() + RotationOffset,
-			 NonAttachedScale, bDestroyAtEnd);
+		const FVector Location = Offset + MeshComp->GetComponentLocation();
+		const FRotator Rotation = MeshComp->GetComponentRotation() + RotationOffset;
+		NiagaraSystem = IsValid(EffectPool) ?
+			EffectPool->SpawnAtLocation(Template, Location, Rotation, NonAttachedScale) :
+			UNiagaraFunctionLibrary::SpawnSystemAtLocation(MeshComp->GetWorld(), Template, Location, Rotation,
+				NonAttachedScale, bDestroyAtEnd);
 	}
+	if(NiagaraSystem == nullptr) return nullptr;
 
-	if(!PlayLengthName.IsNone()) NiagaraSystem->SetVariableFloat(PlayLengthName, NotifyTime);
+	if(!bHasResolvedParameters) ResolveParameters();
+	ResolvedPlayLength.Set(NiagaraSystem, NotifyTime);
 
-	for(const FFloatParameter& Parameter : FloatParameters)
+	for(int32 i = 0; i < FloatParameters.Num(); i++)
 	{
-		if(Parameter.bUseMeshScaling)
-		{
-			NiagaraSystem->SetVariableFloat(Parameter.VariableName,
-				Parameter.Value * MeshComp->GetComponentScale().X);
-		}
-		else
-		{
-			NiagaraSystem->SetVariableFloat(Parameter.VariableName, Parameter.Value);
-		}
+		const FFloatParameter& Parameter = FloatParameters[i];
+		ResolvedFloatParameters[i].Set(NiagaraSystem, Parameter.bUseMeshScaling ?
+			Parameter.Value * static_cast<float>(MeshComp->GetComponentScale().X) : Parameter.Value);
 	}
-	for(const FVectorParameter& Parameter : VectorParameters)
+	for(int32 i = 0; i < VectorParameters.Num(); i++)
 	{
-		if(Parameter.bUseMeshScaling)
-		{
-			NiagaraSystem->SetVariableVec3(Parameter.VariableName,
-				Parameter.Value * MeshComp->GetComponentScale());
-		}
-		else
-		{
-			NiagaraSystem->SetVariableVec3(Parameter.VariableName, Parameter.Value);
-		}
+		const FVectorParameter& Parameter = VectorParameters[i];
+		ResolvedVectorParameters[i].Set(NiagaraSystem, FVector3f(Parameter.bUseMeshScaling ?
+			Parameter.Value * MeshComp->GetComponentScale() : Parameter.Value));
 	}
 	
 	for(const FMaterialParameter& Parameter : MaterialParameters)
 	{
 		NiagaraSystem->SetVariableMaterial(Parameter.VariableName, Parameter.Material);
 	}
-	for(const FLinearColorParameter& Parameter : LinearColorParameters)
+	for(int32 i = 0; i < LinearColorParameters.Num(); i++)
 	{
-		NiagaraSystem->SetVariableLinearColor(Parameter.VariableName, Parameter.Value);
+		ResolvedLinearColorParameters[i].Set(NiagaraSystem, LinearColorParameters[i].Value);
 	}
 	
 	return NiagaraSystem;
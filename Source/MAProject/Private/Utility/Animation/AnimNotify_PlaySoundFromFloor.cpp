@@ -3,8 +3,7 @@
 
 #include "Utility/Animation/AnimNotify_PlaySoundFromFloor.h"
 
-#include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetSystemLibrary.h"
+#include "Utility/Animation/FootstepSurfaceSubsystem.h"
 #include "Utility/Sound/SoundResponseConfigs.h"
 
 UAnimNotify_PlaySoundFromFloor::UAnimNotify_PlaySoundFromFloor() : ScanLength(20.f), VolumeMultiplier(1.f),
@@ -16,18 +15,11 @@ void UAnimNotify_PlaySoundFromFloor::Notify(USkeletalMeshComponent* MeshComp, UA
                                             const FAnimNotifyEventReference& EventReference)
 {
 	Super::Notify(MeshComp, Animation, EventReference);
-	FVector TraceStart;
-	if(MeshComp->DoesSocketExist(ScanStartSocket)) TraceStart = MeshComp->GetSocketLocation(ScanStartSocket);
-	else TraceStart = MeshComp->GetComponentLocation();
-	FHitResult HitResult;
-	UKismetSystemLibrary::LineTraceSingle(MeshComp->GetWorld(), TraceStart, TraceStart + FVector(0.f, 0.f, -ScanLength),
-		UEngineTypes::ConvertToTraceType(ECC_Camera), true, {},
-		EDrawDebugTrace::None, HitResult, true);
-	
-	if(!HitResult.bBlockingHit) return;
-	const EPhysicalSurface PhysicalSurfaceType = UGameplayStatics::GetSurfaceType(HitResult);
+	//the scan is shared with the other footstep notifies of this frame
+	const FFootstepFloor Floor = UFootstepSurfaceSubsystem::FindFloor(MeshComp, ScanStartSocket, ScanLength);
+	if(!Floor.bHasFloor) return;
 
 	if(!IsValid(SoundResponseConfig.Get())) return;
-	const FSoundConfig SoundConfig = SoundResponseConfig.GetDefaultObject()->GetPhysicsResponses().FindRef(PhysicalSurfaceType);
-	SoundConfig.PlaySoundAtLocation(MeshComp->GetWorld(), HitResult.Location, VolumeMultiplier, PitchMultiplier);
+	const FSoundConfig& SoundConfig = SoundResponseConfig.GetDefaultObject()->GetResponse(Floor.SurfaceType);
+	SoundConfig.PlaySoundAtLocation(MeshComp->GetWorld(), Floor.Location, VolumeMultiplier, PitchMultiplier);
 }
@@ -3,9 +3,8 @@
 
 #include "Utility/Animation/AnimNotify_ReportAINoiseEvent.h"
 
-#include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "Perception/AISense_Hearing.h"
+#include "Utility/Animation/FootstepSurfaceSubsystem.h"
 #include "Utility/Sound/SoundResponseConfigs.h"
 
 UAnimNotify_ReportAINoiseEvent::UAnimNotify_ReportAINoiseEvent(): bScanForFloor(false), ScanLength(20.f),
@@ -19,25 +18,19 @@ void UAnimNotify_ReportAINoiseEvent::Notify(USkeletalMeshComponent* MeshComp, UA
 {
 	Super::Notify(MeshComp, Animation, EventReference);
 	FVector SoundLocation;
-	if(MeshComp->DoesSocketExist(Socket)) SoundLocation = MeshComp->GetSocketLocation(Socket);
-	else SoundLocation = MeshComp->GetComponentLocation();
-
 	float ResultingLoudness = AILoudness;
 	if(bScanForFloor)
 	{
-		FHitResult HitResult;
-		UKismetSystemLibrary::LineTraceSingle(MeshComp->GetWorld(), SoundLocation, 
-		SoundLocation + FVector(0.f, 0.f, -ScanLength),
-			UEngineTypes::ConvertToTraceType(ECC_Camera), true, {},
-			EDrawDebugTrace::None, HitResult, true);
-	
-		if(!HitResult.bBlockingHit) return;
-		SoundLocation = HitResult.Location;
-		const EPhysicalSurface PhysicalSurfaceType = UGameplayStatics::GetSurfaceType(HitResult);
+		//the scan is shared with the other footstep notifies of this frame
+		const FFootstepFloor Floor = UFootstepSurfaceSubsystem::FindFloor(MeshComp, Socket, ScanLength);
+		if(!Floor.bHasFloor) return;
+		SoundLocation = Floor.Location;
 
 		if(!IsValid(SoundResponseConfig.Get())) return;
-		ResultingLoudness *= SoundResponseConfig.GetDefaultObject()->GetPhysicsResponses().FindRef(PhysicalSurfaceType);
+		ResultingLoudness *= SoundResponseConfig.GetDefaultObject()->GetResponse(Floor.SurfaceType);
 	}
+	else if(MeshComp->DoesSocketExist(Socket)) SoundLocation = MeshComp->GetSocketLocation(Socket);
+	else SoundLocation = MeshComp->GetComponentLocation();
 
 	//for some reason we cannot use GetWorld() directly as that always returns nullptr
 	UAISense_Hearing::ReportNoiseEvent(MeshComp->GetWorld(), SoundLocation, ResultingLoudness,
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Animation/FootstepSurfaceSubsystem.h"
+
+#include "MAProject.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Footstep Floor Scans"), STAT_FootstepFloorScans, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shared Footstep Floor Scans"), STAT_SharedFootstepFloorScans, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Footstep Floors"), STAT_MovementFootstepFloors, STATGROUP_MAProjectAI);
+
+FFootstepFloor UFootstepSurfaceSubsystem::FindFloor(const USkeletalMeshComponent* MeshComp, FName Socket,
+	float ScanLength)
+{
+	check(IsValid(MeshComp));
+	const UWorld* World = MeshComp->GetWorld();
+	const FVector Start = MeshComp->DoesSocketExist(Socket) ? MeshComp->GetSocketLocation(Socket) :
+		MeshComp->GetComponentLocation();
+	//the subsystem doesn't exist in every world (e.g. animation previews)
+	UFootstepSurfaceSubsystem* Subsystem = World->GetSubsystem<UFootstepSurfaceSubsystem>();
+	if(!IsValid(Subsystem)) return ScanFloor(World, Start, ScanLength);
+
+	if(Subsystem->ScansFrame != GFrameCounter)
+	{
+		Subsystem->Scans.Reset();
+		Subsystem->ScansFrame = GFrameCounter;
+		//the characters that were destroyed don't need their surfaces anymore
+		for(auto Iterator = Subsystem->Surfaces.CreateIterator(); Iterator; ++Iterator)
+		{
+			if(Iterator.Key().ResolveObjectPtr() == nullptr) Iterator.RemoveCurrent();
+		}
+	}
+
+	const AActor* Owner = MeshComp->GetOwner();
+	const UCharacterMovementComponent* MovementComponent = IsValid(Owner) ?
+		Owner->FindComponentByClass<UCharacterMovementComponent>() : nullptr;
+	const FHitResult* MovementFloor = IsValid(MovementComponent) ?
+		FindMovementFloor(MovementComponent, Start, ScanLength) : nullptr;
+	if(MovementFloor == nullptr) return Subsystem->FindSharedFloor(MeshComp, Socket, Start, ScanLength);
+
+	//the movement component doesn't query the physical materials, so the surface is scanned when the floor changes
+	const UPrimitiveComponent* FloorComponent = MovementFloor->GetComponent();
+	FFootstepSurface& Surface = Subsystem->Surfaces.FindOrAdd(MovementComponent);
+	if(Surface.Component != FloorComponent ||
+		FVector::DistSquared2D(Surface.Location, Start) > FMath::Square(MaxSurfaceDistance))
+	{
+		const FFootstepFloor ScannedFloor = Subsystem->FindSharedFloor(MeshComp, Socket, Start, ScanLength);
+		//otherwise something else is below the socket (e.g. the foot is above an edge)
+		if(ScannedFloor.Component == FloorComponent)
+		{
+			Surface = FFootstepSurface(FloorComponent, Start, ScannedFloor.SurfaceType);
+		}
+		return ScannedFloor;
+	}
+
+	INC_DWORD_STAT(STAT_MovementFootstepFloors);
+	FFootstepFloor Floor;
+	Floor.bHasFloor = true;
+	Floor.Location = FVector(Start.X, Start.Y, MovementFloor->ImpactPoint.Z);
+	Floor.Distance = Start.Z - MovementFloor->ImpactPoint.Z;
+	Floor.SurfaceType = Surface.SurfaceType;
+	Floor.Component = FloorComponent;
+	return Floor;
+}
+
+const FHitResult* UFootstepSurfaceSubsystem::FindMovementFloor(const UCharacterMovementComponent* MovementComponent,
+	const FVector& Start, float ScanLength)
+{
+	const FFindFloorResult& MovementFloor = MovementComponent->CurrentFloor;
+	if(!MovementComponent->IsMovingOnGround() || !MovementFloor.IsWalkableFloor() ||
+		!IsValid(MovementFloor.HitResult.GetComponent())) return nullptr;
+	//the floor is straight below the character, not necessarily below the socket
+	const float Distance = Start.Z - MovementFloor.HitResult.ImpactPoint.Z;
+	if(Distance < 0.f || Distance > ScanLength) return nullptr;
+	return &MovementFloor.HitResult;
+}
+
+FFootstepFloor UFootstepSurfaceSubsystem::FindSharedFloor(const USkeletalMeshComponent* MeshComp, FName Socket,
+	const FVector& Start, float ScanLength)
+{
+	FFootstepFloorScan& Scan = Scans.FindOrAdd(MakeTuple(TObjectKey<USkeletalMeshComponent>(MeshComp), Socket));
+	//an earlier scan answers the request if it found a floor within the length or didn't find one within a longer one
+	if(Scan.ScanLength > 0.f && (Scan.Floor.bHasFloor ? Scan.Floor.Distance <= ScanLength :
+		Scan.ScanLength >= ScanLength))
+	{
+		INC_DWORD_STAT(STAT_SharedFootstepFloorScans);
+		return Scan.Floor;
+	}
+	Scan = FFootstepFloorScan(ScanLength, ScanFloor(MeshComp->GetWorld(), Start, ScanLength));
+	return Scan.Floor;
+}
+
+FFootstepFloor UFootstepSurfaceSubsystem::ScanFloor(const UWorld* World, const FVector& Start, float ScanLength)
+{
+	INC_DWORD_STAT(STAT_FootstepFloorScans);
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FootstepFloor), true);
+	QueryParams.bReturnPhysicalMaterial = true;
+	FHitResult HitResult;
+	FFootstepFloor Floor;
+	if(!World->LineTraceSingleByChannel(HitResult, Start, Start + FVector(0.f, 0.f, -ScanLength), ECC_Camera,
+		QueryParams)) return Floor;
+	Floor.bHasFloor = true;
+	Floor.Location = HitResult.Location;
+	Floor.Distance = HitResult.Distance;
+	Floor.SurfaceType = UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
+	Floor.Component = HitResult.GetComponent();
+	return Floor;
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "FootstepSurfaceSubsystem.generated.h"
+
+class UCharacterMovementComponent;
+class UPrimitiveComponent;
+
+//The floor found below a socket of a mesh
+struct FFootstepFloor
+{
+	FFootstepFloor() : bHasFloor(false), Location(NAN), Distance(0.f), SurfaceType(SurfaceType_Default){}
+
+	bool bHasFloor;
+	FVector Location;
+	//from the start of the scan (only valid if there is a floor)
+	float Distance;
+	EPhysicalSurface SurfaceType;
+	//the component the floor belongs to
+	TWeakObjectPtr<const UPrimitiveComponent> Component;
+};
+
+//A scan of the current frame
+struct FFootstepFloorScan
+{
+	FFootstepFloorScan() : ScanLength(0.f){}
+	FFootstepFloorScan(float NewScanLength, const FFootstepFloor& NewFloor) : ScanLength(NewScanLength), Floor(NewFloor){}
+
+	float ScanLength;
+	FFootstepFloor Floor;
+};
+
+//The surface of the floor a character last walked on
+struct FFootstepSurface
+{
+	FFootstepSurface() : Location(NAN), SurfaceType(SurfaceType_Default){}
+	FFootstepSurface(const UPrimitiveComponent* NewComponent, const FVector& NewLocation,
+		EPhysicalSurface NewSurfaceType) : Component(NewComponent), Location(NewLocation), SurfaceType(NewSurfaceType){}
+
+	TWeakObjectPtr<const UPrimitiveComponent> Component;
+	//where the surface was scanned
+	FVector Location;
+	EPhysicalSurface SurfaceType;
+};
+
+/**
+ * Finds the floors of the footstep notifies (sounds and AI noise). Walking characters use the floor of their movement
+ * component and only scan for its surface when they step onto another component or moved away from the last scan. All scans are shared between the
+ * notifies of the same socket within a frame.
+ */
+UCLASS()
+class UFootstepSurfaceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Finds the floor at most ScanLength below the socket (or the mesh itself if it doesn't have the socket)
+	static FFootstepFloor FindFloor(const USkeletalMeshComponent* MeshComp, FName Socket, float ScanLength);
+
+protected:
+	//only contains the scans of the frame with the same number
+	TMap<TPair<TObjectKey<USkeletalMeshComponent>, FName>, FFootstepFloorScan> Scans;
+	uint64 ScansFrame = 0;
+	TMap<TObjectKey<UCharacterMovementComponent>, FFootstepSurface> Surfaces;
+
+	//how far a character can move on the same component before its surface is scanned again (landscapes and meshes
+	//can have several physical materials)
+	static constexpr double MaxSurfaceDistance = 100.0;
+
+	//Returns the walkable floor of the movement component if the socket can reach it (or nullptr)
+	static const FHitResult* FindMovementFloor(const UCharacterMovementComponent* MovementComponent,
+		const FVector& Start, float ScanLength);
+	FFootstepFloor FindSharedFloor(const USkeletalMeshComponent* MeshComp, FName Socket, const FVector& Start,
+		float ScanLength);
+	static FFootstepFloor ScanFloor(const UWorld* World, const FVector& Start, float ScanLength);
+};
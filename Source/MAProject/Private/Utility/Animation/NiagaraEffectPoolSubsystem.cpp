@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Animation/NiagaraEffectPoolSubsystem.h"
+
+#include "MAProject.h"
+#include "NiagaraSystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effect Pool Hits"), STAT_EffectPoolHits, STATGROUP_MAProjectEffects);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effect Pool Misses"), STAT_EffectPoolMisses, STATGROUP_MAProjectEffects);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Pooled Effects"), STAT_LivePooledEffects, STATGROUP_MAProjectEffects);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Peak Live Pooled Effects"), STAT_PeakLivePooledEffects, STATGROUP_MAProjectEffects);
+
+FNiagaraEffectParameter::FNiagaraEffectParameter(const UNiagaraSystem* System, const FNiagaraTypeDefinition& Type,
+	FName Name) : bExists(false)
+{
+	//like with the setters of the component, names without a namespace refer to user parameters
+	const FString NameString = Name.ToString();
+	Variable = FNiagaraVariable(Type, NameString.StartsWith(TEXT("User.")) ? Name : FName(TEXT("User.") + NameString));
+	bExists = IsValid(System) && System->GetExposedParameters().FindParameterOffset(Variable) != nullptr;
+}
+
+UNiagaraEffectPoolSubsystem::UNiagaraEffectPoolSubsystem() : NumOfLiveComponents(0), PeakNumOfLiveComponents(0),
+	PrewarmCount(4), MaxFreeComponents(32)
+{
+}
+
+UNiagaraComponent* UNiagaraEffectPoolSubsystem::SpawnAttached(UNiagaraSystem* System,
+	USceneComponent* AttachToComponent, FName SocketName, const FVector& Location, const FRotator& Rotation,
+	const FVector& Scale, EAttachLocation::Type LocationType)
+{
+	check(IsValid(AttachToComponent));
+	UNiagaraComponent* Component = Acquire(System);
+	if(Component == nullptr) return nullptr;
+	Component->SetAbsolute(false, false, false);
+	Component->AttachToComponent(AttachToComponent, FAttachmentTransformRules::KeepRelativeTransform, SocketName);
+	if(LocationType == EAttachLocation::KeepWorldPosition) Component->SetWorldLocationAndRotation(Location, Rotation);
+	else Component->SetRelativeLocationAndRotation(Location, Rotation);
+	Component->SetRelativeScale3D(Scale);
+	Component->Activate(true);
+	return Component;
+}
+
+UNiagaraComponent* UNiagaraEffectPoolSubsystem::SpawnAtLocation(UNiagaraSystem* System, const FVector& Location,
+	const FRotator& Rotation, const FVector& Scale)
+{
+	UNiagaraComponent* Component = Acquire(System);
+	if(Component == nullptr) return nullptr;
+	Component->SetAbsolute(true, true, true);
+	Component->SetWorldLocationAndRotation(Location, Rotation);
+	Component->SetRelativeScale3D(Scale);
+	Component->Activate(true);
+	return Component;
+}
+
+void UNiagaraEffectPoolSubsystem::Prewarm(UNiagaraSystem* System)
+{
+	if(!IsValid(System)) return;
+	FNiagaraEffectPool& Pool = Pools.FindOrAdd(System);
+	while(Pool.FreeComponents.Num() < PrewarmCount) Pool.FreeComponents.Add(CreateComponent(System));
+}
+
+void UNiagaraEffectPoolSubsystem::Deinitialize()
+{
+	Pools.Reset();
+	OwnedComponents.Reset();
+	Super::Deinitialize();
+}
+
+UNiagaraComponent* UNiagaraEffectPoolSubsystem::Acquire(UNiagaraSystem* System)
+{
+	if(!IsValid(System)) return nullptr;
+	if(!Pools.Contains(System)) Prewarm(System);
+	FNiagaraEffectPool& Pool = Pools.FindChecked(System);
+
+	UNiagaraComponent* Component = nullptr;
+	while(Component == nullptr && !Pool.FreeComponents.IsEmpty())
+	{
+		Component = Pool.FreeComponents.Pop(false).Get();
+		//the component may have been destroyed together with something it was attached to
+		if(!IsValid(Component)) Component = nullptr;
+	}
+	if(Component != nullptr)
+	{
+		INC_DWORD_STAT(STAT_EffectPoolHits);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_EffectPoolMisses);
+		OwnedComponents.RemoveAllSwap([](const UNiagaraComponent* Other){ return !IsValid(Other); }, false);
+		Component = CreateComponent(System);
+	}
+
+	NumOfLiveComponents++;
+	PeakNumOfLiveComponents = FMath::Max(PeakNumOfLiveComponents, NumOfLiveComponents);
+	SET_DWORD_STAT(STAT_LivePooledEffects, NumOfLiveComponents);
+	SET_DWORD_STAT(STAT_PeakLivePooledEffects, PeakNumOfLiveComponents);
+	return Component;
+}
+
+UNiagaraComponent* UNiagaraEffectPoolSubsystem::CreateComponent(UNiagaraSystem* System)
+{
+	UNiagaraComponent* Component = NewObject<UNiagaraComponent>(GetWorld());
+	Component->SetAutoDestroy(false);
+	Component->bAutoActivate = false;
+	Component->SetAsset(System);
+	Component->OnSystemFinished.AddDynamic(this, &UNiagaraEffectPoolSubsystem::OnEffectFinished);
+	Component->RegisterComponentWithWorld(GetWorld());
+	OwnedComponents.Add(Component);
+	return Component;
+}
+
+void UNiagaraEffectPoolSubsystem::OnEffectFinished(UNiagaraComponent* Component)
+{
+	FNiagaraEffectPool* Pool = Pools.Find(Component->GetAsset());
+	if(Pool == nullptr || Pool->FreeComponents.Contains(Component)) return;
+	NumOfLiveComponents = FMath::Max(NumOfLiveComponents - 1, 0);
+	SET_DWORD_STAT(STAT_LivePooledEffects, NumOfLiveComponents);
+	if(!IsValid(Component)) return;
+
+	if(Pool->FreeComponents.Num() >= MaxFreeComponents)
+	{
+		OwnedComponents.RemoveSingleSwap(Component, false);
+		Component->DestroyComponent();
+		return;
+	}
+	//like with the engine's pool, the next spawn has to start out like a newly created component
+	Component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	Component->ComponentTags.Reset();
+	Component->SetUserParametersToDefaultValues();
+	Component->EmptyOverrideMaterials();
+	Pool->FreeComponents.Add(Component);
+}
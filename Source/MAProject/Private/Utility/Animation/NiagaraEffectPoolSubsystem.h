@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NiagaraEffectPoolSubsystem.generated.h"
+
+class UNiagaraSystem;
+
+//A user parameter of a Niagara system, resolved once instead of by name whenever an effect is spawned
+struct FNiagaraEffectParameter
+{
+	FNiagaraEffectParameter() : bExists(false){}
+	FNiagaraEffectParameter(const UNiagaraSystem* System, const FNiagaraTypeDefinition& Type, FName Name);
+
+	//Does nothing if the system doesn't have the parameter
+	template<typename T>
+	void Set(UNiagaraComponent* Component, const T& Value) const
+	{
+		if(bExists) Component->GetOverrideParameters().SetParameterValue(Value, Variable, true);
+	}
+
+	FNiagaraVariable Variable;
+	bool bExists;
+};
+
+//The components of a single system that are currently not in use
+struct FNiagaraEffectPool
+{
+	TArray<TWeakObjectPtr<UNiagaraComponent>> FreeComponents;
+};
+
+/**
+ * Reuses the components of short lived Niagara effects (e.g. hit effects) instead of creating and destroying one for
+ * every spawn. The pool of a system is pre-warmed when it is first used and components return to it once their system
+ * has finished.
+ */
+UCLASS(Config=Game)
+class UNiagaraEffectPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UNiagaraEffectPoolSubsystem();
+
+	UNiagaraComponent* SpawnAttached(UNiagaraSystem* System, USceneComponent* AttachToComponent, FName SocketName,
+		const FVector& Location, const FRotator& Rotation, const FVector& Scale, EAttachLocation::Type LocationType);
+	UNiagaraComponent* SpawnAtLocation(UNiagaraSystem* System, const FVector& Location, const FRotator& Rotation,
+		const FVector& Scale);
+	//Fills the pool of the system up to the pre-warm count
+	void Prewarm(UNiagaraSystem* System);
+
+	virtual void Deinitialize() override;
+
+protected:
+	TMap<TObjectKey<UNiagaraSystem>, FNiagaraEffectPool> Pools;
+	//all components created by the pool (so they aren't garbage collected while in use)
+	UPROPERTY()
+	TArray<UNiagaraComponent*> OwnedComponents;
+	int32 NumOfLiveComponents;
+	int32 PeakNumOfLiveComponents;
+
+	//the number of components created when a system is first used
+	UPROPERTY(Config)
+	int32 PrewarmCount;
+	//finished components beyond this number are destroyed instead of being kept for later use
+	UPROPERTY(Config)
+	int32 MaxFreeComponents;
+
+	UNiagaraComponent* Acquire(UNiagaraSystem* System);
+	UNiagaraComponent* CreateComponent(UNiagaraSystem* System);
+	UFUNCTION()
+	void OnEffectFinished(UNiagaraComponent* Component);
+};
@@ -0,0 +1,239 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Benchmark/CombatBenchmarkCommandlet.h"
+
+#include "MAProject.h"
+#include "NavigationSystem.h"
+#include "Characters/Fighters/Opponents/OpponentCharacter.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCombatBenchmark, Log, All);
+
+UCombatBenchmarkCommandlet::UCombatBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCombatBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapName;
+	FString OpponentClassName;
+	if(!FParse::Value(*Params, TEXT("Map="), MapName) || !FParse::Value(*Params, TEXT("OpponentClass="), OpponentClassName))
+	{
+		UE_LOG(LogCombatBenchmark, Error, TEXT("Usage: -run=CombatBenchmark -Map=<map> -OpponentClass=<class path>"));
+		return 1;
+	}
+	int32 OpponentCount = 16;
+	int32 Frames = 900;
+	int32 WarmupFrames = 60;
+	uint64 Seed = 0;
+	float FramesPerSecond = 30.f;
+	float SpawnRadius = 1500.f;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("CombatBenchmark.json");
+	FParse::Value(*Params, TEXT("Opponents="), OpponentCount);
+	FParse::Value(*Params, TEXT("Frames="), Frames);
+	FParse::Value(*Params, TEXT("WarmupFrames="), WarmupFrames);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("FPS="), FramesPerSecond);
+	FParse::Value(*Params, TEXT("SpawnRadius="), SpawnRadius);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	const float DeltaTime = 1.f / FMath::Max(FramesPerSecond, 1.f);
+
+	UClass* OpponentClass = LoadClass<AOpponentCharacter>(nullptr, *OpponentClassName);
+	if(OpponentClass == nullptr)
+	{
+		UE_LOG(LogCombatBenchmark, Error, TEXT("%s is not an opponent class"), *OpponentClassName);
+		return 1;
+	}
+	UWorld* World = LoadGameWorld(MapName);
+	if(World == nullptr)
+	{
+		UE_LOG(LogCombatBenchmark, Error, TEXT("Failed to load %s"), *MapName);
+		return 1;
+	}
+
+	//all randomness of the fight comes from seeded generators, so every run of a build plays out the same way
+	pcg32 RandomGenerator(Seed);
+	AOpponentCharacter::SeedRandomGenerator(Seed, FSeedOpponentRandomGeneratorKey());
+	FMath::RandInit(static_cast<int32>(Seed));
+
+	//the player controller spawns the player character and registers it with the combat manager
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	APlayerController* PlayerController = World->SpawnActor<APlayerController>(IsValid(GameMode) ?
+		GameMode->PlayerControllerClass.Get() : APlayerController::StaticClass());
+	APawn* PlayerPawn = IsValid(PlayerController) ? PlayerController->GetPawn() : nullptr;
+	if(!IsValid(PlayerPawn))
+	{
+		UE_LOG(LogCombatBenchmark, Error, TEXT("The player controller of %s didn't spawn a player pawn"), *MapName);
+		DestroyGameWorld(World);
+		return 1;
+	}
+	const FVector Origin = PlayerPawn->GetActorLocation();
+	const int32 SpawnedOpponents = SpawnOpponents(World, OpponentClass, OpponentCount, Origin, SpawnRadius,
+		RandomGenerator);
+
+	TArray<double> FrameMilliseconds;
+	FrameMilliseconds.Reserve(Frames);
+	FVector Waypoint = Origin;
+	for(int32 Frame = 0; Frame < WarmupFrames + Frames; Frame++)
+	{
+		if(Frame == WarmupFrames) FCombatBenchmarkRecorder::StartRecording();
+		if(IsValid(PlayerPawn)) DriveScriptedPlayer(PlayerPawn, Origin, SpawnRadius, Frame, RandomGenerator, Waypoint);
+		const uint64 FrameStart = FPlatformTime::Cycles64();
+		World->Tick(LEVELTICK_All, DeltaTime);
+		GFrameCounter++;
+		if(!FCombatBenchmarkRecorder::IsRecording()) continue;
+		FrameMilliseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - FrameStart));
+		FCombatBenchmarkRecorder::EndFrame();
+	}
+	FCombatBenchmarkRecorder::StopRecording();
+
+	const TSharedRef<FJsonObject> Settings = MakeShared<FJsonObject>();
+	Settings->SetStringField(TEXT("map"), MapName);
+	Settings->SetStringField(TEXT("opponentClass"), OpponentClassName);
+	Settings->SetNumberField(TEXT("opponents"), SpawnedOpponents);
+	Settings->SetNumberField(TEXT("frames"), Frames);
+	Settings->SetNumberField(TEXT("warmupFrames"), WarmupFrames);
+	Settings->SetNumberField(TEXT("seed"), static_cast<double>(Seed));
+	Settings->SetNumberField(TEXT("deltaTime"), DeltaTime);
+	const bool WroteReport = WriteReport(OutputPath, Settings, FrameMilliseconds);
+	DestroyGameWorld(World);
+	return WroteReport ? 0 : 1;
+}
+
+UWorld* UCombatBenchmarkCommandlet::LoadGameWorld(const FString& MapName)
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage == nullptr ? nullptr : UWorld::FindWorldInPackage(MapPackage);
+	if(World == nullptr) return nullptr;
+
+	World->WorldType = EWorldType::Game;
+	World->AddToRoot();
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	GWorld = World;
+	if(!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreatePhysicsScene(true)
+			.CreateNavigation(true).CreateAISystem(true).ShouldSimulatePhysics(false).EnableTraceCollision(true));
+	}
+	World->UpdateWorldComponents(true, false);
+
+	const FURL URL;
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+	return World;
+}
+
+void UCombatBenchmarkCommandlet::DestroyGameWorld(UWorld* World)
+{
+	World->EndPlay(EEndPlayReason::Quit);
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	GWorld = nullptr;
+}
+
+int32 UCombatBenchmarkCommandlet::SpawnOpponents(UWorld* World, UClass* OpponentClass, int32 Count,
+	const FVector& Center, float Radius, pcg32& RandomGenerator)
+{
+	const UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	std::uniform_real_distribution<double> AngleDistribution(0.0, DOUBLE_TWO_PI);
+	std::uniform_real_distribution<double> RadiusDistribution(0.25, 1.0);
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+
+	int32 Spawned = 0;
+	//opponents that can't be placed are retried at another location, but the attempts are limited for broken maps
+	for(int32 Attempt = 0; Attempt < Count * 4 && Spawned < Count; Attempt++)
+	{
+		const double Angle = AngleDistribution(RandomGenerator);
+		const FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * Radius *
+			RadiusDistribution(RandomGenerator);
+		FNavLocation ProjectedLocation;
+		if(NavigationSystem == nullptr ||
+			!NavigationSystem->ProjectPointToNavigation(Location, ProjectedLocation, FVector(200.0))) continue;
+
+		const FRotator Rotation = (Center - ProjectedLocation.Location).GetSafeNormal2D().Rotation();
+		APawn* Opponent = World->SpawnActor<APawn>(OpponentClass, ProjectedLocation.Location +
+			FVector(0.0, 0.0, 100.0), Rotation, SpawnParameters);
+		if(!IsValid(Opponent)) continue;
+		if(!IsValid(Opponent->GetController())) Opponent->SpawnDefaultController();
+		Spawned++;
+	}
+	if(Spawned < Count)
+	{
+		UE_LOG(LogCombatBenchmark, Warning, TEXT("Only %d of %d opponents could be spawned"), Spawned, Count);
+	}
+	return Spawned;
+}
+
+void UCombatBenchmarkCommandlet::DriveScriptedPlayer(APawn* PlayerPawn, const FVector& Origin, float Radius,
+	int32 Frame, pcg32& RandomGenerator, FVector& Waypoint)
+{
+	//a new waypoint every few seconds (at 30fps), or as soon as the current one is reached
+	if(Frame % 120 == 0 || FVector::DistSquared2D(PlayerPawn->GetActorLocation(), Waypoint) < FMath::Square(100.0))
+	{
+		std::uniform_real_distribution<double> Distribution(-1.0, 1.0);
+		Waypoint = Origin + FVector(Distribution(RandomGenerator), Distribution(RandomGenerator), 0.0) * Radius * 0.5;
+	}
+	PlayerPawn->AddMovementInput((Waypoint - PlayerPawn->GetActorLocation()).GetSafeNormal2D());
+}
+
+bool UCombatBenchmarkCommandlet::WriteReport(const FString& OutputPath, const TSharedRef<FJsonObject>& Settings,
+	TArray<double>& FrameMilliseconds)
+{
+	const int32 RecordedFrames = FMath::Max(FrameMilliseconds.Num(), 1);
+	const TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetObjectField(TEXT("settings"), Settings);
+
+	double TotalFrameMilliseconds = 0.0;
+	for(const double Milliseconds : FrameMilliseconds) TotalFrameMilliseconds += Milliseconds;
+	FrameMilliseconds.Sort();
+	const TSharedRef<FJsonObject> FrameReport = MakeShared<FJsonObject>();
+	FrameReport->SetNumberField(TEXT("averageMs"), TotalFrameMilliseconds / RecordedFrames);
+	FrameReport->SetNumberField(TEXT("p95Ms"), FrameMilliseconds.IsEmpty() ? 0.0 :
+		FrameMilliseconds[FMath::Min(FMath::FloorToInt32(FrameMilliseconds.Num() * 0.95), FrameMilliseconds.Num() - 1)]);
+	FrameReport->SetNumberField(TEXT("maxMs"), FrameMilliseconds.IsEmpty() ? 0.0 : FrameMilliseconds.Last());
+	Report->SetObjectField(TEXT("frame"), FrameReport);
+
+	//sorted by name, so the reports of different builds can be diffed line by line
+	TArray<FName> Scopes;
+	FCombatBenchmarkRecorder::GetTimings().GetKeys(Scopes);
+	Scopes.Sort(FNameLexicalLess());
+	const TSharedRef<FJsonObject> ScopesReport = MakeShared<FJsonObject>();
+	for(const FName Scope : Scopes)
+	{
+		const FCombatBenchmarkTiming& Timing = FCombatBenchmarkRecorder::GetTimings()[Scope];
+		const double TotalMilliseconds = FPlatformTime::ToMilliseconds64(Timing.TotalCycles);
+		const TSharedRef<FJsonObject> ScopeReport = MakeShared<FJsonObject>();
+		ScopeReport->SetNumberField(TEXT("calls"), static_cast<double>(Timing.Calls));
+		ScopeReport->SetNumberField(TEXT("totalMs"), TotalMilliseconds);
+		ScopeReport->SetNumberField(TEXT("averageMsPerFrame"), TotalMilliseconds / RecordedFrames);
+		ScopeReport->SetNumberField(TEXT("maxFrameMs"), FPlatformTime::ToMilliseconds64(Timing.MaxFrameCycles));
+		ScopesReport->SetObjectField(Scope.ToString(), ScopeReport);
+	}
+	Report->SetObjectField(TEXT("scopes"), ScopesReport);
+
+	FString Output;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+	if(!FJsonSerializer::Serialize(Report, Writer) || !FFileHelper::SaveStringToFile(Output, *OutputPath))
+	{
+		UE_LOG(LogCombatBenchmark, Error, TEXT("Failed to write the report to %s"), *OutputPath);
+		return false;
+	}
+	UE_LOG(LogCombatBenchmark, Display, TEXT("Wrote the combat benchmark report to %s"), *OutputPath);
+	return true;
+}
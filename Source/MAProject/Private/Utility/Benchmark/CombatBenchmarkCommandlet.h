@@ -0,0 +1,40 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Utility/Tools/pcg-cpp/include/pcg_random.hpp"
+#include "CombatBenchmarkCommandlet.generated.h"
+
+class AOpponentCharacter;
+class FJsonObject;
+
+/**
+ * Runs a deterministic headless fight and writes the timings of the combat AI scopes to a JSON file, which can be
+ * diffed between builds. Besides the project's own scopes, this includes the behavior tree ticks of the opponents
+ * and the ticks of the perception system. The map needs a navigation mesh, a combat manager and a player start.
+ * UnrealEditor-Cmd MAProject.uproject -run=CombatBenchmark -Map=/Game/Maps/Benchmark
+ *	-OpponentClass=/Game/Characters/BP_Opponent.BP_Opponent_C -nullrhi -unattended
+ * Optional: -Opponents=16 -Frames=900 -WarmupFrames=60 -Seed=0 -FPS=30 -SpawnRadius=1500 -Output=<path>.json
+ */
+UCLASS()
+class UCombatBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCombatBenchmarkCommandlet();
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	static UWorld* LoadGameWorld(const FString& MapName);
+	static void DestroyGameWorld(UWorld* World);
+	static int32 SpawnOpponents(UWorld* World, UClass* OpponentClass, int32 Count, const FVector& Center, float Radius,
+		pcg32& RandomGenerator);
+	//moves the player pawn between random points around where it started, so the opponents have to follow
+	static void DriveScriptedPlayer(APawn* PlayerPawn, const FVector& Origin, float Radius, int32 Frame,
+		pcg32& RandomGenerator, FVector& Waypoint);
+	static bool WriteReport(const FString& OutputPath, const TSharedRef<FJsonObject>& Settings,
+		TArray<double>& FrameMilliseconds);
+};
@@ -0,0 +1,35 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Benchmark/CombatBenchmarkRecorder.h"
+
+void FCombatBenchmarkRecorder::StartRecording()
+{
+	check(IsInGameThread());
+	Timings.Reset();
+	bIsRecording = true;
+}
+
+void FCombatBenchmarkRecorder::StopRecording()
+{
+	EndFrame();
+	bIsRecording = false;
+}
+
+void FCombatBenchmarkRecorder::EndFrame()
+{
+	for(TPair<FName, FCombatBenchmarkTiming>& Timing : Timings)
+	{
+		Timing.Value.MaxFrameCycles = FMath::Max(Timing.Value.MaxFrameCycles, Timing.Value.FrameCycles);
+		Timing.Value.FrameCycles = 0;
+	}
+}
+
+void FCombatBenchmarkRecorder::AddTiming(FName Scope, uint64 Cycles)
+{
+	check(IsInGameThread());
+	FCombatBenchmarkTiming& Timing = Timings.FindOrAdd(Scope);
+	Timing.Calls++;
+	Timing.TotalCycles += Cycles;
+	Timing.FrameCycles += Cycles;
+}
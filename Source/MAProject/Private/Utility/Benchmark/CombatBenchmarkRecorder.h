@@ -0,0 +1,62 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FCombatBenchmarkTiming
+{
+	FCombatBenchmarkTiming() : Calls(0), TotalCycles(0), FrameCycles(0), MaxFrameCycles(0){}
+
+	uint64 Calls;
+	uint64 TotalCycles;
+	//the cycles spent during the current frame
+	uint64 FrameCycles;
+	uint64 MaxFrameCycles;
+};
+
+/**
+ * Accumulates the time spent in the scopes of the combat AI (see MAPROJECT_SCOPE_CYCLE_COUNTER) while a combat
+ * benchmark is recording. Unlike the stats, this also works in builds without stats and can be read directly.
+ * Only the game thread is recorded.
+ */
+class MAPROJECT_API FCombatBenchmarkRecorder
+{
+public:
+	static void StartRecording();
+	static void StopRecording();
+	static bool IsRecording() { return bIsRecording; }
+	//folds the time spent during the current frame into the per frame maxima
+	static void EndFrame();
+	static void AddTiming(FName Scope, uint64 Cycles);
+	static const TMap<FName, FCombatBenchmarkTiming>& GetTimings() { return Timings; }
+	
+private:
+	inline static bool bIsRecording = false;
+	inline static TMap<FName, FCombatBenchmarkTiming> Timings;
+};
+
+class FCombatBenchmarkScope
+{
+public:
+	explicit FCombatBenchmarkScope(FName NewScope) : Scope(NewScope),
+		StartCycles(FCombatBenchmarkRecorder::IsRecording() && IsInGameThread() ? FPlatformTime::Cycles64() : 0){}
+	~FCombatBenchmarkScope()
+	{
+		if(StartCycles != 0) FCombatBenchmarkRecorder::AddTiming(Scope, FPlatformTime::Cycles64() - StartCycles);
+	}
+
+private:
+	FName Scope;
+	uint64 StartCycles;
+};
+
+#if UE_BUILD_SHIPPING
+#define MAPROJECT_SCOPE_CYCLE_COUNTER(Stat) SCOPE_CYCLE_COUNTER(Stat)
+#else
+//a cycle counter whose time is also recorded by running combat benchmarks (using the name of the stat)
+#define MAPROJECT_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	static const FName PREPROCESSOR_JOIN(Stat, _BenchmarkName)(TEXT(#Stat)); \
+	const FCombatBenchmarkScope PREPROCESSOR_JOIN(Stat, _BenchmarkScope)(PREPROCESSOR_JOIN(Stat, _BenchmarkName))
+#endif
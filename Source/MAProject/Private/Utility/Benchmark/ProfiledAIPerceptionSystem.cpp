@@ -0,0 +1,14 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Benchmark/ProfiledAIPerceptionSystem.h"
+
+#include "MAProject.h"
+
+DECLARE_CYCLE_STAT(TEXT("Perception System Tick"), STAT_PerceptionSystemTick, STATGROUP_MAProjectAI);
+
+void UProfiledAIPerceptionSystem::Tick(float DeltaTime)
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_PerceptionSystemTick);
+	Super::Tick(DeltaTime);
+}
@@ -0,0 +1,20 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Perception/AIPerceptionSystem.h"
+#include "ProfiledAIPerceptionSystem.generated.h"
+
+/**
+ * A perception system whose ticks (updating the senses and handing the stimuli to the perception components) are
+ * measured by the combat AI stats (and the combat benchmark). Used through the PerceptionSystemClassName of the AISystem.
+ */
+UCLASS()
+class UProfiledAIPerceptionSystem : public UAIPerceptionSystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+};
@@ -0,0 +1,15 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Benchmark/ProfiledBehaviorTreeComponent.h"
+
+#include "MAProject.h"
+
+DECLARE_CYCLE_STAT(TEXT("Behavior Tree Tick"), STAT_BehaviorTreeTick, STATGROUP_MAProjectAI);
+
+void UProfiledBehaviorTreeComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_BehaviorTreeTick);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
@@ -3,13 +3,27 @@
 
 #include "Utility/CombatManager.h"
 
+#include "MAProject.h"
+#include "Async/ParallelFor.h"
 #include "Characters/Fighters/Attacks/AttackTree/AttackNode.h"
 #include "Characters/Fighters/Opponents/OpponentCharacter.h"
 #include "Characters/Fighters/Opponents/AI/OpponentController.h"
 #include "Characters/Fighters/Player/PlayerCharacter.h"
+#include "DrawDebugHelpers.h"
 #include "Kismet/GameplayStatics.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
 #include "Utility/Sound/GlobalSoundManager.h"
 
+DECLARE_CYCLE_STAT(TEXT("Distribute Aggression Tokens"), STAT_DistributeAggressionTokens, STATGROUP_MAProjectAI);
+DECLARE_CYCLE_STAT(TEXT("Update Participants Snapshot"), STAT_UpdateParticipantsSnapshot, STATGROUP_MAProjectAI);
+DECLARE_CYCLE_STAT(TEXT("Update Reserved Space Grid"), STAT_UpdateReservedSpaceGrid, STATGROUP_MAProjectAI);
+DECLARE_CYCLE_STAT(TEXT("Evaluate Combat Locations"), STAT_EvaluateCombatLocations, STATGROUP_MAProjectAI);
+DECLARE_CYCLE_STAT(TEXT("Resolve Combat Locations"), STAT_ResolveCombatLocations, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Location Queries"), STAT_CombatLocationQueries, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Location Resamples"), STAT_CombatLocationResamples, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Aggression Token Grants"), STAT_AggressionTokenGrants, STATGROUP_MAProjectAI);
+
 
 bool FAggressorInfo::operator==(const FAggressorInfo& AggressionData) const
 {
@@ -18,20 +32,185 @@ bool FAggressorInfo::operator==(const FAggressorInfo& AggressionData) const
 }
 
 FScoredAggressorInfo::FScoredAggressorInfo(AOpponentCharacter* NewHolder, UAttackNode* AttackTreeNode,
-	float NewScore, uint32 NewTokens) : FAggressorInfo(NewHolder, AttackTreeNode, NewTokens), Score(NewScore)
+	float NewScore, uint32 NewTokens, uint32 NewSequence) : FAggressorInfo(NewHolder, AttackTreeNode, NewTokens),
+	Score(NewScore), Sequence(NewSequence)
+{
+}
+
+void FAggressionTokenScheduler::AddRequester(AOpponentCharacter* Requester, double CurrentTime)
+{
+	if(RequestIndices.Contains(Requester)) return;
+	FRequest& Request = Requests.AddDefaulted_GetRef();
+	Request.Info = FAggressorInfo(Requester, nullptr, 0);
+	Request.RequestingSince = CurrentTime;
+	Request.bIsScoreValid = false;
+	RequestIndices.Add(Requester, Requests.Num() - 1);
+}
+
+void FAggressionTokenScheduler::RemoveRequester(const AOpponentCharacter* Requester)
+{
+	int32 Index;
+	if(!RequestIndices.RemoveAndCopyValue(Requester, Index)) return;
+	Requests.RemoveAtSwap(Index, 1, false);
+	if(Requests.IsValidIndex(Index)) RequestIndices[Requests[Index].Info.Aggressor] = Index;
+}
+
+void FAggressionTokenScheduler::InvalidateScore(const AOpponentCharacter* Requester)
+{
+	if(const int32* Index = RequestIndices.Find(Requester)) Requests[*Index].bIsScoreValid = false;
+}
+
+void FAggressionTokenScheduler::Reset()
+{
+	Requests.Reset();
+	RequestIndices.Reset();
+	Queue.Reset();
+}
+
+void FAggressionTokenScheduler::BuildQueue(double CurrentTime, uint32 MaxTokens,
+	TFunctionRef<FAggressionScoreInputs(const AOpponentCharacter*)> GetInputs,
+	TFunctionRef<void(FAggressorInfo&, FAggressionScore&, const FAggressionScoreInputs&)> Scorer,
+	TFunctionRef<float(FAggressorInfo&)> AttackPicker)
+{
+	Stats.Distributions++;
+	//resetting keeps the allocation, so after the first few distributions no memory is allocated anymore
+	Queue.Reset();
+	//the requests are kept in the same order as the passive participants
+	for(int32 i = 0; i < Requests.Num(); i++)
+	{
+		FRequest& Request = Requests[i];
+		//an attack picked for an earlier distribution might not be valid anymore
+		Request.Info.RequestedAttack = nullptr;
+		const FAggressionScoreInputs Inputs = GetInputs(Request.Info.Aggressor);
+		if(!Request.bIsScoreValid || HaveInputsChanged(Request.ScoredInputs, Inputs))
+		{
+			Scorer(Request.Info, Request.Score, Inputs);
+			Request.ScoredInputs = Inputs;
+			Request.bIsScoreValid = true;
+			Stats.Rescores++;
+		}
+		//the time left until the requester can attack is the only part of the score that changes by itself
+		const float Score = AOpponentCharacter::ScaleAggressionScore(Request.Score.BaseScore,
+			FMath::Max(Request.Score.AttackReadyTime - CurrentTime, 0.0));
+		//A score < 0.f means that the given participant cannot become aggressive, so it is not relevant
+		if(Score < 0.f || Request.Info.RequestedTokens > MaxTokens) continue;
+		const float AttackValue = AttackPicker(Request.Info);
+		Queue.Emplace(Request.Info.Aggressor, Request.Info.RequestedAttack, Score + AttackValue,
+			Request.Info.RequestedTokens, i);
+	}
+	Queue.Heapify(&FAggressionTokenScheduler::HasHigherScore);
+}
+
+bool FAggressionTokenScheduler::HaveInputsChanged(const FAggressionScoreInputs& Scored,
+	const FAggressionScoreInputs& Current) const
+{
+	return Scored.bIsPlayerTarget != Current.bIsPlayerTarget || Scored.bCanAttack != Current.bCanAttack ||
+		Scored.AttackSourceIndex != Current.AttackSourceIndex ||
+		FVector::DistSquared(Scored.RequesterLocation, Current.RequesterLocation) > FMath::Square(RescoreDistance) ||
+		FVector::DistSquared(Scored.PlayerLocation, Current.PlayerLocation) > FMath::Square(RescoreDistance) ||
+		(Scored.PlayerViewDirection | Current.PlayerViewDirection) < RescoreViewDot;
+}
+
+FScoredAggressorInfo FAggressionTokenScheduler::PopBest()
+{
+	FScoredAggressorInfo Best;
+	Queue.HeapPop(Best, &FAggressionTokenScheduler::HasHigherScore, false);
+	return Best;
+}
+
+void FAggressionTokenScheduler::OnGranted(const AOpponentCharacter* Requester, double CurrentTime)
+{
+	if(const int32* Index = RequestIndices.Find(Requester))
+	{
+		const double StarvationTime = CurrentTime - Requests[*Index].RequestingSince;
+		Stats.TotalStarvationTime += StarvationTime;
+		Stats.MaxStarvationTime = FMath::Max(Stats.MaxStarvationTime, StarvationTime);
+	}
+	Stats.Grants++;
+	RemoveRequester(Requester);
+}
+
+FCombatLocationQuery::FCombatLocationQuery() : ParticipantStatus(ECombatParticipantStatus::NotRegistered), CombatTargetLocation(NAN), MinRequestedRadius(0.f),
+	CurrentTargetLocation(NAN), ValidationExtent(NAN), ProjectionExtent(NAN), bUseAsyncNavigation(false),
+	bFoundLocation(false),
+	bWasRecalculated(false), ResultingLocation(NAN),
+#if WITH_EDITORONLY_DATA
+	bIsDebugging(false),
+#endif
+	bCurrentTargetLocationValid(false), bCandidatesExhaustive(true), bPathToTargetExists(true),
+	TestedCurrentTargetLocation(NAN),
+	MaxPossibleMatch(0), NextSampleIndex(0), OptimalCandidates(0)
+{
+}
+
+int32 FCombatParticipantsSnapshot::Find(const AOpponentCharacter* Participant) const
+{
+	const int32* Index = Indices.Find(Participant);
+	return Index == nullptr ? INDEX_NONE : *Index;
+}
+
+void FCombatParticipantsSnapshot::Reset()
+{
+	Participants.Reset();
+	Flags.Reset();
+	Locations.Reset();
+	TargetLocations.Reset();
+	FacingPoints.Reset();
+	RequiredSpaces.Reset();
+	MinRequiredRadii.Reset();
+	Indices.Reset();
+}
+
+void FCombatParticipantsSnapshot::Add(AOpponentCharacter* Participant)
+{
+	ECombatParticipantFlags ParticipantFlags = ECombatParticipantFlags::None;
+	FVector FacingPoint(NAN);
+	if(const ACharacter* CombatTarget = Participant->GetCombatTarget(); IsValid(CombatTarget))
+	{
+		FacingPoint = CombatTarget->GetActorLocation();
+		ParticipantFlags |= ECombatParticipantFlags::HasCombatTarget;
+	}
+
+	FVector TargetLocation(NAN);
+	if(const AOpponentController* Controller = Cast<AOpponentController>(Participant->GetController()); IsValid(Controller))
+	{
+		TargetLocation = Controller->GetReservedLocation();
+		if(!TargetLocation.ContainsNaN()) ParticipantFlags |= ECombatParticipantFlags::HasTargetLocation;
+	}
+
+	Indices.Add(Participant, Participants.Add(Participant));
+	Flags.Add(ParticipantFlags);
+	Locations.Add(Participant->GetActorLocation());
+	TargetLocations.Add(TargetLocation);
+	FacingPoints.Add(FacingPoint);
+	const FRequiredSpace& RequiredSpace = RequiredSpaces.Add_GetRef(Participant->GetRequiredSpace());
+	MinRequiredRadii.Add(RequiredSpace.GetMinimalRadius());
+}
+
+TArray<const FPositionalConstraint*> FCombatLocationQuery::GetRelevantConstraints(bool IncludeZoneConstraint) const
 {
+	TArray<const FPositionalConstraint*> RelevantConstraints = {&PlayerDistanceConstraint};
+	if(ReservedSpaceConstraint.Grid != nullptr) RelevantConstraints.Add(&ReservedSpaceConstraint);
+	if(IncludeZoneConstraint) RelevantConstraints.Add(&PlayerZoneConstraint);
+	return RelevantConstraints;
+}
+
+bool FCombatLocationQuery::IsStillValid() const
+{
+	return Participant.IsValid() && AnchorController.IsValid() && IsValid(AnchorController->GetPawn());
 }
 
 // Sets default values
-ACombatManager::ACombatManager() : PlayerCharacter(nullptr), SoundManager(nullptr), PendingOutOfCombatDuration(10.f),
-                                   MaxAggressionTokens(2),
+ACombatManager::ACombatManager() : PlayerCharacter(nullptr), SoundManager(nullptr), ReservedSpaceGridCellSize(200.f),
+                                   PendingOutOfCombatDuration(10.f),
+                                   MaxAggressionTokens(2), AggressionRescoreDistance(50.0),
+                                   AggressionRescoreViewAngle(5.0),
+                                   bUseAsyncNavigationQueries(true),
+                                   MaxAsyncPathQueriesPerParticipant(8),
                                    AvailableAggressionTokens(MaxAggressionTokens)
 {
-#if WITH_EDITORONLY_DATA
+	//ticking is required to solve the combat location requests
 	PrimaryActorTick.bCanEverTick = true;
-#else
-	PrimaryActorTick.bCanEverTick = false;
-#endif
 }
 
 ECombatParticipantStatus ACombatManager::GetParticipationStatus(AFighterCharacter* Character) const
@@ -76,6 +255,9 @@ bool ACombatManager::RegisterCombatParticipant(AOpponentCharacter* Participant,
 		PendingOutOfCombat.Remove(Participant);
 	}
 	PassiveParticipants.Add(Participant);
+	TokenScheduler.AddRequester(Participant, GetWorld()->GetTimeSeconds());
+	Participant->BindOnAggressionScoreInvalidated(TDelegate<void(AOpponentCharacter*)>::CreateUObject(this,
+		&ACombatManager::OnAggressionScoreInvalidated), FEditOnAggressionScoreInvalidatedKey());
 	//try to grant the tokens
 	GrantTokens(FAggressorInfo(Participant, Participant->GetRandomValidAttack(), Participant->GetRequestedTokens()));
 	return true;
@@ -84,9 +266,11 @@ bool ACombatManager::RegisterCombatParticipant(AOpponentCharacter* Participant,
 void ACombatManager::UnregisterCombatParticipant(AOpponentCharacter* Participant, bool SetToPending, FManageCombatParticipantsKey Key)
 {
 	if(AnticipatedActive.Aggressor == Participant) AnticipatedActive = FAggressorInfo();
+	Participant->UnbindOnAggressionScoreInvalidated(this, FEditOnAggressionScoreInvalidatedKey());
 	//we can't use ReleaseAggressionTokens as this could lead to token redistribution and Participant not becoming passive
 	const bool WasActiveParticipant = RemoveAggressionTokens(Participant);
 	PassiveParticipants.RemoveSwap(Participant);
+	TokenScheduler.RemoveRequester(Participant);
 	if(WasActiveParticipant) AttemptDistributeFreeTokens();
 	if(!SetToPending)
 	{
@@ -107,10 +291,93 @@ void ACombatManager::ReleaseAggressionTokens(AOpponentCharacter* Participant, FM
 	if(RemoveAggressionTokens(Participant))	AttemptDistributeFreeTokens();
 }
 
+void ACombatManager::RequestCombatLocation(const AOpponentController* Requester, bool ForceRecalculation,
+	FRequestCombatLocationKey Key)
+{
+	//a participant only needs one location per frame
+	for(TTuple<TWeakObjectPtr<const AOpponentController>, bool>& PendingRequest : PendingCombatLocationRequests)
+	{
+		if(PendingRequest.Key.Get() != Requester) continue;
+		PendingRequest.Value |= ForceRecalculation;
+		return;
+	}
+	PendingCombatLocationRequests.Add({Requester, ForceRecalculation});
+}
+
+void ACombatManager::SolveCombatLocations(TArray<FCombatLocationQuery>& Queries, UWorld* World)
+{
+	EvaluateCombatLocations(Queries, World);
+	ResolveCombatLocations(Queries, World);
+}
+
+void ACombatManager::EvaluateCombatLocations(TArray<FCombatLocationQuery>& Queries, UWorld* World)
+{
+	if(Queries.IsEmpty()) return;
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_EvaluateCombatLocations);
+	INC_DWORD_STAT_BY(STAT_CombatLocationQueries, Queries.Num());
+
+	Queries.StableSort(&ACombatManager::IsSolvedBefore);
+
+	EParallelForFlags ParallelForFlags = EParallelForFlags::None;
 #if WITH_EDITORONLY_DATA
+	//debug drawing is only possible on the game thread
+	for(const FCombatLocationQuery& Query : Queries)
+	{
+		if(Query.bIsDebugging) ParallelForFlags = EParallelForFlags::ForceSingleThread;
+	}
+#endif
+
+	UNavigationSystemV1* NavigationSystem = UNavigationSystemV1::GetNavigationSystem(World);
+	TArray<FCombatLocationQuery*> UnfinishedQueries;
+	for(FCombatLocationQuery& Query : Queries)
+	{
+		if(StartCombatLocationEvaluation(Query, World)) UnfinishedQueries.Add(&Query);
+	}
+
+	//Every resolved query can take away at most one of the optimal candidates of the following queries by reserving it,
+	//so we need at least as many optimal candidates as there are queries to not have to sample again.
+	//The navigation data may only be queried on the game thread, so the sample points are projected (and their path
+	//lengths are checked) here, while only the scoring of the projected points is done on worker threads
+	const int32 RequiredOptimalCandidates = Queries.Num();
+	while(!UnfinishedQueries.IsEmpty())
+	{
+		for(FCombatLocationQuery* Query : UnfinishedQueries)
+		{
+			ProjectCombatLocationSamples(*Query, NavigationSystem, World);
+		}
+		ParallelFor(UnfinishedQueries.Num(), [&UnfinishedQueries, World](int32 Index)
+		{
+			ScoreCombatLocationSamples(*UnfinishedQueries[Index], World);
+		}, ParallelForFlags);
+		for(int32 i = UnfinishedQueries.Num() - 1; i >= 0; i--)
+		{
+			if(CollectCombatLocationCandidates(*UnfinishedQueries[i], NavigationSystem, RequiredOptimalCandidates))
+			{
+				UnfinishedQueries.RemoveAt(i);
+			}
+		}
+	}
+}
+
+void ACombatManager::ResolveCombatLocations(TArray<FCombatLocationQuery>& Queries, UWorld* World)
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_ResolveCombatLocations);
+	TArray<const FCombatLocationQuery*> ResolvedQueries;
+	for(FCombatLocationQuery& Query : Queries)
+	{
+		ResolveCombatLocation(Query, ResolvedQueries, World);
+		ResolvedQueries.Add(&Query);
+	}
+}
+
 void ACombatManager::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
+	UpdateParticipantsSnapshot();
+	UpdateReservedSpaceGrid();
+	SolvePendingCombatLocations();
+	ResolveFinishedCombatLocationBatches();
+#if WITH_EDITORONLY_DATA
 	if(bIsDebugging)
 	{
 		for(const AOpponentCharacter* OpponentCharacter : PassiveParticipants)
@@ -126,8 +393,8 @@ void ACombatManager::Tick(float DeltaSeconds)
 		FVector(1, 0, 0));
 		}
 	}
-}
 #endif
+}
 
 // Called when the game starts or when spawned
 void ACombatManager::BeginPlay()
@@ -135,6 +402,9 @@ void ACombatManager::BeginPlay()
 	Super::BeginPlay();
 
 	AvailableAggressionTokens = MaxAggressionTokens;
+	TokenScheduler.RescoreDistance = AggressionRescoreDistance;
+	TokenScheduler.RescoreViewDot = FMath::Cos(FMath::DegreesToRadians(AggressionRescoreViewAngle));
+	ReservedSpaceGrid = FReservedSpaceGrid(ReservedSpaceGridCellSize);
 
 	//There can only be one combat manager at any given time to prevent logic problems
 	TArray<AActor*> Actors;
@@ -172,6 +442,8 @@ bool ACombatManager::GrantTokens(const FAggressorInfo& AggressorInfo)
 	}
 	if(AggressorInfo.RequestedTokens > AvailableAggressionTokens) return false;
 	AvailableAggressionTokens -= AggressorInfo.RequestedTokens;
+	TokenScheduler.OnGranted(AggressorInfo.Aggressor, GetWorld()->GetTimeSeconds());
+	INC_DWORD_STAT(STAT_AggressionTokenGrants);
 	MakeActiveParticipant(PassiveParticipants.Find(AggressorInfo.Aggressor));
 	AggressorInfo.Aggressor->SetRequestedAttack(AggressorInfo.RequestedAttack, FRequestAttackKey());
 	AggressorInfo.Aggressor->ExecuteOnAggressionTokensGranted(FExecuteOnAggressionTokensGrantedKey());
@@ -198,6 +470,7 @@ bool ACombatManager::MakePassiveParticipant(int32 Index)
 		return false;
 	}
 	PassiveParticipants.Add(ActiveParticipants[Index]);
+	TokenScheduler.AddRequester(ActiveParticipants[Index], GetWorld()->GetTimeSeconds());
 	ActiveParticipants.RemoveAtSwap(Index);
 	return true;
 }
@@ -207,70 +480,77 @@ float ACombatManager::GetAttackValue(UAttackNode* AttackNode, AOpponentCharacter
 	if(!IsValid(AttackNode) || !IsValid(Attacker)) return -1.f;
 	//getOverallValue will often be around 2 and the character's attack stat is around 100
 	//Since we want the attack score to maximally be 6, we multiply with  ~6/200
-	return 0.03f * static_cast<float>(Attacker->GetCharacterStats()->Attack.GetResulting()) *
+	return 0.03f * static_cast<float>(Attacker->GetCharacterStats()->GetAttack()) *
 		AttackNode->GetAttackProperties().GetOverallValue();
 	//we just look at the "default attack", even if this might not be accurate when using contextual attacks
 }
 
 void ACombatManager::AttemptDistributeFreeTokens()
 {
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_DistributeAggressionTokens);
 	if(IsValid(AnticipatedActive.Aggressor) && IsValid(AnticipatedActive.RequestedAttack))
 	{
 		if(!GrantTokens(AnticipatedActive)) return;
 	}
 	
-	//Generate a list of participants trying to become aggressive sorted from best to worst
-	TList<FScoredAggressorInfo>* BestOption = nullptr;
-	for(AOpponentCharacter* Participant : PassiveParticipants)
+	//Queue the participants trying to become aggressive from best to worst
+	const FVector PlayerLocation = PlayerCharacter->GetActorLocation();
+	FVector PlayerEyesLocation;
+	FRotator PlayerViewRotation;
+	PlayerCharacter->GetActorEyesViewPoint(PlayerEyesLocation, PlayerViewRotation);
+	const FVector PlayerViewDirection = PlayerViewRotation.Vector();
+	const AActor* PlayerTarget = PlayerCharacter->GetCurrentTarget();
+	TokenScheduler.BuildQueue(GetWorld()->GetTimeSeconds(), MaxAggressionTokens,
+		[this, &PlayerLocation, &PlayerViewDirection, PlayerTarget](const AOpponentCharacter* Participant)
 	{
-		float Score = Participant->GenerateAggressionScore(PlayerCharacter);
-		//A score < 0.f means that the given participant cannot become aggressive, so it is not relevant
-		if(Score >= 0.f && Participant->GetRequestedTokens() <= MaxAggressionTokens)
-		{
-			UAttackNode* RequestedAttack = Participant->GetRandomValidAttack();
-			Score += GetAttackValue(RequestedAttack, Participant);
-
-			//Add the information generated to the list in the correct place
-			const FScoredAggressorInfo ScoredAggressorInfo(Participant, RequestedAttack, Score, Participant->GetRequestedTokens());
-			TList<FScoredAggressorInfo>** CurrentElement = &BestOption;
-			while(true)
-			{
-				if(*CurrentElement == nullptr)
-				{
-					*CurrentElement = new TList(ScoredAggressorInfo);
-					break;
-				}
-				if(Score > (*CurrentElement)->Element.Score)
-				{
-					TList<FScoredAggressorInfo>* NextElement = *CurrentElement;
-					*CurrentElement = new TList(ScoredAggressorInfo, NextElement);
-					break;
-				}
-				CurrentElement = &(*CurrentElement)->Next;
-			}
-		}
-	}
+		FAggressionScoreInputs Inputs;
+		//the participants that joined combat after the snapshot was taken are not part of it yet
+		const int32 SnapshotIndex = ParticipantsSnapshot.Find(Participant);
+		Inputs.RequesterLocation = SnapshotIndex == INDEX_NONE ? Participant->GetActorLocation() :
+			ParticipantsSnapshot.Locations[SnapshotIndex];
+		Inputs.PlayerLocation = PlayerLocation;
+		Inputs.PlayerViewDirection = PlayerViewDirection;
+		Inputs.AttackSourceIndex = Participant->GetCharacterStats()->Attacks.GetCurrentNodeIndex(GetWorld());
+		Inputs.bIsPlayerTarget = PlayerTarget == Participant;
+		Inputs.bCanAttack = Participant->GetAcceptedInputs().IsAllowedInput(EInputType::Attack);
+		return Inputs;
+	},
+		[this](FAggressorInfo& Request, FAggressionScore& Score, const FAggressionScoreInputs& Inputs)
+	{
+		AOpponentCharacter* Participant = Request.Aggressor;
+		Score.BaseScore = Participant->GenerateBaseAggressionScore(PlayerCharacter, Inputs.RequesterLocation,
+			Inputs.PlayerLocation);
+		Score.AttackReadyTime = Participant->GetAttackReadyTime();
+		Request.RequestedTokens = Participant->GetRequestedTokens();
+	},
+		[](FAggressorInfo& Request)
+	{
+		Request.RequestedAttack = Request.Aggressor->GetRandomValidAttack();
+		return GetAttackValue(Request.RequestedAttack, Request.Aggressor);
+	});
 
-	TList<FScoredAggressorInfo>* CurrentOption = BestOption;
-	while(true)
+	while(!TokenScheduler.IsQueueEmpty())
 	{
-		if(CurrentOption == nullptr) break;
 		//Try grant tokens to the entity, thereby checking whether that is even possible
-		if(!GrantTokens(CurrentOption->Element))
+		if(const FScoredAggressorInfo CurrentOption = TokenScheduler.PopBest(); !GrantTokens(CurrentOption))
 		{
-			if(CurrentOption->Next != nullptr && CurrentOption->Next->Element.RequestedTokens <= AvailableAggressionTokens)
+			if(!TokenScheduler.IsQueueEmpty() && TokenScheduler.PeekBest().RequestedTokens <= AvailableAggressionTokens)
 			{
 				//if an entity requires more tokens than what is left over, and there are still other entities that might
 				//be satisfied with the available amount of tokens, we queue the entity (to be guaranteed to be the
 				//next one to receive a token) before stopping token distribution.
 				//This prevents entities requiring a high amount of tokens from never being able to get active.
-				AnticipatedActive = static_cast<FAggressorInfo>(CurrentOption->Next->Element);
+				AnticipatedActive = static_cast<FAggressorInfo>(TokenScheduler.PeekBest());
 			}
 			else AnticipatedActive = FAggressorInfo();
 			break;
 		}
-		CurrentOption = CurrentOption->Next;
-	}	
+	}
+}
+
+void ACombatManager::OnAggressionScoreInvalidated(AOpponentCharacter* Participant)
+{
+	TokenScheduler.InvalidateScore(Participant);
 }
 
 void ACombatManager::FullyExitFromCombat(AOpponentCharacter* OpponentCharacter)
@@ -284,6 +564,478 @@ void ACombatManager::FullyExitFromCombat(AOpponentCharacter* OpponentCharacter)
 	}
 }
 
+void ACombatManager::UpdateParticipantsSnapshot()
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_UpdateParticipantsSnapshot);
+	ParticipantsSnapshot.Reset();
+	for(AOpponentCharacter* Participant : ActiveParticipants)
+	{
+		if(IsValid(Participant)) ParticipantsSnapshot.Add(Participant);
+	}
+	for(AOpponentCharacter* Participant : PassiveParticipants)
+	{
+		if(IsValid(Participant)) ParticipantsSnapshot.Add(Participant);
+	}
+}
+
+void ACombatManager::UpdateReservedSpaceGrid()
+{
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_UpdateReservedSpaceGrid);
+	CurrentReservations.Reset();
+	constexpr ECombatParticipantFlags RequiredFlags =
+		ECombatParticipantFlags::HasCombatTarget | ECombatParticipantFlags::HasTargetLocation;
+	for(int32 i = 0; i < ParticipantsSnapshot.Num(); i++)
+	{
+		if(!ParticipantsSnapshot.HasFlags(i, RequiredFlags)) continue;
+		CurrentReservations.Add({ParticipantsSnapshot.Participants[i], FReservedSpaceConstraint(
+			ParticipantsSnapshot.RequiredSpaces[i], ParticipantsSnapshot.TargetLocations[i],
+			ParticipantsSnapshot.FacingPoints[i])});
+	}
+	//the participants rarely change their target locations, so the cells can mostly be kept
+	ReservedSpaceGrid.Update(CurrentReservations);
+}
+
+void ACombatManager::SolvePendingCombatLocations()
+{
+	if(PendingCombatLocationRequests.IsEmpty()) return;
+	TArray<TTuple<TWeakObjectPtr<const AOpponentController>, bool>> Requests = MoveTemp(PendingCombatLocationRequests);
+	PendingCombatLocationRequests.Reset();
+
+	//Participants still waiting for the result of an earlier batch are only solved again once that batch is resolved,
+	//so they never get two conflicting locations
+	Requests.RemoveAll([this](const TTuple<TWeakObjectPtr<const AOpponentController>, bool>& Request)
+	{
+		if(!Request.Key.IsValid()) return true;
+		const AOpponentCharacter* Participant = Cast<AOpponentCharacter>(Request.Key->GetPawn());
+		if(Participant == nullptr || !InFlightParticipants.Contains(Participant)) return false;
+		PendingCombatLocationRequests.Add(Request);
+		return true;
+	});
+
+	//the participants solved in this batch don't reserve their old target location, instead they reserve the newly
+	//chosen one during ResolveCombatLocation
+	TArray<AOpponentCharacter*> JointlySolvedParticipants;
+	for(const TTuple<TWeakObjectPtr<const AOpponentController>, bool>& Request : Requests)
+	{
+		if(!Request.Key.IsValid()) continue;
+		if(AOpponentCharacter* Participant = Cast<AOpponentCharacter>(Request.Key->GetPawn()))
+		{
+			JointlySolvedParticipants.Add(Participant);
+		}
+	}
+
+	TArray<FCombatLocationQuery> Queries;
+	for(const TTuple<TWeakObjectPtr<const AOpponentController>, bool>& Request : Requests)
+	{
+		if(!Request.Key.IsValid()) continue;
+		AOpponentCharacter* Participant = Cast<AOpponentCharacter>(Request.Key->GetPawn());
+		if(!IsValid(Participant)) continue;
+		const ECombatParticipantStatus ParticipantStatus = GetParticipationStatus(Participant);
+		//the participant might have left combat since the request was made
+		if(ParticipantStatus != ECombatParticipantStatus::Active && ParticipantStatus != ECombatParticipantStatus::Passive)
+			continue;
+
+		FCombatLocationQuery& Query = Queries.AddDefaulted_GetRef();
+		Query.bUseAsyncNavigation = bUseAsyncNavigationQueries;
+		if(!Request.Key->SetupCombatLocationQuery(Query, ParticipantStatus, Request.Value, JointlySolvedParticipants,
+			FCombatLocationQueryKey()))
+		{
+			//the other participants don't respect its old location anymore, so it can't keep it
+			Request.Key->OnCombatLocationSolved(Queries.Pop(), FCombatLocationQueryKey());
+			continue;
+		}
+		Query.AnchorController = Query.PlayerDistanceConstraint.AnchorController;
+	}
+	if(Queries.IsEmpty()) return;
+
+	//without asynchronous navigation the batch is done right away, but it is still resolved together with the others
+	const TSharedRef<FCombatLocationBatch> Batch = MakeShared<FCombatLocationBatch>();
+	Batch->Queries = MoveTemp(Queries);
+	EvaluateCombatLocations(Batch->Queries, GetWorld());
+	RequestCombatLocationPaths(Batch);
+	for(const FCombatLocationQuery& Query : Batch->Queries)
+	{
+		InFlightParticipants.Add(Batch->Participants.Add_GetRef(Query.Participant.Get()));
+	}
+	CombatLocationBatches.Add(Batch);
+}
+
+void ACombatManager::ResolveFinishedCombatLocationBatches()
+{
+	TArray<FCombatLocationQuery> Queries;
+	CombatLocationBatches.RemoveAll([this, &Queries](const TSharedRef<FCombatLocationBatch>& Batch)
+	{
+		if(Batch->PendingPathQueries > 0) return false;
+		Queries.Append(MoveTemp(Batch->Queries));
+		for(const TObjectKey<AOpponentCharacter>& Participant : Batch->Participants)
+		{
+			InFlightParticipants.Remove(Participant);
+		}
+		return true;
+	});
+
+	//the participant or its combat target might have been destroyed (or the participant might have left combat) while
+	//waiting for the path queries. Without a combat target, the query is delivered without a location, as the
+	//participants resolved together with it ignore its old location
+	for(FCombatLocationQuery& Query : Queries)
+	{
+		if(!Query.IsStillValid()) Query.bPathToTargetExists = false;
+	}
+	Queries.RemoveAll([this](const FCombatLocationQuery& Query)
+	{
+		if(!Query.Participant.IsValid()) return true;
+		const ECombatParticipantStatus ParticipantStatus = GetParticipationStatus(Query.Participant.Get());
+		return ParticipantStatus != ECombatParticipantStatus::Active && ParticipantStatus != ECombatParticipantStatus::Passive;
+	});
+	if(Queries.IsEmpty()) return;
+
+	TArray<const AActor*> JointlyResolvedParticipants;
+	for(const FCombatLocationQuery& Query : Queries)
+	{
+		JointlyResolvedParticipants.Add(Query.Participant.Get());
+	}
+	for(FCombatLocationQuery& Query : Queries)
+	{
+		RefreshReservedSpace(Query, JointlyResolvedParticipants);
+	}
+	Queries.StableSort(&ACombatManager::IsSolvedBefore);
+	ResolveCombatLocations(Queries, GetWorld());
+	DeliverCombatLocations(Queries);
+}
+
+void ACombatManager::RefreshReservedSpace(FCombatLocationQuery& Query,
+	const TArray<const AActor*>& JointlyResolvedParticipants)
+{
+	FReservedSpaceGridConstraint& ReservedSpace = Query.ReservedSpaceConstraint;
+	if(ReservedSpace.Grid == nullptr) return;
+	const uint32 OldMaxMatch = ReservedSpace.GetMaxMatchLevel();
+	for(const AActor* Participant : JointlyResolvedParticipants)
+	{
+		ReservedSpace.IgnoredReservers.AddUnique(Participant);
+	}
+	ReservedSpace.Refresh();
+
+	//the reserved space part of the candidates' match levels has to be replaced with the current one
+	for(FCombatLocationCandidate& Candidate : Query.Candidates)
+	{
+		if(Candidate.MatchLevel == 0) continue;
+		const uint8 ReservedSpaceMatch = ReservedSpace.GetMatchLevel(Candidate.TestedLocation, nullptr);
+		Candidate.MatchLevel = ReservedSpaceMatch == 0 ? 0 : Candidate.MatchLevel - OldMaxMatch + ReservedSpaceMatch;
+	}
+	Query.MaxPossibleMatch = Query.MaxPossibleMatch - FMath::Min(Query.MaxPossibleMatch, OldMaxMatch) +
+		ReservedSpace.GetMaxMatchLevel();
+
+	if(Query.bCurrentTargetLocationValid &&
+		ReservedSpace.GetMatchLevel(Query.TestedCurrentTargetLocation, nullptr) == 0)
+	{
+		//the current target location has been taken in the meantime
+		Query.bCurrentTargetLocationValid = false;
+		Query.bCandidatesExhaustive = false;
+	}
+}
+
+void ACombatManager::DeliverCombatLocations(const TArray<FCombatLocationQuery>& Queries) const
+{
+	for(const FCombatLocationQuery& Query : Queries)
+	{
+		//without a path to the combat target the query has no location, which clears the old one
+		if(!Query.Participant.IsValid()) continue;
+		if(const AOpponentController* Controller = Cast<AOpponentController>(Query.Participant->GetController()))
+		{
+			Controller->OnCombatLocationSolved(Query, FCombatLocationQueryKey());
+		}
+	}
+}
+
+void ACombatManager::RequestCombatLocationPaths(const TSharedRef<FCombatLocationBatch>& Batch)
+{
+	UNavigationSystemV1* NavigationSystem = UNavigationSystemV1::GetNavigationSystem(GetWorld());
+	//the same navigation data as used by UNavigationSystemV1::GetPathLength
+	const ANavigationData* DefaultNavData = IsValid(NavigationSystem) ?
+		NavigationSystem->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+
+	const auto RequestPath = [this, &Batch, NavigationSystem](const ANavigationData& NavData, const FVector& Start,
+		const FVector& End, int32 QueryIndex, int32 CheckIndex)
+	{
+		NavigationSystem->FindPathAsync(NavData.GetConfig(), FPathFindingQuery(this, NavData, Start, End),
+			FNavPathQueryDelegate::CreateUObject(this, &ACombatManager::OnCombatLocationPathFound, Batch,
+				QueryIndex, CheckIndex));
+		Batch->PendingPathQueries++;
+	};
+
+	for(int32 QueryIndex = 0; QueryIndex < Batch->Queries.Num(); QueryIndex++)
+	{
+		FCombatLocationQuery& Query = Batch->Queries[QueryIndex];
+		if(!Query.bUseAsyncNavigation || !Query.PlayerDistanceConstraint.bUseNavPath || !Query.IsStillValid()) continue;
+
+		const ANavigationData* ParticipantNavData = IsValid(NavigationSystem) ?
+			NavigationSystem->GetNavDataForProps(Query.Participant->GetNavAgentPropertiesRef(),
+				Query.Participant->GetNavAgentLocation()) : nullptr;
+		if(!IsValid(ParticipantNavData) || !IsValid(DefaultNavData))
+		{
+			Query.bPathToTargetExists = false;
+			continue;
+		}
+		const FVector AnchorLocation = Query.AnchorController->GetPawn()->GetNavAgentLocation();
+
+		//a path from the NPC to the target has to exist
+		RequestPath(*ParticipantNavData, Query.Participant->GetNavAgentLocation(), AnchorLocation, QueryIndex,
+			CombatTargetReachableCheck);
+
+		if(Query.bCurrentTargetLocationValid)
+		{
+			RequestPath(*DefaultNavData, Query.TestedCurrentTargetLocation, AnchorLocation, QueryIndex,
+				CurrentTargetLocationCheck);
+			continue;
+		}
+
+		//only the best candidates (by the cheap constraints) are checked, in the order they would be chosen
+		Query.Candidates.StableSort([](const FCombatLocationCandidate& A, const FCombatLocationCandidate& B)
+		{
+			return A.MatchLevel > B.MatchLevel;
+		});
+		if(Query.Candidates.Num() > MaxAsyncPathQueriesPerParticipant)
+		{
+			Query.Candidates.SetNum(MaxAsyncPathQueriesPerParticipant);
+			Query.bCandidatesExhaustive = false;
+		}
+		for(int32 CandidateIndex = 0; CandidateIndex < Query.Candidates.Num(); CandidateIndex++)
+		{
+			RequestPath(*DefaultNavData, Query.Candidates[CandidateIndex].TestedLocation, AnchorLocation, QueryIndex,
+				CandidateIndex);
+		}
+	}
+}
+
+void ACombatManager::OnCombatLocationPathFound(uint32 PathQueryID, ENavigationQueryResult::Type Result,
+	FNavPathSharedPtr Path, TSharedRef<FCombatLocationBatch> Batch, int32 QueryIndex, int32 CheckIndex)
+{
+	Batch->PendingPathQueries--;
+	FCombatLocationQuery& Query = Batch->Queries[QueryIndex];
+	//the query is discarded when the batch is resolved
+	if(!Query.IsStillValid()) return;
+
+	const bool PathFound = Result == ENavigationQueryResult::Success && Path.IsValid();
+	if(CheckIndex == CombatTargetReachableCheck)
+	{
+		Query.bPathToTargetExists = PathFound;
+	}
+	else
+	{
+		const FVector& TestedLocation = CheckIndex == CurrentTargetLocationCheck ?
+			Query.TestedCurrentTargetLocation : Query.Candidates[CheckIndex].TestedLocation;
+		//only use path length (which is an approximation) if it is longer than the air distance (same as in
+		//FCircularDistanceConstraint::GetMatchLevel)
+		const double Distance = FMath::Max(FVector::Distance(TestedLocation,
+			Query.AnchorController->GetPawn()->GetActorLocation()),
+			PathFound ? Path->GetLength() : 0.0);
+		const uint8 DistanceMatchLevel = PathFound ? Query.PlayerDistanceConstraint.GetMatchLevelForDistance(Distance) : 0;
+
+		if(CheckIndex == CurrentTargetLocationCheck)
+		{
+			if(DistanceMatchLevel == 0)
+			{
+				//we need to look for a new location after all
+				Query.bCurrentTargetLocationValid = false;
+				Query.bCandidatesExhaustive = false;
+			}
+		}
+		else
+		{
+			FCombatLocationCandidate& Candidate = Query.Candidates[CheckIndex];
+			Candidate.MatchLevel = DistanceMatchLevel == 0 ? 0 :
+				Candidate.MatchLevel - Candidate.DistanceMatchLevel + DistanceMatchLevel;
+			Candidate.DistanceMatchLevel = DistanceMatchLevel;
+		}
+	}
+}
+
+bool ACombatManager::StartCombatLocationEvaluation(FCombatLocationQuery& Query, UWorld* World)
+{
+	Query.Candidates.Reset();
+	Query.NextSampleIndex = 0;
+	Query.OptimalCandidates = 0;
+
+	//Check if it is necessary to change the target location, before calculating it, reducing movement noise
+	if(!Query.CurrentTargetLocation.ContainsNaN())
+	{
+		Query.bCurrentTargetLocationValid = UConstraintsFunctionLibrary::GetMatchLevel(Query.CurrentTargetLocation,
+			Query.TestedCurrentTargetLocation, Query.GetRelevantConstraints(false), World, Query.ValidationExtent,
+			UConstraintsFunctionLibrary::RequireAllValid, Query.bUseAsyncNavigation) != 0;
+		if(Query.bCurrentTargetLocationValid) return false;
+	}
+
+	Query.MaxPossibleMatch = 0;
+	for(const FPositionalConstraint* Constraint : Query.GetRelevantConstraints(true))
+	{
+		Query.MaxPossibleMatch += Constraint->GetMaxMatchLevel();
+	}
+	return Query.PointGenerator.GetIndexRange() > 0;
+}
+
+void ACombatManager::ProjectCombatLocationSamples(FCombatLocationQuery& Query, UNavigationSystemV1* NavigationSystem,
+	UWorld* World)
+{
+	Query.RoundSamples.Reset();
+	const uint64 EndIndex = FMath::Min(Query.PointGenerator.GetIndexRange(),
+		Query.NextSampleIndex + CombatLocationSamplesPerRound);
+	for(FCircularPointsIterator It = Query.PointGenerator.CreateIterator(Query.NextSampleIndex); It.GetIndex() < EndIndex;
+		++It)
+	{
+		const FVector SamplePoint = *It;
+		//same as in UConstraintsFunctionLibrary::GetMatchLevel, points that can't be projected are invalid
+		FVector TestedLocation = SamplePoint;
+		if(!Query.ProjectionExtent.ContainsNaN())
+		{
+			FNavLocation ProjectedLocation;
+			if(IsValid(NavigationSystem) &&
+				NavigationSystem->ProjectPointToNavigation(SamplePoint, ProjectedLocation, Query.ProjectionExtent))
+			{
+				TestedLocation = ProjectedLocation.Location;
+			}
+			else
+			{
+				TestedLocation = FVector(NAN);
+#if WITH_EDITORONLY_DATA
+				if(Query.bIsDebugging) DrawDebugPoint(World, SamplePoint, 10.f, FColor(0, 0, 0), false, 1, SDPG_World);
+#endif
+			}
+		}
+		Query.RoundSamples.Add(FCombatLocationCandidate(0, 0, SamplePoint, TestedLocation));
+	}
+	Query.NextSampleIndex = EndIndex;
+}
+
+void ACombatManager::ScoreCombatLocationSamples(FCombatLocationQuery& Query, UWorld* World)
+{
+	TArray<const FPositionalConstraint*> RelevantConstraints = Query.GetRelevantConstraints(true);
+	//path lengths can only be checked on the game thread, so the distance constraint is checked there afterwards
+	if(Query.NeedsSynchronousPathLengths()) RelevantConstraints.Remove(&Query.PlayerDistanceConstraint);
+
+	bool IsDebugging = false;
+#if WITH_EDITORONLY_DATA
+	IsDebugging = Query.bIsDebugging;
+#endif
+
+	for(FCombatLocationCandidate& Sample : Query.RoundSamples)
+	{
+		if(Sample.TestedLocation.ContainsNaN()) continue;
+		//the location is already projected and the navigation system isn't passed on, so no navigation data is accessed
+		Sample.MatchLevel = UConstraintsFunctionLibrary::GetMatchLevel(Sample.TestedLocation, RelevantConstraints, World,
+			FVector(NAN), UConstraintsFunctionLibrary::RequireAllValid, true, IsDebugging);
+		//with asynchronous navigation the distance match may still change once the path length is known
+		if(Sample.MatchLevel != 0 && Query.bUseAsyncNavigation)
+		{
+			Sample.DistanceMatchLevel = Query.PlayerDistanceConstraint.GetMatchLevel(Sample.TestedLocation, nullptr);
+		}
+	}
+}
+
+bool ACombatManager::CollectCombatLocationCandidates(FCombatLocationQuery& Query, UNavigationSystemV1* NavigationSystem,
+	int32 RequiredOptimalCandidates)
+{
+	const bool NeedsPathLengths = Query.NeedsSynchronousPathLengths();
+	const uint64 IndexRange = Query.PointGenerator.GetIndexRange();
+	for(int32 i = 0; i < Query.RoundSamples.Num(); i++)
+	{
+		FCombatLocationCandidate& Sample = Query.RoundSamples[i];
+		if(Sample.MatchLevel == 0) continue;
+		if(NeedsPathLengths)
+		{
+			const uint8 DistanceMatch = Query.PlayerDistanceConstraint.GetMatchLevel(Sample.TestedLocation,
+				NavigationSystem);
+			if(DistanceMatch == 0) continue;
+			Sample.MatchLevel += DistanceMatch;
+		}
+		Query.Candidates.Add(Sample);
+		if(Sample.MatchLevel < Query.MaxPossibleMatch || ++Query.OptimalCandidates < RequiredOptimalCandidates) continue;
+
+		//enough optimal candidates were found, so the remaining points aren't evaluated anymore
+		if(i + 1 < Query.RoundSamples.Num() || Query.NextSampleIndex < IndexRange) Query.bCandidatesExhaustive = false;
+		return true;
+	}
+	return Query.NextSampleIndex >= IndexRange;
+}
+
+void ACombatManager::ResolveCombatLocation(FCombatLocationQuery& Query,
+	const TArray<const FCombatLocationQuery*>& ResolvedQueries, UWorld* World)
+{
+	//the space reserved by the previously resolved queries of the same batch
+	TArray<FReservedSpaceConstraint> JointReservations;
+	for(const FCombatLocationQuery* ResolvedQuery : ResolvedQueries)
+	{
+		if(!ResolvedQuery->bFoundLocation) continue;
+		JointReservations.Add(FReservedSpaceConstraint(ResolvedQuery->Participant->GetRequiredSpace(),
+			ResolvedQuery->ResultingLocation, ResolvedQuery->CombatTargetLocation, Query.MinRequestedRadius));
+	}
+	const auto IsNotJointlyReserved = [&JointReservations](const FVector& Location)
+	{
+		for(const FReservedSpaceConstraint& Reservation : JointReservations)
+		{
+			if(Reservation.GetMatchLevel(Location, nullptr) == 0) return false;
+		}
+		return true;
+	};
+
+	if(!Query.bPathToTargetExists)
+	{
+		Query.bFoundLocation = false;
+		return;
+	}
+
+	if(Query.bCurrentTargetLocationValid && IsNotJointlyReserved(Query.TestedCurrentTargetLocation))
+	{
+		Query.ResultingLocation = Query.CurrentTargetLocation;
+		Query.bFoundLocation = true;
+		return;
+	}
+	Query.bWasRecalculated = true;
+
+	//the candidates might not be complete (or might not even have been evaluated) so we have to sample again
+	if(Query.bCurrentTargetLocationValid || !Query.bCandidatesExhaustive)
+	{
+		TArray<const FPositionalConstraint*> RelevantConstraints = Query.GetRelevantConstraints(true);
+		for(const FReservedSpaceConstraint& Reservation : JointReservations)
+		{
+			RelevantConstraints.Add(&Reservation);
+		}
+		bool IsDebugging = false;
+#if WITH_EDITORONLY_DATA
+		IsDebugging = Query.bIsDebugging;
+#endif
+		//This is rare (every query has as many optimal candidates as there are queries in its batch), so the path
+		//lengths are checked synchronously, as the distance constraint would be violated otherwise
+		INC_DWORD_STAT(STAT_CombatLocationResamples);
+		Query.bFoundLocation = UConstraintsFunctionLibrary::GetBestPositionSampled(Query.ResultingLocation,
+			Query.PointGenerator, RelevantConstraints, World, Query.ProjectionExtent,
+			UConstraintsFunctionLibrary::RequireAllOptimal, UConstraintsFunctionLibrary::RequireAllValid,
+			false, IsDebugging);
+		return;
+	}
+
+	//same selection as in GetBestPositionSampled: the first optimal candidate, otherwise the first best one
+	const uint32 MaxPossibleMatch = Query.MaxPossibleMatch + JointReservations.Num();
+	uint32 BestMatch = 0;
+	for(const FCombatLocationCandidate& Candidate : Query.Candidates)
+	{
+		if(Candidate.MatchLevel == 0 || !IsNotJointlyReserved(Candidate.TestedLocation)) continue;
+		//all joint reservations are satisfied at this point (with a match level of 1 each)
+		const uint32 Match = Candidate.MatchLevel + JointReservations.Num();
+		if(Match >= MaxPossibleMatch)
+		{
+			Query.ResultingLocation = Candidate.SampleLocation;
+			Query.bFoundLocation = true;
+			return;
+		}
+		if(BestMatch < Match)
+		{
+			BestMatch = Match;
+			Query.ResultingLocation = Candidate.SampleLocation;
+		}
+	}
+	Query.bFoundLocation = !Query.ResultingLocation.ContainsNaN();
+}
+
 void ACombatManager::OnOutOfCombat(AOpponentCharacter* Participant)
 {
 	if(!IsValid(Participant))
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/NonPlayerFunctionality/AISignificanceSubsystem.h"
+
+#include "MAProject.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Characters/Fighters/Opponents/OpponentCharacter.h"
+#include "Characters/Fighters/Opponents/AI/OpponentController.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Significance"), STAT_AISignificance, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Significance Evaluations"), STAT_AISignificanceEvaluations, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deferred AI Work"), STAT_DeferredAIWork, STATGROUP_MAProjectAI);
+
+UAISignificanceSubsystem::UAISignificanceSubsystem() : Cursor(0), SpentBudget(0.0), BudgetFrame(0), FrameBudget(2.f),
+	MaxDeferral(1.f), VisibleDistanceFactor(2.f), VisibilityTimeout(0.5f),
+	CombatTier(0.f, 0.f, 0.f, ECrowdAvoidanceQuality::Good,
+		EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones, 0.f, true),
+	NearTier(3000.f, 0.f, 0.f, ECrowdAvoidanceQuality::Good,
+		EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered, 0.f, true),
+	FarTier(8000.f, 0.1f, 0.25f, ECrowdAvoidanceQuality::Low,
+		EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered, 0.1f, false),
+	DormantTier(0.f, 1.f, 1.f, ECrowdAvoidanceQuality::Low,
+		EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered, 0.5f, false)
+{
+}
+
+void UAISignificanceSubsystem::Register(AOpponentController* Controller)
+{
+	if(EntryIndices.Contains(Controller)) return;
+	EntryIndices.Add(Controller, Entries.Emplace(Controller));
+	Refresh(Controller);
+}
+
+void UAISignificanceSubsystem::Unregister(const AOpponentController* Controller)
+{
+	if(const int32* EntryIndex = EntryIndices.Find(Controller)) RemoveEntry(*EntryIndex);
+}
+
+void UAISignificanceSubsystem::Refresh(const AOpponentController* Controller)
+{
+	FVector ViewLocation;
+	if(!GetViewLocation(ViewLocation)) return;
+	if(FAISignificanceEntry* Entry = FindEntry(Controller)) Evaluate(*Entry, ViewLocation);
+}
+
+bool UAISignificanceSubsystem::CanRunBudgetedWork(const AOpponentController* Controller, float DeferredTime)
+{
+	//opponents whose tier hasn't been applied yet run at full rate as well
+	const FAISignificanceEntry* Entry = FindEntry(Controller);
+	if(Entry == nullptr || Entry->Tier == EAISignificanceTier::Combat || Entry->Tier == EAISignificanceTier::Num) return true;
+	if(DeferredTime >= MaxDeferral || GetRemainingBudget() > 0.0) return true;
+	INC_DWORD_STAT(STAT_DeferredAIWork);
+	return false;
+}
+
+void UAISignificanceSubsystem::AddBudgetedWorkTime(double Time)
+{
+	GetRemainingBudget();
+	SpentBudget += Time;
+}
+
+const FAISignificanceTierSettings& UAISignificanceSubsystem::GetTierSettings(EAISignificanceTier Tier) const
+{
+	switch(Tier)
+	{
+	case EAISignificanceTier::Combat:
+		return CombatTier;
+	case EAISignificanceTier::Near:
+		return NearTier;
+	case EAISignificanceTier::Far:
+		return FarTier;
+	case EAISignificanceTier::Dormant:
+		return DormantTier;
+	default:
+		checkNoEntry();
+		return CombatTier;
+	}
+}
+
+void UAISignificanceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_AISignificance);
+	FVector ViewLocation;
+	if(Entries.IsEmpty() || !GetViewLocation(ViewLocation)) return;
+
+	//at least one opponent is evaluated each frame, so every opponent is eventually updated
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + GetRemainingBudget();
+	int32 NumOfEvaluations = 0;
+	do
+	{
+		if(Cursor >= Entries.Num()) Cursor = 0;
+		if(Evaluate(Entries[Cursor], ViewLocation)) Cursor++;
+		else RemoveEntry(Cursor);
+		NumOfEvaluations++;
+	}
+	while(!Entries.IsEmpty() && NumOfEvaluations < Entries.Num() && FPlatformTime::Seconds() < EndTime);
+	SpentBudget += FPlatformTime::Seconds() - StartTime;
+	INC_DWORD_STAT_BY(STAT_AISignificanceEvaluations, NumOfEvaluations);
+}
+
+FAISignificanceEntry* UAISignificanceSubsystem::FindEntry(const AOpponentController* Controller)
+{
+	const int32* EntryIndex = EntryIndices.Find(Controller);
+	return EntryIndex == nullptr ? nullptr : &Entries[*EntryIndex];
+}
+
+void UAISignificanceSubsystem::RemoveEntry(int32 EntryIndex)
+{
+	EntryIndices.Remove(Entries[EntryIndex].ControllerKey);
+	Entries.RemoveAtSwap(EntryIndex, 1, false);
+	if(Entries.IsValidIndex(EntryIndex)) EntryIndices[Entries[EntryIndex].ControllerKey] = EntryIndex;
+	//the last entry has been moved to the removed one, which might already have been evaluated this round
+	if(EntryIndex < Cursor) Cursor--;
+}
+
+double UAISignificanceSubsystem::GetRemainingBudget()
+{
+	if(BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		SpentBudget = 0.0;
+	}
+	return FrameBudget / 1000.0 - SpentBudget;
+}
+
+bool UAISignificanceSubsystem::GetViewLocation(FVector& ViewLocation) const
+{
+	if(const APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0))
+	{
+		ViewLocation = CameraManager->GetCameraLocation();
+		return true;
+	}
+	if(const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(GetWorld(), 0))
+	{
+		ViewLocation = PlayerPawn->GetActorLocation();
+		return true;
+	}
+	return false;
+}
+
+EAISignificanceTier UAISignificanceSubsystem::CalculateTier(const AOpponentController* Controller,
+	const FVector& ViewLocation) const
+{
+	const AOpponentCharacter* Opponent = Cast<AOpponentCharacter>(Controller->GetPawn());
+	if(!IsValid(Opponent) || IsValid(Opponent->GetCombatTarget())) return EAISignificanceTier::Combat;
+
+	float Distance = FVector::Distance(Opponent->GetActorLocation(), ViewLocation);
+	if(Opponent->WasRecentlyRendered(VisibilityTimeout)) Distance /= VisibleDistanceFactor;
+	if(Distance <= NearTier.MaxDistance) return EAISignificanceTier::Near;
+	if(Distance <= FarTier.MaxDistance) return EAISignificanceTier::Far;
+	return EAISignificanceTier::Dormant;
+}
+
+bool UAISignificanceSubsystem::Evaluate(FAISignificanceEntry& Entry, const FVector& ViewLocation) const
+{
+	AOpponentController* Controller = Entry.Controller.Get();
+	if(!IsValid(Controller)) return false;
+	const EAISignificanceTier Tier = CalculateTier(Controller, ViewLocation);
+	if(Tier == Entry.Tier) return true;
+	Entry.Tier = Tier;
+	Controller->ApplySignificanceTier(GetTierSettings(Tier), FAISignificanceKey());
+	return true;
+}
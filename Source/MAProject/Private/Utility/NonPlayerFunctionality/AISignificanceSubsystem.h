@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Navigation/CrowdManager.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "AISignificanceSubsystem.generated.h"
+
+class AOpponentController;
+
+struct FAISignificanceKey final
+{
+	friend class UAISignificanceSubsystem;
+private:
+	FAISignificanceKey(){}
+};
+
+enum class EAISignificanceTier : uint8
+{
+	//in combat, always updated at full rate
+	Combat,
+	Near,
+	Far,
+	//not in combat and far away from the player, should cost close to nothing
+	Dormant,
+	Num
+};
+
+//How often the different parts of an opponent are updated within a significance tier
+USTRUCT()
+struct FAISignificanceTierSettings
+{
+	GENERATED_BODY()
+
+	FAISignificanceTierSettings() : MaxDistance(0.f), TickInterval(0.f), BehaviorTreeTickInterval(0.f),
+		CrowdAvoidanceQuality(ECrowdAvoidanceQuality::Good),
+		AnimTickOption(EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones), AnimTickInterval(0.f),
+		bAllowSynchronousPathQueries(true){}
+	FAISignificanceTierSettings(float NewMaxDistance, float NewTickInterval, float NewBehaviorTreeTickInterval,
+		ECrowdAvoidanceQuality::Type NewCrowdAvoidanceQuality, EVisibilityBasedAnimTickOption NewAnimTickOption,
+		float NewAnimTickInterval, bool AllowSynchronousPathQueries) : MaxDistance(NewMaxDistance),
+		TickInterval(NewTickInterval), BehaviorTreeTickInterval(NewBehaviorTreeTickInterval),
+		CrowdAvoidanceQuality(NewCrowdAvoidanceQuality), AnimTickOption(NewAnimTickOption),
+		AnimTickInterval(NewAnimTickInterval), bAllowSynchronousPathQueries(AllowSynchronousPathQueries){}
+
+	//opponents out of combat that are further away than this use a lower tier (unused for the lowest tier)
+	UPROPERTY(Config, meta=(Units="cm"))
+	float MaxDistance;
+	//of the controller and the character
+	UPROPERTY(Config, meta=(Units="s"))
+	float TickInterval;
+	UPROPERTY(Config, meta=(Units="s"))
+	float BehaviorTreeTickInterval;
+	UPROPERTY(Config)
+	TEnumAsByte<ECrowdAvoidanceQuality::Type> CrowdAvoidanceQuality;
+	UPROPERTY(Config)
+	EVisibilityBasedAnimTickOption AnimTickOption;
+	//the update rate optimization of the mesh's animation
+	UPROPERTY(Config, meta=(Units="s"))
+	float AnimTickInterval;
+	//whether the rotation manager may check its paths with synchronous navigation queries
+	UPROPERTY(Config)
+	bool bAllowSynchronousPathQueries;
+};
+
+//An opponent managed by the subsystem
+struct FAISignificanceEntry
+{
+	FAISignificanceEntry() : Tier(EAISignificanceTier::Num){}
+	explicit FAISignificanceEntry(AOpponentController* NewController) : Controller(NewController),
+		ControllerKey(NewController), Tier(EAISignificanceTier::Num){}
+
+	TWeakObjectPtr<AOpponentController> Controller;
+	//still identifies the entry once the controller has been destroyed
+	TObjectKey<AOpponentController> ControllerKey;
+	//Num until the first tier has been applied
+	EAISignificanceTier Tier;
+};
+
+/**
+ * Ranks the opponents by their distance to the player, their visibility and their combat status and lowers the update
+ * rates of the less significant ones.
+ * The AI work of the opponents (their behavior tree ticks) and the re-evaluation of the tiers share a per-frame budget.
+ * The work of opponents in combat always runs, while the work of the others is deferred once the budget of the frame is
+ * used up, until it has been deferred for MaxDeferral. The opponents are re-evaluated round robin with what is left of
+ * the budget (at least one per frame).
+ */
+UCLASS(Config=Game)
+class UAISignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UAISignificanceSubsystem();
+
+	void Register(AOpponentController* Controller);
+	void Unregister(const AOpponentController* Controller);
+	//Re-evaluates the opponent immediately (e.g. when it enters or leaves combat)
+	void Refresh(const AOpponentController* Controller);
+	//Whether the budgeted work of the opponent, which has been deferred for DeferredTime so far, may run this frame
+	bool CanRunBudgetedWork(const AOpponentController* Controller, float DeferredTime);
+	void AddBudgetedWorkTime(double Time);
+
+	const FAISignificanceTierSettings& GetTierSettings(EAISignificanceTier Tier) const;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UAISignificanceSubsystem, STATGROUP_Tickables);
+	}
+
+protected:
+	TArray<FAISignificanceEntry> Entries;
+	TMap<TObjectKey<AOpponentController>, int32> EntryIndices;
+	//the next entry to be evaluated
+	int32 Cursor;
+	//time spent on budgeted work and evaluations in BudgetFrame
+	double SpentBudget;
+	uint64 BudgetFrame;
+
+	//time per frame spent on the AI work of the opponents and on re-evaluating their tiers
+	UPROPERTY(Config, meta=(Units="ms"))
+	float FrameBudget;
+	//work of opponents out of combat is never deferred for longer than this
+	UPROPERTY(Config, meta=(Units="s"))
+	float MaxDeferral;
+	//visible opponents count as closer to the player by this factor
+	UPROPERTY(Config)
+	float VisibleDistanceFactor;
+	//how long an opponent counts as visible after it has last been rendered
+	UPROPERTY(Config, meta=(Units="s"))
+	float VisibilityTimeout;
+
+	UPROPERTY(Config)
+	FAISignificanceTierSettings CombatTier;
+	UPROPERTY(Config)
+	FAISignificanceTierSettings NearTier;
+	UPROPERTY(Config)
+	FAISignificanceTierSettings FarTier;
+	UPROPERTY(Config)
+	FAISignificanceTierSettings DormantTier;
+
+	FAISignificanceEntry* FindEntry(const AOpponentController* Controller);
+	void RemoveEntry(int32 EntryIndex);
+	//in seconds, resets the budget on a new frame
+	double GetRemainingBudget();
+	bool GetViewLocation(FVector& ViewLocation) const;
+	EAISignificanceTier CalculateTier(const AOpponentController* Controller, const FVector& ViewLocation) const;
+	//Returns false if the controller isn't valid anymore
+	bool Evaluate(FAISignificanceEntry& Entry, const FVector& ViewLocation) const;
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/NonPlayerFunctionality/BudgetedBehaviorTreeComponent.h"
+
+#include "Characters/Fighters/Opponents/AI/OpponentController.h"
+#include "Utility/NonPlayerFunctionality/AISignificanceSubsystem.h"
+
+void UBudgetedBehaviorTreeComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	if(!IsValid(AISignificance))
+	{
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+		return;
+	}
+	DeferredTime += DeltaTime;
+	if(!AISignificance->CanRunBudgetedWork(Cast<AOpponentController>(GetOwner()), DeferredTime)) return;
+
+	const double StartTime = FPlatformTime::Seconds();
+	Super::TickComponent(DeferredTime, TickType, ThisTickFunction);
+	DeferredTime = 0.f;
+	AISignificance->AddBudgetedWorkTime(FPlatformTime::Seconds() - StartTime);
+}
+
+void UBudgetedBehaviorTreeComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	AISignificance = GetWorld()->GetSubsystem<UAISignificanceSubsystem>();
+}
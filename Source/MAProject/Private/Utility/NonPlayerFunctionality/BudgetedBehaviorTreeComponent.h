@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Utility/Benchmark/ProfiledBehaviorTreeComponent.h"
+#include "BudgetedBehaviorTreeComponent.generated.h"
+
+class UAISignificanceSubsystem;
+
+//A behavior tree component of an opponent whose ticks are deferred while the AI budget of the frame is used up
+UCLASS()
+class UBudgetedBehaviorTreeComponent : public UProfiledBehaviorTreeComponent
+{
+	GENERATED_BODY()
+
+public:
+	UBudgetedBehaviorTreeComponent() : DeferredTime(0.f), AISignificance(nullptr){}
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+		override;
+
+protected:
+	//the time of the deferred ticks, which is passed on with the next tick
+	float DeferredTime;
+
+	UPROPERTY()
+	UAISignificanceSubsystem* AISignificance;
+
+	virtual void BeginPlay() override;
+};
@@ -14,6 +14,7 @@
 
 // Sets default values for this component's properties
 UCharacterRotationManagerComponent::UCharacterRotationManagerComponent() : bIsInCombat(false),
+	bAllowSynchronousPathQueries(true),
 	CharacterRotationMode(ECharacterRotationMode::OrientToMovement),
 	StoredCharacterRotationMode(ECharacterRotationMode::FlickBack), OpponentCharacter(nullptr),
 	OpponentController(nullptr), StoredTarget(nullptr)
@@ -69,8 +70,9 @@ void UCharacterRotationManagerComponent::ChooseOptimalForCombat(const FVector& T
 
 		const bool IsEndInRange = FVector::Distance(TargetLocation, LookAtGoalLocation) <= MaxCombatRadius;
 		const bool IsStartInRange = FVector::Distance(GetComponentLocation(), LookAtGoalLocation) <= MaxCombatRadius;
-		bool EverLeavesRange = !IsEndInRange || !IsStartInRange;
-		if(IsEndInRange && IsStartInRange)
+		//without a path query, a detour can't be ruled out, so the path might leave the range
+		bool EverLeavesRange = !IsEndInRange || !IsStartInRange || !bAllowSynchronousPathQueries;
+		if(!EverLeavesRange)
 		{
 			//Also: all path points have to be close enough, to guarantee,
 			//that we don't make a long detour to get around some obstacle
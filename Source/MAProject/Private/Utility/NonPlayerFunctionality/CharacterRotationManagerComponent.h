@@ -30,11 +30,17 @@ public:
 
 	void ChooseOptimalForCombat(const FVector& TargetLocation);
 	void SetIsInCombat(bool IsInCombat){ bIsInCombat = IsInCombat; }
+	//without synchronous path queries, paths are assumed to stay within the combat radius
+	void SetAllowSynchronousPathQueries(bool AllowSynchronousPathQueries)
+	{
+		bAllowSynchronousPathQueries = AllowSynchronousPathQueries;
+	}
 	void SetRotationMode(ECharacterRotationMode NewRotationMode, bool StoreForFlickBack = false,
 		AActor* NewTarget = nullptr, const FVector& TargetLocation = FVector(NAN));
 
 protected:
 	uint8 bIsInCombat:1;
+	uint8 bAllowSynchronousPathQueries:1;
 	ECharacterRotationMode CharacterRotationMode;
 	ECharacterRotationMode StoredCharacterRotationMode;
 	
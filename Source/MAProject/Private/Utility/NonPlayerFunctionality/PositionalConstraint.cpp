@@ -4,6 +4,7 @@
 #include "PositionalConstraint.h"
 
 #include "NavigationSystem.h"
+#include "Algo/BinarySearch.h"
 #include "Components/BoxComponent.h"
 #include "Components/ShapeComponent.h"
 #include "Components/SphereComponent.h"
@@ -35,36 +36,160 @@ FReservedSpaceConstraint::FReservedSpaceConstraint(const FRequiredSpace& NewRequ
 }
 
 uint8 FReservedSpaceConstraint::GetMatchLevel(const FVector& Position, UNavigationSystemV1* NavigationSystem) const
+{
+	return IsReserved(Position, OtherRadius) ? 0 : MatchLevelFactor;
+}
+
+bool FReservedSpaceConstraint::IsReserved(const FVector& Position, float CheckerRadius) const
 {
 	if(RequiredSpace.Sphere != nullptr)
 	{
 		const FVector LocationOffset = (FacingToPoint - Position).Rotation().
 			RotateVector(RequiredSpace.Sphere->GetRelativeLocation());
-		if(FVector::Distance(Position, ReserverLocation + LocationOffset) >=
-			FMath::Max(RequiredSpace.Sphere->GetScaledSphereRadius(), OtherRadius))
-		{
-			return MatchLevelFactor;
-		}
-		return 0;
+		return FVector::Distance(Position, ReserverLocation + LocationOffset) <
+			FMath::Max(RequiredSpace.Sphere->GetScaledSphereRadius(), CheckerRadius);
 	}
 	if(RequiredSpace.Box != nullptr)
 	{
 		const FRotator ToWorldSpaceRotation = (FacingToPoint - Position).Rotation();
 		const FVector BoxLocation =
 			ToWorldSpaceRotation.RotateVector(RequiredSpace.Box->GetRelativeLocation()) + ReserverLocation;
-		const FVector BoxExtent = ToWorldSpaceRotation.RotateVector(RequiredSpace.Box->GetScaledBoxExtent());
+		//the rotated extent may have negative components
+		const FVector BoxExtent = ToWorldSpaceRotation.RotateVector(RequiredSpace.Box->GetScaledBoxExtent()).GetAbs();
 
 		const bool InsideX = (Position.X < BoxLocation.X + BoxExtent.X) && (Position.X > BoxLocation.X - BoxExtent.X);
 		const bool InsideY = (Position.Y < BoxLocation.Y + BoxExtent.Y) && (Position.Y > BoxLocation.Y - BoxExtent.Y);
 		const bool InsideZ = (Position.Z < BoxLocation.Z + BoxExtent.Z) && (Position.Z > BoxLocation.Z - BoxExtent.Z);
-		if(!InsideX && !InsideY && !InsideZ)
+		return InsideX && InsideY && InsideZ;
+	}
+	unimplemented();
+	return false;
+}
+
+float FReservedSpaceConstraint::GetReach() const
+{
+	//the shape is rotated around the reserver location, so its offset counts in any direction
+	if(RequiredSpace.Sphere != nullptr)
+	{
+		return RequiredSpace.Sphere->GetRelativeLocation().Length() + RequiredSpace.Sphere->GetScaledSphereRadius();
+	}
+	if(RequiredSpace.Box != nullptr)
+	{
+		return RequiredSpace.Box->GetRelativeLocation().Length() + RequiredSpace.Box->GetScaledBoxExtent().Length();
+	}
+	return 0.f;
+}
+
+void FReservedSpaceGrid::Reset()
+{
+	Reservations.Reset();
+	Cells.Reset();
+}
+
+void FReservedSpaceGrid::Add(const AActor* Reserver, const FReservedSpaceConstraint& Reservation)
+{
+	const int32 ReservationIndex = Reservations.Add({Reserver, Reservation});
+	const float Reach = Reservation.GetReach();
+	const FIntPoint MinCell = GetCell(Reservation.ReserverLocation.X - Reach, Reservation.ReserverLocation.Y - Reach);
+	const FIntPoint MaxCell = GetCell(Reservation.ReserverLocation.X + Reach, Reservation.ReserverLocation.Y + Reach);
+	for(int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for(int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
 		{
-			return MatchLevelFactor;
+			Cells.FindOrAdd(FIntPoint(X, Y)).Add(ReservationIndex);
 		}
-		return 0;
 	}
-	unimplemented();
-	return 0;
+}
+
+bool FReservedSpaceGrid::Update(const TArray<TTuple<const AActor*, FReservedSpaceConstraint>>& NewReservations)
+{
+	bool NeedsRebuild = NewReservations.Num() != Reservations.Num();
+	for(int32 i = 0; !NeedsRebuild && i < NewReservations.Num(); i++)
+	{
+		const TTuple<const AActor*, FReservedSpaceConstraint>& OldReservation = Reservations[i];
+		const TTuple<const AActor*, FReservedSpaceConstraint>& NewReservation = NewReservations[i];
+		//the cells only depend on the reserver location and the reach of the reserved space
+		NeedsRebuild = OldReservation.Key != NewReservation.Key ||
+			OldReservation.Value.ReserverLocation != NewReservation.Value.ReserverLocation ||
+			OldReservation.Value.GetReach() != NewReservation.Value.GetReach();
+	}
+	if(!NeedsRebuild)
+	{
+		for(int32 i = 0; i < NewReservations.Num(); i++)
+		{
+			Reservations[i].Value = NewReservations[i].Value;
+		}
+		return false;
+	}
+
+	Reset();
+	for(const TTuple<const AActor*, FReservedSpaceConstraint>& Reservation : NewReservations)
+	{
+		Add(Reservation.Key, Reservation.Value);
+	}
+	return true;
+}
+
+void FReservedSpaceGrid::GetNearbyReservations(const FVector& Position, float CheckerRadius,
+	TArray<int32>& ReservationIndices) const
+{
+	//a reservation affects the position if its reach overlaps with the checker radius, so they share at least one cell
+	const FIntPoint MinCell = GetCell(Position.X - CheckerRadius, Position.Y - CheckerRadius);
+	const FIntPoint MaxCell = GetCell(Position.X + CheckerRadius, Position.Y + CheckerRadius);
+	for(int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for(int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+			if(Cell == nullptr) continue;
+			for(const int32 ReservationIndex : *Cell)
+			{
+				ReservationIndices.AddUnique(ReservationIndex);
+			}
+		}
+	}
+}
+
+FIntPoint FReservedSpaceGrid::GetCell(double X, double Y) const
+{
+	return FIntPoint(FMath::FloorToInt32(X / CellSize), FMath::FloorToInt32(Y / CellSize));
+}
+
+FReservedSpaceGridConstraint::FReservedSpaceGridConstraint() : Grid(nullptr), OtherRadius(0.f), MaxMatchLevel(0)
+{
+}
+
+FReservedSpaceGridConstraint::FReservedSpaceGridConstraint(const FReservedSpaceGrid* NewGrid,
+	const TArray<const AActor*>& NewIgnoredReservers, float CheckerRadius) : Grid(NewGrid),
+	IgnoredReservers(NewIgnoredReservers), OtherRadius(CheckerRadius), MaxMatchLevel(0)
+{
+	Refresh();
+}
+
+void FReservedSpaceGridConstraint::Refresh()
+{
+	check(Grid != nullptr);
+	MaxMatchLevel = 0;
+	for(const TTuple<const AActor*, FReservedSpaceConstraint>& Reservation : Grid->GetReservations())
+	{
+		if(IgnoredReservers.Contains(Reservation.Key)) continue;
+		MaxMatchLevel += Reservation.Value.MatchLevelFactor;
+	}
+}
+
+uint8 FReservedSpaceGridConstraint::GetMatchLevel(const FVector& Position, UNavigationSystemV1* NavigationSystem) const
+{
+	//Same as one FReservedSpaceConstraint per reservation: a single reserved one invalidates the position (just like
+	//FReservedSpaceConstraint::GetMatchLevel returning 0) and the ones that aren't close are always satisfied
+	NearbyReservations.Reset();
+	Grid->GetNearbyReservations(Position, OtherRadius, NearbyReservations);
+	for(const int32 ReservationIndex : NearbyReservations)
+	{
+		const TTuple<const AActor*, FReservedSpaceConstraint>& Reservation = Grid->GetReservations()[ReservationIndex];
+		if(IgnoredReservers.Contains(Reservation.Key)) continue;
+		if(Reservation.Value.IsReserved(Position, OtherRadius)) return 0;
+	}
+	return GetMaxMatchLevel();
 }
 
 FObstacleSpaceConstraint::FObstacleSpaceConstraint() : MatchLevelFactor(4)
@@ -122,7 +247,11 @@ uint8 FCircularDistanceConstraint::GetMatchLevel(const FVector& Position, UNavig
 		if(PathLength > Distance) Distance = PathLength; 
 		
 	}
+	return GetMatchLevelForDistance(Distance);
+}
 
+uint8 FCircularDistanceConstraint::GetMatchLevelForDistance(double Distance) const
+{
 	if(Distance <= OptimalMaxRadius && Distance >= OptimalMinRadius) return 2;
 	if(Distance <= MaxRadius && Distance >= MinRadius) return 1;
 	return 0;
@@ -285,35 +414,47 @@ FCircularPointsGenerator::FCircularPointsGenerator(): MinimalLength(0), Density(
 void FCircularPointsGenerator::SetProperties(const FCircularDistanceConstraint& SourceConstraint,
                                             const FVector& NewStartDirection, float NewDensity)
 {
-	SourcePoint = SourceConstraint.AnchorController->GetPawn()->GetActorLocation();
+	SetProperties(SourceConstraint.AnchorController->GetPawn()->GetActorLocation(), NewStartDirection,
+		SourceConstraint.MinRadius, SourceConstraint.MaxRadius, NewDensity);
+}
+
+void FCircularPointsGenerator::SetProperties(const FVector& NewSourcePoint, const FVector& NewStartDirection,
+	float MinRadius, float MaxRadius, float NewDensity)
+{
+	SourcePoint = NewSourcePoint;
 	StartDirection = NewStartDirection.GetSafeNormal();
-	MinimalLength = SourceConstraint.MinRadius;
+	MinimalLength = MinRadius;
 	Density = NewDensity;
-	NumOfCircles = ceil((SourceConstraint.MaxRadius - SourceConstraint.MinRadius) * NewDensity);
+	NumOfCircles = ceil((MaxRadius - MinRadius) * NewDensity);
+
+	//GetIndexRange slightly overestimates the number of points, so we store one more circle than required
+	CircleOffsets.Reset(NumOfCircles + 2);
+	CircleOffsets.Add(0);
+	for(uint64 i = 0; i <= NumOfCircles; i++)
+	{
+		CircleOffsets.Add(CircleOffsets.Last() + GetPointsOnCircle(i));
+	}
 }
 
 FVector FCircularPointsGenerator::GetSamplePoint(uint64 Index) const
 {
-	uint64 CurrentCircleIndex = 0;
-	uint64 IndicesRemaining = Index;
-	uint64 PointsOnCurrentCircle = 0;
-	for(uint64 i = 0; i < Index; i++)
+	uint64 CurrentCircleIndex;
+	uint64 IndicesRemaining;
+	uint64 PointsOnCurrentCircle;
+	GetCirclePosition(Index, CurrentCircleIndex, IndicesRemaining, PointsOnCurrentCircle);
+	if(CurrentCircleIndex >= Index)
 	{
-		PointsOnCurrentCircle = ceil(Density * (DOUBLE_TWO_PI * (MinimalLength + static_cast<double>(i) / Density)));
-		if(IndicesRemaining >= PointsOnCurrentCircle)
+		//the sampling order has always only searched the circles before the index. When there is no matching circle,
+		//the point stays on the innermost circle (with the point count of the last searched circle)
+		IndicesRemaining = Index;
+		for(uint64 i = 0; i < Index; i++)
 		{
-			IndicesRemaining -= PointsOnCurrentCircle;
-			continue;
+			IndicesRemaining -= GetPointsOnCircle(i);
 		}
-		CurrentCircleIndex = i;
-		break;
+		PointsOnCurrentCircle = Index == 0 ? 0 : GetPointsOnCircle(Index - 1);
+		CurrentCircleIndex = 0;
 	}
-
-	const double Radius = MinimalLength + static_cast<double>(CurrentCircleIndex) / Density;
-	const double RadiansPerStep = PointsOnCurrentCircle == 0 ? 0.0 : DOUBLE_TWO_PI/static_cast<double>(PointsOnCurrentCircle);
-	const double RotationAmount = RadiansPerStep * ceil(static_cast<double>(IndicesRemaining)/2.0) *
-		(IndicesRemaining & 0b1 ? -1.0 : 1.0);
-	return  SourcePoint + (StartDirection * Radius).RotateAngleAxisRad(RotationAmount,FVector(0.f, 0.f, 1.f));
+	return GetSamplePointOnCircle(CurrentCircleIndex, IndicesRemaining, PointsOnCurrentCircle);
 }
 
 uint64 FCircularPointsGenerator::GetIndexRange() const
@@ -322,6 +463,77 @@ uint64 FCircularPointsGenerator::GetIndexRange() const
 	return static_cast<float>(NumOfCircles) * (DOUBLE_TWO_PI * (Density * MinimalLength + 0.5*static_cast<float>(NumOfCircles)));
 }
 
+FCircularPointsIterator FCircularPointsGenerator::CreateIterator(uint64 StartIndex) const
+{
+	return FCircularPointsIterator(*this, StartIndex);
+}
+
+uint64 FCircularPointsGenerator::GetPointsOnCircle(uint64 CircleIndex) const
+{
+	return ceil(Density * (DOUBLE_TWO_PI * (MinimalLength + static_cast<double>(CircleIndex) / Density)));
+}
+
+void FCircularPointsGenerator::GetCirclePosition(uint64 Index, uint64& CircleIndex, uint64& IndexOnCircle,
+	uint64& PointsOnCircle) const
+{
+	uint64 CircleOffset;
+	if(CircleOffsets.Num() > 1 && Index < CircleOffsets.Last())
+	{
+		//the circle containing the index is the last one starting at or before it
+		CircleIndex = Algo::UpperBound(CircleOffsets, Index) - 1;
+		CircleOffset = CircleOffsets[CircleIndex];
+		PointsOnCircle = CircleOffsets[CircleIndex + 1] - CircleOffset;
+	}
+	else
+	{
+		//continue after the last stored circle
+		CircleIndex = CircleOffsets.IsEmpty() ? 0 : CircleOffsets.Num() - 1;
+		CircleOffset = CircleOffsets.IsEmpty() ? 0 : CircleOffsets.Last();
+		PointsOnCircle = GetPointsOnCircle(CircleIndex);
+		while(Index - CircleOffset >= PointsOnCircle)
+		{
+			CircleOffset += PointsOnCircle;
+			PointsOnCircle = GetPointsOnCircle(++CircleIndex);
+		}
+	}
+	IndexOnCircle = Index - CircleOffset;
+}
+
+FVector FCircularPointsGenerator::GetSamplePointOnCircle(uint64 CircleIndex, uint64 IndexOnCircle,
+	uint64 PointsOnCircle) const
+{
+	const double Radius = MinimalLength + static_cast<double>(CircleIndex) / Density;
+	const double RadiansPerStep = PointsOnCircle == 0 ? 0.0 : DOUBLE_TWO_PI/static_cast<double>(PointsOnCircle);
+	const double RotationAmount = RadiansPerStep * ceil(static_cast<double>(IndexOnCircle)/2.0) *
+		(IndexOnCircle & 0b1 ? -1.0 : 1.0);
+	return  SourcePoint + (StartDirection * Radius).RotateAngleAxisRad(RotationAmount,FVector(0.f, 0.f, 1.f));
+}
+
+FCircularPointsIterator::FCircularPointsIterator(const FCircularPointsGenerator& NewGenerator, uint64 StartIndex) :
+	Generator(NewGenerator), Index(StartIndex)
+{
+	Generator.GetCirclePosition(Index, CircleIndex, IndexOnCircle, PointsOnCircle);
+}
+
+FVector FCircularPointsIterator::operator*() const
+{
+	//the first few points may not lie on the circle containing them (see FCircularPointsGenerator::GetSamplePoint)
+	if(CircleIndex >= Index) return Generator.GetSamplePoint(Index);
+	return Generator.GetSamplePointOnCircle(CircleIndex, IndexOnCircle, PointsOnCircle);
+}
+
+FCircularPointsIterator& FCircularPointsIterator::operator++()
+{
+	Index++;
+	IndexOnCircle++;
+	while(IndexOnCircle >= PointsOnCircle)
+	{
+		IndexOnCircle -= PointsOnCircle;
+		PointsOnCircle = Generator.GetPointsOnCircle(++CircleIndex);
+	}
+	return *this;
+}
+
 void FSquarePointGenerator::SetProperties(const FVector& NewSourcePoint, const FVector& NewStartDirection,
                                           float NewDistribution, float MaxLength, float MaxWidth)
 {
@@ -424,6 +636,16 @@ uint32 UConstraintsFunctionLibrary::GetMatchLevel(const FVector& TestLocation,
 	const TArray<const FPositionalConstraint*>& RelevantConstraints, UWorld* World, const FVector& DistanceFromNavMesh,
 	ETestType InstantFailureCondition, bool ForceNoNavPath, bool DebuggingEnabled)
 {
+	FVector TestedLocation;
+	return GetMatchLevel(TestLocation, TestedLocation, RelevantConstraints, World, DistanceFromNavMesh,
+		InstantFailureCondition, ForceNoNavPath, DebuggingEnabled);
+}
+
+uint32 UConstraintsFunctionLibrary::GetMatchLevel(const FVector& TestLocation, FVector& TestedLocation,
+	const TArray<const FPositionalConstraint*>& RelevantConstraints, UWorld* World, const FVector& DistanceFromNavMesh,
+	ETestType InstantFailureCondition, bool ForceNoNavPath, bool DebuggingEnabled)
+{
+	TestedLocation = TestLocation;
 	if(TestLocation.ContainsNaN()) return 0;
 	UNavigationSystemV1* NavigationSystem = UNavigationSystemV1::GetNavigationSystem(World);
 
@@ -440,6 +662,7 @@ uint32 UConstraintsFunctionLibrary::GetMatchLevel(const FVector& TestLocation,
 			return 0;
 		}
 		LocationToTest = ProjectedLocation;
+		TestedLocation = LocationToTest;
 	}
 		
 	uint32 TotalMatch = 0;
@@ -486,7 +709,8 @@ void UConstraintsFunctionLibrary::DebugConstraint(const FVector& TestLocation, c
 	{
 		Color = FColor(255, 0, 0);
 	}
-	else if(Constraint->IsOfType(FReservedSpaceConstraint::ConstraintID))
+	else if(Constraint->IsOfType(FReservedSpaceConstraint::ConstraintID) ||
+		Constraint->IsOfType(FReservedSpaceGridConstraint::ConstraintID))
 	{
 		Color = FColor(0, 0, 255);
 	}
@@ -75,6 +75,71 @@ public:
 	
 	virtual uint8 GetMaxMatchLevel() const override { return MatchLevelFactor; }
 	virtual uint8 GetMatchLevel(const FVector& Position, UNavigationSystemV1* NavigationSystem) const override;
+
+	//whether the position is inside the reserved space (for a checker with the given radius)
+	bool IsReserved(const FVector& Position, float CheckerRadius) const;
+	//the maximal horizontal distance from the reserver location at which a position can be reserved (excluding the checker radius)
+	float GetReach() const;
+};
+
+//A uniform 2D grid over reserved spaces, so positions only have to be tested against the reservations close to them
+struct MAPROJECT_API FReservedSpaceGrid
+{
+	FReservedSpaceGrid(float NewCellSize = 200.f) : CellSize(NewCellSize){}
+
+	void Reset();
+	//the checker radius of the reservation is ignored, as that is given when looking up the reservations
+	void Add(const AActor* Reserver, const FReservedSpaceConstraint& Reservation);
+	//Replaces all reservations. The cells are only rebuilt if a reservation was added, removed or has moved, otherwise
+	//the reservations are just overwritten. Returns whether the cells were rebuilt
+	bool Update(const TArray<TTuple<const AActor*, FReservedSpaceConstraint>>& NewReservations);
+
+	const TArray<TTuple<const AActor*, FReservedSpaceConstraint>>& GetReservations() const { return Reservations; }
+	//Adds the indices of all reservations that could reserve the position for a checker with the given radius
+	void GetNearbyReservations(const FVector& Position, float CheckerRadius, TArray<int32>& ReservationIndices) const;
+
+protected:
+	float CellSize;
+	TArray<TTuple<const AActor*, FReservedSpaceConstraint>> Reservations;
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	FIntPoint GetCell(double X, double Y) const;
+};
+
+/* Limitation: Reserved space by others (looked up in a FReservedSpaceGrid)
+ * Equivalent to one FReservedSpaceConstraint per reservation in the grid
+ */
+USTRUCT()
+struct MAPROJECT_API FReservedSpaceGridConstraint : public FPositionalConstraint
+{
+	GENERATED_BODY();
+public:
+	const FReservedSpaceGrid* Grid;
+	TArray<const AActor*> IgnoredReservers;
+	float OtherRadius;
+
+	FReservedSpaceGridConstraint();
+	FReservedSpaceGridConstraint(const FReservedSpaceGrid* NewGrid, const TArray<const AActor*>& NewIgnoredReservers,
+		float CheckerRadius);
+
+	//Recalculates the maximal match level after the reservations of the grid or the ignored reservers have changed
+	void Refresh();
+
+	inline static uint32 ConstraintID = 6;
+	virtual uint32 GetConstraintType() const override { return ConstraintID; }
+	virtual bool IsOfType(uint32 ID) const override { return ConstraintID == ID || Super::IsOfType(ID); }
+
+	virtual uint8 GetMaxMatchLevel() const override
+	{
+		return static_cast<uint8>(FMath::Min(MaxMatchLevel, static_cast<int32>(TNumericLimits<uint8>::Max())));
+	}
+	virtual uint8 GetMatchLevel(const FVector& Position, UNavigationSystemV1* NavigationSystem) const override;
+
+protected:
+	//the sum of the match level factors of all relevant reservations (may exceed the range of a match level)
+	int32 MaxMatchLevel;
+	//scratch space of the grid lookups (a constraint is only ever evaluated by one thread at a time)
+	mutable TArray<int32> NearbyReservations;
 };
 
 
@@ -152,6 +217,8 @@ public:
 	virtual bool IsOfType(uint32 ID) const override { return ConstraintID == ID || Super::IsOfType(ID); }
 
 	virtual uint8 GetMatchLevel(const FVector& Position, UNavigationSystemV1* NavigationSystem) const override;
+	//the match level of a position with the given distance to the anchor (which may be an air or a path distance)
+	uint8 GetMatchLevelForDistance(double Distance) const;
 
 #if WITH_EDITORONLY_DATA
 	virtual void DrawConstraintDebug(UWorld* World, FLinearColor DebugColor, float ShowTime) const override;
@@ -244,6 +311,8 @@ public:
 };
 
 
+struct FCircularPointsIterator;
+
 //The goto point generator used to directly limit the searched points when given a FCircularDistanceConstraint
 USTRUCT()
 struct MAPROJECT_API FCircularPointsGenerator : public FPointGenerator
@@ -261,8 +330,41 @@ public:
 		float NewDensity){ SetProperties(SourceConstraint, NewStartDirection, NewDensity); }
 	void SetProperties(const FCircularDistanceConstraint& SourceConstraint, const FVector& NewStartDirection,
 		float NewDensity);
+	void SetProperties(const FVector& NewSourcePoint, const FVector& NewStartDirection, float MinRadius, float MaxRadius,
+		float NewDensity);
 	virtual FVector GetSamplePoint(uint64 Index) const override;
 	virtual uint64 GetIndexRange() const override;
+
+	//Use this when sampling the points in order, as it doesn't have to look up the circle of every single point
+	FCircularPointsIterator CreateIterator(uint64 StartIndex = 0) const;
+
+protected:
+	friend FCircularPointsIterator;
+
+	//CircleOffsets[i] is the index of the first point on circle i (the last entry is the end of the last stored circle)
+	TArray<uint64> CircleOffsets;
+
+	uint64 GetPointsOnCircle(uint64 CircleIndex) const;
+	//Gets the circle that contains the point with the given index
+	void GetCirclePosition(uint64 Index, uint64& CircleIndex, uint64& IndexOnCircle, uint64& PointsOnCircle) const;
+	FVector GetSamplePointOnCircle(uint64 CircleIndex, uint64 IndexOnCircle, uint64 PointsOnCircle) const;
+};
+
+//Yields the sample points of a FCircularPointsGenerator in index order (the points are identical to GetSamplePoint)
+struct MAPROJECT_API FCircularPointsIterator
+{
+	FCircularPointsIterator(const FCircularPointsGenerator& NewGenerator, uint64 StartIndex);
+
+	uint64 GetIndex() const { return Index; }
+	FVector operator*() const;
+	FCircularPointsIterator& operator++();
+
+private:
+	const FCircularPointsGenerator& Generator;
+	uint64 Index;
+	uint64 CircleIndex;
+	uint64 IndexOnCircle;
+	uint64 PointsOnCircle;
 };
 
 USTRUCT()
@@ -331,6 +433,13 @@ public:
 		UWorld* World, const FVector& DistanceFromNavMesh = FVector(NAN),
 		ETestType InstantFailureCondition = RequireAllValid, bool ForceNoNavPath = false, bool DebuggingEnabled = false);
 
+	/// @brief Same as GetMatchLevel, but also returns the location that was actually tested
+	/// @param TestedLocation Is set to the TestLocation projected to the navigation mesh (or TestLocation if no projection was requested)
+	static uint32 GetMatchLevel(const FVector& TestLocation, FVector& TestedLocation,
+		const TArray<const FPositionalConstraint*>& RelevantConstraints, UWorld* World,
+		const FVector& DistanceFromNavMesh = FVector(NAN), ETestType InstantFailureCondition = RequireAllValid,
+		bool ForceNoNavPath = false, bool DebuggingEnabled = false);
+
 #if WITH_EDITORONLY_DATA
 	static void DebugConstraint(const FVector& TestLocation, const FPositionalConstraint* Constraint, FColor Mask, UWorld* WorldContext);
 #endif
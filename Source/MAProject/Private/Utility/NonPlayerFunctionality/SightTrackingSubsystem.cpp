@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/NonPlayerFunctionality/SightTrackingSubsystem.h"
+
+#include "MAProject.h"
+#include "Characters/Fighters/Opponents/AI/OpponentController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Sight Tracking"), STAT_SightTracking, STATGROUP_MAProjectAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Watched Actors"), STAT_WatchedActors, STATGROUP_MAProjectAI);
+
+USightTrackingSubsystem::USightTrackingSubsystem() : CurrentWheelTick(INDEX_NONE)
+{
+}
+
+void USightTrackingSubsystem::Watch(AOpponentController* Controller, AActor* Target, const FVector& Location, float Radius)
+{
+	TArray<FSightWatcher>& Watchers = WatchedActors.FindOrAdd(Target);
+	if(FSightWatcher* Watcher = Watchers.FindByPredicate([Controller](const FSightWatcher& Other)
+	{
+		return Other.Controller == Controller;
+	}))
+	{
+		*Watcher = FSightWatcher(Controller, Location, Radius);
+		return;
+	}
+	Watchers.Emplace(Controller, Location, Radius);
+}
+
+void USightTrackingSubsystem::StopWatching(const AOpponentController* Controller, const AActor* Target)
+{
+	TArray<FSightWatcher>* Watchers = WatchedActors.Find(Target);
+	if(Watchers == nullptr) return;
+	Watchers->RemoveAllSwap([Controller](const FSightWatcher& Watcher){ return Watcher.Controller == Controller; });
+	if(Watchers->IsEmpty()) WatchedActors.Remove(Target);
+}
+
+void USightTrackingSubsystem::StopWatchingAll(const AOpponentController* Controller)
+{
+	for(auto Iterator = WatchedActors.CreateIterator(); Iterator; ++Iterator)
+	{
+		Iterator.Value().RemoveAllSwap([Controller](const FSightWatcher& Watcher)
+		{
+			return Watcher.Controller == Controller;
+		});
+		if(Iterator.Value().IsEmpty()) Iterator.RemoveCurrent();
+	}
+}
+
+void USightTrackingSubsystem::ScheduleExpiry(AOpponentController* Controller, AActor* Target, double Delay)
+{
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	if(CurrentWheelTick == INDEX_NONE) CurrentWheelTick = GetWheelTick(CurrentTime);
+	//the slot of a tick is only processed once the time has passed the start of that tick, so rounding up means the
+	//expiry never happens too early
+	const int64 DueTick = FMath::Max(FMath::CeilToInt64((CurrentTime + Delay) / SlotDuration), CurrentWheelTick + 1);
+	ExpiryWheel[DueTick % NumOfSlots].Emplace(Controller, Target,
+		static_cast<uint32>((DueTick - CurrentWheelTick - 1) / NumOfSlots));
+}
+
+void USightTrackingSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_SightTracking);
+	SET_DWORD_STAT(STAT_WatchedActors, WatchedActors.Num());
+	UpdateWatchedActors();
+	AdvanceExpiryWheel();
+}
+
+void USightTrackingSubsystem::UpdateWatchedActors()
+{
+	PendingMoveNotifications.Reset();
+	for(auto Iterator = WatchedActors.CreateIterator(); Iterator; ++Iterator)
+	{
+		AActor* Target = Iterator.Key().ResolveObjectPtr();
+		if(!IsValid(Target))
+		{
+			Iterator.RemoveCurrent();
+			continue;
+		}
+		//the location of each watched actor is only looked up once, independent of the number of watchers
+		const FVector TargetLocation = Target->GetActorLocation();
+		for(FSightWatcher& Watcher : Iterator.Value())
+		{
+			if(FVector::DistSquared(Watcher.LastLocation, TargetLocation) < Watcher.RadiusSquared) continue;
+			Watcher.LastLocation = TargetLocation;
+			PendingMoveNotifications.Emplace(Watcher.Controller, Target, TargetLocation);
+		}
+	}
+
+	//the controllers may change the watched actors, so they are only notified after iterating
+	for(const TTuple<TWeakObjectPtr<AOpponentController>, TWeakObjectPtr<AActor>, FVector>& Notification :
+		PendingMoveNotifications)
+	{
+		AOpponentController* Controller = Notification.Get<0>().Get();
+		AActor* Target = Notification.Get<1>().Get();
+		if(!IsValid(Controller) || !IsValid(Target)) continue;
+		Controller->OnWatchedActorMoved(Target, Notification.Get<2>(), FSightTrackingKey());
+	}
+}
+
+void USightTrackingSubsystem::AdvanceExpiryWheel()
+{
+	const int64 TargetTick = GetWheelTick(GetWorld()->GetTimeSeconds());
+	if(CurrentWheelTick == INDEX_NONE) CurrentWheelTick = TargetTick;
+	while(CurrentWheelTick < TargetTick)
+	{
+		CurrentWheelTick++;
+		TArray<FSightExpiry>& Slot = ExpiryWheel[CurrentWheelTick % NumOfSlots];
+		if(Slot.IsEmpty()) continue;
+
+		//the notified controllers may schedule new expiries for the next revolution, so the slot is swapped out first
+		Swap(FiringExpiries, Slot);
+		for(FSightExpiry& Expiry : FiringExpiries)
+		{
+			if(Expiry.Rounds > 0)
+			{
+				Expiry.Rounds--;
+				Slot.Add(Expiry);
+				continue;
+			}
+			AOpponentController* Controller = Expiry.Controller.Get();
+			AActor* Target = Expiry.Target.Get();
+			if(IsValid(Controller)) Controller->OnSightExpired(Target, FSightTrackingKey());
+		}
+		FiringExpiries.Reset();
+	}
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "SightTrackingSubsystem.generated.h"
+
+class AOpponentController;
+
+struct FSightTrackingKey final
+{
+	friend class USightTrackingSubsystem;
+private:
+	FSightTrackingKey(){}
+};
+
+//A controller that wants to be notified once the watched actor has moved further than the radius
+struct FSightWatcher
+{
+	FSightWatcher() : LastLocation(NAN), RadiusSquared(0.f){}
+	FSightWatcher(AOpponentController* NewController, const FVector& NewLastLocation, float Radius) :
+		Controller(NewController), LastLocation(NewLastLocation), RadiusSquared(Radius * Radius){}
+
+	TWeakObjectPtr<AOpponentController> Controller;
+	FVector LastLocation;
+	float RadiusSquared;
+};
+
+struct FSightExpiry
+{
+	FSightExpiry() : Rounds(0){}
+	FSightExpiry(AOpponentController* NewController, AActor* NewTarget, uint32 NewRounds) : Controller(NewController),
+		Target(NewTarget), Rounds(NewRounds){}
+
+	TWeakObjectPtr<AOpponentController> Controller;
+	TWeakObjectPtr<AActor> Target;
+	//the number of full revolutions of the timing wheel left before expiring
+	uint32 Rounds;
+};
+
+/**
+ * Senses don't get updated except when registered/unregistered, so the position changes of sighted actors have to be
+ * tracked manually. Instead of every controller polling its stimuli each frame, the actors are tracked here once and
+ * only the controllers watching an actor that moved far enough are notified.
+ * The expiration of lost sight stimuli is handled by a timing wheel.
+ */
+UCLASS()
+class USightTrackingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	USightTrackingSubsystem();
+
+	//Starts (or refreshes) watching the target. The controller is notified once the target has moved further than Radius
+	//from Location
+	void Watch(AOpponentController* Controller, AActor* Target, const FVector& Location, float Radius);
+	void StopWatching(const AOpponentController* Controller, const AActor* Target);
+	void StopWatchingAll(const AOpponentController* Controller);
+	//the controller is notified when the delay has passed (rounded up to the resolution of the timing wheel)
+	void ScheduleExpiry(AOpponentController* Controller, AActor* Target, double Delay);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(USightTrackingSubsystem, STATGROUP_Tickables);
+	}
+
+protected:
+	TMap<TObjectKey<AActor>, TArray<FSightWatcher>> WatchedActors;
+
+	static constexpr int32 NumOfSlots = 64;
+	static constexpr double SlotDuration = 0.1;
+	TArray<FSightExpiry> ExpiryWheel[NumOfSlots];
+	//the last tick of the wheel whose slot has been processed
+	int64 CurrentWheelTick;
+
+	//the moves found by the current update, before any controller is notified
+	TArray<TTuple<TWeakObjectPtr<AOpponentController>, TWeakObjectPtr<AActor>, FVector>> PendingMoveNotifications;
+	TArray<FSightExpiry> FiringExpiries;
+
+	void UpdateWatchedActors();
+	void AdvanceExpiryWheel();
+
+	int64 GetWheelTick(double Time) const { return FMath::FloorToInt64(Time / SlotDuration); }
+};
@@ -9,24 +9,93 @@
 
 namespace UReadWriteHelpers
 {
+	//Only the tagged properties are serialized (instead of the whole actor), so a copy of the property memory gives the
+	//same result as the actor itself
+	static void SerializeSaveGameProperties(FArchive& Archive, UClass* Class, uint8* Data)
+	{
+		FObjectAndNameAsStringProxyArchive ProxyArchive(Archive, true);
+		//Find only variables with UPROPERTY(SaveGame)
+		ProxyArchive.ArIsSaveGame = true;
+		Class->SerializeTaggedProperties(ProxyArchive, Data, Class, nullptr);
+	}
+
 	void WriteToTarget(AActor* Target, TArray<uint8>& Bytes)
 	{
 		FMemoryReader MemReader(Bytes);
-
-		FObjectAndNameAsStringProxyArchive ProxyArchive(MemReader, true);
-		ProxyArchive.ArIsSaveGame = true;
 		//Convert binary array back into actor's variables
-		Target->Serialize(ProxyArchive);
+		SerializeSaveGameProperties(MemReader, Target->GetClass(), reinterpret_cast<uint8*>(Target));
 	}
 
 	void ReadFromTarget(AActor* Target, TArray<uint8>& Bytes)
 	{
 		//Pass the array to fill with data from Actor
 		FMemoryWriter MemoryWriter(Bytes);
-		FObjectAndNameAsStringProxyArchive ProxyArchive(MemoryWriter, true);
-		//Find only variables with UPROPERTY(SaveGame)
-		ProxyArchive.ArIsSaveGame = true;
 		//Converts Actor's SaveGame UPROPERTIES into binary array
-		Target->Serialize(ProxyArchive);
+		SerializeSaveGameProperties(MemoryWriter, Target->GetClass(), reinterpret_cast<uint8*>(Target));
+	}
+}
+
+FSaveGamePropertyCopy::FSaveGamePropertyCopy(const AActor* Source) : Class(Source->GetClass())
+{
+	Data = static_cast<uint8*>(FMemory::Malloc(Class->GetPropertiesSize(), Class->GetMinAlignment()));
+	for(TFieldIterator<FProperty> Property(Class); Property; ++Property)
+	{
+		if(!Property->HasAnyPropertyFlags(CPF_SaveGame)) continue;
+		Property->InitializeValue_InContainer(Data);
+		Property->CopyCompleteValue_InContainer(Data, Source);
+	}
+}
+
+FSaveGamePropertyCopy::~FSaveGamePropertyCopy()
+{
+	for(TFieldIterator<FProperty> Property(Class); Property; ++Property)
+	{
+		if(Property->HasAnyPropertyFlags(CPF_SaveGame)) Property->DestroyValue_InContainer(Data);
+	}
+	FMemory::Free(Data);
+}
+
+bool FSaveGamePropertyCopy::Matches(const AActor* Actor) const
+{
+	if(Actor->GetClass() != Class) return false;
+	for(TFieldIterator<FProperty> Property(Class); Property; ++Property)
+	{
+		if(!Property->HasAnyPropertyFlags(CPF_SaveGame)) continue;
+		for(int32 i = 0; i < Property->ArrayDim; i++)
+		{
+			if(!Property->Identical_InContainer(Data, Actor, i)) return false;
+		}
+	}
+	return true;
+}
+
+void FSaveGamePropertyCopy::CopyTo(AActor* Target) const
+{
+	check(Target->GetClass() == Class);
+	for(TFieldIterator<FProperty> Property(Class); Property; ++Property)
+	{
+		if(Property->HasAnyPropertyFlags(CPF_SaveGame)) Property->CopyCompleteValue_InContainer(Target, Data);
+	}
+}
+
+void FSaveGamePropertyCopy::Serialize(TArray<uint8>& Bytes) const
+{
+	FMemoryWriter MemoryWriter(Bytes);
+	UReadWriteHelpers::SerializeSaveGameProperties(MemoryWriter, Class, Data);
+}
+
+void FSaveGamePropertyCopy::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(Class);
+	//the objects the copied properties point to must not be collected while the copy is alive
+	FVerySlowReferenceCollectorArchiveScope CollectorScope(Collector.GetVerySlowReferenceCollectorArchive(), Class);
+	for(TFieldIterator<FProperty> Property(Class); Property; ++Property)
+	{
+		if(!Property->HasAnyPropertyFlags(CPF_SaveGame)) continue;
+		for(int32 i = 0; i < Property->ArrayDim; i++)
+		{
+			Property->SerializeItem(FStructuredArchiveFromArchive(CollectorScope.GetArchive()).GetSlot(),
+				Property->ContainerPtrToValuePtr<void>(Data, i));
+		}
 	}
 }
\ No newline at end of file
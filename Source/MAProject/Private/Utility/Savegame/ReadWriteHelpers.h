@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "UObject/GCObject.h"
 
 /**
  * 
@@ -12,3 +13,28 @@ namespace UReadWriteHelpers
 	void WriteToTarget(AActor* Target, TArray<uint8>& Bytes);
 	void ReadFromTarget(AActor* Target, TArray<uint8>& Bytes);
 }
+
+//Copy of the SaveGame properties of an actor in the memory layout of its class, which is never changed once taken
+class FSaveGamePropertyCopy : public FGCObject
+{
+public:
+	UE_NONCOPYABLE(FSaveGamePropertyCopy);
+	explicit FSaveGamePropertyCopy(const AActor* Source);
+	virtual ~FSaveGamePropertyCopy() override;
+
+	UClass* GetClass() const { return Class; }
+	//Whether the actor is of the same class and all its SaveGame properties are identical to the copy
+	bool Matches(const AActor* Actor) const;
+	//Sets the SaveGame properties of an actor of the same class to the copy
+	void CopyTo(AActor* Target) const;
+	//Serializes the copy the same way ReadFromTarget serializes the actor (doesn't have to happen on the game thread)
+	void Serialize(TArray<uint8>& Bytes) const;
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FSaveGamePropertyCopy"); }
+
+protected:
+	UClass* Class;
+	//only the SaveGame properties are initialized, the rest of the memory is never touched
+	uint8* Data;
+};
@@ -3,25 +3,74 @@
 
 #include "Utility/Savegame/SavableObjectIDGenerator.h"
 
-#include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
+#include "Algo/BinarySearch.h"
 #include "Utility/Savegame/SavableObjectMarkerComponent.h"
 
 DEFINE_LOG_CATEGORY(LogUniqueWorldId);
 
-uint64 GetLowestValidID(const TArray<uint64>& IDsInUse)
+FUniqueWorldIdAllocator::FUniqueWorldIdAllocator()
 {
-	uint64 LowestId = std::numeric_limits<uint64>::max();
-	if(IDsInUse.IsEmpty()) return LowestId;
+	FreeRanges.Add(FUniqueWorldIdRange());
+}
+
+void FUniqueWorldIdAllocator::Rebuild(TArray<uint64>& IDsInUse)
+{
+	IDsInUse.Sort();
+	FreeRanges.Reset();
+	uint64 LastID = 0;
 	for(const uint64 Id : IDsInUse)
 	{
-		if(Id < LowestId) LowestId = Id;
+		if(Id - LastID > 1) FreeRanges.Emplace(LastID + 1, Id - 1);
+		LastID = Id;
+	}
+	if(LastID < std::numeric_limits<uint64>::max())
+	{
+		FreeRanges.Emplace(LastID + 1, std::numeric_limits<uint64>::max());
+	}
+}
+
+uint64 FUniqueWorldIdAllocator::Allocate(bool bAllowReusingIndices)
+{
+	if(FreeRanges.IsEmpty())
+	{
+		checkNoEntry();
+		return 0;
 	}
+	//If we should not reuse indices we fill the indices above the currently highest index
+	const uint64 Id = bAllowReusingIndices ? FreeRanges[0].First : FreeRanges.Last().First;
+	MarkUsed(Id);
+	return Id;
+}
+
+bool FUniqueWorldIdAllocator::MarkUsed(uint64 Id)
+{
+	const int32 RangeIndex = FindRange(Id);
+	if(RangeIndex == INDEX_NONE) return false;
 
-	return LowestId;
+	FUniqueWorldIdRange& Range = FreeRanges[RangeIndex];
+	if(Range.First == Range.Last) FreeRanges.RemoveAt(RangeIndex);
+	else if(Range.First == Id) Range.First++;
+	else if(Range.Last == Id) Range.Last--;
+	else
+	{
+		const FUniqueWorldIdRange UpperRange(Id + 1, Range.Last);
+		Range.Last = Id - 1;
+		FreeRanges.Insert(UpperRange, RangeIndex + 1);
+	}
+	return true;
+}
+
+int32 FUniqueWorldIdAllocator::FindRange(uint64 Id) const
+{
+	//the last range starting at or below the ID is the only one that can contain it
+	const int32 RangeIndex = Algo::UpperBoundBy(FreeRanges, Id, &FUniqueWorldIdRange::First) - 1;
+	if(RangeIndex < 0 || FreeRanges[RangeIndex].Last < Id) return INDEX_NONE;
+	return RangeIndex;
 }
 
 // Sets default values
-ASavableObjectIDGenerator::ASavableObjectIDGenerator() : bAllowReusingIndices(true)
+ASavableObjectIDGenerator::ASavableObjectIDGenerator() : bAllowReusingIndices(true), bHasBuiltAllocator(false)
 {
 	PrimaryActorTick.bCanEverTick = false;
 }
@@ -31,6 +80,35 @@ bool ASavableObjectIDGenerator::IsEditorOnly() const
 	return true;
 }
 
+#if WITH_EDITOR
+void ASavableObjectIDGenerator::OnSavableObjectRegistered(USavableObjectMarkerComponent* SavableObject)
+{
+	UWorld* World = SavableObject->GetWorld();
+	if(World == nullptr || World->WorldType != EWorldType::Editor) return;
+	TActorIterator<ASavableObjectIDGenerator> Iterator(World);
+	//without a generator the IDs are assigned once one is placed
+	if(!Iterator) return;
+	ASavableObjectIDGenerator* Generator = *Iterator;
+	if(!Generator->bHasBuiltAllocator)
+	{
+		Generator->Recalculate();
+		return;
+	}
+
+	const uint64 Id = SavableObject->GetUniqueWorldID();
+	const TWeakObjectPtr<USavableObjectMarkerComponent>* Owner = Generator->IdOwners.Find(Id);
+	//duplicated objects keep the ID of their original
+	if(Id == 0 || (Owner != nullptr && Owner->IsValid() && Owner->Get() != SavableObject &&
+		Owner->Get()->IsRegistered()))
+	{
+		Generator->AssignNewID(SavableObject);
+		return;
+	}
+	Generator->IdOwners.Add(Id, SavableObject);
+	Generator->Allocator.MarkUsed(Id);
+}
+#endif
+
 // Called when the game starts or when spawned
 void ASavableObjectIDGenerator::BeginPlay()
 {
@@ -38,77 +116,53 @@ void ASavableObjectIDGenerator::BeginPlay()
 	Recalculate();	
 }
 
-void ASavableObjectIDGenerator::Recalculate() const
+void ASavableObjectIDGenerator::Recalculate()
 {
-	//Collect the new actors to add
+	//Collect the new objects to add (the savable objects are looked up directly instead of searching all actors)
+	TArray<UObject*> SavableObjects;
+	GetObjectsOfClass(USavableObjectMarkerComponent::StaticClass(), SavableObjects, true, RF_ClassDefaultObject);
 	TArray<uint64> IDsInUse;
 	TArray<USavableObjectMarkerComponent*> NewObjects;
-	TArray<AActor*> WorldActors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AActor::StaticClass(), WorldActors);
-	for(const AActor* Actor : WorldActors)
+	IdOwners.Reset();
+	for(UObject* Object : SavableObjects)
 	{
-		//Only interested in Savable actors
-		if(!IsValid(Actor)) continue;
-		UActorComponent* ObjectComponent = Actor->GetComponentByClass(USavableObjectMarkerComponent::StaticClass());
-		if(!IsValid(ObjectComponent)) continue;
-		USavableObjectMarkerComponent* CallRef = CastChecked<USavableObjectMarkerComponent>(ObjectComponent);
+		USavableObjectMarkerComponent* CallRef = CastChecked<USavableObjectMarkerComponent>(Object);
+		if(CallRef->IsTemplate() || CallRef->GetWorld() != GetWorld() || !IsValid(CallRef->GetOwner())) continue;
 		const uint64 Id = CallRef->GetUniqueWorldID();
 		if(Id == 0)
 		{
 			NewObjects.Add(CallRef);
 		}
-		else
+		else if(IdOwners.Contains(Id))
 		{
-			if(IDsInUse.Contains(Id))
-			{
-				//Happens when copying an already indexed object only keep one of them
-				CallRef->SetUniqueWorldID(0, FSetUniqueWorldIdKey());
-				UE_LOG(LogUniqueWorldId, Warning, TEXT("Multiple objects with the same index detected"));
-				NewObjects.Add(CallRef);
-			}
-			else IDsInUse.Add(Id);
+			//Happens when copying an already indexed object only keep one of them
+			UE_LOG(LogUniqueWorldId, Warning, TEXT("Multiple objects with the same index detected"));
+			NewObjects.Add(CallRef);
 		}
-	}
-		
-	uint64 LastID = 0;
-	TArray<std::pair<uint64, uint64>> UnusedIndices;
-	while(true)
-	{
-		const uint64 NextID = GetLowestValidID(IDsInUse);
-		IDsInUse.Remove(NextID);
-		if(NextID - LastID > 1)
+		else
 		{
-			UnusedIndices.Add(std::pair(LastID, NextID));
+			IdOwners.Add(Id, CallRef);
+			IDsInUse.Add(Id);
 		}
-		if(NextID == std::numeric_limits<uint64>::max()) break;
-		LastID = NextID;
-	}
-	
-	uint64 UsedRange = 0;
-	std::pair<uint64, uint64> BoundariesToFillNow;
-	if(bAllowReusingIndices) BoundariesToFillNow = UnusedIndices[0];
-	else
-	{
-		//If we should not reuse indices we first try to fill the indices above the currently highest index
-		BoundariesToFillNow = UnusedIndices.Last();
 	}
-	
-	
+
+	Modify();
+	Allocator.Rebuild(IDsInUse);
+	bHasBuiltAllocator = true;
 	for(USavableObjectMarkerComponent* SavableObject : NewObjects)
 	{
-		if(BoundariesToFillNow.second - BoundariesToFillNow.first <= UsedRange)
-		{
-			UnusedIndices.Remove(BoundariesToFillNow);
-			//Independent of bAllowReusingIndices we restart at the lowest boundaries after filling the first boundaries
-			BoundariesToFillNow = UnusedIndices[0];
-		}
-		if(UnusedIndices.IsEmpty()) { checkNoEntry(); }
-		const uint64 TargetId = BoundariesToFillNow.first + UsedRange;
-		SavableObject->SetUniqueWorldID(TargetId, FSetUniqueWorldIdKey());
-		
-		UE_LOG(LogUniqueWorldId, Log, TEXT("%s was set to index %s"), *SavableObject->GetOwner()->GetName(),
-			*FString::FromInt(TargetId));
-		UsedRange++;
+		AssignNewID(SavableObject);
 	}
 }
 
+void ASavableObjectIDGenerator::AssignNewID(USavableObjectMarkerComponent* SavableObject)
+{
+	Modify();
+	const uint64 TargetId = Allocator.Allocate(bAllowReusingIndices);
+	SavableObject->Modify();
+	SavableObject->SetUniqueWorldID(TargetId, FSetUniqueWorldIdKey());
+	IdOwners.Add(TargetId, SavableObject);
+
+	UE_LOG(LogUniqueWorldId, Log, TEXT("%s was set to index %s"), *SavableObject->GetOwner()->GetName(),
+		*FString::FromInt(TargetId));
+}
@@ -3,3 +3,26 @@
 
 #include "Utility/Savegame/SavableObjectMarkerComponent.h"
 
+#include "Utility/Savegame/SavableObjectIDGenerator.h"
+#include "Utility/Savegame/SaveRegistrySubsystem.h"
+
+void USavableObjectMarkerComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	SaveRegistry = GetWorld()->GetSubsystem<USaveRegistrySubsystem>();
+	if(IsValid(SaveRegistry)) SaveRegistry->Register(this);
+}
+
+void USavableObjectMarkerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+	if(IsValid(SaveRegistry)) SaveRegistry->Unregister(this, EndPlayReason);
+}
+
+#if WITH_EDITOR
+void USavableObjectMarkerComponent::OnRegister()
+{
+	Super::OnRegister();
+	ASavableObjectIDGenerator::OnSavableObjectRegistered(this);
+}
+#endif
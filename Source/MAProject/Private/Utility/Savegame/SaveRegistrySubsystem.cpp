@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Savegame/SaveRegistrySubsystem.h"
+
+#include "Characters/Fighters/Player/CustomGameState.h"
+#include "Utility/Savegame/ReadWriteHelpers.h"
+#include "Utility/Savegame/SavableObjectMarkerComponent.h"
+#include "Utility/Savegame/WorldSaveGameFile.h"
+#include "Utility/Savegame/WorldStateSaveGame.h"
+
+void USaveRegistrySubsystem::Register(USavableObjectMarkerComponent* SavableObject)
+{
+	const uint64 Id = SavableObject->GetUniqueWorldID();
+	//objects without an ID have never been indexed by the generator and can't be identified in the save file
+	if(Id == 0) return;
+	if(SavableObjects.Contains(Id))
+	{
+		UE_LOG(LogSaveGame, Warning, TEXT("%s shares its unique world ID with another registered object"),
+			*SavableObject->GetOwner()->GetName());
+		return;
+	}
+	const FName ChunkName = GetChunkName(SavableObject->GetOwner());
+	FRegisteredObject& RegisteredObject = SavableObjects.Add(Id, FRegisteredObject(SavableObject, ChunkName));
+
+	if(IsValid(SaveGame)) ApplyRecord(RegisteredObject, FindOrLoadChunk(ChunkName));
+}
+
+void USaveRegistrySubsystem::Unregister(const USavableObjectMarkerComponent* SavableObject,
+	EEndPlayReason::Type EndPlayReason)
+{
+	const uint64 Id = SavableObject->GetUniqueWorldID();
+	FRegisteredObject* RegisteredObject = SavableObjects.Find(Id);
+	if(RegisteredObject == nullptr || RegisteredObject->SavableObject != SavableObject) return;
+
+	if(IsValid(SaveGame))
+	{
+		FWorldSaveChunk& Chunk = FindOrLoadChunk(RegisteredObject->ChunkName);
+		//actors that are streamed out keep their state until they are streamed in again, while destroyed actors
+		//are reset to their initial state on the next load
+		if(EndPlayReason == EEndPlayReason::RemovedFromWorld) UpdateRecord(*RegisteredObject, Chunk);
+		else if(EndPlayReason == EEndPlayReason::Destroyed && Chunk.FindRecord(Id) != nullptr)
+		{
+			Chunk.RemoveRecord(Id);
+			Chunk.bIsDirty = true;
+		}
+	}
+	SavableObjects.Remove(Id);
+}
+
+void USaveRegistrySubsystem::LoadSaveGame(UWorldStateSaveGame* NewSaveGame, const TSharedPtr<FWorldSaveGameFile>& File)
+{
+	SaveGame = NewSaveGame;
+	SaveFile = File;
+	for(TPair<uint64, FRegisteredObject>& RegisteredObject : SavableObjects)
+	{
+		ApplyRecord(RegisteredObject.Value, FindOrLoadChunk(RegisteredObject.Value.ChunkName));
+	}
+}
+
+void USaveRegistrySubsystem::WriteSaveGame()
+{
+	check(IsValid(SaveGame));
+	for(TPair<uint64, FRegisteredObject>& RegisteredObject : SavableObjects)
+	{
+		UpdateRecord(RegisteredObject.Value, FindOrLoadChunk(RegisteredObject.Value.ChunkName));
+	}
+}
+
+FName USaveRegistrySubsystem::GetChunkName(const AActor* Actor)
+{
+	//PIE prefixes the package names of the levels, which must not end up in the save file
+	return FName(UWorld::RemovePIEPrefix(Actor->GetLevel()->GetOutermost()->GetName()));
+}
+
+bool USaveRegistrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FWorldSaveChunk& USaveRegistrySubsystem::FindOrLoadChunk(FName ChunkName)
+{
+	if(FWorldSaveChunk* Chunk = SaveGame->LoadedChunks.Find(ChunkName)) return *Chunk;
+	FWorldSaveChunk& Chunk = SaveGame->LoadedChunks.Add(ChunkName);
+	if(SaveFile.IsValid() && !SaveFile->LoadChunk(ChunkName, Chunk))
+	{
+		//levels that haven't been saved yet simply start with an empty chunk
+		Chunk.SavedActors.Reset();
+		Chunk.IndexRecords();
+	}
+	return Chunk;
+}
+
+void USaveRegistrySubsystem::UpdateRecord(FRegisteredObject& RegisteredObject, FWorldSaveChunk& Chunk)
+{
+	const uint64 Id = RegisteredObject.SavableObject->GetUniqueWorldID();
+	AActor* Actor = RegisteredObject.SavableObject->GetOwner();
+	//SaveGame properties can be changed from anywhere (including blueprints), so instead of relying on the actors to
+	//report their changes, their memory is compared to the copy taken when they were last saved
+	const FNonPlayerSaveData* PreviousRecord = Chunk.FindRecord(Id);
+	if(PreviousRecord != nullptr && RegisteredObject.SavedState.IsValid() &&
+		Actor->GetActorTransform().Equals(PreviousRecord->Transform) && RegisteredObject.SavedState->Matches(Actor))
+	{
+		return;
+	}
+
+	//copies are shared and never changed, so a new one is taken instead of updating the old one
+	RegisteredObject.SavedState = MakeShared<FSaveGamePropertyCopy, ESPMode::ThreadSafe>(Actor);
+	FNonPlayerSaveData& ActorSaveData = Chunk.FindOrAddRecord(Id);
+	ActorSaveData.Transform = Actor->GetActorTransform();
+	ActorSaveData.PendingData = RegisteredObject.SavedState;
+	Chunk.bIsDirty = true;
+}
+
+void USaveRegistrySubsystem::ApplyRecord(FRegisteredObject& RegisteredObject, FWorldSaveChunk& Chunk)
+{
+	FNonPlayerSaveData* ActorSaveData = Chunk.FindRecord(RegisteredObject.SavableObject->GetUniqueWorldID());
+	if(ActorSaveData == nullptr) return;
+	AActor* Actor = RegisteredObject.SavableObject->GetOwner();
+	Actor->SetActorTransform(ActorSaveData->Transform);
+	//the loaded state counts as saved, so actors that don't change aren't written again
+	if(ActorSaveData->PendingData.IsValid() && ActorSaveData->PendingData->GetClass() == Actor->GetClass())
+	{
+		ActorSaveData->PendingData->CopyTo(Actor);
+		RegisteredObject.SavedState = ActorSaveData->PendingData;
+	}
+	else
+	{
+		UReadWriteHelpers::WriteToTarget(Actor, ActorSaveData->SerializedData);
+		RegisteredObject.SavedState = MakeShared<FSaveGamePropertyCopy, ESPMode::ThreadSafe>(Actor);
+	}
+	RegisteredObject.SavableObject->OnActorLoaded.Broadcast();
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SaveRegistrySubsystem.generated.h"
+
+class FSaveGamePropertyCopy;
+class FWorldSaveGameFile;
+struct FWorldSaveChunk;
+class UWorldStateSaveGame;
+class USavableObjectMarkerComponent;
+
+/**
+ * Keeps track of all savable actors in the world by their unique world ID, so saving and loading don't have to search
+ * the world (or the saved records) for them.
+ * The records are stored in one chunk per level. The chunk of a level is only read from the save file once the first
+ * actor of that level registers, at which point its record is applied.
+ * When writing, only the records of actors whose transform or SaveGame properties differ from their last save are
+ * replaced, so the chunks of unchanged levels don't have to be compressed and written again. Whether the SaveGame
+ * properties changed is found by comparing them to a copy of their last saved memory, so unchanged actors are never
+ * serialized. The copies of changed actors become the pending data of their records and are serialized by the task
+ * that writes the save file.
+ */
+UCLASS()
+class USaveRegistrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void Register(USavableObjectMarkerComponent* SavableObject);
+	void Unregister(const USavableObjectMarkerComponent* SavableObject, EEndPlayReason::Type EndPlayReason);
+
+	//Sets the save game the records are stored in and applies them to all registered actors
+	void LoadSaveGame(UWorldStateSaveGame* SaveGame, const TSharedPtr<FWorldSaveGameFile>& File);
+	//Updates the records of the save game to the current state of the registered actors
+	void WriteSaveGame();
+
+	//The name of the chunk the records of the actor are stored in
+	static FName GetChunkName(const AActor* Actor);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	struct FRegisteredObject
+	{
+		FRegisteredObject() : SavableObject(nullptr){}
+		FRegisteredObject(USavableObjectMarkerComponent* NewSavableObject, FName NewChunkName) :
+			SavableObject(NewSavableObject), ChunkName(NewChunkName){}
+
+		USavableObjectMarkerComponent* SavableObject;
+		FName ChunkName;
+		//the SaveGame properties as they were last saved or loaded (invalid if the actor has no record yet)
+		TSharedPtr<FSaveGamePropertyCopy, ESPMode::ThreadSafe> SavedState;
+	};
+	TMap<uint64, FRegisteredObject> SavableObjects;
+
+	UPROPERTY()
+	UWorldStateSaveGame* SaveGame;
+	TSharedPtr<FWorldSaveGameFile> SaveFile;
+
+	FWorldSaveChunk& FindOrLoadChunk(FName ChunkName);
+	//Copies the actor into its record if it changed since it was last saved
+	static void UpdateRecord(FRegisteredObject& RegisteredObject, FWorldSaveChunk& Chunk);
+	static void ApplyRecord(FRegisteredObject& RegisteredObject, FWorldSaveChunk& Chunk);
+};
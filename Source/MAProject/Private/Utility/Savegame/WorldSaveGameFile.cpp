@@ -0,0 +1,369 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Savegame/WorldSaveGameFile.h"
+
+#include "Async/Async.h"
+#include "Characters/Fighters/Player/CustomGameState.h"
+#include "PlatformFeatures.h"
+#include "SaveGameSystem.h"
+#include "Utility/Savegame/ReadWriteHelpers.h"
+
+void FWorldSaveGameSnapshot::Capture(UWorldStateSaveGame* SaveGame)
+{
+	PlayerData = SaveGame->PlayerData;
+	ChunkNames.Reset();
+	ChunkRecordStarts.Reset();
+	ActorIDs.Reset();
+	ActorTransforms.Reset();
+	DataOffsets.Reset();
+	Arena.Reset();
+	PendingIndices.Reset();
+	PendingCopies.Reset();
+	for(TPair<FName, FWorldSaveChunk>& Chunk : SaveGame->LoadedChunks)
+	{
+		if(!Chunk.Value.bIsDirty) continue;
+		Chunk.Value.bIsDirty = false;
+		ChunkNames.Add(Chunk.Key);
+		ChunkRecordStarts.Add(ActorIDs.Num());
+		for(const FNonPlayerSaveData& ActorSaveData : Chunk.Value.SavedActors)
+		{
+			ActorIDs.Add(ActorSaveData.ActorUniqueWorldID);
+			ActorTransforms.Add(ActorSaveData.Transform);
+			DataOffsets.Add(Arena.Num());
+			if(ActorSaveData.PendingData.IsValid())
+			{
+				PendingIndices.Add(PendingCopies.Add(ActorSaveData.PendingData));
+				continue;
+			}
+			PendingIndices.Add(INDEX_NONE);
+			Arena.Append(ActorSaveData.SerializedData);
+		}
+	}
+	ChunkRecordStarts.Add(ActorIDs.Num());
+	DataOffsets.Add(Arena.Num());
+}
+
+void FWorldSaveGameSnapshot::SerializePendingCopies()
+{
+	PendingData.SetNum(PendingCopies.Num());
+	for(int32 i = 0; i < PendingCopies.Num(); i++)
+	{
+		PendingData[i].Reset();
+		PendingCopies[i]->Serialize(PendingData[i]);
+	}
+}
+
+void FWorldSaveGameSnapshot::ResolvePendingCopies(UWorldStateSaveGame* SaveGame)
+{
+	check(IsInGameThread());
+	for(int32 ChunkIndex = 0; ChunkIndex < ChunkNames.Num(); ChunkIndex++)
+	{
+		FWorldSaveChunk* Chunk = SaveGame->LoadedChunks.Find(ChunkNames[ChunkIndex]);
+		if(Chunk == nullptr) continue;
+		for(int32 i = ChunkRecordStarts[ChunkIndex]; i < ChunkRecordStarts[ChunkIndex + 1]; i++)
+		{
+			if(PendingIndices[i] == INDEX_NONE) continue;
+			FNonPlayerSaveData* ActorSaveData = Chunk->FindRecord(ActorIDs[i]);
+			if(ActorSaveData == nullptr || ActorSaveData->PendingData != PendingCopies[PendingIndices[i]]) continue;
+			ActorSaveData->SerializedData = MoveTemp(PendingData[PendingIndices[i]]);
+			ActorSaveData->PendingData.Reset();
+		}
+	}
+}
+
+void FWorldSaveGameSnapshot::EncodePlayer(FArchive& Archive) const
+{
+	check(Archive.IsSaving());
+	FTransform PlayerTransform = PlayerData.Transform;
+	int32 PlayerDataSize = PlayerData.SerializedData.Num();
+	Archive << PlayerTransform << PlayerDataSize;
+	Archive.Serialize(const_cast<uint8*>(PlayerData.SerializedData.GetData()), PlayerDataSize);
+}
+
+void FWorldSaveGameSnapshot::EncodeChunk(int32 ChunkIndex, FArchive& Archive) const
+{
+	check(Archive.IsSaving());
+	int32 NumOfRecords = ChunkRecordStarts[ChunkIndex + 1] - ChunkRecordStarts[ChunkIndex];
+	Archive << NumOfRecords;
+	for(int32 i = ChunkRecordStarts[ChunkIndex]; i < ChunkRecordStarts[ChunkIndex + 1]; i++)
+	{
+		uint64 Id = ActorIDs[i];
+		FTransform Transform = ActorTransforms[i];
+		const bool bIsPending = PendingIndices[i] != INDEX_NONE;
+		int32 DataSize = bIsPending ? PendingData[PendingIndices[i]].Num() : DataOffsets[i + 1] - DataOffsets[i];
+		const uint8* Data = bIsPending ? PendingData[PendingIndices[i]].GetData() : Arena.GetData() + DataOffsets[i];
+		Archive << Id << Transform << DataSize;
+		Archive.Serialize(const_cast<uint8*>(Data), DataSize);
+	}
+}
+
+bool FWorldSaveGameSnapshot::DecodePlayer(FArchive& Archive, FGeneralActorSaveData& PlayerData)
+{
+	check(Archive.IsLoading());
+	int32 PlayerDataSize = 0;
+	Archive << PlayerData.Transform << PlayerDataSize;
+	if(Archive.IsError() || PlayerDataSize < 0 || PlayerDataSize > Archive.TotalSize() - Archive.Tell()) return false;
+	PlayerData.SerializedData.SetNumUninitialized(PlayerDataSize);
+	Archive.Serialize(PlayerData.SerializedData.GetData(), PlayerDataSize);
+	return !Archive.IsError();
+}
+
+bool FWorldSaveGameSnapshot::DecodeChunk(FArchive& Archive, FWorldSaveChunk& Chunk)
+{
+	check(Archive.IsLoading());
+	int32 NumOfRecords = 0;
+	Archive << NumOfRecords;
+	if(Archive.IsError() || NumOfRecords < 0) return false;
+	Chunk.SavedActors.Reset(NumOfRecords);
+	for(int32 i = 0; i < NumOfRecords; i++)
+	{
+		FNonPlayerSaveData& ActorSaveData = Chunk.SavedActors.AddDefaulted_GetRef();
+		int32 DataSize = 0;
+		Archive << ActorSaveData.ActorUniqueWorldID << ActorSaveData.Transform << DataSize;
+		if(Archive.IsError() || DataSize < 0 || DataSize > Archive.TotalSize() - Archive.Tell()) return false;
+		ActorSaveData.SerializedData.SetNumUninitialized(DataSize);
+		Archive.Serialize(ActorSaveData.SerializedData.GetData(), DataSize);
+	}
+	Chunk.IndexRecords();
+	return !Archive.IsError();
+}
+
+FWorldSaveGameFile::FWorldSaveGameFile(const FString& NewSlotName) : SlotName(NewSlotName), NextSlotIndex(0),
+	Pipe(TEXT("WorldSaveGameFile"))
+{
+}
+
+UWorldStateSaveGame* FWorldSaveGameFile::Open()
+{
+	FScopeLock Lock(&IndexLock);
+	ChunkIndex.Reset();
+	TArray<uint8> Data;
+	if(!GetSaveGameSystem()->LoadGame(false, *SlotName, UserIndex, Data)) return nullptr;
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic << Version;
+	//saves of older versions are treated like missing ones
+	if(Reader.IsError() || Magic != FileMagic || Version != FileVersion) return nullptr;
+	int32 SavedNextSlotIndex = 0;
+	FBlobEntry PlayerEntry;
+	int32 PlayerDataSize = 0;
+	Reader << SavedNextSlotIndex << PlayerEntry << PlayerDataSize;
+	if(Reader.IsError() || PlayerDataSize < 0 || PlayerDataSize > Reader.TotalSize() - Reader.Tell()) return nullptr;
+	const int64 PlayerDataOffset = Reader.Tell();
+	Reader.Seek(PlayerDataOffset + PlayerDataSize);
+
+	int32 NumOfChunks = 0;
+	Reader << NumOfChunks;
+	if(Reader.IsError() || NumOfChunks < 0) return nullptr;
+	for(int32 i = 0; i < NumOfChunks; i++)
+	{
+		//the level names are stored as strings as well
+		FString LevelName;
+		FBlobEntry Entry;
+		Reader << LevelName << Entry;
+		ChunkIndex.Add(FName(*LevelName), Entry);
+	}
+
+	TArray<uint8> RawData;
+	UWorldStateSaveGame* SaveGame = NewObject<UWorldStateSaveGame>();
+	if(Reader.IsError() || !DecompressBlob(PlayerEntry, Data.GetData() + PlayerDataOffset, PlayerDataSize, RawData))
+	{
+		ChunkIndex.Reset();
+		return nullptr;
+	}
+	FMemoryReader RawReader(RawData);
+	if(!FWorldSaveGameSnapshot::DecodePlayer(RawReader, SaveGame->PlayerData))
+	{
+		ChunkIndex.Reset();
+		return nullptr;
+	}
+	NextSlotIndex = SavedNextSlotIndex;
+	return SaveGame;
+}
+
+bool FWorldSaveGameFile::LoadChunk(FName LevelName, FWorldSaveChunk& OutChunk)
+{
+	//the worker thread doesn't delete the slot of a chunk while the lock is held
+	FScopeLock Lock(&IndexLock);
+	const FBlobEntry* Entry = ChunkIndex.Find(LevelName);
+	if(Entry == nullptr) return false;
+	TArray<uint8> Data;
+	TArray<uint8> RawData;
+	if(!GetSaveGameSystem()->LoadGame(false, *GetChunkSlotName(Entry->SlotIndex), UserIndex, Data) ||
+		!DecompressBlob(*Entry, Data.GetData(), Data.Num(), RawData))
+	{
+		return false;
+	}
+	FMemoryReader RawReader(RawData);
+	return FWorldSaveGameSnapshot::DecodeChunk(RawReader, OutChunk);
+}
+
+void FWorldSaveGameFile::WriteAsync(UWorldStateSaveGame* SaveGame, bool bCompress,
+	FOnWorldSaveGameWrittenDelegate OnWritten)
+{
+	check(IsInGameThread());
+	TSharedRef<FWorldSaveGameSnapshot, ESPMode::ThreadSafe>* FreeSnapshot = SnapshotPool.FindByPredicate(
+		[](const TSharedRef<FWorldSaveGameSnapshot, ESPMode::ThreadSafe>& Snapshot){ return Snapshot.IsUnique(); });
+	TSharedRef<FWorldSaveGameSnapshot, ESPMode::ThreadSafe> Snapshot = FreeSnapshot != nullptr ? *FreeSnapshot :
+		SnapshotPool.Add_GetRef(MakeShared<FWorldSaveGameSnapshot, ESPMode::ThreadSafe>());
+	//this is the only part of the save that has to happen on the game thread
+	Snapshot->Capture(SaveGame);
+
+	Pipe.Launch(TEXT("WriteWorldSaveGame"), [this, Snapshot, bCompress, OnWritten,
+		WeakSaveGame = TWeakObjectPtr<UWorldStateSaveGame>(SaveGame)]()
+	{
+		Snapshot->SerializePendingCopies();
+		const bool bSuccess = WriteFile(*Snapshot, bCompress);
+		if(!bSuccess) UE_LOG(LogSaveGame, Warning, TEXT("Failed to write the save game %s."), *SlotName);
+		AsyncTask(ENamedThreads::GameThread, [Snapshot, bSuccess, OnWritten, WeakSaveGame]()
+		{
+			if(UWorldStateSaveGame* SaveGame = WeakSaveGame.Get(); IsValid(SaveGame))
+			{
+				//the copies have been serialized even if the file couldn't be written
+				Snapshot->ResolvePendingCopies(SaveGame);
+				//the captured chunks have to be written again with the next save
+				for(const FName& LevelName : Snapshot->ChunkNames)
+				{
+					FWorldSaveChunk* Chunk = SaveGame->LoadedChunks.Find(LevelName);
+					if(!bSuccess && Chunk != nullptr) Chunk->bIsDirty = true;
+				}
+			}
+			// ReSharper disable once CppExpressionWithoutSideEffects
+			OnWritten.ExecuteIfBound(bSuccess);
+		});
+	});
+}
+
+bool FWorldSaveGameFile::WriteFile(const FWorldSaveGameSnapshot& Snapshot, bool bCompress)
+{
+	//changed chunks are written to new slots, so the lock is only needed to copy and to replace the index
+	//(otherwise loading a chunk on the game thread would have to wait for the compression)
+	TMap<FName, FBlobEntry> NewChunkIndex;
+	int32 NewNextSlotIndex;
+	{
+		FScopeLock Lock(&IndexLock);
+		NewChunkIndex = ChunkIndex;
+		NewNextSlotIndex = NextSlotIndex;
+	}
+	ISaveGameSystem* SaveGameSystem = GetSaveGameSystem();
+	const FName CompressionFormat = bCompress ? NAME_Oodle : NAME_None;
+
+	TArray<uint8> RawData;
+	TArray<uint8> BlobData;
+	auto EncodeBlob = [&RawData, &BlobData, CompressionFormat](FBlobEntry& Entry)
+	{
+		Entry.CompressionFormat = CompressionFormat;
+		Entry.UncompressedSize = RawData.Num();
+		if(!CompressionFormat.IsNone()) return CompressBlob(CompressionFormat, RawData, BlobData);
+		BlobData = RawData;
+		return true;
+	};
+	TArray<int32> WrittenSlots;
+	TArray<int32> ReplacedSlots;
+	//until the main slot has been written, it and the slots it references stay untouched
+	auto DeleteSlots = [this, SaveGameSystem](const TArray<int32>& SlotIndices)
+	{
+		for(const int32 SlotIndex : SlotIndices)
+		{
+			SaveGameSystem->DeleteGame(false, *GetChunkSlotName(SlotIndex), UserIndex);
+		}
+	};
+
+	for(int32 i = 0; i < Snapshot.ChunkNames.Num(); i++)
+	{
+		RawData.Reset();
+		FMemoryWriter ChunkWriter(RawData);
+		Snapshot.EncodeChunk(i, ChunkWriter);
+		FBlobEntry Entry;
+		Entry.SlotIndex = NewNextSlotIndex++;
+		if(!EncodeBlob(Entry) ||
+			!SaveGameSystem->SaveGame(false, *GetChunkSlotName(Entry.SlotIndex), UserIndex, BlobData))
+		{
+			DeleteSlots(WrittenSlots);
+			return false;
+		}
+		WrittenSlots.Add(Entry.SlotIndex);
+		if(const FBlobEntry* OldEntry = NewChunkIndex.Find(Snapshot.ChunkNames[i])) ReplacedSlots.Add(OldEntry->SlotIndex);
+		NewChunkIndex.Add(Snapshot.ChunkNames[i], Entry);
+	}
+
+	RawData.Reset();
+	FMemoryWriter PlayerWriter(RawData);
+	Snapshot.EncodePlayer(PlayerWriter);
+	FBlobEntry PlayerEntry;
+	if(!EncodeBlob(PlayerEntry))
+	{
+		DeleteSlots(WrittenSlots);
+		return false;
+	}
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	uint32 Magic = FileMagic;
+	int32 Version = FileVersion;
+	int32 PlayerDataSize = BlobData.Num();
+	Writer << Magic << Version << NewNextSlotIndex << PlayerEntry << PlayerDataSize;
+	Writer.Serialize(BlobData.GetData(), PlayerDataSize);
+	int32 NumOfChunks = NewChunkIndex.Num();
+	Writer << NumOfChunks;
+	for(TPair<FName, FBlobEntry>& Entry : NewChunkIndex)
+	{
+		FString LevelName = Entry.Key.ToString();
+		Writer << LevelName << Entry.Value;
+	}
+	if(!SaveGameSystem->SaveGame(false, *SlotName, UserIndex, Data))
+	{
+		DeleteSlots(WrittenSlots);
+		return false;
+	}
+
+	{
+		FScopeLock Lock(&IndexLock);
+		ChunkIndex = MoveTemp(NewChunkIndex);
+		NextSlotIndex = NewNextSlotIndex;
+	}
+	//chunks are only read while holding the lock, so nothing reads the replaced slots anymore
+	DeleteSlots(ReplacedSlots);
+	return true;
+}
+
+ISaveGameSystem* FWorldSaveGameFile::GetSaveGameSystem()
+{
+	ISaveGameSystem* SaveGameSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+	check(SaveGameSystem != nullptr);
+	return SaveGameSystem;
+}
+
+FString FWorldSaveGameFile::GetChunkSlotName(int32 SlotIndex) const
+{
+	return FString::Printf(TEXT("%s_%d"), *SlotName, SlotIndex);
+}
+
+bool FWorldSaveGameFile::CompressBlob(FName Format, const TArray<uint8>& RawData, TArray<uint8>& OutData)
+{
+	int32 CompressedSize = FCompression::CompressMemoryBound(Format, RawData.Num());
+	OutData.SetNumUninitialized(CompressedSize, false);
+	if(!FCompression::CompressMemory(Format, OutData.GetData(), CompressedSize, RawData.GetData(), RawData.Num()))
+	{
+		return false;
+	}
+	OutData.SetNum(CompressedSize, false);
+	return true;
+}
+
+bool FWorldSaveGameFile::DecompressBlob(const FBlobEntry& Entry, const uint8* Data, int64 Size, TArray<uint8>& OutData)
+{
+	if(Entry.UncompressedSize < 0 || Entry.UncompressedSize > MAX_int32) return false;
+	OutData.SetNumUninitialized(Entry.UncompressedSize, false);
+	if(Entry.CompressionFormat.IsNone())
+	{
+		if(Size != Entry.UncompressedSize) return false;
+		FMemory::Memcpy(OutData.GetData(), Data, Size);
+		return true;
+	}
+	return FCompression::UncompressMemory(Entry.CompressionFormat, OutData.GetData(), Entry.UncompressedSize, Data,
+		Size);
+}
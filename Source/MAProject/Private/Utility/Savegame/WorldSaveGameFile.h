@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Pipe.h"
+#include "Utility/Savegame/WorldStateSaveGame.h"
+
+class ISaveGameSystem;
+
+DECLARE_DELEGATE_OneParam(FOnWorldSaveGameWrittenDelegate, bool /*bSuccess*/);
+
+//Flat copy of the changed parts of a world save game that can be encoded independently of the game thread.
+//The serialized data of all actors is stored in one arena (except for the records that haven't been serialized yet,
+//which only share their property copy)
+struct FWorldSaveGameSnapshot
+{
+	FGeneralActorSaveData PlayerData;
+	TArray<FName> ChunkNames;
+	//the records of chunk i are ChunkRecordStarts[i] to ChunkRecordStarts[i + 1] - 1
+	TArray<int32> ChunkRecordStarts;
+	TArray<uint64> ActorIDs;
+	TArray<FTransform> ActorTransforms;
+	//the data of record i is stored in Arena[DataOffsets[i]] to Arena[DataOffsets[i + 1] - 1]
+	TArray<int32> DataOffsets;
+	TArray<uint8> Arena;
+	//record i is serialized into PendingData[PendingIndices[i]] by the write task (INDEX_NONE if it is in the arena)
+	TArray<int32> PendingIndices;
+	TArray<TSharedPtr<FSaveGamePropertyCopy, ESPMode::ThreadSafe>> PendingCopies;
+	TArray<TArray<uint8>> PendingData;
+
+	//Copies the player data and all dirty chunks, which are considered clean afterwards
+	void Capture(UWorldStateSaveGame* SaveGame);
+	void SerializePendingCopies();
+	//Hands the serialized copies to the records that haven't changed again since they were captured
+	void ResolvePendingCopies(UWorldStateSaveGame* SaveGame);
+	void EncodePlayer(FArchive& Archive) const;
+	void EncodeChunk(int32 ChunkIndex, FArchive& Archive) const;
+	static bool DecodePlayer(FArchive& Archive, FGeneralActorSaveData& PlayerData);
+	static bool DecodeChunk(FArchive& Archive, FWorldSaveChunk& Chunk);
+};
+
+/**
+ * The world save is split into one independently compressed blob per level (streaming level or world partition cell),
+ * which are stored in slots of their own through the platform's save game system. The main slot contains the player
+ * and the index of the chunk slots, so opening the save only reads the main slot, the chunks are read once their level
+ * is loaded.
+ * Writing happens in two phases: the game thread only takes a snapshot of the changed chunks, while serializing the
+ * changed actors, encoding, compressing and writing the slots are done on a worker thread. Unchanged chunks keep their
+ * slots, while changed ones are written to new slots that replace the old ones once the main slot references them.
+ */
+class FWorldSaveGameFile
+{
+public:
+	explicit FWorldSaveGameFile(const FString& NewSlotName);
+	//pending writes are finished, so no save is lost when the file is destroyed
+	~FWorldSaveGameFile(){ Pipe.WaitUntilEmpty(); }
+
+	//Reads the index and the player from the main slot (nullptr if there is none or it is invalid)
+	UWorldStateSaveGame* Open();
+	//false if the save doesn't contain a valid chunk for the level
+	bool LoadChunk(FName LevelName, FWorldSaveChunk& OutChunk);
+	//OnWritten is executed on the game thread once all slots have been written
+	void WriteAsync(UWorldStateSaveGame* SaveGame, bool bCompress, FOnWorldSaveGameWrittenDelegate OnWritten);
+
+protected:
+	struct FBlobEntry
+	{
+		FBlobEntry() : SlotIndex(INDEX_NONE), UncompressedSize(0){}
+		//the blob is stored in the slot "<SlotName>_<SlotIndex>" (the player is stored in the main slot)
+		int32 SlotIndex;
+		FName CompressionFormat;
+		int64 UncompressedSize;
+
+		friend FArchive& operator<<(FArchive& Archive, FBlobEntry& Entry)
+		{
+			//names are stored as strings, because memory archives don't serialize them
+			FString CompressionFormatName = Entry.CompressionFormat.ToString();
+			Archive << Entry.SlotIndex << CompressionFormatName << Entry.UncompressedSize;
+			if(Archive.IsLoading()) Entry.CompressionFormat = FName(*CompressionFormatName);
+			return Archive;
+		}
+	};
+
+	FString SlotName;
+	//guards the index, which the worker thread only replaces once the new slots have been written
+	FCriticalSection IndexLock;
+	TMap<FName, FBlobEntry> ChunkIndex;
+	//slots are never overwritten, every written chunk gets a new one
+	int32 NextSlotIndex;
+
+	UE::Tasks::FPipe Pipe;
+	//snapshots that aren't referenced by a pending write anymore are reused
+	TArray<TSharedRef<FWorldSaveGameSnapshot, ESPMode::ThreadSafe>> SnapshotPool;
+
+	static constexpr uint32 FileMagic = 0x4D415753;
+	static constexpr int32 FileVersion = 4;
+	static constexpr int32 UserIndex = 0;
+
+	bool WriteFile(const FWorldSaveGameSnapshot& Snapshot, bool bCompress);
+	static ISaveGameSystem* GetSaveGameSystem();
+	FString GetChunkSlotName(int32 SlotIndex) const;
+	static bool CompressBlob(FName Format, const TArray<uint8>& RawData, TArray<uint8>& OutData);
+	static bool DecompressBlob(const FBlobEntry& Entry, const uint8* Data, int64 Size, TArray<uint8>& OutData);
+};
@@ -2,3 +2,36 @@
 
 
 #include "Utility/Savegame/WorldStateSaveGame.h"
+
+FNonPlayerSaveData* FWorldSaveChunk::FindRecord(uint64 ActorUniqueWorldID)
+{
+	const int32* RecordIndex = RecordIndices.Find(ActorUniqueWorldID);
+	return RecordIndex == nullptr ? nullptr : &SavedActors[*RecordIndex];
+}
+
+FNonPlayerSaveData& FWorldSaveChunk::FindOrAddRecord(uint64 ActorUniqueWorldID)
+{
+	if(FNonPlayerSaveData* Record = FindRecord(ActorUniqueWorldID)) return *Record;
+	RecordIndices.Add(ActorUniqueWorldID, SavedActors.Num());
+	FNonPlayerSaveData& Record = SavedActors.AddDefaulted_GetRef();
+	Record.ActorUniqueWorldID = ActorUniqueWorldID;
+	return Record;
+}
+
+void FWorldSaveChunk::RemoveRecord(uint64 ActorUniqueWorldID)
+{
+	int32 RecordIndex;
+	if(!RecordIndices.RemoveAndCopyValue(ActorUniqueWorldID, RecordIndex)) return;
+	SavedActors.RemoveAtSwap(RecordIndex, 1, false);
+	//the last record has been moved into the free spot
+	if(SavedActors.IsValidIndex(RecordIndex)) RecordIndices[SavedActors[RecordIndex].ActorUniqueWorldID] = RecordIndex;
+}
+
+void FWorldSaveChunk::IndexRecords()
+{
+	RecordIndices.Reset();
+	for(int32 i = 0; i < SavedActors.Num(); i++)
+	{
+		RecordIndices.Add(SavedActors[i].ActorUniqueWorldID, i);
+	}
+}
@@ -19,4 +19,64 @@ void FSoundConfig::PlaySoundAtLocation(UWorld* World, const FVector& PlayLocatio
 		VolumeMultiplier * AdditionalVolumeMultiplier, PitchMultiplier * AdditionalPitchMultiplier,
 		0.f, SoundAttenuation);
 
+}
+
+void UPhysicsSoundResponseConfig::PostInitProperties()
+{
+	Super::PostInitProperties();
+	ResolveResponses();
+}
+
+void UPhysicsSoundResponseConfig::PostLoad()
+{
+	Super::PostLoad();
+	ResolveResponses();
+}
+
+#if WITH_EDITOR
+void UPhysicsSoundResponseConfig::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	ResolveResponses();
+}
+#endif
+
+void UPhysicsSoundResponseConfig::ResolveResponses()
+{
+	ResolvedResponses.Reset();
+	ResolvedResponses.SetNum(SurfaceType_Max);
+	for(const TPair<TEnumAsByte<EPhysicalSurface>, FSoundConfig>& Response : PhysicsResponses)
+	{
+		ResolvedResponses[Response.Key] = Response.Value;
+	}
+}
+
+void UPhysicsAILoudnessResponseConfig::PostInitProperties()
+{
+	Super::PostInitProperties();
+	ResolveResponses();
+}
+
+void UPhysicsAILoudnessResponseConfig::PostLoad()
+{
+	Super::PostLoad();
+	ResolveResponses();
+}
+
+#if WITH_EDITOR
+void UPhysicsAILoudnessResponseConfig::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	ResolveResponses();
+}
+#endif
+
+void UPhysicsAILoudnessResponseConfig::ResolveResponses()
+{
+	ResolvedResponses.Reset();
+	ResolvedResponses.SetNumZeroed(SurfaceType_Max);
+	for(const TPair<TEnumAsByte<EPhysicalSurface>, float>& Response : PhysicsAILoudnessResponses)
+	{
+		ResolvedResponses[Response.Key] = Response.Value;
+	}
 }
\ No newline at end of file
@@ -5,6 +5,84 @@
 
 #include "Characters/Fighters/Attacks/AttackDamageEvent.h"
 
+FStatBonuses::FStatBonuses()
+{
+	FMemory::Memzero(Flat);
+	FMemory::Memzero(Percentage);
+}
+
+void FStatBonuses::Add(EScalableStat Stat, float FlatBonus, float PercentageBonus)
+{
+	Flat[static_cast<int32>(Stat)] += FlatBonus;
+	Percentage[static_cast<int32>(Stat)] += PercentageBonus;
+}
+
+FStatBonuses FStatBonuses::operator-() const
+{
+	FStatBonuses Negated;
+	for(int32 i = 0; i < NumOfLanes; i += 4)
+	{
+		VectorStoreAligned(VectorNegate(VectorLoadAligned(&Flat[i])), &Negated.Flat[i]);
+		VectorStoreAligned(VectorNegate(VectorLoadAligned(&Percentage[i])), &Negated.Percentage[i]);
+	}
+	return Negated;
+}
+
+FStatBlock::FStatBlock() : Generation(1), ResolvedGeneration(0)
+{
+	FMemory::Memzero(Base);
+	FMemory::Memzero(FlatBonus);
+	FMemory::Memzero(PercentageBonus);
+	FMemory::Memzero(Resulting);
+	FMemory::Memzero(ResultingInt);
+}
+
+void FStatBlock::SetBase(EScalableStat Stat, float NewBase)
+{
+	Base[static_cast<int32>(Stat)] = NewBase;
+	Generation++;
+}
+
+void FStatBlock::ResetBonuses(EScalableStat Stat)
+{
+	FlatBonus[static_cast<int32>(Stat)] = 0.f;
+	PercentageBonus[static_cast<int32>(Stat)] = 0.f;
+	Generation++;
+}
+
+void FStatBlock::AddBonuses(const FStatBonuses& Bonuses)
+{
+	for(int32 i = 0; i < NumOfLanes; i += 4)
+	{
+		VectorStoreAligned(VectorAdd(VectorLoadAligned(&FlatBonus[i]), VectorLoadAligned(&Bonuses.Flat[i])),
+			&FlatBonus[i]);
+		VectorStoreAligned(VectorAdd(VectorLoadAligned(&PercentageBonus[i]), VectorLoadAligned(&Bonuses.Percentage[i])),
+			&PercentageBonus[i]);
+	}
+	Generation++;
+}
+
+bool FStatBlock::operator==(const FStatBlock& StatBlock) const
+{
+	return FMemory::Memcmp(Base, StatBlock.Base, sizeof(Base)) == 0 &&
+		FMemory::Memcmp(FlatBonus, StatBlock.FlatBonus, sizeof(FlatBonus)) == 0 &&
+		FMemory::Memcmp(PercentageBonus, StatBlock.PercentageBonus, sizeof(PercentageBonus)) == 0;
+}
+
+void FStatBlock::Resolve() const
+{
+	for(int32 i = 0; i < NumOfLanes; i++)
+	{
+		//computed in double precision like the stats always were, as float rounding changes the truncated values
+		//(e.g. 225 with +4% would result in 233 instead of 234)
+		const double Scaled = PercentageBonus[i] < 0.f ? 1.0 : Base[i] * (1.0 + PercentageBonus[i] / 100.0);
+		const double Result = Scaled + FlatBonus[i];
+		Resulting[i] = static_cast<float>(Result);
+		ResultingInt[i] = static_cast<int32>(Result);
+	}
+	ResolvedGeneration = Generation;
+}
+
 bool FGeneralBaseStats::operator==(const FGeneralBaseStats& GeneralBaseStats) const
 {
 	return BaseHealth == GeneralBaseStats.BaseHealth && BaseAttack == GeneralBaseStats.BaseAttack &&
@@ -22,23 +100,30 @@ FGeneralObjectStatsBuffs FGeneralObjectStatsBuffs::ReverseGeneralObjectBuffs() c
 		-FlatDefense);
 }
 
-FGeneralObjectStats::FGeneralObjectStats(): Attack(0, 0, 0.f),
-                                            Defense(0, 0, 0.f)
+void FGeneralObjectStatsBuffs::AddTo(FStatBonuses& Bonuses) const
+{
+	//the health bonuses were stored as integers, which truncated them towards zero
+	Bonuses.Add(EScalableStat::Health, FMath::TruncToFloat(FlatHealth), HealthBuff);
+	Bonuses.Add(EScalableStat::Attack, FMath::Floor(FlatAttack), AttackBuff);
+	Bonuses.Add(EScalableStat::Defense, FMath::Floor(FlatDefense), DefenseBuff);
+}
+
+FGeneralObjectStats::FGeneralObjectStats(): CurrentHealth(0)
 {
 }
 
 bool FGeneralObjectStats::operator==(const FGeneralObjectStats& GeneralObjectStats) const
 {
-	return Health == GeneralObjectStats.Health && Attack == GeneralObjectStats.Attack &&
-		Defense == GeneralObjectStats.Defense;
+	return ScalableStats == GeneralObjectStats.ScalableStats && CurrentHealth == GeneralObjectStats.CurrentHealth;
 }
 
 void FGeneralObjectStats::FromBase(const FGeneralBaseStats& Stats, const FSavableModifiersBase& Modifiers)
 {
 	//TODO: Include real level scaling
-	Health.SetBaseMax(Stats.BaseHealth * Modifiers.Level);
-	Attack.Base = Stats.BaseAttack * Modifiers.Level;
-	Defense.Base = Stats.BaseDefense * Modifiers.Level;
+	ScalableStats.SetBase(EScalableStat::Health, Stats.BaseHealth * Modifiers.Level);
+	CurrentHealth = GetMaxHealth();
+	ScalableStats.SetBase(EScalableStat::Attack, Stats.BaseAttack * Modifiers.Level);
+	ScalableStats.SetBase(EScalableStat::Defense, Stats.BaseDefense * Modifiers.Level);
 }
 
 void FGeneralObjectStats::Reset()
@@ -50,46 +135,60 @@ void FGeneralObjectStats::Reset()
 
 void FGeneralObjectStats::ResetHealth()
 {
-	Health.Reset();
-	OnMaxHealthChanged.Broadcast(Health.Current, Health.Maximum.GetResulting());
-	Health.Reset();
+	ScalableStats.ResetBonuses(EScalableStat::Health);
+	CurrentHealth = GetMaxHealth();
+	OnMaxHealthChanged.Broadcast(CurrentHealth, GetMaxHealth());
 }
 
 void FGeneralObjectStats::ResetAttack()
 {
-	Attack.FlatBonus = 0.f;
-	Attack.PercentageBonus = 0.f;
+	ScalableStats.ResetBonuses(EScalableStat::Attack);
 }
 
 void FGeneralObjectStats::ResetDefense()
 {
-	Defense.FlatBonus = 0.f;
-	Defense.PercentageBonus = 0.f;
+	ScalableStats.ResetBonuses(EScalableStat::Defense);
 }
 
 void FGeneralObjectStats::Buff(const FGeneralObjectStatsBuffs& Buffs)
 {
-	Health.AddBonuses(Buffs.FlatHealth, Buffs.HealthBuff);
-	OnMaxHealthChanged.Broadcast(Health.Current, Health.Maximum.GetResulting());
-	Attack.FlatBonus += FMath::Floor(Buffs.FlatAttack);
-	Defense.FlatBonus += FMath::Floor(Buffs.FlatDefense);
-	Attack.PercentageBonus += Buffs.AttackBuff;
-	Defense.PercentageBonus += Buffs.DefenseBuff;
- }
+	FStatBonuses Bonuses;
+	Buffs.AddTo(Bonuses);
+	ApplyBonuses(Bonuses);
+}
 
 void FGeneralObjectStats::Debuff(const FGeneralObjectStatsBuffs& Buffs)
 {
-	Health.AddBonuses(-Buffs.FlatHealth, -Buffs.HealthBuff);
-	OnMaxHealthChanged.Broadcast(Health.Current, Health.Maximum.GetResulting());
-	Attack.FlatBonus -= FMath::Floor(Buffs.FlatAttack);
-	Defense.FlatBonus -= FMath::Floor(Buffs.FlatDefense);
-	Attack.PercentageBonus -= Buffs.AttackBuff;
-	Defense.PercentageBonus -= Buffs.DefenseBuff;
+	FStatBonuses Bonuses;
+	Buffs.AddTo(Bonuses);
+	ApplyBonuses(-Bonuses);
+}
+
+void FGeneralObjectStats::Buff(TArrayView<FGeneralObjectStats* const> Stats, const FGeneralObjectStatsBuffs& Buffs)
+{
+	FStatBonuses Bonuses;
+	Buffs.AddTo(Bonuses);
+	for(FGeneralObjectStats* ObjectStats : Stats) ObjectStats->ApplyBonuses(Bonuses);
+}
+
+void FGeneralObjectStats::ApplyBonuses(const FStatBonuses& Bonuses)
+{
+	const int32 OldMaxHealth = GetMaxHealth();
+	ScalableStats.AddBonuses(Bonuses);
+	CurrentHealth = RescaleCurrent(CurrentHealth, OldMaxHealth, GetMaxHealth());
+	OnMaxHealthChanged.Broadcast(CurrentHealth, GetMaxHealth());
+}
+
+int32 FGeneralObjectStats::RescaleCurrent(int32 Current, int32 OldMaximum, int32 NewMaximum)
+{
+	if(OldMaximum == 0) return NewMaximum;
+	const double NewCurrent = round(static_cast<double>(Current) / OldMaximum * NewMaximum);
+	return Current != 0 && NewCurrent == 0.0 ? 1 : static_cast<int32>(NewCurrent);
 }
 
 float FGeneralObjectStats::GetDamageOutput() const
 {
-	return Attack.GetResulting();
+	return GetAttack();
 }
 
 int32 FGeneralObjectStats::ReceiveDamage(float Damage, const FCustomDamageEvent* DamageInfo)
@@ -105,14 +204,14 @@ int32 FGeneralObjectStats::ReceiveDamage(float Damage, const FCustomDamageEvent*
 int32 FGeneralObjectStats::ChangeHealth(int32 DeltaHealth)
 {
 	int32 ResultingHealth;
-	if(Health.Current + DeltaHealth >= Health.Maximum.GetResulting()) ResultingHealth = Health.Maximum.GetResulting();
-	else if(Health.Current <= -DeltaHealth) ResultingHealth = 0;
-	else ResultingHealth = Health.Current + DeltaHealth;
+	if(CurrentHealth + DeltaHealth >= GetMaxHealth()) ResultingHealth = GetMaxHealth();
+	else if(CurrentHealth <= -DeltaHealth) ResultingHealth = 0;
+	else ResultingHealth = CurrentHealth + DeltaHealth;
 	
-	OnHealthChanged.Broadcast(ResultingHealth, Health.Current);
+	OnHealthChanged.Broadcast(ResultingHealth, CurrentHealth);
 	
 	if(ResultingHealth <= 0 && OnNoHealthReached.IsBound())OnNoHealthReached.Broadcast();
 	
-	Health.Current = ResultingHealth;
-	return Health.Current;
+	CurrentHealth = ResultingHealth;
+	return CurrentHealth;
 }
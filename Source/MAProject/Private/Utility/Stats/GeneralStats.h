@@ -6,78 +6,76 @@
 #include "CustomDamageEvent.h"
 #include "GeneralStats.generated.h"
 
-template<typename Value, typename Percentage>
-class TScalable
+//The stats that can be modified by buffs (the lanes of FStatBlock). The first ones are shared by all objects, the others
+//are only used by characters
+enum class EScalableStat : uint8
 {
-public:
-	Value Base;
-	Value FlatBonus;
-	Percentage PercentageBonus;
-	
-	TScalable() = default;
+	Health,
+	Attack,
+	Defense,
+	Toughness,
+	WalkSpeed,
+	RunSpeed,
+	InterruptionResistance,
+	Num
+};
 
-	TScalable(const Value& NewBase, const Value& NewFlatBonus, const Percentage& NewPercentageBonus) :
-		Base(NewBase), FlatBonus(NewFlatBonus), PercentageBonus(NewPercentageBonus){}
-	
-	TScalable(const TScalable& Scalable) :
-		Base(static_cast<Value>(Scalable.Base)), FlatBonus(static_cast<Value>(Scalable.FlatBonus)),
-		PercentageBonus(static_cast<Percentage>(Scalable.PercentageBonus))
-	{}
+//Bonuses for all lanes of a FStatBlock, so they can be added at once
+struct MAPROJECT_API FStatBonuses
+{
+	static constexpr int32 NumOfLanes = 8;
+	static_assert(static_cast<int32>(EScalableStat::Num) <= NumOfLanes);
 
-	Value GetResulting() const
-	{
-		return (PercentageBonus < 0 ? 1 : Base * (1.0 + PercentageBonus/100.0)) + FlatBonus;
-	};
+	FStatBonuses();
 
-	Value operator+(const Value& OtherFlatBonus){ return GetResulting() * OtherFlatBonus; }
-	Value operator*(const Percentage& OtherScalar){ return GetResulting() * OtherScalar; }
-	
-	bool operator==(const TScalable& Scalable) const
-	{
-		return Base == static_cast<Value>(Scalable.Base) &&
-			FlatBonus == static_cast<Value>(Scalable.Base) &&
-				PercentageBonus == static_cast<Percentage>(Scalable.PercentageBonus);
-	}
+	void Add(EScalableStat Stat, float FlatBonus, float PercentageBonus);
+	FStatBonuses operator-() const;
+
+	alignas(16) float Flat[NumOfLanes];
+	alignas(16) float Percentage[NumOfLanes];
 };
 
-template<typename Value, typename Percentage>
-class TMaxedValue{
-public:
-	typedef TScalable<Value, Percentage> FMaxVal;
-	
-	FMaxVal Maximum;
-	Value Current;
-	
-	TMaxedValue() : Maximum(0, 0, 0), Current(0){}
-	TMaxedValue(const Value& NewBase, const Value& NewFlatBonus, const Percentage& NewPercentageBonus) :
-		Maximum(NewBase, NewFlatBonus, NewPercentageBonus){ Current = Maximum.GetResulting(); }
-	TMaxedValue(const FMaxVal& Scalable) : Maximum(Scalable){ Current = Maximum.GetResulting(); }
-	TMaxedValue(const TMaxedValue& MaxedValue) : Maximum(MaxedValue), Current(MaxedValue.Current){}
+/**
+ * The base values and bonuses of all scalable stats of an object, packed so the bonuses are added with SIMD and the
+ * resulting values are all computed together. They are only recomputed when the modifiers changed since the last read
+ * (tracked by a generation counter), so reading a stat usually only is a load.
+ */
+struct MAPROJECT_API FStatBlock
+{
+	static constexpr int32 NumOfLanes = FStatBonuses::NumOfLanes;
 
-	void SetBaseMax(const Value& NewBase)
-	{
-		Maximum.Base = NewBase;
-		Current = Maximum.GetResulting();
-	}
-	void Reset()
-	{
-		Maximum.FlatBonus = 0.f;
-		Maximum.PercentageBonus = 0.f;
-		Current = Maximum.GetResulting();
-	}
-	void AddBonuses(const Value& FlatBonus, const Percentage& PercentageBonus)
+	FStatBlock();
+
+	float GetResulting(EScalableStat Stat) const
 	{
-		const double CurrentRatio = static_cast<double>(Current)/static_cast<double>(Maximum.GetResulting());
-		Maximum.FlatBonus += FlatBonus;
-		Maximum.FlatBonus += PercentageBonus;
-		const double NewCurrent = round(CurrentRatio * static_cast<double>(Maximum.GetResulting()));
-		Current = (Current != 0 && NewCurrent == 0.0 ? 1.0 : NewCurrent);
+		if(ResolvedGeneration != Generation) Resolve();
+		return Resulting[static_cast<int32>(Stat)];
 	}
-	
-	bool operator==(const TMaxedValue& Scalable) const
+	//The resulting value truncated towards zero
+	int32 GetResultingInt(EScalableStat Stat) const
 	{
-		return Maximum == Scalable.Maximum && Current == static_cast<Value>(Scalable.Current);
+		if(ResolvedGeneration != Generation) Resolve();
+		return ResultingInt[static_cast<int32>(Stat)];
 	}
+	float GetBase(EScalableStat Stat) const { return Base[static_cast<int32>(Stat)]; }
+	uint32 GetGeneration() const { return Generation; }
+
+	void SetBase(EScalableStat Stat, float NewBase);
+	void ResetBonuses(EScalableStat Stat);
+	void AddBonuses(const FStatBonuses& Bonuses);
+
+	bool operator==(const FStatBlock& StatBlock) const;
+
+protected:
+	alignas(16) float Base[NumOfLanes];
+	alignas(16) float FlatBonus[NumOfLanes];
+	alignas(16) float PercentageBonus[NumOfLanes];
+	alignas(16) mutable float Resulting[NumOfLanes];
+	alignas(16) mutable int32 ResultingInt[NumOfLanes];
+	uint32 Generation;
+	mutable uint32 ResolvedGeneration;
+
+	void Resolve() const;
 };
 
 USTRUCT()
@@ -149,6 +147,7 @@ public:
 	float FlatDefense;
 
 	FGeneralObjectStatsBuffs ReverseGeneralObjectBuffs() const;
+	virtual void AddTo(FStatBonuses& Bonuses) const;
 };
 
 
@@ -165,12 +164,13 @@ struct FGeneralObjectStats
 	
 	FOnMinHealthReachedDelegate OnNoHealthReached;
 
+	FStatBlock ScalableStats;
 	//Represents the current health of the object. Should not be changed directly but through ReceiveDamage
-	TMaxedValue<int32, float> Health;
-
-	TScalable<int32, float> Attack;
-	TScalable<int32, float> Defense;
+	int32 CurrentHealth;
 
+	int32 GetMaxHealth() const { return ScalableStats.GetResultingInt(EScalableStat::Health); }
+	int32 GetAttack() const { return ScalableStats.GetResultingInt(EScalableStat::Attack); }
+	int32 GetDefense() const { return ScalableStats.GetResultingInt(EScalableStat::Defense); }
 
 	bool operator==(const FGeneralObjectStats& GeneralObjectStats) const;
 
@@ -181,14 +181,21 @@ struct FGeneralObjectStats
 	void ResetDefense();
 	void Buff(const FGeneralObjectStatsBuffs& Buffs);
 	void Debuff(const FGeneralObjectStatsBuffs& Buffs);
+	//Buffs all the stats at once (e.g. area buffs), only converting the buffs once
+	static void Buff(TArrayView<FGeneralObjectStats* const> Stats, const FGeneralObjectStatsBuffs& Buffs);
 
 	virtual float GetDamageOutput() const;
 	virtual void GenerateDamageEvent(FCustomDamageEvent& DamageEvent, const FHitResult& HitResult = FHitResult()) const = 0;
 	int32 ReceiveDamage(float Damage, const FCustomDamageEvent* DamageInfo);
-	int32 ReceiveDamage(float Damage){ return ChangeHealth(-Damage/static_cast<float>(Defense.GetResulting())); }
+	int32 ReceiveDamage(float Damage){ return ChangeHealth(-Damage/static_cast<float>(GetDefense())); }
 	int32 ChangeHealth(int32 DeltaHealth);
 	FORCEINLINE int32 ChangeHealthByPercentage(float Percentage)
 	{ 
-		return ChangeHealth(static_cast<float>(Health.Maximum.GetResulting()) * Percentage/100.f);
+		return ChangeHealth(static_cast<float>(GetMaxHealth()) * Percentage/100.f);
 	}
+
+protected:
+	virtual void ApplyBonuses(const FStatBonuses& Bonuses);
+	//Keeps the ratio between the current and the maximal value, but doesn't let a non zero value become zero
+	static int32 RescaleCurrent(int32 Current, int32 OldMaximum, int32 NewMaximum);
 };
@@ -5,25 +5,34 @@
 
 #include "Characters/GeneralCharacter.h"
 #include "Components/Image.h"
+#include "Utility/Stats/StatusEffectSubsystem.h"
 
 UStatusEffect::UStatusEffect() : BoundImage(nullptr), EffectTarget(nullptr), Thumbnail(nullptr), MaxEffectTime(-1.f)
 {
-	PrimaryComponentTick.bCanEverTick = true;
-	PrimaryComponentTick.bStartWithTickEnabled = false;
+	//the remaining time is tracked by the UStatusEffectSubsystem
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
-void UStatusEffect::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UStatusEffect::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	const float TimeRemaining = GetOwner()->GetWorld()->GetTimerManager().GetTimerRemaining(EffectResetHandle);
-	if(TimeRemaining <= 0) return;
-	BoundImage->GetDynamicMaterial()->SetScalarParameterValue("Alpha", TimeRemaining/MaxEffectTime);
+	Super::EndPlay(EndPlayReason);
+	//the effect may be destroyed together with its owner without being removed first
+	if(UStatusEffectSubsystem* StatusEffectSubsystem = GetStatusEffectSubsystem())
+	{
+		StatusEffectSubsystem->Stop(this);
+		StatusEffectSubsystem->SetIsBound(this, false);
+	}
+}
+
+float UStatusEffect::GetTimeRemaining() const
+{
+	const UStatusEffectSubsystem* StatusEffectSubsystem = GetStatusEffectSubsystem();
+	return StatusEffectSubsystem == nullptr ? -1.f : StatusEffectSubsystem->GetTimeRemaining(this);
 }
 
 void UStatusEffect::ForceRestartTimer(FForceStatusEffectTimerRestartKey)
 {
-	GetOwner()->GetWorld()->GetTimerManager().SetTimer(EffectResetHandle, this, &UStatusEffect::OnEffectTimeExceeded,
-		MaxEffectTime);
+	GetStatusEffectSubsystem()->Start(this, MaxEffectTime);
 }
 
 void UStatusEffect::BindImage(UImage* Image, FStatusEffectBindImageKey)
@@ -36,20 +45,28 @@ void UStatusEffect::BindImage(UImage* Image, FStatusEffectBindImageKey)
 	BoundImage = Image;
 	if(IsValid(Thumbnail)) BoundImage->SetBrushResourceObject(Thumbnail);
 	BoundImage->SetVisibility(ESlateVisibility::Visible);
-	PrimaryComponentTick.SetTickFunctionEnable(true);
+	GetStatusEffectSubsystem()->SetIsBound(this, true);
+}
+
+void UStatusEffect::SetImageAlpha(float Alpha, FStatusEffectSubsystemKey)
+{
+	if(!IsValid(BoundImage)) return;
+	BoundImage->GetDynamicMaterial()->SetScalarParameterValue("Alpha", Alpha);
 }
 
 void UStatusEffect::OnEffectApplied_Implementation(AGeneralCharacter* Target)
 {
 	OnEffectApplied(Target);
 	EffectTarget = Target;
-	GetWorld()->GetTimerManager().SetTimer(EffectResetHandle, this, &UStatusEffect::OnEffectTimeExceeded,
-		MaxEffectTime);
+	GetStatusEffectSubsystem()->Start(this, MaxEffectTime);
 }
 
 void UStatusEffect::OnEffectRemoved_Implementation(AGeneralCharacter* Target)
 {
 	OnEffectRemoved(Target);
+	UStatusEffectSubsystem* StatusEffectSubsystem = GetStatusEffectSubsystem();
+	StatusEffectSubsystem->Stop(this);
+	StatusEffectSubsystem->SetIsBound(this, false);
 	if(IsValid(BoundImage))	BoundImage->SetVisibility(ESlateVisibility::Hidden);
 }
 
@@ -59,8 +76,13 @@ void UStatusEffect::OnEffectTimedOut_Implementation(AGeneralCharacter* Target)
 	OnEffectTimedOut(Target);
 }
 
-void UStatusEffect::OnEffectTimeExceeded()
+void UStatusEffect::OnExpired(FStatusEffectSubsystemKey)
 {
 	OnEffectTimedOut_Implementation(EffectTarget);
 	EffectTarget->RemoveStatusEffectExternal(this, FModifyCharacterStatusEffectKey());
-}
\ No newline at end of file
+}
+UStatusEffectSubsystem* UStatusEffect::GetStatusEffectSubsystem() const
+{
+	const UWorld* World = GetWorld();
+	return World == nullptr ? nullptr : World->GetSubsystem<UStatusEffectSubsystem>();
+}
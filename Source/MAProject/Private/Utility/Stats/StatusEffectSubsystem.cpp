@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utility/Stats/StatusEffectSubsystem.h"
+
+#include "MAProject.h"
+#include "Characters/GeneralCharacter.h"
+#include "Utility/Stats/StatusEffect.h"
+
+DECLARE_CYCLE_STAT(TEXT("Status Effects"), STAT_StatusEffects, STATGROUP_MAProjectStatusEffects);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Status Effects"), STAT_ActiveStatusEffects, STATGROUP_MAProjectStatusEffects);
+
+FActiveStatusEffect::FActiveStatusEffect(UStatusEffect* NewEffect, AGeneralCharacter* NewOwner, double NewStartTime,
+	float NewDuration, uint32 NewSerial) : Effect(NewEffect), Owner(NewOwner), EffectClass(NewEffect->GetClass()),
+	StartTime(NewStartTime), Duration(NewDuration),
+	ExpirationTime(NewDuration > 0.f ? NewStartTime + NewDuration : TNumericLimits<double>::Max()), Serial(NewSerial)
+{
+}
+
+void UStatusEffectSubsystem::Start(UStatusEffect* Effect, float Duration)
+{
+	Stop(Effect);
+	const FActiveStatusEffect ActiveEffect(Effect, Cast<AGeneralCharacter>(Effect->GetOwner()),
+		GetWorld()->GetTimeSeconds(), Duration, NextSerial++);
+	const int32 EffectIndex = ActiveEffects.Add(ActiveEffect);
+	ActiveEffectIndices.Add(Effect, EffectIndex);
+	//effects that never expire don't need an entry
+	if(Duration > 0.f)
+	{
+		//outdated entries are dropped once they make up most of the heap, so restarting effects doesn't grow it
+		if(ExpirationHeap.Num() >= 2 * ActiveEffects.Num())
+		{
+			ExpirationHeap.RemoveAllSwap([this](const FStatusEffectExpiration& Expiration)
+			{
+				return !ActiveEffects.IsValidIndex(Expiration.EffectIndex) ||
+					ActiveEffects[Expiration.EffectIndex].Serial != Expiration.Serial;
+			}, false);
+			ExpirationHeap.Heapify();
+		}
+		ExpirationHeap.HeapPush(FStatusEffectExpiration(ActiveEffect.ExpirationTime, EffectIndex, ActiveEffect.Serial));
+	}
+
+	if(FBoundStatusEffect* BoundEffect = BoundEffects.FindByPredicate(
+		[Effect](const FBoundStatusEffect& Other){ return Other.Effect == Effect; }))
+	{
+		BoundEffect->Duration = Duration;
+		BoundEffect->ExpirationTime = ActiveEffect.ExpirationTime;
+		BoundEffect->LastAlpha = -1.f;
+	}
+}
+
+void UStatusEffectSubsystem::Stop(const UStatusEffect* Effect)
+{
+	int32 EffectIndex;
+	//the heap entry of the effect is outdated by freeing its index
+	if(ActiveEffectIndices.RemoveAndCopyValue(Effect, EffectIndex)) ActiveEffects.RemoveAt(EffectIndex);
+}
+
+float UStatusEffectSubsystem::GetTimeRemaining(const UStatusEffect* Effect) const
+{
+	const FActiveStatusEffect* ActiveEffect = FindActiveEffect(Effect);
+	if(ActiveEffect == nullptr || ActiveEffect->Duration <= 0.f) return -1.f;
+	return static_cast<float>(ActiveEffect->ExpirationTime - GetWorld()->GetTimeSeconds());
+}
+
+int32 UStatusEffectSubsystem::GetEffectClassIndex(const UClass* EffectClass)
+{
+	if(const int32* ClassIndex = EffectClassIndices.Find(EffectClass)) return *ClassIndex;
+	return EffectClassIndices.Add(EffectClass, EffectClassIndices.Num());
+}
+
+int32 UStatusEffectSubsystem::FindEffectClassIndex(const UClass* EffectClass) const
+{
+	const int32* ClassIndex = EffectClassIndices.Find(EffectClass);
+	return ClassIndex == nullptr ? INDEX_NONE : *ClassIndex;
+}
+
+void UStatusEffectSubsystem::SetIsBound(UStatusEffect* Effect, bool bIsBound)
+{
+	BoundEffects.RemoveAllSwap([Effect](const FBoundStatusEffect& BoundEffect){ return BoundEffect.Effect == Effect; });
+	if(!bIsBound) return;
+
+	FBoundStatusEffect& BoundEffect = BoundEffects.Emplace_GetRef(Effect);
+	if(const FActiveStatusEffect* ActiveEffect = FindActiveEffect(Effect))
+	{
+		BoundEffect.Duration = ActiveEffect->Duration;
+		BoundEffect.ExpirationTime = ActiveEffect->ExpirationTime;
+	}
+}
+
+void UStatusEffectSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	MAPROJECT_SCOPE_CYCLE_COUNTER(STAT_StatusEffects);
+	SET_DWORD_STAT(STAT_ActiveStatusEffects, ActiveEffects.Num());
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	//the expired effects are removed before notifying them, because removing them can start or stop other effects
+	ExpiredEffects.Reset();
+	while(ExpirationHeap.Num() > 0 && ExpirationHeap.HeapTop().ExpirationTime <= CurrentTime)
+	{
+		FStatusEffectExpiration Expiration;
+		ExpirationHeap.HeapPop(Expiration, false);
+		if(!ActiveEffects.IsValidIndex(Expiration.EffectIndex)) continue;
+		const FActiveStatusEffect& ActiveEffect = ActiveEffects[Expiration.EffectIndex];
+		if(ActiveEffect.Serial != Expiration.Serial) continue;
+		ExpiredEffects.Add(ActiveEffect.Effect);
+		//effects stop themselves when they end play, so the effect is still valid here
+		ActiveEffectIndices.Remove(ActiveEffect.Effect.Get());
+		ActiveEffects.RemoveAt(Expiration.EffectIndex);
+	}
+	for(const TWeakObjectPtr<UStatusEffect>& ExpiredEffect : ExpiredEffects)
+	{
+		if(UStatusEffect* Effect = ExpiredEffect.Get(); IsValid(Effect)) Effect->OnExpired(FStatusEffectSubsystemKey());
+	}
+	UpdateBoundEffects();
+}
+
+const FActiveStatusEffect* UStatusEffectSubsystem::FindActiveEffect(const UStatusEffect* Effect) const
+{
+	const int32* EffectIndex = ActiveEffectIndices.Find(Effect);
+	return EffectIndex == nullptr ? nullptr : &ActiveEffects[*EffectIndex];
+}
+
+void UStatusEffectSubsystem::UpdateBoundEffects()
+{
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	for(int32 i = BoundEffects.Num() - 1; i >= 0; i--)
+	{
+		FBoundStatusEffect& BoundEffect = BoundEffects[i];
+		UStatusEffect* Effect = BoundEffect.Effect.Get();
+		if(!IsValid(Effect))
+		{
+			BoundEffects.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+		const double TimeRemaining = BoundEffect.ExpirationTime - CurrentTime;
+		if(BoundEffect.Duration <= 0.f || TimeRemaining <= 0.0) continue;
+		const float Alpha = static_cast<float>(TimeRemaining / BoundEffect.Duration);
+		if(FMath::Abs(Alpha - BoundEffect.LastAlpha) < AlphaUpdateThreshold) continue;
+		BoundEffect.LastAlpha = Alpha;
+		Effect->SetImageAlpha(Alpha, FStatusEffectSubsystemKey());
+	}
+}
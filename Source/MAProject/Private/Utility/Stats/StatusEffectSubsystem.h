@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StatusEffectSubsystem.generated.h"
+
+class AGeneralCharacter;
+class UStatusEffect;
+
+struct FStatusEffectSubsystemKey final
+{
+	friend class UStatusEffectSubsystem;
+private:
+	FStatusEffectSubsystemKey(){}
+};
+
+struct FActiveStatusEffect
+{
+	FActiveStatusEffect() : EffectClass(nullptr), StartTime(0.0), Duration(0.f), ExpirationTime(0.0), Serial(0){}
+	FActiveStatusEffect(UStatusEffect* NewEffect, AGeneralCharacter* NewOwner, double NewStartTime, float NewDuration,
+		uint32 NewSerial);
+
+	TWeakObjectPtr<UStatusEffect> Effect;
+	TWeakObjectPtr<AGeneralCharacter> Owner;
+	const UClass* EffectClass;
+	double StartTime;
+	float Duration;
+	double ExpirationTime;
+	//identifies this start of the effect
+	uint32 Serial;
+};
+
+//Entry of the expiration heap, which is outdated once the serial of its effect doesn't match anymore
+struct FStatusEffectExpiration
+{
+	FStatusEffectExpiration() : ExpirationTime(0.0), EffectIndex(INDEX_NONE), Serial(0){}
+	FStatusEffectExpiration(double NewExpirationTime, int32 NewEffectIndex, uint32 NewSerial) :
+		ExpirationTime(NewExpirationTime), EffectIndex(NewEffectIndex), Serial(NewSerial){}
+
+	double ExpirationTime;
+	int32 EffectIndex;
+	uint32 Serial;
+
+	//effects expiring at the same time expire in the order they were started
+	bool operator<(const FStatusEffectExpiration& Other) const
+	{
+		return ExpirationTime < Other.ExpirationTime || (ExpirationTime == Other.ExpirationTime && Serial < Other.Serial);
+	}
+};
+
+//An effect whose remaining time is shown in the HUD
+struct FBoundStatusEffect
+{
+	FBoundStatusEffect() : Duration(0.f), ExpirationTime(0.0), LastAlpha(-1.f){}
+	explicit FBoundStatusEffect(UStatusEffect* NewEffect) : Effect(NewEffect), Duration(0.f), ExpirationTime(0.0),
+		LastAlpha(-1.f){}
+
+	TWeakObjectPtr<UStatusEffect> Effect;
+	float Duration;
+	double ExpirationTime;
+	float LastAlpha;
+};
+
+/**
+ * Times all active status effects of the world. The effects are found through their index in a sparse array, while their
+ * expiration times are kept in a heap, so expiring them only has to look at its top. Stopping an effect doesn't touch
+ * the heap, its entry is skipped once it reaches the top. The images of the effects shown in the HUD are only updated
+ * once their value has visibly changed.
+ */
+UCLASS()
+class UStatusEffectSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Starts (or restarts) the effect, effects with a duration <= 0 never expire
+	void Start(UStatusEffect* Effect, float Duration);
+	void Stop(const UStatusEffect* Effect);
+	//-1 if the effect isn't active or never expires
+	float GetTimeRemaining(const UStatusEffect* Effect) const;
+	//Bound effects get their image updated according to their remaining time
+	void SetIsBound(UStatusEffect* Effect, bool bIsBound);
+	//A dense index identifying the effect class in this world (assigned the first time the class is looked up)
+	int32 GetEffectClassIndex(const UClass* EffectClass);
+	//INDEX_NONE if the class has never been looked up (so no effect of it has ever been active)
+	int32 FindEffectClassIndex(const UClass* EffectClass) const;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(UStatusEffectSubsystem, STATGROUP_Tickables);
+	}
+
+protected:
+	TSparseArray<FActiveStatusEffect> ActiveEffects;
+	TMap<TObjectKey<UStatusEffect>, int32> ActiveEffectIndices;
+	TArray<FStatusEffectExpiration> ExpirationHeap;
+	uint32 NextSerial = 0;
+	TArray<FBoundStatusEffect> BoundEffects;
+	//the effects removed by the current tick that still have to be notified
+	TArray<TWeakObjectPtr<UStatusEffect>> ExpiredEffects;
+	//only contains the effect classes (and their parents) that have been used in this world
+	TMap<TObjectKey<UClass>, int32> EffectClassIndices;
+
+	//smaller changes of the alpha wouldn't be visible in an 8 bit channel
+	static constexpr float AlphaUpdateThreshold = 1.f / 255.f;
+
+	const FActiveStatusEffect* FindActiveEffect(const UStatusEffect* Effect) const;
+	void UpdateBoundEffects();
+};
@@ -54,12 +54,8 @@ public:
 
 	virtual const FAttackProperties& GetAttackProperties(const AActor* PlayingInstance = nullptr) const;
 	virtual bool CanBeCalled(const FString& NodeName) const;
-	bool GetIsOnCd() const { return bIsOnCd; }
-	FTimerHandle GetTimerHandle() const{ return CdHandle; }
-	void Execute();
-	void ForceSetCd(float DesiredCd);
-	float CdTimeElapsed() const;
-	float CdTimeRemaining() const;
+	//the cooldown of the node is stored per character (see FAttacks)
+	float GetCdTime() const { return AttackProperties.GetTotalCdTime(); }
 
 #if WITH_EDITOR
 	virtual FText GetNodeTitle() const override;
@@ -67,9 +63,6 @@ public:
 	virtual FLinearColor GetBackgroundColor() const override;
 #endif
 protected:
-	bool bIsOnCd;
-	FTimerHandle CdHandle;
-
 	UPROPERTY(EditDefaultsOnly, Category = AttackProperties)
 	FAttackPropertiesNode AttackProperties;
 	UPROPERTY(EditDefaultsOnly, Category = AttackProperties)
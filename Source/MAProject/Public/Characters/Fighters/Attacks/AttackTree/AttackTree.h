@@ -6,6 +6,8 @@
 #include "GenericGraph.h"
 #include "AttackTree.generated.h"
 
+class FAttackTreeTable;
+
 /**
  * 
  */
@@ -16,7 +18,11 @@ class MAPROJECT_API UAttackTree : public UGenericGraph
 public:
 	UAttackTree();
 	bool GetShowAsPlayerTree() const { return bShowAsPlayerTree; };
+	//the flattened version of this tree used at runtime (compiled when first needed)
+	TSharedRef<const FAttackTreeTable> GetCompiledTable() const;
 protected:
 	UPROPERTY(EditDefaultsOnly)
 	bool bShowAsPlayerTree;
+
+	mutable TSharedPtr<const FAttackTreeTable> CompiledTable;
 };
@@ -17,6 +17,7 @@ public:
 	UAttackTreeRootNode();
 	
 	bool GetIsMainRootNode(const FString& Identifier = FString()) const;
+	const FString& GetJumpToIdentifier() const { return JumpToIdentifier; }
 	
 #if WITH_EDITOR
 	virtual void SetNodeTitle(const FText& NewTitle) override;
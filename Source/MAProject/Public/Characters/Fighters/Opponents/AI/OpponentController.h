@@ -7,6 +7,8 @@
 #include "Perception/AIPerceptionComponent.h"
 #include "Perception/AIPerceptionTypes.h"
 #include "Utility/CombatManager.h"
+#include "Utility/NonPlayerFunctionality/AISignificanceSubsystem.h"
+#include "Utility/NonPlayerFunctionality/SightTrackingSubsystem.h"
 #include "OpponentController.generated.h"
 
 class AOpponentCharacter;
@@ -22,6 +24,13 @@ private:
 	FForceEndCombatKey(){}
 };
 
+struct FCombatLocationQueryKey final
+{
+	friend class ACombatManager;
+private:
+	FCombatLocationQueryKey(){}
+};
+
 struct FReleaseTokenKey final
 {
 	friend class UBTTask_ReleaseAggressionTokens;
@@ -71,7 +80,6 @@ public:
 
 	
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
-	virtual void Tick(float DeltaSeconds) override;
 
 	
 	virtual FGenericTeamId GetGenericTeamId() const override { return 1; }
@@ -80,6 +88,19 @@ public:
 	bool UpdateCombatLocation(FVector& ResultingLocation, ECombatParticipantStatus ParticipantStatus,
 		bool ForceRecalculation = false) const;
 
+	bool SetupCombatLocationQuery(FCombatLocationQuery& Query, ECombatParticipantStatus ParticipantStatus,
+		bool ForceRecalculation, const TArray<AOpponentCharacter*>& JointlySolvedParticipants, FCombatLocationQueryKey) const
+	{ return SetupCombatLocationQueryInternal(Query, ParticipantStatus, ForceRecalculation, JointlySolvedParticipants); }
+	//writes the solved target location to the blackboard (or clears it if none was found). Requested locations arrive
+	//at the end of the frame, or once the path queries are done with asynchronous navigation
+	void OnCombatLocationSolved(const FCombatLocationQuery& Query, FCombatLocationQueryKey) const;
+
+	//the sighted actor has moved further than RelevantSightPerceptionChangeRadius since the last update
+	void OnWatchedActorMoved(AActor* SightedActor, const FVector& NewLocation, FSightTrackingKey);
+	//the sight of the actor has been lost for long enough to be forgotten (nullptr if the actor has been destroyed)
+	void OnSightExpired(AActor* SightedActor, FSightTrackingKey);
+	void ApplySignificanceTier(const FAISignificanceTierSettings& Settings, FAISignificanceKey Key);
+
 	//We override the built in MoveTo function to make all move to requests use the custom MoveTarget so we can
 	//have a smooth interpolation when movement targets are changed on the fly instead of always stopping and then
 	//starting to walk every time we change the MoveTo target
@@ -87,6 +108,8 @@ public:
 	
 	float GetFieldOfView() const;
 	ACombatManager* GetCombatManager() const{ return CombatManager; }
+	//the location the controlled character currently occupies or is moving to
+	FVector GetReservedLocation() const { return GetCharacterTargetLocation(ControlledOpponent, TargetLocationKeyName); }
 
 #if WITH_EDITORONLY_DATA
 	bool GetIsDebugging() const { return bIsDebugging; }
@@ -103,6 +126,10 @@ protected:
 	UPROPERTY()
 	ACombatManager* CombatManager;
 	UPROPERTY()
+	USightTrackingSubsystem* SightTracking;
+	UPROPERTY()
+	UAISignificanceSubsystem* AISignificance;
+	UPROPERTY()
 	AOpponentCharacter* ControlledOpponent;
 	UPROPERTY()
 	UCrowdFollowingComponent* CrowdFollowingComponent;
@@ -130,6 +157,8 @@ protected:
 
 	UPROPERTY(EditAnywhere, Category = Perception)
 	float RelevantSightPerceptionChangeRadius;
+	//the time after which a lost sight stimulus is forgotten
+	static constexpr double SightExpirationTime = 1.0;
 	
 	UPROPERTY(EditAnywhere, Category = Combat, AdvancedDisplay)
 	float ForwardSampleNumber;
@@ -146,6 +175,12 @@ protected:
 	void ActiveUpdateCombat(const AActor* CombatTarget, const FAIStimulus& KnownInformation) const;
 	void EndCombat(bool FullyUnregister = false) const;
 
+	//Sets up the constraints for finding a combat location. Participants contained in JointlySolvedParticipants are
+	//ignored, as their reservations are handled by the combat manager. Returns false if no location can be found.
+	bool SetupCombatLocationQueryInternal(FCombatLocationQuery& Query, ECombatParticipantStatus ParticipantStatus,
+		bool ForceRecalculation, const TArray<AOpponentCharacter*>& JointlySolvedParticipants) const;
+	void FinishCombatLocationQuery(const FCombatLocationQuery& Query) const;
+
 	bool OnSightForgotten(AActor* SightedActor) const;
 
 	static FVector GetCharacterTargetLocation(const AOpponentCharacter* RelevantCharacter, FName BlackboardTargetLocationName);
@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "Characters/Fighters/FighterCharacter.h"
+#include "Utility/NonPlayerFunctionality/AISignificanceSubsystem.h"
 #include "Utility/NonPlayerFunctionality/PositionalConstraint.h"
 #include "Utility/Tools/pcg-cpp/include/pcg_random.hpp"
 #include "OpponentCharacter.generated.h"
@@ -108,6 +109,20 @@ private:
 	FResetOpponentStatsKey(){}
 };
 
+struct FSeedOpponentRandomGeneratorKey final
+{
+	friend class UCombatBenchmarkCommandlet;
+private:
+	FSeedOpponentRandomGeneratorKey(){}
+};
+
+struct FEditOnAggressionScoreInvalidatedKey final
+{
+	friend ACombatManager;
+private:
+	FEditOnAggressionScoreInvalidatedKey(){}
+};
+
 /**
  * 
  */
@@ -131,9 +146,17 @@ public:
 	void BindOnAggressionTokensGranted(const TDelegate<void()>& FunctionToBind, FEditOnAggressionTokensGrantedOrReleasedKey);
 	void BindOnAggressionTokensReleased(const TDelegate<void()>& FunctionToBind, FEditOnAggressionTokensGrantedOrReleasedKey);
 	
+	//called whenever the attacks or the state the aggression score depends on change (e.g. after attacking or dying)
+	void BindOnAggressionScoreInvalidated(const TDelegate<void(AOpponentCharacter*)>& FunctionToBind,
+		FEditOnAggressionScoreInvalidatedKey);
+	void UnbindOnAggressionScoreInvalidated(const void* BoundObject, FEditOnAggressionScoreInvalidatedKey);
+	
 	void ExecuteOnAggressionTokensGranted(FExecuteOnAggressionTokensGrantedKey) const;
 	void ExecuteOnAggressionTokensReleased(FExecuteOnAggressionTokensReleasedKey) const;
 	void ResetAllStats(FResetOpponentStatsKey) const { CharacterStats->Reset(); }
+	//makes the attacks and stagger chances of all opponents reproducible
+	static void SeedRandomGenerator(uint64 Seed, FSeedOpponentRandomGeneratorKey){ RandomGenerator.seed(Seed); }
+	void ApplySignificanceTier(const FAISignificanceTierSettings& Settings, FAISignificanceKey);
 
 	FRequiredSpace GetRequiredSpace() const;
 	USphereComponent* GetRequiredSpaceActive() const;
@@ -167,6 +190,21 @@ public:
 	 * @return the score is always >= 0.f if the opponent is allowed to become aggressive (normally: <= 4.5f;
 	 * if character is the player's target: <= 8.5f)*/
 	 float GenerateAggressionScore(APlayerCharacter* PlayerCharacter) const;
+	/**
+	 * @brief Same as above, but with the distance taken from the given locations (e.g. of the combat manager's snapshot)
+	 */
+	 float GenerateAggressionScore(APlayerCharacter* PlayerCharacter, const FVector& OwnLocation,
+		const FVector& PlayerLocation) const;
+	/**
+	 * @brief Same as above, but without the penalty for not being able to attack yet, so the score only changes when
+	 * the locations or the opponent's state change (see ScaleAggressionScore)
+	 */
+	 float GenerateBaseAggressionScore(APlayerCharacter* PlayerCharacter, const FVector& OwnLocation,
+		const FVector& PlayerLocation) const;
+	//applies the penalty for opponents that can only attack in CanAttackInSeconds to the base aggression score
+	static float ScaleAggressionScore(float BaseScore, float CanAttackInSeconds);
+	//the world time at which the opponent will be able to attack again
+	double GetAttackReadyTime() const;
 
 protected:
 	inline static pcg_extras::seed_seq_from<std::random_device> SeedSource;
@@ -177,6 +215,7 @@ protected:
 	
 	TDelegate<void()> OnAggressionTokensGranted;
 	TDelegate<void()> OnAggressionTokensRemoved;
+	TMulticastDelegate<void(AOpponentCharacter*)> OnAggressionScoreInvalidated;
 
 	UPROPERTY()
 	UAttackNode* RequestedAttack;
@@ -235,13 +274,15 @@ protected:
 
 	bool CanAttack() const{ return CanAttackInSeconds() <= 0.f; };
 	float CanAttackInSeconds() const;
-	static float EarliestAttackSeconds(const UGenericGraphNode* SourceNode);
+	float EarliestAttackSeconds(const UGenericGraphNode* SourceNode) const;
+	//a random attack following the current node, weighted by priority (RequiredRange < 0 means any range)
+	UAttackNode* SampleAvailableAttack(float RequiredRange) const;
 	
 	void SetUseActiveCombatSpace() const;
 	void SetUsePassiveSpace() const;
 
 	UFUNCTION()
-	void OnAttackTreeRootChanged(){ RequestedAttack = nullptr; };
+	void OnAttackTreeRootChanged(){ RequestedAttack = nullptr; OnAggressionScoreInvalidated.Broadcast(this); };
 	
 	UFUNCTION()
 	void OnSelectMotionWarpingTarget(const FAttackProperties& Properties);	
@@ -8,6 +8,7 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogSaveGame, Warning, All);
 
+class FWorldSaveGameFile;
 class UWorldStateSaveGame;
 /**
  * 
@@ -21,6 +22,9 @@ public:
 	ACustomGameState();
 	virtual void ReceivedGameModeClass() override;
 
+	//Executed once a save requested by WriteSaveGame has been written to disk
+	TMulticastDelegate<void(bool bSuccess)> OnSaveGameWritten;
+
 	void LoadSaveGame();
 	void WriteSaveGame();
 	
@@ -28,4 +32,9 @@ protected:
 
 	UPROPERTY()
 	UWorldStateSaveGame* WorldSaveGame;
+
+	UPROPERTY(EditAnywhere, Category = SaveGame)
+	bool bCompressSaveGame;
+
+	TSharedPtr<FWorldSaveGameFile> SaveFile;
 };
@@ -6,6 +6,7 @@
 #include "Characters/Fighters/FighterCharacter.h"
 #include "InputActionValue.h"
 #include "PlayerPartyController.h"
+#include "Characters/Fighters/Player/TargetSelectionQueries.h"
 #include "PlayerCharacter.generated.h"
 
 class UPlayerStatsMonitorBaseWidget;
@@ -104,8 +105,10 @@ protected:
 	FStoredInput LastInput;
 	TDelegate<void(const FVector2D&)> OnPlayerMovedCamera;
 	TDelegate<void(bool)> OnAttackInterrupted;
-
-	
+	//the traces of the target selection are run asynchronously, so the selection uses the results of the last frame
+	FTargetSelectionQueries TargetSelectionQueries;
+	//the frame in which the target was last selected with the current state of the world
+	uint64 ConfirmedTargetSelectionFrame;
 
 	UPROPERTY()
 	UTargetInformationComponent* CurrentTarget;
@@ -217,7 +220,11 @@ protected:
 	void OpenPauseMenu();
 
 	void UpdateTargetSelection();
-	bool IsOccluded(ETraceTypeQuery TraceType, const FVector& ObserverLocation, const FVector& TargetCenter, const FVector& TargetExtent, AActor* TargetActor) const;
+	//Re-selects the target with synchronous traces where the cached results are outdated (at most once per frame), so
+	//the target an action uses is the same as if all traces had been synchronous
+	void ConfirmTargetSelection();
+	void SelectTarget(const FVector& EyesLocation, const FVector& ViewDirection, const FVector& PlayerLocation,
+		bool bIsSelectionRequested);
 
 	UFUNCTION()
 	void ShowDeathMenu(bool IsLimitDurationOver);
@@ -9,28 +9,37 @@
 class UImage;
 class UTextBlock;
 /**
- * 
+ * Only updated when the displayed values change (the cooldowns in tenth-second steps), so it doesn't need to tick
  */
-UCLASS()
+UCLASS(meta=(DisableNativeTick))
 class MAPROJECT_API UPlayerStatsMonitorBaseWidget : public UStatsMonitorBaseWidget
 {
 	GENERATED_BODY()
+	//creates the bound widgets, which are otherwise only created by the widget blueprint
+	friend class FPlayerStatsMonitorCooldownTest;
 
 public:
 	UPlayerStatsMonitorBaseWidget();
 
 	void SetTotalSkillCdTime(float CdTime);
 	void SetTotalUltimateCdTime(float CdTime);
-	void SetSkillTimer(FTimerHandle SkillTimerHandle);
-	void SetUltimateTimer(FTimerHandle UltimateTimerHandle);
+	//-1 if the skill isn't on cooldown
+	void SetSkillCdReadyTime(double ReadyTime);
+	void SetUltimateCdReadyTime(double ReadyTime);
 	UImage* GetFirstAvailableImage();
 	UImage* GetFirstUnconnectedImage();
 
 protected:
 	float SkillTotalCd;
 	float UltimateTotalCd;
-	FTimerHandle SkillCdHandle;
-	FTimerHandle UltimateCdHandle;
+	double SkillCdReadyTime;
+	double UltimateCdReadyTime;
+	//the displayed remaining cooldowns in tenths of a second (INDEX_NONE if hidden)
+	int32 DisplayedSkillCdTenths;
+	int32 DisplayedUltimateCdTenths;
+	//incremented whenever a ready time is set, so the steps scheduled for older ready times are ignored
+	uint32 SkillCdGeneration;
+	uint32 UltimateCdGeneration;
 
 	TArray<UImage*> StatusEffectMarkers;
 	
@@ -49,11 +58,15 @@ protected:
 	UPROPERTY(meta = (BindWidget))
 	UImage* UltimateCdPercentage;
 	
-	virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
 	virtual void UpdateHealthInternal(int32 NewHealth, int32 OldHealth) override;
 	virtual void UpdateMaxHealthInternal(int32 CurrentHealth, int32 NewMaxHealth) override;
 	void SetSkillCdTime(float CdTime);
 	void SetUltimateCdTime(float CdTime);
+	//Updates the displayed cooldown and schedules the next update for when the displayed value changes
+	void OnSkillCdStep(uint32 Generation);
+	void OnUltimateCdStep(uint32 Generation);
+	//the world time at which the displayed value of a cooldown with the given ready time changes next
+	double GetNextCdStepTime(double ReadyTime) const;
 
 	UFUNCTION(BlueprintCallable)
 	void RegisterStatusEffectMarker(const TArray<UImage*>& Markers){ StatusEffectMarkers.Append(Markers); }
@@ -4,28 +4,47 @@
 
 #include "CoreMinimal.h"
 #include "Components/WidgetComponent.h"
+#include "UserInterface/StatsMonitorBaseWidget.h"
 #include "PlayerFacingWidgetComponent.generated.h"
 
+struct FCharacterStats;
 
-DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHealthMonitorWidgetInitializedDelegate, UStatsMonitorBaseWidget*, Widget);
-
+/**
+ * Marks where the health bar of its owner is displayed. The bar itself is drawn by the UHealthBarSubsystem using the
+ * widget class of this component, so the component doesn't create its own widget (outside of the editor) or tick.
+ */
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class MAPROJECT_API UPlayerFacingWidgetComponent : public UWidgetComponent
 {
 	GENERATED_BODY()
 
 public:
-	
-	FOnHealthMonitorWidgetInitializedDelegate OnHealthMonitorWidgetInitialized;
-	
 	// Sets default values for this component's properties
 	UPlayerFacingWidgetComponent();
-	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
-							   FActorComponentTickFunction* ThisTickFunction) override;
+
+	virtual void InitWidget() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//Displays the values of the stats and keeps them up to date
+	void RegisterStats(FCharacterStats* Stats, FSetupInformationKey);
+
+	UFUNCTION()
+	void UpdateHealth(int32 NewHealth, int32 OldHealth);
+	UFUNCTION()
+	void UpdateMaxHealth(int32 NewCurrentHealth, int32 NewMaxHealth);
+	UFUNCTION()
+	void UpdateToughness(int32 NewToughness, int32 OldToughness);
+	UFUNCTION()
+	void UpdateMaxToughness(int32 NewCurrentToughness, int32 NewMaxToughness);
 
 protected:
+	int32 CurrentHealth;
+	int32 MaxHealth;
+	int32 CurrentToughness;
+	int32 MaxToughness;
+
 	// Called when the game starts
 	virtual void BeginPlay() override;
+
+	void PushRatios() const;
 };
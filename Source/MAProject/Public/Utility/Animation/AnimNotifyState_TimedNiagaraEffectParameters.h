@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "AnimNotifyState_TimedNiagaraEffect.h"
+#include "Utility/Animation/NiagaraEffectPoolSubsystem.h"
 #include "AnimNotifyState_TimedNiagaraEffectParameters.generated.h"
 
 
@@ -77,6 +78,11 @@ public:
 
 	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration,
 		const FAnimNotifyEventReference& EventReference) override;
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+		const FAnimNotifyEventReference& EventReference) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 	
 protected:
 	float NotifyTime;
@@ -99,5 +105,13 @@ protected:
 	UPROPERTY(EditAnywhere)
 	FVector NonAttachedScale;
 
+	//the parameters resolved for the template (in the same order as the arrays above), only done once
+	mutable bool bHasResolvedParameters;
+	mutable FNiagaraEffectParameter ResolvedPlayLength;
+	mutable TArray<FNiagaraEffectParameter> ResolvedFloatParameters;
+	mutable TArray<FNiagaraEffectParameter> ResolvedLinearColorParameters;
+	mutable TArray<FNiagaraEffectParameter> ResolvedVectorParameters;
+
+	void ResolveParameters() const;
 	virtual UFXSystemComponent* SpawnEffect(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) const override;
 };
@@ -3,7 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "AI/Navigation/NavigationTypes.h"
 #include "GameFramework/Actor.h"
+#include "Utility/NonPlayerFunctionality/PositionalConstraint.h"
 #include "CombatManager.generated.h"
 
 
@@ -34,6 +36,13 @@ private:
 	FManageAggressionTokensKey(){};
 };
 
+struct FRequestCombatLocationKey final
+{
+	friend class AOpponentController;
+private:
+	FRequestCombatLocationKey(){};
+};
+
 struct FAggressorInfo
 {
 	FAggressorInfo() : Aggressor(nullptr),
@@ -53,9 +62,111 @@ struct FAggressorInfo
 
 struct FScoredAggressorInfo : public FAggressorInfo
 {
-	FScoredAggressorInfo() : Score(std::numeric_limits<float>::lowest()){}
-	FScoredAggressorInfo(AOpponentCharacter* NewHolder, UAttackNode* AttackTreeNode, float NewScore, uint32 NewTokens);
+	FScoredAggressorInfo() : Score(std::numeric_limits<float>::lowest()), Sequence(0){}
+	FScoredAggressorInfo(AOpponentCharacter* NewHolder, UAttackNode* AttackTreeNode, float NewScore, uint32 NewTokens,
+		uint32 NewSequence);
 	float Score;
+	//the position in the order of the passive participants (decides between equal scores)
+	uint32 Sequence;
+};
+
+struct FAggressionTokenSchedulerStats
+{
+	FAggressionTokenSchedulerStats() : Grants(0), Rescores(0), Distributions(0), TotalStarvationTime(0.0),
+		MaxStarvationTime(0.0){}
+
+	uint64 Grants;
+	uint64 Rescores;
+	uint64 Distributions;
+	//the time the participants have been waiting for their tokens while being passive
+	double TotalStarvationTime;
+	double MaxStarvationTime;
+
+	double GetAverageStarvationTime() const { return Grants == 0 ? 0.0 : TotalStarvationTime / Grants; }
+};
+
+//What an aggression score depends on apart from the requester's attacks and state (which signal their own changes)
+struct FAggressionScoreInputs
+{
+	FAggressionScoreInputs() : RequesterLocation(NAN), PlayerLocation(NAN), PlayerViewDirection(NAN),
+		AttackSourceIndex(INDEX_NONE), bIsPlayerTarget(false), bCanAttack(false){}
+
+	FVector RequesterLocation;
+	FVector PlayerLocation;
+	FVector PlayerViewDirection;
+	//the attack tree node the requested attack has to follow (changes when the combo expires)
+	int32 AttackSourceIndex;
+	bool bIsPlayerTarget;
+	//whether attacking is currently allowed by the requester's input limits
+	bool bCanAttack;
+};
+
+//The parts of an aggression score that stay the same until its inputs change
+struct FAggressionScore
+{
+	FAggressionScore() : BaseScore(-1.f), AttackReadyTime(0.0){}
+
+	//the score without the penalty for not being able to attack yet (< 0.f if the requester can't become aggressive)
+	float BaseScore;
+	//the world time at which the requester can attack again
+	double AttackReadyTime;
+};
+
+//Keeps the scored aggression requests of all passive participants. Scores are only recalculated once the requester
+//signaled a change of its attacks or state or once the scored locations or the player's view have changed noticeably,
+//and the requests are handed out by priority using a binary heap whose memory is reused
+class FAggressionTokenScheduler
+{
+public:
+	FAggressionTokenScheduler() : RescoreDistance(50.0), RescoreViewDot(0.996){}
+
+	//how far the requester or the player may move before the score is recalculated
+	double RescoreDistance;
+	//the minimal dot product between the scored and the current view direction of the player (cosine of the angle)
+	double RescoreViewDot;
+
+	void AddRequester(AOpponentCharacter* Requester, double CurrentTime);
+	void RemoveRequester(const AOpponentCharacter* Requester);
+	//forces the score of the requester to be recalculated on the next distribution
+	void InvalidateScore(const AOpponentCharacter* Requester);
+	void Reset();
+
+	//Rescores all invalidated requests and the ones whose inputs have changed, then queues all requests that are
+	//allowed to receive tokens by their score (the time until the requesters can attack is applied to all of them).
+	//The requested attacks are picked anew for every distribution, AttackPicker returns the value of the picked attack
+	void BuildQueue(double CurrentTime, uint32 MaxTokens,
+		TFunctionRef<FAggressionScoreInputs(const AOpponentCharacter*)> GetInputs,
+		TFunctionRef<void(FAggressorInfo&, FAggressionScore&, const FAggressionScoreInputs&)> Scorer,
+		TFunctionRef<float(FAggressorInfo&)> AttackPicker);
+	bool IsQueueEmpty() const { return Queue.IsEmpty(); }
+	const FScoredAggressorInfo& PeekBest() const { return Queue.HeapTop(); }
+	FScoredAggressorInfo PopBest();
+	//The requester has received its tokens and will not be requesting anymore
+	void OnGranted(const AOpponentCharacter* Requester, double CurrentTime);
+
+	const FAggressionTokenSchedulerStats& GetStats() const { return Stats; }
+
+protected:
+	struct FRequest
+	{
+		FAggressorInfo Info;
+		FAggressionScore Score;
+		FAggressionScoreInputs ScoredInputs;
+		double RequestingSince;
+		bool bIsScoreValid;
+	};
+	
+	//in the same order as the passive participants of the combat manager (both swap on removal)
+	TArray<FRequest> Requests;
+	TMap<const AOpponentCharacter*, int32> RequestIndices;
+	TArray<FScoredAggressorInfo> Queue;
+	FAggressionTokenSchedulerStats Stats;
+
+	static bool HasHigherScore(const FScoredAggressorInfo& A, const FScoredAggressorInfo& B)
+	{
+		return A.Score > B.Score || (A.Score == B.Score && A.Sequence < B.Sequence);
+	}
+	bool HaveInputsChanged(const FAggressionScoreInputs& Scored, const FAggressionScoreInputs& Current) const;
 };
 
 UENUM(BlueprintType)
@@ -67,6 +178,127 @@ enum class ECombatParticipantStatus : uint8
 	Player UMETA(DisplayName="Player")
 };
 
+struct FCombatLocationCandidate
+{
+	FCombatLocationCandidate() : MatchLevel(0), DistanceMatchLevel(0), SampleLocation(NAN), TestedLocation(NAN){}
+	FCombatLocationCandidate(uint32 NewMatchLevel, uint8 NewDistanceMatchLevel, const FVector& NewSampleLocation,
+		const FVector& NewTestedLocation) : MatchLevel(NewMatchLevel), DistanceMatchLevel(NewDistanceMatchLevel),
+		SampleLocation(NewSampleLocation), TestedLocation(NewTestedLocation){}
+
+	uint32 MatchLevel;
+	//the part of the match level coming from the player distance constraint
+	uint8 DistanceMatchLevel;
+	FVector SampleLocation;
+	//the sample location projected to the navigation mesh
+	FVector TestedLocation;
+};
+
+enum class ECombatParticipantFlags : uint8
+{
+	None = 0,
+	HasCombatTarget = 1 << 0,
+	//whether the location the participant is moving to is known
+	HasTargetLocation = 1 << 1,
+};
+ENUM_CLASS_FLAGS(ECombatParticipantFlags);
+
+//Structure of arrays view of all NPC combat participants, rebuilt once per tick by the combat manager.
+//All arrays are indexed the same way, so every consumer gets the same consistent state of the combat within a frame
+struct FCombatParticipantsSnapshot
+{
+	int32 Num() const { return Participants.Num(); }
+	//INDEX_NONE if the participant is not part of the snapshot
+	int32 Find(const AOpponentCharacter* Participant) const;
+	bool HasFlags(int32 Index, ECombatParticipantFlags RequiredFlags) const
+	{
+		return EnumHasAllFlags(Flags[Index], RequiredFlags);
+	}
+
+	void Reset();
+	void Add(AOpponentCharacter* Participant);
+
+	TArray<AOpponentCharacter*> Participants;
+	TArray<ECombatParticipantFlags> Flags;
+	TArray<FVector> Locations;
+	//the location the participant is currently moving to, or its current location (NaN if unknown)
+	TArray<FVector> TargetLocations;
+	//the location of the participant's combat target (NaN if there is none)
+	TArray<FVector> FacingPoints;
+	TArray<FRequiredSpace> RequiredSpaces;
+	TArray<float> MinRequiredRadii;
+
+protected:
+	TMap<const AOpponentCharacter*, int32> Indices;
+};
+
+//Combat location queries that are waiting for the results of their asynchronous path queries
+struct FCombatLocationBatch
+{
+	FCombatLocationBatch() : PendingPathQueries(0){}
+	TArray<FCombatLocationQuery> Queries;
+	//the participants of the queries (even if they have been destroyed in the meantime)
+	TArray<TObjectKey<AOpponentCharacter>> Participants;
+	int32 PendingPathQueries;
+};
+
+//Everything needed to find the combat location of a single participant.
+//The constraints are set up by the participant's controller, the solving is done by the combat manager
+struct FCombatLocationQuery
+{
+	FCombatLocationQuery();
+
+	//the query may outlive the participant and its combat target while waiting for asynchronous path queries
+	TWeakObjectPtr<AOpponentCharacter> Participant;
+	TWeakObjectPtr<AController> AnchorController;
+	ECombatParticipantStatus ParticipantStatus;
+
+	FCircularDistanceConstraint PlayerDistanceConstraint;
+	FPlayerRelativeWorldZoneConstraint PlayerZoneConstraint;
+	//the space reserved by participants that are not solved together with this query
+	FReservedSpaceGridConstraint ReservedSpaceConstraint;
+	FCircularPointsGenerator PointGenerator;
+
+	FVector CombatTargetLocation;
+	float MinRequestedRadius;
+	//NaN if the current target location should not be kept even when it is still valid
+	FVector CurrentTargetLocation;
+	FVector ValidationExtent;
+	FVector ProjectionExtent;
+
+	//if set, navigation paths are not searched while sampling. Instead, the best candidates are checked using
+	//asynchronous path queries (only possible when solved by the combat manager)
+	bool bUseAsyncNavigation;
+
+	bool bFoundLocation;
+	bool bWasRecalculated;
+	FVector ResultingLocation;
+
+#if WITH_EDITORONLY_DATA
+	bool bIsDebugging;
+#endif
+
+	TArray<const FPositionalConstraint*> GetRelevantConstraints(bool IncludeZoneConstraint) const;
+	//whether the participant and the anchor of the player relative constraints still exist
+	bool IsStillValid() const;
+
+private:
+	friend class ACombatManager;
+	bool bCurrentTargetLocationValid;
+	bool bCandidatesExhaustive;
+	bool bPathToTargetExists;
+	FVector TestedCurrentTargetLocation;
+	uint32 MaxPossibleMatch;
+	TArray<FCombatLocationCandidate> Candidates;
+	//the index of the first sample point of the next evaluation round
+	uint64 NextSampleIndex;
+	int32 OptimalCandidates;
+	//the sample points of the current evaluation round (with the tested location being NaN if projecting failed)
+	TArray<FCombatLocationCandidate> RoundSamples;
+
+	//whether the path lengths for the player distance constraint have to be checked while evaluating the candidates
+	bool NeedsSynchronousPathLengths() const { return PlayerDistanceConstraint.bUseNavPath && !bUseAsyncNavigation; }
+};
+
 UCLASS()
 class MAPROJECT_API ACombatManager : public AActor
 {
@@ -80,6 +312,11 @@ public:
 
 	const TArray<AOpponentCharacter*>& GetAllActiveParticipants(){ return ActiveParticipants; }
 	const TArray<AOpponentCharacter*>& GetAllPassiveParticipants(){ return PassiveParticipants; }
+	const FAggressionTokenSchedulerStats& GetTokenSchedulerStats() const { return TokenScheduler.GetStats(); }
+	//the state of all NPC participants at the beginning of this tick
+	const FCombatParticipantsSnapshot& GetParticipantsSnapshot() const { return ParticipantsSnapshot; }
+	//the space reserved by all participants (updated every tick)
+	const FReservedSpaceGrid& GetReservedSpaceGrid() const { return ReservedSpaceGrid; }
 
 	//register or unregister (nullptr) the player for combat
 	void RegisterCombatParticipant(APlayerCharacter* PlayerParticipant, FManageCombatParticipantsKey Key);
@@ -90,14 +327,30 @@ public:
 
 	void ReleaseAggressionTokens(AOpponentCharacter* Participant, FManageAggressionTokensKey Key);
 
-#if WITH_EDITORONLY_DATA
+	//queue a recalculation of the participant's combat location, which will be solved together with all other requests
+	//of this frame (the result is handed back via AOpponentController::OnCombatLocationSolved)
+	void RequestCombatLocation(const AOpponentController* Requester, bool ForceRecalculation, FRequestCombatLocationKey Key);
+
+	//Solves all queries at once. The sample points are scored in parallel and the reservations are resolved jointly,
+	//so no two queries end up at the same location
+	static void SolveCombatLocations(TArray<FCombatLocationQuery>& Queries, UWorld* World);
+	static void EvaluateCombatLocations(TArray<FCombatLocationQuery>& Queries, UWorld* World);
+	static void ResolveCombatLocations(TArray<FCombatLocationQuery>& Queries, UWorld* World);
+
 	virtual void Tick(float DeltaSeconds) override;
-#endif
 
 protected:
 	TArray<FAggressorInfo> ActiveRequests;	
+
+	//the combat location requests that will be solved on the next tick (the bool forces recalculation)
+	TArray<TTuple<TWeakObjectPtr<const AOpponentController>, bool>> PendingCombatLocationRequests;
+	//the batches that have been evaluated but not resolved yet (most likely still waiting for their path queries)
+	TArray<TSharedRef<FCombatLocationBatch>> CombatLocationBatches;
+	//the participants that are part of one of the combat location batches
+	TSet<TObjectKey<AOpponentCharacter>> InFlightParticipants;
 	
 	FAggressorInfo AnticipatedActive;
+	FAggressionTokenScheduler TokenScheduler;
 	
 	UPROPERTY()
 	APlayerCharacter* PlayerCharacter;
@@ -112,10 +365,29 @@ protected:
 	UPROPERTY()
 	AGlobalSoundManager* SoundManager;
 
+	FCombatParticipantsSnapshot ParticipantsSnapshot;
+	FReservedSpaceGrid ReservedSpaceGrid;
+	//the reservations of the participants inserted into the grid this tick
+	TArray<TTuple<const AActor*, FReservedSpaceConstraint>> CurrentReservations;
+	UPROPERTY(EditAnywhere, AdvancedDisplay)
+	float ReservedSpaceGridCellSize;
+
 	UPROPERTY(EditAnywhere)
 	float PendingOutOfCombatDuration;
 	UPROPERTY(EditAnywhere)
 	uint32 MaxAggressionTokens;	
+	//how far a passive participant or the player may move before the aggression score is recalculated
+	UPROPERTY(EditAnywhere, AdvancedDisplay, meta=(ClampMin=0))
+	double AggressionRescoreDistance;
+	//how far (in degrees) the player may turn before the aggression scores are recalculated
+	UPROPERTY(EditAnywhere, AdvancedDisplay, meta=(ClampMin=0, ClampMax=180))
+	double AggressionRescoreViewAngle;
+	//whether navigation path lengths used for combat locations should be evaluated without blocking the game thread
+	UPROPERTY(EditAnywhere)
+	bool bUseAsyncNavigationQueries;
+	//the maximal number of candidates per participant whose path length is checked asynchronously
+	UPROPERTY(EditAnywhere, meta=(EditCondition="bUseAsyncNavigationQueries", ClampMin=1))
+	int32 MaxAsyncPathQueriesPerParticipant;
 	uint32 AvailableAggressionTokens;
 
 	
@@ -132,12 +404,58 @@ protected:
 
 	//Try to distribute the AvailableAggressionTokens so the highest scoring objects will be inserted
 	void AttemptDistributeFreeTokens();
+	void OnAggressionScoreInvalidated(AOpponentCharacter* Participant);
 
 	void FullyExitFromCombat(AOpponentCharacter* OpponentCharacter);
 
 	UFUNCTION()
 	void OnOutOfCombat(AOpponentCharacter* Participant);
 
+	//the check indices of the asynchronous path queries that don't belong to a candidate
+	static constexpr int32 CombatTargetReachableCheck = -2;
+	static constexpr int32 CurrentTargetLocationCheck = -1;
+
+	void UpdateParticipantsSnapshot();
+	void UpdateReservedSpaceGrid();
+	//Evaluates the pending requests of all participants that aren't part of an unresolved batch yet
+	void SolvePendingCombatLocations();
+	//Resolves all batches whose path queries are done together, so they can't choose conflicting locations
+	void ResolveFinishedCombatLocationBatches();
+	void DeliverCombatLocations(const TArray<FCombatLocationQuery>& Queries) const;
+
+	//Sends out the path queries of all the queries in the batch that use asynchronous navigation
+	void RequestCombatLocationPaths(const TSharedRef<FCombatLocationBatch>& Batch);
+	void OnCombatLocationPathFound(uint32 PathQueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path,
+		TSharedRef<FCombatLocationBatch> Batch, int32 QueryIndex, int32 CheckIndex);
+
+	//active participants are the ones about to attack, so they get the first pick
+	static bool IsSolvedBefore(const FCombatLocationQuery& A, const FCombatLocationQuery& B)
+	{
+		return A.ParticipantStatus == ECombatParticipantStatus::Active &&
+			B.ParticipantStatus != ECombatParticipantStatus::Active;
+	}
+	//Updates the reserved space of a query evaluated on an earlier frame to the current reservations.
+	//The reservations of the participants resolved together with the query are ignored, as they are resolved jointly
+	static void RefreshReservedSpace(FCombatLocationQuery& Query, const TArray<const AActor*>& JointlyResolvedParticipants);
+	
+	//the number of sample points per query that are projected to the navigation mesh, before being scored in parallel
+	static constexpr int32 CombatLocationSamplesPerRound = 32;
+
+	//Checks the current target location of the query and prepares the sampling. Returns whether sampling is needed
+	static bool StartCombatLocationEvaluation(FCombatLocationQuery& Query, UWorld* World);
+	//Projects the sample points of the next evaluation round to the navigation mesh (game thread only)
+	static void ProjectCombatLocationSamples(FCombatLocationQuery& Query, UNavigationSystemV1* NavigationSystem,
+		UWorld* World);
+	//Scores the projected sample points of the current round without accessing the navigation data (thread safe)
+	static void ScoreCombatLocationSamples(FCombatLocationQuery& Query, UWorld* World);
+	//Adds the valid samples of the current round to the candidates (only using the constraints that don't depend on
+	//other queries), checking their path lengths if necessary (game thread only). Returns whether the query is done
+	static bool CollectCombatLocationCandidates(FCombatLocationQuery& Query, UNavigationSystemV1* NavigationSystem,
+		int32 RequiredOptimalCandidates);
+	//Chooses the final location of a query while respecting the locations previously chosen for the other queries
+	static void ResolveCombatLocation(FCombatLocationQuery& Query, const TArray<const FCombatLocationQuery*>& ResolvedQueries,
+		UWorld* World);
+
 #if WITH_EDITORONLY_DATA
 	TTuple<float, FDrawDebugImagesDelegate> DebugImagesToDraw;
 
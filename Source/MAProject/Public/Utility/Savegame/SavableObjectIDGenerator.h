@@ -6,9 +6,49 @@
 #include "GameFramework/Actor.h"
 #include "SavableObjectIDGenerator.generated.h"
 
+class USavableObjectMarkerComponent;
+
 DECLARE_LOG_CATEGORY_EXTERN(LogUniqueWorldId, Error, All);
 
-uint64 GetLowestValidID(const TArray<uint64>& IDsInUse);
+//An inclusive range of unique world IDs
+USTRUCT()
+struct FUniqueWorldIdRange
+{
+	GENERATED_BODY()
+public:
+	FUniqueWorldIdRange() : First(1), Last(std::numeric_limits<uint64>::max()){}
+	FUniqueWorldIdRange(uint64 NewFirst, uint64 NewLast) : First(NewFirst), Last(NewLast){}
+
+	UPROPERTY()
+	uint64 First;
+	UPROPERTY()
+	uint64 Last;
+};
+
+//Keeps the unused unique world IDs as sorted ranges, so free IDs can be found without looking at the used ones
+USTRUCT()
+struct MAPROJECT_API FUniqueWorldIdAllocator
+{
+	GENERATED_BODY()
+public:
+	FUniqueWorldIdAllocator();
+
+	//Rebuilds the free ranges from the IDs in use (which get sorted)
+	void Rebuild(TArray<uint64>& IDsInUse);
+	//The lowest free ID or (if indices shouldn't be reused) the lowest one above all used IDs
+	uint64 Allocate(bool bAllowReusingIndices);
+	//false if the ID is already in use
+	bool MarkUsed(uint64 Id);
+	bool IsFree(uint64 Id) const { return FindRange(Id) != INDEX_NONE; }
+
+protected:
+	//sorted and disjoint, the last range always ends with the highest possible ID (0 is never a valid ID)
+	UPROPERTY()
+	TArray<FUniqueWorldIdRange> FreeRanges;
+
+	//the index of the free range containing the ID (INDEX_NONE if the ID is in use)
+	int32 FindRange(uint64 Id) const;
+};
 
 UCLASS()
 class MAPROJECT_API ASavableObjectIDGenerator : public AActor
@@ -20,6 +60,11 @@ public:
 	ASavableObjectIDGenerator();
 	virtual bool IsEditorOnly() const override;
 
+#if WITH_EDITOR
+	//Gives newly placed or duplicated objects their own ID without recalculating all of them
+	static void OnSavableObjectRegistered(USavableObjectMarkerComponent* SavableObject);
+#endif
+
 protected:
 	//Turning off this functionality means, that a once populated ID will not be restored until all other indices were used
 	//this means that when first shipping the project this option should be enabled to not invalidate existing players
@@ -27,8 +72,19 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "ID Generation")
 	bool bAllowReusingIndices;
 
+	UPROPERTY()
+	FUniqueWorldIdAllocator Allocator;
+	//whether the allocator has been built from the objects in the world (levels saved before it existed haven't)
+	UPROPERTY()
+	bool bHasBuiltAllocator;
+
+	//the objects the IDs in use belong to (used to detect duplicates)
+	TMap<uint64, TWeakObjectPtr<USavableObjectMarkerComponent>> IdOwners;
+
 	virtual void BeginPlay() override;
 
 	UFUNCTION(CallInEditor, Category = "ID Generation")
-	void Recalculate() const;
+	void Recalculate();
+
+	void AssignNewID(USavableObjectMarkerComponent* SavableObject);
 };
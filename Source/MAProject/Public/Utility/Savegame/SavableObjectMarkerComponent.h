@@ -8,6 +8,8 @@
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDataSavedDelegate);
 
+class USaveRegistrySubsystem;
+
 struct FSetUniqueWorldIdKey final
 {
 	friend class ASavableObjectIDGenerator;
@@ -22,7 +24,7 @@ class MAPROJECT_API USavableObjectMarkerComponent : public UActorComponent
 
 public:
 	static const uint64 PlayerControllerID;
-	USavableObjectMarkerComponent() : UniqueWorldID(0){}
+	USavableObjectMarkerComponent() : UniqueWorldID(0), SaveRegistry(nullptr){}
 
 	FOnDataSavedDelegate OnActorLoaded;
 
@@ -30,8 +32,17 @@ public:
 	uint64 GetUniqueWorldID() const { return UniqueWorldID; };
 	//Sets the custom generated unique world ID (can only be used by the in-editor generator)
 	void SetUniqueWorldID(uint64 NewId, FSetUniqueWorldIdKey Key){ UniqueWorldID = NewId; }
-	
+
 protected:
 	UPROPERTY(VisibleAnywhere)
 	uint64 UniqueWorldID;
+
+	UPROPERTY()
+	USaveRegistrySubsystem* SaveRegistry;
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+#if WITH_EDITOR
+	virtual void OnRegister() override;
+#endif
 };
@@ -6,6 +6,8 @@
 #include "GameFramework/SaveGame.h"
 #include "WorldStateSaveGame.generated.h"
 
+class FSaveGamePropertyCopy;
+
 USTRUCT()
 struct FGeneralActorSaveData
 {
@@ -26,6 +28,33 @@ public:
 	FNonPlayerSaveData() : FGeneralActorSaveData(), ActorUniqueWorldID(0){}
 	UPROPERTY()
 	uint64 ActorUniqueWorldID;
+
+	//the SaveGame properties that haven't been serialized yet, which take precedence over the serialized data
+	TSharedPtr<FSaveGamePropertyCopy, ESPMode::ThreadSafe> PendingData;
+};
+
+//The saved actors of a single level (streaming level or world partition cell), which can be loaded independently
+USTRUCT()
+struct FWorldSaveChunk
+{
+	GENERATED_BODY()
+public:
+	FWorldSaveChunk() : bIsDirty(false){}
+
+	UPROPERTY()
+	TArray<FNonPlayerSaveData> SavedActors;
+
+	//whether the chunk changed since it was last written
+	bool bIsDirty;
+
+	FNonPlayerSaveData* FindRecord(uint64 ActorUniqueWorldID);
+	FNonPlayerSaveData& FindOrAddRecord(uint64 ActorUniqueWorldID);
+	void RemoveRecord(uint64 ActorUniqueWorldID);
+	//has to be called after the saved actors have been replaced
+	void IndexRecords();
+
+protected:
+	TMap<uint64, int32> RecordIndices;
 };
 
 UCLASS()
@@ -39,7 +68,8 @@ public:
 	UPROPERTY()
 	FGeneralActorSaveData PlayerData;
 
+	//only the chunks of the levels that have been loaded so far, the others stay on disk
 	UPROPERTY()
-	TArray<FNonPlayerSaveData> SavedActors;
+	TMap<FName, FWorldSaveChunk> LoadedChunks;
 	
 };
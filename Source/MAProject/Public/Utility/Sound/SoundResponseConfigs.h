@@ -38,10 +38,22 @@ class MAPROJECT_API UPhysicsSoundResponseConfig : public UObject
 {
 	GENERATED_BODY()
 public:
-	const TMap<TEnumAsByte<EPhysicalSurface>, FSoundConfig>& GetPhysicsResponses(){ return PhysicsResponses; }
+	const TMap<TEnumAsByte<EPhysicalSurface>, FSoundConfig>& GetPhysicsResponses() const { return PhysicsResponses; }
+	//the response of the surface type (a config without sound if none is defined)
+	const FSoundConfig& GetResponse(EPhysicalSurface SurfaceType) const { return ResolvedResponses[SurfaceType]; }
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 protected:
 	UPROPERTY(EditAnywhere)                                
 	TMap<TEnumAsByte<EPhysicalSurface>, FSoundConfig> PhysicsResponses;
+	//the physics responses indexed by the surface type, rebuilt whenever they change
+	TArray<FSoundConfig> ResolvedResponses;
+
+	void ResolveResponses();
 };
 
 //Get the corresponding sound for every EPhysicalSurface type as defined
@@ -50,10 +62,22 @@ class MAPROJECT_API UPhysicsAILoudnessResponseConfig : public UObject
 {
 	GENERATED_BODY()
 public:
-	const TMap<TEnumAsByte<EPhysicalSurface>, float>& GetPhysicsResponses(){ return PhysicsAILoudnessResponses; }
+	const TMap<TEnumAsByte<EPhysicalSurface>, float>& GetPhysicsResponses() const { return PhysicsAILoudnessResponses; }
+	//the loudness of the surface type (0 if none is defined)
+	float GetResponse(EPhysicalSurface SurfaceType) const { return ResolvedResponses[SurfaceType]; }
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 protected:
 	UPROPERTY(EditAnywhere)                                
 	TMap<TEnumAsByte<EPhysicalSurface>, float> PhysicsAILoudnessResponses;
+	//the physics responses indexed by the surface type, rebuilt whenever they change
+	TArray<float> ResolvedResponses;
+
+	void ResolveResponses();
 };
 
 
@@ -9,6 +9,8 @@
 class APlayerCharacter;
 class UImage;
 class AGeneralCharacter;
+struct FStatusEffectSubsystemKey;
+class UStatusEffectSubsystem;
 
 struct FForceStatusEffectTimerRestartKey final
 {
@@ -34,13 +36,16 @@ class MAPROJECT_API UStatusEffect : public UActorComponent
 public:
 	UStatusEffect();
 
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	FTimerHandle GetTimerHandle() const { return EffectResetHandle; }
+	//-1 if the effect isn't active or never runs out
+	float GetTimeRemaining() const;
 	float GetMaxEffectTime() const { return MaxEffectTime; }
 	void ForceRestartTimer(FForceStatusEffectTimerRestartKey);
 	void BindImage(UImage* Image, FStatusEffectBindImageKey);
 	bool IsBoundImage(const UImage* Image) const { return BoundImage == Image; }
+	void SetImageAlpha(float Alpha, FStatusEffectSubsystemKey);
+	void OnExpired(FStatusEffectSubsystemKey);
 
 	void OnEffectApplied_Implementation(AGeneralCharacter* Target);
 	void OnEffectRemoved_Implementation(AGeneralCharacter* Target);
@@ -52,8 +57,6 @@ public:
 	void OnEffectRemoved(AGeneralCharacter* Target);
 
 protected:
-	FTimerHandle EffectResetHandle;
-
 	UPROPERTY()
 	UImage* BoundImage; 
 	
@@ -71,8 +74,7 @@ protected:
 
 	void OnEffectTimedOut_Implementation(AGeneralCharacter* Target);
 
-	UFUNCTION()
-	void OnEffectTimeExceeded();
+	UStatusEffectSubsystem* GetStatusEffectSubsystem() const;
 	
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnEffectTimedOut(AGeneralCharacter* Target);	